@@ -0,0 +1,370 @@
+// Checks the vector paths of the pixel kernels against the scalar path,
+//  then measures the throughput of every path
+//
+// Usage : ft_rf_pixel_kernels_benchmark [options]
+//  --check-only          Only compare the paths, don't measure them
+//  --width <pixels>      Width of the measured images, default 1920
+//  --height <pixels>     Height of the measured images, default 1080
+//  --iterations <count>  Runs of each kernel per path, default 50
+//
+// Exits with 0 when every path matches the scalar path, 1 on mismatch
+//  and 2 on error
+
+// project headers
+#include "simd/pixel_kernels.h"
+
+// standard headers
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using ft::rf::simd::t_kernel_path;
+
+// Exit codes
+constexpr int g_exit_success = 0;
+constexpr int g_exit_mismatch = 1;
+constexpr int g_exit_error = 2;
+
+// Command line options
+struct t_options
+{
+    bool check_only = false;
+    int width = 1920;
+    int height = 1080;
+    int iterations = 50;
+};
+
+
+// A kernel run on an image
+// Reads `source`, writes `target`, both sized for the image by `prepare`
+struct t_kernel
+{
+    const char* name = nullptr;
+
+    // Bytes of source and target per pixel
+    std::size_t source_size = 4;
+    std::size_t target_size = 4;
+
+    std::function<void(const std::vector<std::uint8_t>& p_source, std::vector<std::uint8_t>& p_target, int p_width, int p_height)> run;
+
+    // Bytes added to every row of the source and target
+    std::size_t row_padding = 0;
+
+    // Writes the source instead of random bytes, if set
+    std::function<void(std::vector<std::uint8_t>& p_source, std::mt19937& p_engine)> fill;
+};
+
+
+// Fill a source with floats around [0, 1], with some NaN and infinities
+void fill_linear(std::vector<std::uint8_t>& p_source, std::mt19937& p_engine)
+{
+    auto distribution = std::uniform_real_distribution<float>{ -0.25f, 1.25f };
+    auto* values = reinterpret_cast<float*>(p_source.data());
+    const auto count = p_source.size() / sizeof(float);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        values[i] = (i % 97 == 13) ? std::numeric_limits<float>::quiet_NaN() :
+            (i % 89 == 7) ? std::numeric_limits<float>::infinity() :
+            distribution(p_engine);
+    }
+}
+
+
+const char* get_path_name(const t_kernel_path p_path)
+{
+    switch (p_path)
+    {
+    case t_kernel_path::sse2:   return "sse2";
+    case t_kernel_path::avx2:   return "avx2";
+    case t_kernel_path::neon:   return "neon";
+    case t_kernel_path::scalar:
+    default:                    return "scalar";
+    }
+}
+
+
+// Vector paths the running CPU supports, widest last
+std::vector<t_kernel_path> get_vector_paths()
+{
+    auto result = std::vector<t_kernel_path>{};
+    for (const auto path : { t_kernel_path::sse2, t_kernel_path::avx2, t_kernel_path::neon })
+    {
+        ft::rf::simd::set_kernel_path(path);
+        if (ft::rf::simd::get_kernel_path() == path)
+        {
+            result.push_back(path);
+        }
+    }
+    ft::rf::simd::set_kernel_path(t_kernel_path::avx2);
+    return result;
+}
+
+
+// The kernels, each one covering its odd sizes and strides
+std::vector<t_kernel> make_kernels()
+{
+    namespace simd = ft::rf::simd;
+
+    // Rows of the strided copy are padded by this many bytes
+    constexpr std::size_t padding = 36;
+
+    return {
+        { "swizzle_rgba_bgra", 4, 4, [](const auto & p_source, auto & p_target, int p_width, int p_height) {
+            simd::swizzle_rgba_bgra(p_source.data(), p_target.data(), static_cast<std::size_t>(p_width) * p_height);
+        } },
+        { "swizzle_rgba_bgra in place", 4, 4, [](const auto & p_source, auto & p_target, int p_width, int p_height) {
+            std::copy(p_source.begin(), p_source.end(), p_target.begin());
+            simd::swizzle_rgba_bgra(p_target.data(), p_target.data(), static_cast<std::size_t>(p_width) * p_height);
+        } },
+        { "expand_rgb_rgba", 3, 4, [](const auto & p_source, auto & p_target, int p_width, int p_height) {
+            simd::expand_rgb_rgba(p_source.data(), p_target.data(), static_cast<std::size_t>(p_width) * p_height);
+        } },
+        { "premultiply_alpha", 4, 4, [](const auto & p_source, auto & p_target, int p_width, int p_height) {
+            simd::premultiply_alpha(p_source.data(), p_target.data(), static_cast<std::size_t>(p_width) * p_height);
+        } },
+        { "premultiply_alpha in place", 4, 4, [](const auto & p_source, auto & p_target, int p_width, int p_height) {
+            std::copy(p_source.begin(), p_source.end(), p_target.begin());
+            simd::premultiply_alpha(p_target.data(), p_target.data(), static_cast<std::size_t>(p_width) * p_height);
+        } },
+        { "unpremultiply_alpha", 4, 4, [](const auto & p_source, auto & p_target, int p_width, int p_height) {
+            simd::unpremultiply_alpha(p_source.data(), p_target.data(), static_cast<std::size_t>(p_width) * p_height);
+        } },
+        { "srgb_to_linear", 4, 16, [](const auto & p_source, auto & p_target, int p_width, int p_height) {
+            simd::srgb_to_linear(p_source.data(), reinterpret_cast<float*>(p_target.data()), static_cast<std::size_t>(p_width) * p_height);
+        } },
+        { "linear_to_srgb", 16, 4, [](const auto & p_source, auto & p_target, int p_width, int p_height) {
+            simd::linear_to_srgb(reinterpret_cast<const float*>(p_source.data()), p_target.data(), static_cast<std::size_t>(p_width) * p_height);
+        }, 0, fill_linear },
+        { "rgba_to_yuv444", 4, 3, [](const auto & p_source, auto & p_target, int p_width, int p_height) {
+            const auto count = static_cast<std::size_t>(p_width) * p_height;
+            simd::rgba_to_yuv444(p_source.data(), p_target.data(), p_target.data() + count, p_target.data() + count * 2, count);
+        } },
+        { "copy_rows", 4, 4, [](const auto & p_source, auto & p_target, int p_width, int p_height) {
+            const auto row_size = static_cast<std::size_t>(p_width) * 4;
+            simd::copy_rows(p_source.data(), row_size, p_target.data(), row_size, row_size, p_height);
+        } },
+        { "copy_rows strided", 4, 4, [](const auto & p_source, auto & p_target, int p_width, int p_height) {
+            // Target rows start unaligned, with a different stride
+            const auto row_size = static_cast<std::size_t>(p_width) * 4;
+            simd::copy_rows(p_source.data(), row_size + padding, p_target.data() + 1, row_size + padding / 2, row_size, p_height);
+        }, padding },
+        { "flip_rows", 4, 4, [](const auto & p_source, auto & p_target, int p_width, int p_height) {
+            const auto row_size = static_cast<std::size_t>(p_width) * 4;
+            simd::flip_rows(p_source.data(), row_size, p_target.data(), row_size, row_size, p_height);
+        } },
+        { "downsample_2x2", 4, 1, [](const auto & p_source, auto & p_target, int p_width, int p_height) {
+            simd::downsample_2x2(p_source.data(), p_width, p_height, p_target.data());
+        } }
+    };
+}
+
+
+// Random source pixels and a target filled with a marker
+void prepare(
+    const t_kernel& p_kernel,
+    const int p_width,
+    const int p_height,
+    std::vector<std::uint8_t>& p_source,
+    std::vector<std::uint8_t>& p_target)
+{
+    auto engine = std::mt19937{ static_cast<std::uint32_t>(p_width * 7919 + p_height) };
+    auto distribution = std::uniform_int_distribution<int>{ 0, 255 };
+
+    const auto pixels = static_cast<std::size_t>(p_width) * p_height;
+    const auto padding = p_kernel.row_padding * p_height;
+    p_source.resize(pixels * p_kernel.source_size + padding);
+    if (p_kernel.fill != nullptr) {
+        p_kernel.fill(p_source, engine);
+    }
+    else {
+        std::generate(p_source.begin(), p_source.end(), [&]() { return static_cast<std::uint8_t>(distribution(engine)); });
+    }
+
+    // Large enough for every kernel's output, downsampling and unaligned
+    //  targets included
+    p_target.assign(pixels * std::max<std::size_t>(p_kernel.target_size, 4) + padding + 1, 0xCD);
+}
+
+
+// Compare every vector path with the scalar path on images of odd sizes
+// Returns the number of mismatches
+int check_paths(const std::vector<t_kernel>& p_kernels, const std::vector<t_kernel_path>& p_paths)
+{
+    // Sizes leaving tails after every vector width, and a size large
+    //  enough for the non-temporal copies
+    constexpr std::pair<int, int> sizes[] = {
+        { 1, 1 }, { 3, 2 }, { 7, 5 }, { 17, 3 }, { 33, 9 }, { 64, 64 }, { 129, 31 }, { 1021, 517 }
+    };
+
+    int mismatches = 0;
+    auto source = std::vector<std::uint8_t>{};
+    auto expected = std::vector<std::uint8_t>{};
+    auto target = std::vector<std::uint8_t>{};
+
+    for (const auto & kernel : p_kernels)
+    {
+        for (const auto & [width, height] : sizes)
+        {
+            prepare(kernel, width, height, source, expected);
+            ft::rf::simd::set_kernel_path(t_kernel_path::scalar);
+            kernel.run(source, expected, width, height);
+
+            for (const auto path : p_paths)
+            {
+                target.assign(expected.size(), 0xCD);
+                ft::rf::simd::set_kernel_path(path);
+                kernel.run(source, target, width, height);
+
+                const auto difference = std::mismatch(expected.begin(), expected.end(), target.begin());
+                if (difference.first != expected.end())
+                {
+                    std::printf("MISMATCH %s %s %dx%d at byte %zu : expected %d, got %d\n",
+                        kernel.name, get_path_name(path), width, height,
+                        static_cast<std::size_t>(difference.first - expected.begin()),
+                        *difference.first, *difference.second);
+                    ++mismatches;
+                }
+            }
+        }
+    }
+
+    ft::rf::simd::set_kernel_path(t_kernel_path::avx2);
+    return mismatches;
+}
+
+
+// Measure every kernel with the scalar path and every vector path
+void measure_paths(const std::vector<t_kernel>& p_kernels, const std::vector<t_kernel_path>& p_paths, const t_options& p_options)
+{
+    auto paths = std::vector<t_kernel_path>{ t_kernel_path::scalar };
+    paths.insert(paths.end(), p_paths.begin(), p_paths.end());
+
+    std::printf("\n%-28s %-8s %12s %10s\n", "kernel", "path", "MB/s", "speedup");
+
+    auto source = std::vector<std::uint8_t>{};
+    auto target = std::vector<std::uint8_t>{};
+    for (const auto & kernel : p_kernels)
+    {
+        prepare(kernel, p_options.width, p_options.height, source, target);
+
+        double scalar_time = 0.;
+        for (const auto path : paths)
+        {
+            ft::rf::simd::set_kernel_path(path);
+
+            // One untimed run to fault the pages in
+            kernel.run(source, target, p_options.width, p_options.height);
+
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < p_options.iterations; ++i)
+            {
+                kernel.run(source, target, p_options.width, p_options.height);
+            }
+            const auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+                / std::max(p_options.iterations, 1);
+
+            if (path == t_kernel_path::scalar)
+            {
+                scalar_time = time;
+            }
+
+            const auto megabytes = static_cast<double>(source.size()) / (1024. * 1024.);
+            std::printf("%-28s %-8s %12.1f %9.2fx\n",
+                kernel.name,
+                get_path_name(path),
+                time > 0. ? megabytes / time : 0.,
+                time > 0. ? scalar_time / time : 0.);
+        }
+    }
+
+    ft::rf::simd::set_kernel_path(t_kernel_path::avx2);
+}
+
+
+// Read the command line
+// Raises std::invalid_argument if an option is unknown or misses its value
+t_options parse_options(const int p_argc, char** p_argv)
+{
+    auto result = t_options{};
+    for (int i = 1; i < p_argc; ++i)
+    {
+        const auto option = std::string_view{ p_argv[i] };
+        const auto next = [&]() -> int {
+            if (i + 1 >= p_argc) {
+                throw std::invalid_argument("Missing value for " + std::string(option));
+            }
+            return std::stoi(p_argv[++i]);
+        };
+
+        if (option == "--check-only") {
+            result.check_only = true;
+        }
+        else if (option == "--width") {
+            result.width = next();
+        }
+        else if (option == "--height") {
+            result.height = next();
+        }
+        else if (option == "--iterations") {
+            result.iterations = next();
+        }
+        else {
+            throw std::invalid_argument("Unknown option " + std::string(option));
+        }
+    }
+
+    if (result.width < 1 || result.height < 1)
+    {
+        throw std::invalid_argument("The image size must be positive");
+    }
+    return result;
+}
+
+}   // anonymous namespace
+
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const auto options = parse_options(argc, argv);
+        const auto kernels = make_kernels();
+        const auto paths = get_vector_paths();
+
+        std::printf("Vector paths :");
+        for (const auto path : paths) {
+            std::printf(" %s", get_path_name(path));
+        }
+        std::printf(paths.empty() ? " none\n" : "\n");
+
+        const auto mismatches = check_paths(kernels, paths);
+        std::printf("%d mismatch(es) against the scalar path\n", mismatches);
+        if (mismatches != 0)
+        {
+            return g_exit_mismatch;
+        }
+
+        if (options.check_only == false)
+        {
+            measure_paths(kernels, paths, options);
+        }
+        return g_exit_success;
+    }
+    catch (const std::exception & p_error)
+    {
+        std::fprintf(stderr, "%s\n", p_error.what());
+        return g_exit_error;
+    }
+}
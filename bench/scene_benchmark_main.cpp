@@ -0,0 +1,217 @@
+// Runs the built-in bench scenes and checks them against a baseline
+//
+// Usage : ft_rf_scene_benchmark [options]
+//  --baseline <file>     Compare the results with a baseline written by
+//                        this program, exits with 1 on regression
+//  --update-baseline     Write the results to the baseline file instead
+//  --output <file>       Write the results there, default is stdout
+//  --tolerance <value>   Fraction a metric may be worse than its baseline,
+//                        default 0.1
+//  --frames <count>      Frames measured per scene
+//  --warmup <count>      Frames drawn before measuring
+//  --scene <name>        Only run this scene, may be repeated
+//  --null-gl             Use the null OpenGL dispatch
+//
+// Exits with 0 when nothing regressed, 1 on regression and 2 on error
+
+// project headers
+#include "bench/bench_scenes.h"
+#include "bench/scene_benchmark.h"
+#include "opengl_context/gl_dispatch.h"
+
+// standard headers
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// Exit codes
+constexpr int g_exit_success = 0;
+constexpr int g_exit_regression = 1;
+constexpr int g_exit_error = 2;
+
+// Command line options
+struct t_options
+{
+    std::optional<std::string> baseline;
+    bool update_baseline = false;
+    std::optional<std::string> output;
+    double tolerance = 0.1;
+    std::vector<std::string> scenes;
+    bool null_gl = false;
+    ft::rf::bench::t_scene_benchmark_params params;
+};
+
+
+// Read the command line
+// Raises std::invalid_argument if an option is unknown or misses its value
+t_options parse_options(const int p_argc, char** p_argv)
+{
+    auto result = t_options{};
+    for (int i = 1; i < p_argc; ++i)
+    {
+        const auto option = std::string_view{ p_argv[i] };
+        const auto next = [&]() -> std::string {
+            if (i + 1 >= p_argc) {
+                throw std::invalid_argument("Missing value for " + std::string(option));
+            }
+            return p_argv[++i];
+        };
+
+        if (option == "--baseline") {
+            result.baseline = next();
+        }
+        else if (option == "--update-baseline") {
+            result.update_baseline = true;
+        }
+        else if (option == "--output") {
+            result.output = next();
+        }
+        else if (option == "--tolerance") {
+            result.tolerance = std::stod(next());
+        }
+        else if (option == "--frames") {
+            result.params.frames = static_cast<std::size_t>(std::stoul(next()));
+        }
+        else if (option == "--warmup") {
+            result.params.warmup_frames = static_cast<std::size_t>(std::stoul(next()));
+        }
+        else if (option == "--scene") {
+            result.scenes.push_back(next());
+        }
+        else if (option == "--null-gl") {
+            result.null_gl = true;
+        }
+        else {
+            throw std::invalid_argument("Unknown option " + std::string(option));
+        }
+    }
+
+    if (result.update_baseline && result.baseline.has_value() == false)
+    {
+        throw std::invalid_argument("--update-baseline requires --baseline");
+    }
+    if (result.tolerance < 0.)
+    {
+        throw std::invalid_argument("--tolerance must not be negative");
+    }
+    return result;
+}
+
+
+// The default scenes, only those named in `p_names` if any
+std::vector<std::shared_ptr<ft::rf::bench::bench_scene>> select_scenes(const std::vector<std::string>& p_names)
+{
+    auto scenes = ft::rf::bench::make_default_scenes();
+    if (p_names.empty())
+    {
+        return scenes;
+    }
+
+    auto result = std::vector<std::shared_ptr<ft::rf::bench::bench_scene>>{};
+    for (const auto & name : p_names)
+    {
+        const auto found = std::find_if(scenes.begin(), scenes.end(), [&name](const auto & p_scene) {
+            return p_scene->get_name() == name;
+        });
+        if (found == scenes.end())
+        {
+            throw std::invalid_argument("Unknown scene " + name);
+        }
+        result.push_back(*found);
+    }
+    return result;
+}
+
+
+// Run the benchmark, returns the exit code
+int run(const t_options& p_options)
+{
+    if (p_options.null_gl)
+    {
+        ft::rf::context::set_gl_dispatch(ft::rf::context::t_gl_dispatch::null);
+    }
+
+    const auto results = ft::rf::bench::run_scene_benchmarks(select_scenes(p_options.scenes), p_options.params);
+
+    if (p_options.output.has_value())
+    {
+        auto stream = std::ofstream{ *p_options.output };
+        ft::rf::bench::write_results_json(stream, results);
+    }
+    else
+    {
+        ft::rf::bench::write_results_json(std::cout, results);
+    }
+
+    // Batched and naive object draws are compared through their draws per second
+    for (const auto & result : results)
+    {
+        if (result.draws_per_second > 0.)
+        {
+            std::cerr << result.name << " : " << result.draws_per_second << " draws per second\n";
+        }
+    }
+
+    if (p_options.baseline.has_value() == false)
+    {
+        return g_exit_success;
+    }
+
+    if (p_options.update_baseline)
+    {
+        auto stream = std::ofstream{ *p_options.baseline };
+        ft::rf::bench::write_results_json(stream, results);
+        std::cerr << "Baseline written to " << *p_options.baseline << '\n';
+        return stream.good() ? g_exit_success : g_exit_error;
+    }
+
+    auto stream = std::ifstream{ *p_options.baseline };
+    if (stream.is_open() == false)
+    {
+        std::cerr << "Can't open baseline " << *p_options.baseline << '\n';
+        return g_exit_error;
+    }
+
+    // When scenes are selected, the others aren't missing
+    auto baseline = ft::rf::bench::read_results_json(stream);
+    if (p_options.scenes.empty() == false)
+    {
+        std::erase_if(baseline, [&p_options](const auto & p_baseline) {
+            return std::find(p_options.scenes.begin(), p_options.scenes.end(), p_baseline.name) == p_options.scenes.end();
+        });
+    }
+
+    const auto regressions = ft::rf::bench::compare_with_baseline(results, baseline, p_options.tolerance);
+    for (const auto & regression : regressions)
+    {
+        std::cerr << "Regression in " << regression.scene << " : " << regression.metric
+            << " went from " << regression.baseline << " to " << regression.measured << '\n';
+    }
+    return regressions.empty() ? g_exit_success : g_exit_regression;
+}
+
+}   // anonymous namespace
+
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return run(parse_options(argc, argv));
+    }
+    catch (const std::exception & p_error)
+    {
+        std::cerr << p_error.what() << '\n';
+        return g_exit_error;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// A workload drawn by the scene benchmark, see scene_benchmark.h
+
+// standard headers
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ft {
+namespace rf {
+
+// Forward declaration
+class render_frame;
+
+namespace bench {
+
+class bench_scene
+{
+public:
+    // Destructor
+    virtual ~bench_scene() = default;
+
+    // Name identifying the scene in the results and the baseline
+    virtual std::string get_name() const = 0;
+
+    // Create the scene's objects, called once before the first frame
+    virtual void setup(render_frame& p_frame) = 0;
+
+    // Draw frame `p_index`, counted from 0 including the warm-up frames
+    // Called between render_frame::start_frame and render_frame::end_frame
+    virtual void draw(render_frame& p_frame, const std::uint64_t p_index) = 0;
+
+    // Release the scene's objects, called once after the last frame
+    virtual void teardown(render_frame& p_frame) = 0;
+
+    // Draws issued by every frame, 0 if the scene doesn't count them
+    // Gives the draws per second of the results
+    virtual std::size_t get_draws_per_frame() const { return 0; }
+
+};  // class bench_scene
+
+}   // namespace bench
+}   // namespace rf
+}   // namespace ft
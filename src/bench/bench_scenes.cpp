@@ -0,0 +1,789 @@
+#include "bench_scenes.h"
+
+// project headers
+#include "opengl_context/buffer_heap.h"
+#include "opengl_context/call_opengl_function.h"
+#include "opengl_context/gpu_memory_tracker.h"
+#include "opengl_context/make_current.h"
+#include "opengl_context/object_caches.h"
+#include "opengl_context/opengl_context.h"
+#include "opengl_context/shader_program.h"
+#include "opengl_context/texture_atlas.h"
+#include "renderframe/frame_sink.h"
+#include "renderframe/renderframe.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+namespace {
+
+// Vertex of a quad
+struct t_vertex {
+    float x;
+    float y;
+    float u;
+    float v;
+    float layer;
+};
+
+// Pages of the scenes' buffer heaps, every scene fits in one
+constexpr std::size_t g_heap_page_size = std::size_t{ 4 } * 1024 * 1024;
+
+// State thrashing : draws submitted together, and the step between the
+//  states of two consecutive draws, odd so every state is visited
+constexpr std::size_t g_thrash_group = 8;
+constexpr std::size_t g_thrash_step = 37;
+
+// State thrashing : programs and textures the states pick from
+constexpr std::size_t g_thrash_programs = 4;
+constexpr std::size_t g_thrash_textures = 8;
+constexpr int g_thrash_texture_size = 64;
+
+// Object draws : textures the states pick from, each one used with
+//  every state thrashing program
+constexpr std::size_t g_object_textures = 4;
+constexpr int g_object_texture_size = 16;
+
+// Memory tracker tag of the scenes' textures
+constexpr auto g_tracker_tag = "bench";
+
+constexpr auto g_vertex_shader = R"(#version 330 core
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec3 coordinates;
+out vec3 v_coordinates;
+
+void main()
+{
+    v_coordinates = coordinates;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
+)";
+
+// Expects COLOR, a vec4 constructor's arguments, and ITERATIONS
+constexpr auto g_color_fragment_shader = R"(#version 330 core
+in vec3 v_coordinates;
+out vec4 color;
+
+void main()
+{
+    vec3 value = v_coordinates;
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        value = fract(value * 1.618 + vec3(0.1, 0.2, 0.3));
+    }
+    color = vec4(COLOR) * vec4(value, 1.0);
+}
+)";
+
+// Expects COLOR, a vec4 constructor's arguments
+constexpr auto g_texture_fragment_shader = R"(#version 330 core
+uniform sampler2D image;
+in vec3 v_coordinates;
+out vec4 color;
+
+void main()
+{
+    color = texture(image, v_coordinates.xy) * vec4(COLOR);
+}
+)";
+
+constexpr auto g_array_texture_fragment_shader = R"(#version 330 core
+uniform sampler2DArray image;
+in vec3 v_coordinates;
+out vec4 color;
+
+void main()
+{
+    color = texture(image, v_coordinates);
+}
+)";
+
+// Colors of the state thrashing programs
+constexpr std::array<const char*, g_thrash_programs> g_thrash_colors = {
+    "1.0, 0.3, 0.3, 0.8",
+    "0.3, 1.0, 0.3, 0.8",
+    "0.3, 0.3, 1.0, 0.8",
+    "1.0, 1.0, 0.3, 0.8"
+};
+
+
+// Create a `p_size` x `p_size` RGBA8 checkerboard texture of `p_color` and black
+// `p_context` must be active
+unsigned int create_checker_texture(
+    const ft::rf::context::opengl_context & p_context,
+    const int p_size,
+    const std::array<std::uint8_t, 4> p_color)
+{
+    auto pixels = std::vector<std::uint8_t>(static_cast<std::size_t>(p_size) * p_size * 4);
+    for (int y = 0; y < p_size; ++y)
+    {
+        for (int x = 0; x < p_size; ++x)
+        {
+            if (((x / 8) + (y / 8)) % 2 == 0)
+            {
+                std::copy(p_color.begin(), p_color.end(), pixels.data() + (static_cast<std::size_t>(y) * p_size + x) * 4);
+            }
+        }
+    }
+
+    auto texture = GLuint{ 0 };
+    ft::rf::call_opengl<ft::rf::err::context_edit_error>(glGenTextures, 1, &texture);
+    ft::rf::call_opengl<ft::rf::err::context_edit_error>(glBindTexture, GL_TEXTURE_2D, texture);
+    ft::rf::call_opengl<ft::rf::err::context_edit_error>(
+        glTexStorage2D, GL_TEXTURE_2D, GLsizei{ 1 }, GL_RGBA8, p_size, p_size);
+    ft::rf::call_opengl<ft::rf::err::context_edit_error>(
+        glTexSubImage2D,
+        GL_TEXTURE_2D,
+        GLint{ 0 },
+        GLint{ 0 },
+        GLint{ 0 },
+        p_size,
+        p_size,
+        GL_RGBA,
+        GL_UNSIGNED_BYTE,
+        static_cast<const void*>(pixels.data()));
+    ft::rf::call_opengl<ft::rf::err::context_edit_error>(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    ft::rf::call_opengl<ft::rf::err::context_edit_error>(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    ft::rf::context::get_gpu_memory_tracker().track(
+        p_context,
+        ft::rf::context::t_gpu_memory_category::texture,
+        texture,
+        ft::rf::context::estimate_texture_size(GL_RGBA8, p_size, p_size),
+        g_tracker_tag);
+    return texture;
+}
+
+
+// Counts the frames it receives
+class counting_sink : public ft::rf::frame_sink
+{
+public:
+    explicit counting_sink(std::uint64_t& p_count) :
+        m_count(&p_count)
+    {}
+
+    void on_frame(const ft::rf::t_frame&) override
+    {
+        ++*m_count;
+    }
+
+private:
+    std::uint64_t* m_count = nullptr;
+};
+
+}   // anonymous namespace
+
+
+// `p_count` quads of a grid covering the whole frame, row by row
+std::vector<ft::rf::bench::t_quad> ft::rf::bench::make_quad_grid(const std::size_t p_count)
+{
+    auto result = std::vector<t_quad>{};
+    if (p_count == 0)
+    {
+        return result;
+    }
+
+    const auto columns = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(p_count))));
+    const auto rows = (p_count + columns - 1) / columns;
+    const auto width = 2.f / static_cast<float>(columns);
+    const auto height = 2.f / static_cast<float>(rows);
+
+    // Leave a gap between the quads
+    const auto margin_x = width * 0.1f;
+    const auto margin_y = height * 0.1f;
+
+    result.reserve(p_count);
+    for (std::size_t i = 0; i < p_count; ++i)
+    {
+        const auto x = -1.f + width * static_cast<float>(i % columns);
+        const auto y = -1.f + height * static_cast<float>(i / columns);
+
+        auto quad = t_quad{};
+        quad.x0 = x + margin_x;
+        quad.y0 = y + margin_y;
+        quad.x1 = x + width - margin_x;
+        quad.y1 = y + height - margin_y;
+        result.push_back(quad);
+    }
+    return result;
+}
+
+
+// Constructor
+ft::rf::bench::batched_scene::batched_scene() = default;
+
+
+// Destructor
+ft::rf::bench::batched_scene::~batched_scene() = default;
+
+
+// Create the buffer heap and draw batch, then the scene's objects
+void ft::rf::bench::batched_scene::setup(render_frame & p_frame)
+{
+    m_frame = &p_frame;
+    m_context = &p_frame.get_opengl_context();
+
+    auto params = context::t_buffer_heap_params{};
+    params.page_size = g_heap_page_size;
+    m_heap = std::make_unique<context::buffer_heap>(*m_context, params);
+    m_batch = std::make_unique<context::draw_batch>(*m_context);
+
+    auto active = context::make_current{ *m_context };
+    create();
+}
+
+
+// Release the scene's objects, then the buffer heap and draw batch
+void ft::rf::bench::batched_scene::teardown(render_frame &)
+{
+    {
+        auto active = context::make_current{ *m_context };
+        destroy();
+
+        for (const auto & mesh : m_meshes)
+        {
+            m_context->release_vertex_array(mesh->vertex_array);
+            m_heap->free(mesh->vertices);
+            m_heap->free(mesh->indices);
+        }
+        for (const auto program : m_programs)
+        {
+            m_context->delete_program(program);
+        }
+
+        m_batch.reset();
+        m_heap.reset();
+    }
+
+    m_meshes.clear();
+    m_programs.clear();
+    m_context = nullptr;
+    m_frame = nullptr;
+}
+
+
+// Build a program drawing quads with `p_fragment`
+// The fragment shader receives the texture coordinates and layer
+//  as `in vec3 v_coordinates`
+// Deleted by `teardown`
+unsigned int ft::rf::bench::batched_scene::add_program(
+    const std::string & p_fragment,
+    std::vector<std::pair<std::string, std::string>> p_defines)
+{
+    auto source = context::t_program_source{};
+    source.vertex = g_vertex_shader;
+    source.fragment = p_fragment;
+    source.defines = std::move(p_defines);
+
+    const auto program = m_context->create_program(source);
+    m_programs.push_back(program);
+    return program;
+}
+
+
+// Upload quads and get a vertex array drawing them
+// Released by `teardown`
+const ft::rf::bench::batched_scene::t_mesh &
+ft::rf::bench::batched_scene::add_mesh(const std::vector<t_quad> & p_quads)
+{
+    FT_ASSERT(p_quads.empty() == false);
+
+    auto vertices = std::vector<t_vertex>{};
+    auto indices = std::vector<std::uint32_t>{};
+    vertices.reserve(p_quads.size() * 4);
+    indices.reserve(p_quads.size() * 6);
+    for (const auto & quad : p_quads)
+    {
+        const auto first = static_cast<std::uint32_t>(vertices.size());
+        vertices.push_back({ quad.x0, quad.y0, quad.u0, quad.v0, quad.layer });
+        vertices.push_back({ quad.x1, quad.y0, quad.u1, quad.v0, quad.layer });
+        vertices.push_back({ quad.x1, quad.y1, quad.u1, quad.v1, quad.layer });
+        vertices.push_back({ quad.x0, quad.y1, quad.u0, quad.v1, quad.layer });
+        for (const auto corner : { 0u, 1u, 2u, 0u, 2u, 3u }) {
+            indices.push_back(first + corner);
+        }
+    }
+
+    auto mesh = std::make_unique<t_mesh>();
+    mesh->quads = p_quads.size();
+    mesh->vertices = m_heap->allocate(vertices.data(), vertices.size() * sizeof(t_vertex), sizeof(t_vertex));
+    mesh->indices = m_heap->allocate(indices.data(), indices.size() * sizeof(std::uint32_t), sizeof(std::uint32_t));
+
+    // Every quad is drawn with the mesh's base vertex and an offset first index
+    const auto vertex_range = m_heap->get_range(mesh->vertices);
+    const auto index_range = m_heap->get_range(mesh->indices);
+    mesh->base_vertex = vertex_range.get_base_vertex(sizeof(t_vertex));
+    mesh->first_index = index_range.get_first_index(sizeof(std::uint32_t));
+
+    auto desc = context::t_vertex_array_desc{};
+    desc.attributes.push_back({ 0, 2, context::t_attribute_type::float32, false, false, 0, offsetof(t_vertex, x) });
+    desc.attributes.push_back({ 1, 3, context::t_attribute_type::float32, false, false, 0, offsetof(t_vertex, u) });
+    desc.buffers.push_back({ vertex_range.buffer, 0, sizeof(t_vertex), 0 });
+    desc.index_buffer = index_range.buffer;
+    mesh->vertex_array = m_context->acquire_vertex_array(desc);
+
+    m_meshes.push_back(std::move(mesh));
+    return *m_meshes.back();
+}
+
+
+// Replace the quads of a mesh, `p_quads` must have as many quads
+void ft::rf::bench::batched_scene::write_mesh(const t_mesh & p_mesh, const std::vector<t_quad> & p_quads)
+{
+    FT_ASSERT(p_quads.size() == p_mesh.quads);
+
+    auto vertices = std::vector<t_vertex>{};
+    vertices.reserve(p_quads.size() * 4);
+    for (const auto & quad : p_quads)
+    {
+        vertices.push_back({ quad.x0, quad.y0, quad.u0, quad.v0, quad.layer });
+        vertices.push_back({ quad.x1, quad.y0, quad.u1, quad.v0, quad.layer });
+        vertices.push_back({ quad.x1, quad.y1, quad.u1, quad.v1, quad.layer });
+        vertices.push_back({ quad.x0, quad.y1, quad.u0, quad.v1, quad.layer });
+    }
+    m_heap->write(p_mesh.vertices, 0, vertices.data(), vertices.size() * sizeof(t_vertex));
+}
+
+
+// Draw of quad `p_quad` of a mesh
+ft::rf::context::draw_batch::t_draw
+ft::rf::bench::batched_scene::get_draw(const t_mesh & p_mesh, const std::size_t p_quad)
+{
+    FT_ASSERT(p_quad < p_mesh.quads);
+
+    auto draw = context::draw_batch::t_draw{};
+    draw.index_count = 6;
+    draw.first_index = p_mesh.first_index + static_cast<std::uint32_t>(p_quad * 6);
+    draw.base_vertex = p_mesh.base_vertex;
+    return draw;
+}
+
+
+// Draw state using a program and a mesh's vertex array
+ft::rf::context::draw_batch::t_state
+ft::rf::bench::batched_scene::get_state(const unsigned int p_program, const t_mesh & p_mesh)
+{
+    auto state = context::draw_batch::t_state{};
+    state.program = p_program;
+    state.vertex_array = p_mesh.vertex_array;
+    return state;
+}
+
+
+// Constructor
+ft::rf::bench::small_draws_scene::small_draws_scene(const std::size_t p_draws) :
+    m_draws(p_draws)
+{
+    FT_ASSERT(p_draws > 0);
+}
+
+
+std::string ft::rf::bench::small_draws_scene::get_name() const
+{
+    return "small_draws";
+}
+
+
+void ft::rf::bench::small_draws_scene::create()
+{
+    m_mesh = &add_mesh(make_quad_grid(m_draws));
+    const auto program = add_program(g_color_fragment_shader, {
+        { "COLOR", "0.9, 0.6, 0.2, 1.0" },
+        { "ITERATIONS", "0" } });
+    m_state = get_state(program, *m_mesh);
+}
+
+
+void ft::rf::bench::small_draws_scene::draw(render_frame &, const std::uint64_t)
+{
+    for (std::size_t i = 0; i < m_draws; ++i)
+    {
+        m_batch->add(m_state, get_draw(*m_mesh, i));
+    }
+    m_batch->submit();
+}
+
+
+// Constructor
+// Draws `p_layers` quads, each fragment runs `p_iterations` loop iterations
+ft::rf::bench::heavy_fill_scene::heavy_fill_scene(const int p_layers, const int p_iterations) :
+    m_layers(p_layers),
+    m_iterations(p_iterations)
+{
+    FT_ASSERT(p_layers > 0 && p_iterations >= 0);
+}
+
+
+std::string ft::rf::bench::heavy_fill_scene::get_name() const
+{
+    return "heavy_fill";
+}
+
+
+void ft::rf::bench::heavy_fill_scene::create()
+{
+    m_mesh = &add_mesh({ t_quad{} });
+    const auto program = add_program(g_color_fragment_shader, {
+        { "COLOR", "0.4, 0.7, 1.0, 0.25" },
+        { "ITERATIONS", std::to_string(m_iterations) } });
+    m_state = get_state(program, *m_mesh);
+    m_state.blending = context::opengl_context::t_blend_mode::default_transparency;
+}
+
+
+void ft::rf::bench::heavy_fill_scene::draw(render_frame &, const std::uint64_t)
+{
+    for (int i = 0; i < m_layers; ++i)
+    {
+        m_batch->add(m_state, get_draw(*m_mesh, 0));
+    }
+    m_batch->submit();
+}
+
+
+// Constructor
+ft::rf::bench::state_thrash_scene::state_thrash_scene(const std::size_t p_draws) :
+    m_draws(p_draws)
+{
+    FT_ASSERT(p_draws > 0);
+}
+
+
+std::string ft::rf::bench::state_thrash_scene::get_name() const
+{
+    return "state_thrash";
+}
+
+
+void ft::rf::bench::state_thrash_scene::create()
+{
+    using t_blend_mode = context::opengl_context::t_blend_mode;
+    using t_culling_mode = context::opengl_context::t_culling_mode;
+
+    m_mesh = &add_mesh(make_quad_grid(m_draws));
+
+    for (std::size_t i = 0; i < g_thrash_textures; ++i)
+    {
+        const auto shade = static_cast<std::uint8_t>(255 - i * 16);
+        m_textures.push_back(create_checker_texture(*m_context, g_thrash_texture_size,
+            { shade, static_cast<std::uint8_t>(i * 32), static_cast<std::uint8_t>(255 - shade), 255 }));
+    }
+
+    for (const auto color : g_thrash_colors)
+    {
+        const auto program = add_program(g_texture_fragment_shader, { { "COLOR", color } });
+        for (const auto texture : m_textures)
+        {
+            for (const auto blending : { t_blend_mode::disabled, t_blend_mode::default_transparency })
+            {
+                for (const auto culling : { t_culling_mode::no_culling, t_culling_mode::back_culling })
+                {
+                    auto state = get_state(program, *m_mesh);
+                    state.textures[0] = texture;
+                    state.blending = blending;
+                    state.culling = culling;
+                    m_states.push_back(state);
+                }
+            }
+        }
+    }
+}
+
+
+void ft::rf::bench::state_thrash_scene::destroy()
+{
+    for (const auto texture : m_textures)
+    {
+        m_context->delete_texture(texture);
+    }
+    m_textures.clear();
+    m_states.clear();
+}
+
+
+void ft::rf::bench::state_thrash_scene::draw(render_frame &, const std::uint64_t p_index)
+{
+    // Consecutive draws never share a state and the order shifts every frame
+    auto state = static_cast<std::size_t>(p_index % m_states.size());
+    for (std::size_t i = 0; i < m_draws; ++i)
+    {
+        m_batch->add(m_states[state], get_draw(*m_mesh, i));
+        state = (state + g_thrash_step) % m_states.size();
+
+        if ((i + 1) % g_thrash_group == 0) {
+            m_batch->submit();
+        }
+    }
+    m_batch->submit();
+}
+
+
+// Constructor
+// Replaces `p_images` images of `p_size` x `p_size` pixels per frame
+ft::rf::bench::texture_streaming_scene::texture_streaming_scene(const std::size_t p_images, const int p_size) :
+    m_images(p_images),
+    m_size(p_size)
+{
+    FT_ASSERT(p_images > 0 && p_size > 0);
+}
+
+
+// Destructor
+ft::rf::bench::texture_streaming_scene::~texture_streaming_scene() = default;
+
+
+std::string ft::rf::bench::texture_streaming_scene::get_name() const
+{
+    return "texture_streaming";
+}
+
+
+void ft::rf::bench::texture_streaming_scene::create()
+{
+    // Replaced images take new room, the layers filled by the previous
+    //  frames are evicted while the current frame fills another
+    auto params = context::t_texture_atlas_params{};
+    params.size = std::max(params.size, m_size + 2 * params.padding);
+    const auto per_row = static_cast<std::size_t>(params.size / (m_size + 2 * params.padding));
+    const auto per_layer = per_row * per_row;
+    params.layers = static_cast<int>(((m_images + per_layer - 1) / per_layer) * 2 + 1);
+    m_atlas = std::make_unique<context::texture_atlas>(*m_context, params);
+
+    const auto pixel_count = static_cast<std::size_t>(m_size) * m_size;
+    for (std::size_t set = 0; set < 2; ++set)
+    {
+        auto & pixels = m_pixels[set];
+        pixels.resize(pixel_count * 4);
+        for (std::size_t i = 0; i < pixel_count; ++i)
+        {
+            const auto x = i % m_size;
+            const auto y = i / m_size;
+            pixels[i * 4 + 0] = static_cast<std::uint8_t>(x + set * 128);
+            pixels[i * 4 + 1] = static_cast<std::uint8_t>(y);
+            pixels[i * 4 + 2] = static_cast<std::uint8_t>((x ^ y) + set * 64);
+            pixels[i * 4 + 3] = 255;
+        }
+    }
+
+    m_quads = make_quad_grid(m_images);
+    m_mesh = &add_mesh(m_quads);
+    m_state = get_state(add_program(g_array_texture_fragment_shader), *m_mesh);
+}
+
+
+void ft::rf::bench::texture_streaming_scene::destroy()
+{
+    m_atlas.reset();
+}
+
+
+void ft::rf::bench::texture_streaming_scene::draw(render_frame &, const std::uint64_t p_index)
+{
+    m_atlas->next_frame();
+
+    // Replace every image, which can move them in the atlas
+    const auto & pixels = m_pixels[p_index % 2];
+    for (std::size_t i = 0; i < m_images; ++i)
+    {
+        const auto region = m_atlas->insert(i, m_size, m_size, pixels.data());
+        auto & quad = m_quads[i];
+        quad.u0 = region.u0;
+        quad.v0 = region.v0;
+        quad.u1 = region.u1;
+        quad.v1 = region.v1;
+        quad.layer = static_cast<float>(region.layer);
+    }
+    write_mesh(*m_mesh, m_quads);
+    m_atlas->flush();
+
+    {
+        // The draw batch only binds 2D textures, the array texture is
+        //  bound to unit 0 beside them
+        auto active = context::make_current{ *m_context };
+        call_opengl<err::context_edit_error>(glActiveTexture, GL_TEXTURE0);
+        call_opengl<err::context_edit_error>(glBindTexture, GL_TEXTURE_2D_ARRAY, m_atlas->get_texture());
+    }
+
+    for (std::size_t i = 0; i < m_images; ++i)
+    {
+        m_batch->add(m_state, get_draw(*m_mesh, i));
+    }
+    m_batch->submit();
+}
+
+
+// Constructor
+ft::rf::bench::readback_scene::readback_scene() = default;
+
+
+// Destructor
+ft::rf::bench::readback_scene::~readback_scene() = default;
+
+
+std::string ft::rf::bench::readback_scene::get_name() const
+{
+    return "readback";
+}
+
+
+void ft::rf::bench::readback_scene::create()
+{
+    m_mesh = &add_mesh(make_quad_grid(64));
+    const auto program = add_program(g_color_fragment_shader, {
+        { "COLOR", "0.2, 0.9, 0.5, 1.0" },
+        { "ITERATIONS", "0" } });
+    m_state = get_state(program, *m_mesh);
+
+    m_received = 0;
+    m_sink = std::make_shared<counting_sink>(m_received);
+    m_frame->add_frame_sink(m_sink);
+}
+
+
+void ft::rf::bench::readback_scene::destroy()
+{
+    m_frame->remove_frame_sink(*m_sink);
+    m_sink.reset();
+}
+
+
+void ft::rf::bench::readback_scene::draw(render_frame &, const std::uint64_t)
+{
+    for (std::size_t i = 0; i < m_mesh->quads; ++i)
+    {
+        m_batch->add(m_state, get_draw(*m_mesh, i));
+    }
+    m_batch->submit();
+}
+
+
+// Number of frames that reached the sink
+std::uint64_t ft::rf::bench::readback_scene::get_received_count() const
+{
+    return m_received;
+}
+
+
+// Constructor
+ft::rf::bench::object_draws_scene::object_draws_scene(const t_submission p_submission, const std::size_t p_objects) :
+    m_submission(p_submission),
+    m_objects(p_objects)
+{
+    FT_ASSERT(p_objects > 0);
+}
+
+
+std::string ft::rf::bench::object_draws_scene::get_name() const
+{
+    return (m_submission == t_submission::naive) ? "object_draws_naive" : "object_draws_batched";
+}
+
+
+std::size_t ft::rf::bench::object_draws_scene::get_draws_per_frame() const
+{
+    return m_objects;
+}
+
+
+void ft::rf::bench::object_draws_scene::create()
+{
+    m_mesh = &add_mesh(make_quad_grid(m_objects));
+
+    for (std::size_t i = 0; i < g_object_textures; ++i)
+    {
+        const auto shade = static_cast<std::uint8_t>(255 - i * 48);
+        m_textures.push_back(create_checker_texture(*m_context, g_object_texture_size,
+            { shade, 255, static_cast<std::uint8_t>(255 - shade), 255 }));
+    }
+
+    for (const auto color : g_thrash_colors)
+    {
+        const auto program = add_program(g_texture_fragment_shader, { { "COLOR", color } });
+        for (const auto texture : m_textures)
+        {
+            auto state = get_state(program, *m_mesh);
+            state.textures[0] = texture;
+            m_states.push_back(state);
+        }
+    }
+}
+
+
+void ft::rf::bench::object_draws_scene::destroy()
+{
+    for (const auto texture : m_textures)
+    {
+        m_context->delete_texture(texture);
+    }
+    m_textures.clear();
+    m_states.clear();
+}
+
+
+void ft::rf::bench::object_draws_scene::draw(render_frame &, const std::uint64_t)
+{
+    // Neighbouring objects never share a state
+    if (m_submission == t_submission::batched)
+    {
+        for (std::size_t i = 0; i < m_objects; ++i)
+        {
+            m_batch->add(m_states[i % m_states.size()], get_draw(*m_mesh, i));
+        }
+        m_batch->submit();
+        return;
+    }
+
+    // The states only differ by program and texture, the context's modes
+    //  are set once
+    auto active = context::make_current{ *m_context };
+    const auto & modes = m_states.front();
+    m_context->set_blending_mode(modes.blending);
+    m_context->set_depth_test_mode(modes.depth);
+    m_context->set_culling_mode(modes.culling);
+    m_context->set_polygon_mode(modes.polygon);
+    call_opengl<err::context_edit_error>(glActiveTexture, GL_TEXTURE0);
+
+    for (std::size_t i = 0; i < m_objects; ++i)
+    {
+        const auto & state = m_states[i % m_states.size()];
+        const auto command = get_draw(*m_mesh, i);
+
+        call_opengl<err::context_edit_error>(glUseProgram, state.program);
+        call_opengl<err::context_edit_error>(glBindVertexArray, state.vertex_array);
+        call_opengl<err::context_edit_error>(glBindTexture, GL_TEXTURE_2D, state.textures[0]);
+        call_opengl<err::context_edit_error>(
+            glDrawElementsInstancedBaseVertexBaseInstance,
+            GL_TRIANGLES,
+            static_cast<GLsizei>(command.index_count),
+            GL_UNSIGNED_INT,
+            reinterpret_cast<const void*>(static_cast<std::size_t>(command.first_index) * sizeof(std::uint32_t)),
+            static_cast<GLsizei>(command.instance_count),
+            static_cast<GLint>(command.base_vertex),
+            static_cast<GLuint>(command.base_instance));
+    }
+}
+
+
+// Every scene above with its default parameters
+std::vector<std::shared_ptr<ft::rf::bench::bench_scene>> ft::rf::bench::make_default_scenes()
+{
+    return {
+        std::make_shared<small_draws_scene>(),
+        std::make_shared<heavy_fill_scene>(),
+        std::make_shared<state_thrash_scene>(),
+        std::make_shared<texture_streaming_scene>(),
+        std::make_shared<readback_scene>(),
+        std::make_shared<object_draws_scene>(object_draws_scene::t_submission::naive),
+        std::make_shared<object_draws_scene>(object_draws_scene::t_submission::batched)
+    };
+}
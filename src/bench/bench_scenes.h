@@ -0,0 +1,326 @@
+#pragma once
+
+// Synthetic scenes covering the library's main frame costs
+// The scenes only use the library's own drawing paths : quads live in a
+//  buffer_heap, vertex arrays come from the context's object caches and
+//  every draw goes through a draw_batch, except the naive object draws
+//  kept as the reference the batching is measured against
+
+// project headers
+#include "bench_scene.h"
+#include "opengl_context/draw_batch.h"
+
+// standard headers
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ft {
+namespace rf {
+
+// Forward declaration
+namespace context {
+    class buffer_heap;
+    class texture_atlas;
+}
+class frame_sink;
+
+namespace bench {
+
+// A rectangle in normalized device coordinates and the texture
+//  coordinates of its corners
+struct t_quad
+{
+    float x0 = -1.f;
+    float y0 = -1.f;
+    float x1 = 1.f;
+    float y1 = 1.f;
+
+    float u0 = 0.f;
+    float v0 = 0.f;
+    float u1 = 1.f;
+    float v1 = 1.f;
+
+    // Layer of an array texture
+    float layer = 0.f;
+
+};  // struct t_quad
+
+// `p_count` quads of a grid covering the whole frame, row by row
+std::vector<t_quad> make_quad_grid(const std::size_t p_count);
+
+
+// Base of the built-in scenes
+// Creates the objects every scene needs on setup and releases everything
+//  the scene added on teardown
+class batched_scene : public bench_scene
+{
+public:
+    // Destructor
+    ~batched_scene() override;
+
+    // Create the buffer heap and draw batch, then the scene's objects
+    void setup(render_frame& p_frame) override;
+
+    // Release the scene's objects, then the buffer heap and draw batch
+    void teardown(render_frame& p_frame) override;
+
+protected:
+    // Quads uploaded to the buffer heap
+    struct t_mesh {
+        std::uint64_t vertices = 0;
+        std::uint64_t indices = 0;
+        std::size_t quads = 0;
+        unsigned int vertex_array = 0;
+        std::int32_t base_vertex = 0;
+        std::uint32_t first_index = 0;
+    };
+
+    // Constructor
+    batched_scene();
+
+    // Create the scene's objects, the context is active
+    virtual void create() = 0;
+
+    // Release what `create` made other than programs and meshes
+    virtual void destroy() {}
+
+    // Build a program drawing quads with `p_fragment`
+    // The fragment shader receives the texture coordinates and layer
+    //  as `in vec3 v_coordinates`
+    // Deleted by `teardown`
+    unsigned int add_program(
+        const std::string& p_fragment,
+        std::vector<std::pair<std::string, std::string>> p_defines = {});
+
+    // Upload quads and get a vertex array drawing them
+    // Released by `teardown`
+    const t_mesh& add_mesh(const std::vector<t_quad>& p_quads);
+
+    // Replace the quads of a mesh, `p_quads` must have as many quads
+    void write_mesh(const t_mesh& p_mesh, const std::vector<t_quad>& p_quads);
+
+    // Draw of quad `p_quad` of a mesh
+    static context::draw_batch::t_draw get_draw(const t_mesh& p_mesh, const std::size_t p_quad);
+
+    // Draw state using a program and a mesh's vertex array
+    static context::draw_batch::t_state get_state(const unsigned int p_program, const t_mesh& p_mesh);
+
+protected:
+    // Frame and context of the running benchmark
+    render_frame* m_frame = nullptr;
+    context::opengl_context* m_context = nullptr;
+
+    // Vertices and indices of every mesh
+    std::unique_ptr<context::buffer_heap> m_heap;
+
+    // Draws of the current frame
+    std::unique_ptr<context::draw_batch> m_batch;
+
+private:
+    // Programs and meshes to release
+    std::vector<unsigned int> m_programs;
+    std::vector<std::unique_ptr<t_mesh>> m_meshes;
+
+};  // class batched_scene
+
+
+// Many small quads sharing one state, measures the CPU cost of a draw
+class small_draws_scene : public batched_scene
+{
+public:
+    // Constructor
+    explicit small_draws_scene(const std::size_t p_draws = 10000);
+
+    std::string get_name() const override;
+    void draw(render_frame& p_frame, const std::uint64_t p_index) override;
+
+private:
+    void create() override;
+
+private:
+    // Quads drawn every frame
+    std::size_t m_draws = 0;
+
+    const t_mesh* m_mesh = nullptr;
+    context::draw_batch::t_state m_state;
+
+};  // class small_draws_scene
+
+
+// Blended full frame quads with an arithmetic heavy fragment shader,
+//  measures fill rate
+class heavy_fill_scene : public batched_scene
+{
+public:
+    // Constructor
+    // Draws `p_layers` quads, each fragment runs `p_iterations` loop iterations
+    heavy_fill_scene(const int p_layers = 16, const int p_iterations = 32);
+
+    std::string get_name() const override;
+    void draw(render_frame& p_frame, const std::uint64_t p_index) override;
+
+private:
+    void create() override;
+
+private:
+    int m_layers = 0;
+    int m_iterations = 0;
+
+    const t_mesh* m_mesh = nullptr;
+    context::draw_batch::t_state m_state;
+
+};  // class heavy_fill_scene
+
+
+// Quads cycling through programs, textures, blending and culling in an
+//  order that changes every frame, submitted in small groups so sorting
+//  can't merge them, measures the cost of state changes
+class state_thrash_scene : public batched_scene
+{
+public:
+    // Constructor
+    explicit state_thrash_scene(const std::size_t p_draws = 2000);
+
+    std::string get_name() const override;
+    void draw(render_frame& p_frame, const std::uint64_t p_index) override;
+
+private:
+    void create() override;
+    void destroy() override;
+
+private:
+    std::size_t m_draws = 0;
+
+    const t_mesh* m_mesh = nullptr;
+
+    // Every combination of program, texture, blending and culling
+    std::vector<context::draw_batch::t_state> m_states;
+
+    // Small textures the states pick from
+    std::vector<unsigned int> m_textures;
+
+};  // class state_thrash_scene
+
+
+// Replaces images of a texture_atlas every frame and draws them,
+//  measures texture uploads
+class texture_streaming_scene : public batched_scene
+{
+public:
+    // Constructor
+    // Replaces `p_images` images of `p_size` x `p_size` pixels per frame
+    texture_streaming_scene(const std::size_t p_images = 16, const int p_size = 256);
+
+    // Destructor
+    ~texture_streaming_scene() override;
+
+    std::string get_name() const override;
+    void draw(render_frame& p_frame, const std::uint64_t p_index) override;
+
+private:
+    void create() override;
+    void destroy() override;
+
+private:
+    std::size_t m_images = 0;
+    int m_size = 0;
+
+    const t_mesh* m_mesh = nullptr;
+    context::draw_batch::t_state m_state;
+
+    // Atlas the images are streamed to
+    std::unique_ptr<context::texture_atlas> m_atlas;
+
+    // Two sets of pixels, alternated every frame so each upload changes the image
+    std::array<std::vector<std::uint8_t>, 2> m_pixels;
+
+    // Quads of the images, updated with their atlas regions
+    std::vector<t_quad> m_quads;
+
+};  // class texture_streaming_scene
+
+
+// A light scene whose every frame is read back through a frame_sink,
+//  measures the read back path
+class readback_scene : public batched_scene
+{
+public:
+    // Constructor
+    readback_scene();
+
+    // Destructor
+    ~readback_scene() override;
+
+    std::string get_name() const override;
+    void draw(render_frame& p_frame, const std::uint64_t p_index) override;
+
+    // Number of frames that reached the sink
+    std::uint64_t get_received_count() const;
+
+private:
+    void create() override;
+    void destroy() override;
+
+private:
+    const t_mesh* m_mesh = nullptr;
+    context::draw_batch::t_state m_state;
+
+    // Receives the frames read back and counts them
+    std::shared_ptr<frame_sink> m_sink;
+    std::uint64_t m_received = 0;
+
+};  // class readback_scene
+
+
+// Many objects cycling through a few states, either issued one draw call
+//  per object with its whole state or sorted by a draw_batch
+// The pair measures the draws per second batching gains
+class object_draws_scene : public batched_scene
+{
+public:
+    // How the objects reach OpenGL
+    enum class t_submission {
+        // Bind every object's state and draw it on its own
+        naive,
+
+        // Queue every object in the draw batch and submit it once
+        batched
+    };
+
+    // Constructor
+    explicit object_draws_scene(const t_submission p_submission, const std::size_t p_objects = 50000);
+
+    std::string get_name() const override;
+    void draw(render_frame& p_frame, const std::uint64_t p_index) override;
+    std::size_t get_draws_per_frame() const override;
+
+private:
+    void create() override;
+    void destroy() override;
+
+private:
+    t_submission m_submission = t_submission::batched;
+    std::size_t m_objects = 0;
+
+    const t_mesh* m_mesh = nullptr;
+
+    // Every combination of program and texture, objects use them in turn
+    std::vector<context::draw_batch::t_state> m_states;
+
+    // Small textures the states pick from
+    std::vector<unsigned int> m_textures;
+
+};  // class object_draws_scene
+
+
+// Every scene above with its default parameters
+std::vector<std::shared_ptr<bench_scene>> make_default_scenes();
+
+}   // namespace bench
+}   // namespace rf
+}   // namespace ft
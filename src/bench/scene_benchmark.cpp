@@ -0,0 +1,588 @@
+#include "scene_benchmark.h"
+
+// project headers
+#include "opengl_context/call_opengl_function.h"
+#include "opengl_context/gl_dispatch.h"
+#include "opengl_context/make_current.h"
+#include "opengl_context/opengl_context.h"
+#include "renderframe/renderframe.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <istream>
+#include <iterator>
+#include <numeric>
+#include <ostream>
+#include <string_view>
+
+namespace {
+
+// Deepest nesting accepted when reading results
+constexpr int g_max_depth = 16;
+
+// A parsed JSON value
+struct t_json_value {
+    enum class t_kind {
+        null,
+        boolean,
+        number,
+        string,
+        array,
+        object
+    };
+
+    t_kind kind = t_kind::null;
+    bool boolean = false;
+    double number = 0.;
+    std::string string;
+
+    // Elements of an array, or values of an object's members
+    std::vector<t_json_value> elements;
+
+    // Names of an object's members, in the order of `elements`
+    std::vector<std::string> names;
+};
+
+// Position in the JSON being read
+struct t_cursor {
+    std::string_view text;
+    std::size_t position = 0;
+};
+
+
+[[noreturn]] void throw_format(const t_cursor & p_cursor, const char * p_message)
+{
+    throw ft::rf::bench::t_except_bench_format(
+        std::string(p_message) + " at offset " + std::to_string(p_cursor.position));
+}
+
+
+void skip_space(t_cursor & p_cursor)
+{
+    while (p_cursor.position < p_cursor.text.size())
+    {
+        const auto c = p_cursor.text[p_cursor.position];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        ++p_cursor.position;
+    }
+}
+
+
+// Skip spaces and consume `p_char` if it is next
+bool consume(t_cursor & p_cursor, const char p_char)
+{
+    skip_space(p_cursor);
+    if (p_cursor.position < p_cursor.text.size() && p_cursor.text[p_cursor.position] == p_char)
+    {
+        ++p_cursor.position;
+        return true;
+    }
+    return false;
+}
+
+
+void expect(t_cursor & p_cursor, const char p_char)
+{
+    if (consume(p_cursor, p_char) == false)
+    {
+        throw_format(p_cursor, "Unexpected character");
+    }
+}
+
+
+// Append a code point as UTF-8
+void append_utf8(std::string & p_string, const std::uint32_t p_code)
+{
+    if (p_code < 0x80)
+    {
+        p_string += static_cast<char>(p_code);
+    }
+    else if (p_code < 0x800)
+    {
+        p_string += static_cast<char>(0xC0 | (p_code >> 6));
+        p_string += static_cast<char>(0x80 | (p_code & 0x3F));
+    }
+    else
+    {
+        p_string += static_cast<char>(0xE0 | (p_code >> 12));
+        p_string += static_cast<char>(0x80 | ((p_code >> 6) & 0x3F));
+        p_string += static_cast<char>(0x80 | (p_code & 0x3F));
+    }
+}
+
+
+// Read a string, the opening quote must be next
+// Surrogate pairs are kept as two code points
+std::string read_string(t_cursor & p_cursor)
+{
+    expect(p_cursor, '"');
+
+    auto result = std::string{};
+    const auto & text = p_cursor.text;
+    while (true)
+    {
+        if (p_cursor.position >= text.size())
+        {
+            throw_format(p_cursor, "Unterminated string");
+        }
+
+        const auto c = text[p_cursor.position++];
+        if (c == '"')
+        {
+            return result;
+        }
+        if (c != '\\')
+        {
+            result += c;
+            continue;
+        }
+
+        if (p_cursor.position >= text.size())
+        {
+            throw_format(p_cursor, "Unterminated string");
+        }
+        switch (const auto escaped = text[p_cursor.position++])
+        {
+        case '"':
+        case '\\':
+        case '/':
+            result += escaped;
+            break;
+        case 'b': result += '\b'; break;
+        case 'f': result += '\f'; break;
+        case 'n': result += '\n'; break;
+        case 'r': result += '\r'; break;
+        case 't': result += '\t'; break;
+        case 'u':
+        {
+            auto code = std::uint32_t{ 0 };
+            const auto * first = text.data() + p_cursor.position;
+            const auto * last = first + std::min<std::size_t>(4, text.size() - p_cursor.position);
+            const auto [end, error] = std::from_chars(first, last, code, 16);
+            if (error != std::errc{} || end != first + 4)
+            {
+                throw_format(p_cursor, "Invalid escape sequence");
+            }
+            p_cursor.position += 4;
+            append_utf8(result, code);
+            break;
+        }
+        default:
+            throw_format(p_cursor, "Invalid escape sequence");
+        }
+    }
+}
+
+
+t_json_value read_value(t_cursor & p_cursor, const int p_depth)
+{
+    if (p_depth > g_max_depth)
+    {
+        throw_format(p_cursor, "Nesting is too deep");
+    }
+
+    skip_space(p_cursor);
+    if (p_cursor.position >= p_cursor.text.size())
+    {
+        throw_format(p_cursor, "Unexpected end");
+    }
+
+    auto result = t_json_value{};
+    const auto rest = p_cursor.text.substr(p_cursor.position);
+    const auto c = rest.front();
+
+    if (c == '{')
+    {
+        result.kind = t_json_value::t_kind::object;
+        ++p_cursor.position;
+        if (consume(p_cursor, '}'))
+        {
+            return result;
+        }
+        do
+        {
+            skip_space(p_cursor);
+            result.names.push_back(read_string(p_cursor));
+            expect(p_cursor, ':');
+            result.elements.push_back(read_value(p_cursor, p_depth + 1));
+        } while (consume(p_cursor, ','));
+        expect(p_cursor, '}');
+    }
+    else if (c == '[')
+    {
+        result.kind = t_json_value::t_kind::array;
+        ++p_cursor.position;
+        if (consume(p_cursor, ']'))
+        {
+            return result;
+        }
+        do
+        {
+            result.elements.push_back(read_value(p_cursor, p_depth + 1));
+        } while (consume(p_cursor, ','));
+        expect(p_cursor, ']');
+    }
+    else if (c == '"')
+    {
+        result.kind = t_json_value::t_kind::string;
+        result.string = read_string(p_cursor);
+    }
+    else if (rest.starts_with("true") || rest.starts_with("false"))
+    {
+        result.kind = t_json_value::t_kind::boolean;
+        result.boolean = (c == 't');
+        p_cursor.position += result.boolean ? 4 : 5;
+    }
+    else if (rest.starts_with("null"))
+    {
+        p_cursor.position += 4;
+    }
+    else
+    {
+        result.kind = t_json_value::t_kind::number;
+        const auto [end, error] = std::from_chars(rest.data(), rest.data() + rest.size(), result.number);
+        if (error != std::errc{})
+        {
+            throw_format(p_cursor, "Invalid value");
+        }
+        p_cursor.position += static_cast<std::size_t>(end - rest.data());
+    }
+    return result;
+}
+
+
+// Get an object's member of a given kind
+// Raises t_except_bench_format if it is missing or of another kind
+const t_json_value & get_member(
+    const t_json_value & p_object,
+    const std::string_view p_name,
+    const t_json_value::t_kind p_kind)
+{
+    const auto iter = std::find(p_object.names.begin(), p_object.names.end(), p_name);
+    if (iter == p_object.names.end())
+    {
+        throw ft::rf::bench::t_except_bench_format("Missing field \"" + std::string(p_name) + "\"");
+    }
+
+    const auto & member = p_object.elements[static_cast<std::size_t>(iter - p_object.names.begin())];
+    if (member.kind != p_kind)
+    {
+        throw ft::rf::bench::t_except_bench_format("Invalid field \"" + std::string(p_name) + "\"");
+    }
+    return member;
+}
+
+
+double get_number(const t_json_value & p_object, const std::string_view p_name)
+{
+    return get_member(p_object, p_name, t_json_value::t_kind::number).number;
+}
+
+
+// Get a number that may be missing
+// Raises t_except_bench_format if it is of another kind
+double get_optional_number(const t_json_value & p_object, const std::string_view p_name, const double p_default)
+{
+    if (std::find(p_object.names.begin(), p_object.names.end(), p_name) == p_object.names.end())
+    {
+        return p_default;
+    }
+    return get_number(p_object, p_name);
+}
+
+
+// Read a time in milliseconds
+std::chrono::nanoseconds get_milliseconds(const t_json_value & p_object, const std::string_view p_name)
+{
+    return std::chrono::nanoseconds{ std::llround(get_number(p_object, p_name) * 1e6) };
+}
+
+
+// Write a number with a fixed number of decimals, regardless of the locale
+void write_number(std::ostream & p_stream, const double p_value, const int p_decimals = 4)
+{
+    char buffer[64];
+    const auto [end, error] = std::to_chars(
+        std::begin(buffer), std::end(buffer), p_value, std::chars_format::fixed, p_decimals);
+    p_stream.write(buffer, (error == std::errc{}) ? end - buffer : 0);
+}
+
+
+// Write a time in milliseconds
+void write_milliseconds(std::ostream & p_stream, const std::chrono::nanoseconds p_time)
+{
+    write_number(p_stream, static_cast<double>(p_time.count()) / 1e6);
+}
+
+
+// Write a string with its quotes
+void write_string(std::ostream & p_stream, const std::string & p_string)
+{
+    p_stream << '"';
+    for (const auto c : p_string)
+    {
+        if (c == '"' || c == '\\')
+        {
+            p_stream << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            const char digits[] = "0123456789abcdef";
+            p_stream << "\\u00" << digits[(c >> 4) & 0xF] << digits[c & 0xF];
+        }
+        else
+        {
+            p_stream << c;
+        }
+    }
+    p_stream << '"';
+}
+
+}   // anonymous namespace
+
+
+// Run a scene in a new hidden render frame
+ft::rf::bench::t_scene_result ft::rf::bench::run_scene_benchmark(
+    bench_scene & p_scene,
+    const t_scene_benchmark_params & p_params)
+{
+    auto frame_params = t_render_frame_params{};
+    frame_params.window_name = "scene benchmark : " + p_scene.get_name();
+    frame_params.size = { p_params.width, p_params.height };
+    frame_params.present_mode = p_params.present_mode;
+
+    // Every frame is drawn in full, none may be skipped
+    frame_params.damage_tracking = false;
+
+    auto frame = render_frame{ std::move(frame_params) };
+    frame.set_visible(false);
+    auto & gl_context = frame.get_opengl_context();
+
+    auto samples = std::vector<std::chrono::nanoseconds>{};
+    samples.reserve(p_params.frames);
+
+    // GL calls of the measured frames, the teardown's aren't counted
+    auto gl_calls = std::uint64_t{ 0 };
+
+    p_scene.setup(frame);
+    try
+    {
+        // The first frame is measured from the end of the setup
+        auto last_frame_end = std::chrono::steady_clock::now();
+        auto first_gl_calls = context::get_gl_dispatch_counters().calls;
+
+        const auto total = p_params.warmup_frames + p_params.frames;
+        for (std::size_t index = 0; index < total; ++index)
+        {
+            if (frame.start_frame() == false)
+            {
+                throw std::logic_error("Scene benchmark frame was skipped");
+            }
+            p_scene.draw(frame, index);
+            frame.end_frame();
+
+            if (p_params.wait_for_gpu)
+            {
+                auto active = context::make_current{ gl_context };
+                call_opengl<err::context_edit_error>(glFinish);
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            if (index >= p_params.warmup_frames)
+            {
+                samples.push_back(now - last_frame_end);
+            }
+            else
+            {
+                // Measure from the end of the last warm-up frame
+                first_gl_calls = context::get_gl_dispatch_counters().calls;
+            }
+            last_frame_end = now;
+        }
+
+        gl_calls = context::get_gl_dispatch_counters().calls - first_gl_calls;
+    }
+    catch (...)
+    {
+        p_scene.teardown(frame);
+        throw;
+    }
+    p_scene.teardown(frame);
+
+    const auto total_time = std::chrono::duration<double>(
+        std::accumulate(samples.begin(), samples.end(), std::chrono::nanoseconds{ 0 }));
+
+    auto result = t_scene_result{};
+    result.name = p_scene.get_name();
+    if (samples.empty() == false)
+    {
+        const auto count = static_cast<double>(samples.size());
+        result.frames_per_second = (total_time.count() > 0.) ? count / total_time.count() : 0.;
+        result.gl_calls_per_frame = static_cast<double>(gl_calls) / count;
+        result.draws_per_second = result.frames_per_second * static_cast<double>(p_scene.get_draws_per_frame());
+    }
+    result.frame_time = context::make_latency_distribution(samples);
+    return result;
+}
+
+
+// Run scenes one after the other, each in its own render frame
+std::vector<ft::rf::bench::t_scene_result> ft::rf::bench::run_scene_benchmarks(
+    const std::vector<std::shared_ptr<bench_scene>> & p_scenes,
+    const t_scene_benchmark_params & p_params)
+{
+    auto results = std::vector<t_scene_result>{};
+    results.reserve(p_scenes.size());
+    for (const auto & scene : p_scenes)
+    {
+        results.push_back(run_scene_benchmark(*scene, p_params));
+    }
+    return results;
+}
+
+
+// Write results as JSON, frame times in milliseconds
+void ft::rf::bench::write_results_json(std::ostream & p_stream, const std::vector<t_scene_result> & p_results)
+{
+    p_stream << "{\n  \"scenes\": [";
+    for (std::size_t i = 0; i < p_results.size(); ++i)
+    {
+        const auto & result = p_results[i];
+        const auto & time = result.frame_time;
+
+        p_stream << ((i == 0) ? "\n" : ",\n");
+        p_stream << "    {\n      \"name\": ";
+        write_string(p_stream, result.name);
+        p_stream << ",\n      \"frames\": " << time.count;
+        p_stream << ",\n      \"frame_time_ms\": {\n        \"min\": ";
+        write_milliseconds(p_stream, time.min);
+        p_stream << ",\n        \"mean\": ";
+        write_milliseconds(p_stream, time.mean);
+        p_stream << ",\n        \"p50\": ";
+        write_milliseconds(p_stream, time.p50);
+        p_stream << ",\n        \"p95\": ";
+        write_milliseconds(p_stream, time.p95);
+        p_stream << ",\n        \"p99\": ";
+        write_milliseconds(p_stream, time.p99);
+        p_stream << ",\n        \"max\": ";
+        write_milliseconds(p_stream, time.max);
+        p_stream << "\n      },\n      \"fps\": ";
+        write_number(p_stream, result.frames_per_second, 2);
+        p_stream << ",\n      \"gl_calls_per_frame\": ";
+        write_number(p_stream, result.gl_calls_per_frame, 2);
+        p_stream << ",\n      \"draws_per_second\": ";
+        write_number(p_stream, result.draws_per_second, 2);
+        p_stream << "\n    }";
+    }
+    p_stream << (p_results.empty() ? "]\n}\n" : "\n  ]\n}\n");
+}
+
+
+// Read results written by `write_results_json`
+// Raises t_except_bench_format if the JSON is invalid or misses a field,
+//  a missing draws per second reads as 0
+std::vector<ft::rf::bench::t_scene_result> ft::rf::bench::read_results_json(std::istream & p_stream)
+{
+    const auto text = std::string(std::istreambuf_iterator<char>(p_stream), std::istreambuf_iterator<char>());
+
+    auto cursor = t_cursor{ text };
+    const auto document = read_value(cursor, 0);
+    skip_space(cursor);
+    if (cursor.position != text.size())
+    {
+        throw_format(cursor, "Unexpected data after the results");
+    }
+    if (document.kind != t_json_value::t_kind::object)
+    {
+        throw t_except_bench_format("Results must be an object");
+    }
+
+    auto results = std::vector<t_scene_result>{};
+    for (const auto & scene : get_member(document, "scenes", t_json_value::t_kind::array).elements)
+    {
+        if (scene.kind != t_json_value::t_kind::object)
+        {
+            throw t_except_bench_format("Scene results must be objects");
+        }
+        const auto & time = get_member(scene, "frame_time_ms", t_json_value::t_kind::object);
+
+        auto result = t_scene_result{};
+        result.name = get_member(scene, "name", t_json_value::t_kind::string).string;
+        result.frame_time.count = static_cast<std::size_t>(get_number(scene, "frames"));
+        result.frame_time.min = get_milliseconds(time, "min");
+        result.frame_time.mean = get_milliseconds(time, "mean");
+        result.frame_time.p50 = get_milliseconds(time, "p50");
+        result.frame_time.p95 = get_milliseconds(time, "p95");
+        result.frame_time.p99 = get_milliseconds(time, "p99");
+        result.frame_time.max = get_milliseconds(time, "max");
+        result.frames_per_second = get_number(scene, "fps");
+        result.gl_calls_per_frame = get_number(scene, "gl_calls_per_frame");
+        result.draws_per_second = get_optional_number(scene, "draws_per_second", 0.);
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+
+// Find the metrics of `p_results` worse than `p_baseline` by more than
+//  `p_tolerance`, a fraction of the baseline value
+// Frame times and GL calls regress when higher, frames and draws per
+//  second when lower, draws per second only if the baseline has them
+// Scenes of the baseline without a result are reported as "missing",
+//  scenes without a baseline are ignored
+std::vector<ft::rf::bench::t_regression> ft::rf::bench::compare_with_baseline(
+    const std::vector<t_scene_result> & p_results,
+    const std::vector<t_scene_result> & p_baseline,
+    const double p_tolerance)
+{
+    FT_ASSERT(p_tolerance >= 0.);
+
+    auto regressions = std::vector<t_regression>{};
+    for (const auto & baseline : p_baseline)
+    {
+        const auto result = std::find_if(p_results.begin(), p_results.end(), [&baseline](const auto & p_result) {
+            return p_result.name == baseline.name;
+        });
+        if (result == p_results.end())
+        {
+            regressions.push_back({ baseline.name, "missing" });
+            continue;
+        }
+
+        const auto check_higher = [&](const char * p_metric, const double p_baseline_value, const double p_value) {
+            if (p_value > p_baseline_value * (1. + p_tolerance)) {
+                regressions.push_back({ baseline.name, p_metric, p_baseline_value, p_value });
+            }
+        };
+        const auto to_milliseconds = [](const std::chrono::nanoseconds p_time) {
+            return static_cast<double>(p_time.count()) / 1e6;
+        };
+
+        check_higher("p50", to_milliseconds(baseline.frame_time.p50), to_milliseconds(result->frame_time.p50));
+        check_higher("p95", to_milliseconds(baseline.frame_time.p95), to_milliseconds(result->frame_time.p95));
+        check_higher("p99", to_milliseconds(baseline.frame_time.p99), to_milliseconds(result->frame_time.p99));
+        check_higher("gl_calls", baseline.gl_calls_per_frame, result->gl_calls_per_frame);
+
+        if (result->frames_per_second < baseline.frames_per_second * (1. - p_tolerance))
+        {
+            regressions.push_back({ baseline.name, "fps", baseline.frames_per_second, result->frames_per_second });
+        }
+        if (result->draws_per_second < baseline.draws_per_second * (1. - p_tolerance))
+        {
+            regressions.push_back({ baseline.name, "draws_per_second", baseline.draws_per_second, result->draws_per_second });
+        }
+    }
+    return regressions;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+// Runs scenes for a fixed number of frames and measures their frame times
+//
+// Each scene gets its own hidden render_frame, the frames are drawn back
+//  to back without waiting for input, and the time between the end of two
+//  consecutive frames is recorded once the warm-up frames are done
+// Results are written as JSON and compared against a stored baseline so
+//  a regression fails the run instead of going unnoticed
+// The OpenGL implementation is whatever the process loads : a software
+//  driver such as Mesa's llvmpipe makes the run reproducible on machines
+//  without a GPU, and the null dispatch (see gl_dispatch.h) measures the
+//  library's own CPU overhead
+// bench/scene_benchmark_main.cpp drives the built-in scenes, its CTest
+//  test fails when a scene regresses against bench/scene_benchmark_baseline.json
+// That baseline is measured on the llvmpipe machine running the test with
+//  the FT_RF_SCENE_BENCHMARK_BASELINE target, the test is only registered
+//  once it is committed
+
+// project headers
+#include "bench_scene.h"
+#include "renderframe/renderframeparams.h"
+#include "opengl_context/input_latency_tracker.h"
+
+// standard headers
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace bench {
+
+struct t_scene_benchmark_params
+{
+    // Size of the render frames
+    int width = 1280;
+    int height = 720;
+
+    // How frames reach the hidden window
+    // The mailbox mode never waits for the display
+    t_present_mode present_mode = t_present_mode::mailbox;
+
+    // Frames drawn before measuring, to fill caches and pipelines
+    std::size_t warmup_frames = 30;
+
+    // Frames measured
+    std::size_t frames = 300;
+
+    // Wait for the GPU after every frame so its time includes the GPU work
+    // Without it drivers can queue frames and hide their cost
+    bool wait_for_gpu = true;
+
+};  // struct t_scene_benchmark_params
+
+
+// Measurements of a scene
+struct t_scene_result
+{
+    std::string name;
+
+    // Time between the end of consecutive measured frames
+    context::t_latency_distribution frame_time;
+
+    // Measured frames divided by their total time
+    double frames_per_second = 0.;
+
+    // Average OpenGL calls per measured frame
+    double gl_calls_per_frame = 0.;
+
+    // Frames per second times the scene's draws per frame, 0 if the
+    //  scene doesn't count its draws
+    double draws_per_second = 0.;
+
+};  // struct t_scene_result
+
+
+// A metric worse than the baseline by more than the tolerance
+struct t_regression
+{
+    std::string scene;
+
+    // "p50", "p95", "p99", "fps", "draws_per_second", "gl_calls" or
+    //  "missing" if the scene has no result
+    std::string metric;
+
+    // Values in milliseconds for frame times
+    double baseline = 0.;
+    double measured = 0.;
+
+};  // struct t_regression
+
+
+// Raised when results can't be read
+struct t_except_bench_format : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+
+// Run a scene in a new hidden render frame
+t_scene_result run_scene_benchmark(bench_scene& p_scene, const t_scene_benchmark_params& p_params = {});
+
+// Run scenes one after the other, each in its own render frame
+std::vector<t_scene_result> run_scene_benchmarks(
+    const std::vector<std::shared_ptr<bench_scene>>& p_scenes,
+    const t_scene_benchmark_params& p_params = {});
+
+// Write results as JSON, frame times in milliseconds
+void write_results_json(std::ostream& p_stream, const std::vector<t_scene_result>& p_results);
+
+// Read results written by `write_results_json`
+// Raises t_except_bench_format if the JSON is invalid or misses a field,
+//  a missing draws per second reads as 0
+std::vector<t_scene_result> read_results_json(std::istream& p_stream);
+
+// Find the metrics of `p_results` worse than `p_baseline` by more than
+//  `p_tolerance`, a fraction of the baseline value
+// Frame times and GL calls regress when higher, frames and draws per
+//  second when lower, draws per second only if the baseline has them
+// Scenes of the baseline without a result are reported as "missing",
+//  scenes without a baseline are ignored
+std::vector<t_regression> compare_with_baseline(
+    const std::vector<t_scene_result>& p_results,
+    const std::vector<t_scene_result>& p_baseline,
+    const double p_tolerance = 0.1);
+
+}   // namespace bench
+}   // namespace rf
+}   // namespace ft
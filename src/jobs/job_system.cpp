@@ -0,0 +1,352 @@
+#include "job_system.h"
+
+// project headers
+#include "thread_affinity.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// System and deque of the calling worker thread
+thread_local const ft::rf::jobs::job_system* g_worker_system = nullptr;
+thread_local std::size_t g_worker_queue = 0;
+
+}   // anonymous namespace
+
+
+// Constructor
+// Starts the worker threads
+ft::rf::jobs::job_system::job_system(t_job_system_params p_params)
+{
+    if (p_params.threads == 0)
+    {
+        p_params.threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    for (unsigned int i = 0; i < p_params.threads; ++i)
+    {
+        m_queues.push_back(std::make_unique<t_queue>());
+    }
+
+    // Every deque exists before a worker may try to steal from it
+    for (unsigned int i = 0; i < p_params.threads; ++i)
+    {
+        m_workers.emplace_back([this, i, pin = p_params.pin_threads]() {
+            if (pin) {
+                set_current_thread_affinity(i + 1);
+            }
+            run_worker(i);
+        });
+    }
+}
+
+
+// Destructor
+// Runs the queued tasks and stops the worker threads
+ft::rf::jobs::job_system::~job_system()
+{
+    {
+        std::lock_guard<decltype(m_sleep_mutex)> lock{ m_sleep_mutex };
+        m_stop = true;
+    }
+    m_sleep_condition.notify_all();
+
+    for (auto & worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+
+// Number of worker threads
+std::size_t ft::rf::jobs::job_system::get_worker_count() const
+{
+    return m_workers.size();
+}
+
+
+// Number of tasks queued and not started yet
+std::size_t ft::rf::jobs::job_system::get_queued_count() const
+{
+    return m_queued.load(std::memory_order_relaxed);
+}
+
+
+// Number of tasks taken from another worker's deque
+std::uint64_t ft::rf::jobs::job_system::get_steal_count() const
+{
+    return m_steals.load(std::memory_order_relaxed);
+}
+
+
+// Queue a task on the calling worker's deque, or on a worker's
+//  deque in turn if called from another thread
+void ft::rf::jobs::job_system::push(t_task p_task)
+{
+    auto index = get_own_queue();
+    if (index == m_queues.size())
+    {
+        index = m_next_queue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+    }
+
+    {
+        auto & queue = *m_queues[index];
+        std::lock_guard<decltype(queue.mutex)> lock{ queue.mutex };
+        queue.tasks.push_back(std::move(p_task));
+    }
+
+    // Taking the sleep mutex orders the count with a worker's wait
+    {
+        std::lock_guard<decltype(m_sleep_mutex)> lock{ m_sleep_mutex };
+        m_queued.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_sleep_condition.notify_one();
+}
+
+
+// Run one queued task if there is any
+// Returns false if every deque was empty
+bool ft::rf::jobs::job_system::run_one()
+{
+    auto task = t_task{};
+    if (pop(task) == false)
+    {
+        return false;
+    }
+
+    execute(task);
+    return true;
+}
+
+
+// Take a task, from the calling worker's deque first
+bool ft::rf::jobs::job_system::pop(t_task & p_task)
+{
+    const auto own = get_own_queue();
+
+    // Newest task of the own deque, its data is likely still in cache
+    if (own < m_queues.size())
+    {
+        auto & queue = *m_queues[own];
+        std::lock_guard<decltype(queue.mutex)> lock{ queue.mutex };
+        if (queue.tasks.empty() == false)
+        {
+            p_task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // Oldest task of another deque, usually the largest piece of work left
+    const auto first = (own < m_queues.size()) ? own + 1 : 0;
+    for (std::size_t i = 0; i < m_queues.size(); ++i)
+    {
+        const auto index = (first + i) % m_queues.size();
+        if (index == own) {
+            continue;
+        }
+
+        auto & queue = *m_queues[index];
+        std::lock_guard<decltype(queue.mutex)> lock{ queue.mutex };
+        if (queue.tasks.empty() == false)
+        {
+            p_task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            m_steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+// Run a task and report its completion to its group
+void ft::rf::jobs::job_system::execute(t_task & p_task)
+{
+    auto error = std::exception_ptr{};
+    try
+    {
+        p_task.function();
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    // Release the task's captures before the group may be destroyed
+    p_task.function = nullptr;
+    p_task.group->complete(error);
+}
+
+
+// Worker thread entry point
+void ft::rf::jobs::job_system::run_worker(const std::size_t p_index)
+{
+    g_worker_system = this;
+    g_worker_queue = p_index;
+
+    while (true)
+    {
+        if (run_one()) {
+            continue;
+        }
+
+        std::unique_lock<decltype(m_sleep_mutex)> lock{ m_sleep_mutex };
+        m_sleep_condition.wait(lock, [this]() {
+            return m_stop || m_queued.load(std::memory_order_relaxed) > 0;
+        });
+
+        // Queued tasks are run before stopping
+        if (m_stop && m_queued.load(std::memory_order_relaxed) == 0) {
+            break;
+        }
+    }
+}
+
+
+// Index of the calling thread's deque, or `m_queues.size()` if
+//  the thread isn't one of this system's workers
+std::size_t ft::rf::jobs::job_system::get_own_queue() const
+{
+    return (g_worker_system == this) ? g_worker_queue : m_queues.size();
+}
+
+
+// Constructor
+ft::rf::jobs::task_group::task_group(job_system & p_system) :
+    m_system(&p_system)
+{}
+
+
+// Destructor
+// Waits for the group's tasks, their errors are lost
+ft::rf::jobs::task_group::~task_group()
+{
+    try
+    {
+        wait();
+    }
+    catch (...)
+    {
+        // Nothing to report the error to
+    }
+}
+
+
+// Queue a task
+void ft::rf::jobs::task_group::run(std::function<void()> p_task)
+{
+    FT_ASSERT(p_task != nullptr);
+
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    m_system->push({ std::move(p_task), this });
+}
+
+
+// Split [p_begin, p_end) in chunks of at most `p_grain` indices
+//  and queue `p_task(chunk_begin, chunk_end)` for each
+void ft::rf::jobs::task_group::run_range(
+    const std::size_t p_begin,
+    const std::size_t p_end,
+    const std::size_t p_grain,
+    std::function<void(std::size_t, std::size_t)> p_task)
+{
+    FT_ASSERT(p_grain > 0);
+
+    // Shared by the chunks instead of copied into each of them
+    const auto task = std::make_shared<decltype(p_task)>(std::move(p_task));
+    for (auto begin = p_begin; begin < p_end; begin += p_grain)
+    {
+        const auto end = std::min(p_end, begin + p_grain);
+        run([task, begin, end]() { (*task)(begin, end); });
+    }
+}
+
+
+// Run queued tasks until every task of the group completed, then
+//  sleep until the tasks running elsewhere complete
+// Rethrows the first error raised by a task
+void ft::rf::jobs::task_group::wait()
+{
+    while (true)
+    {
+        // Help with any task, the group's tasks may be running elsewhere
+        if (is_done() == false && m_system->run_one())
+        {
+            continue;
+        }
+
+        // Nothing left to run here, only the last completion wakes us
+        std::unique_lock<decltype(m_done_mutex)> lock{ m_done_mutex };
+        m_done_condition.wait(lock, [this]() {
+            return is_done();
+        });
+        break;
+    }
+
+    std::lock_guard<decltype(m_error_mutex)> lock{ m_error_mutex };
+    if (m_error != nullptr)
+    {
+        auto error = std::exchange(m_error, nullptr);
+        std::rethrow_exception(error);
+    }
+}
+
+
+// Is every task of the group completed?
+bool ft::rf::jobs::task_group::is_done() const
+{
+    return m_pending.load(std::memory_order_acquire) == 0;
+}
+
+
+// Get the system running the tasks
+ft::rf::jobs::job_system & ft::rf::jobs::task_group::get_job_system()
+{
+    return *m_system;
+}
+
+
+// Called by job_system when one of the group's tasks completed
+void ft::rf::jobs::task_group::complete(std::exception_ptr p_error)
+{
+    if (p_error != nullptr)
+    {
+        std::lock_guard<decltype(m_error_mutex)> lock{ m_error_mutex };
+        if (m_error == nullptr) {
+            m_error = std::move(p_error);
+        }
+    }
+
+    // Other completions don't need the mutex, nobody waits for them
+    auto pending = m_pending.load(std::memory_order_relaxed);
+    while (pending > 1)
+    {
+        if (m_pending.compare_exchange_weak(pending, pending - 1, std::memory_order_release, std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+
+    // The last completion, a waiter may destroy the group once the
+    //  mutex is released
+    std::lock_guard<decltype(m_done_mutex)> lock{ m_done_mutex };
+    m_pending.fetch_sub(1, std::memory_order_release);
+    m_done_condition.notify_all();
+}
+
+
+// Job system shared by the library, created on first use
+ft::rf::jobs::job_system & ft::rf::jobs::get_default_job_system()
+{
+    static auto system = job_system{ t_job_system_params{} };
+    return system;
+}
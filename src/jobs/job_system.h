@@ -0,0 +1,198 @@
+#pragma once
+
+// Work-stealing task scheduler
+//
+// Each worker thread owns a deque of tasks : it pushes and pops its own
+//  tasks at the back, and idle workers steal from the front of the others'
+// Tasks belong to a task_group, waiting on a group runs queued tasks on
+//  the waiting thread until every task of the group completed
+// render_frame owns a frame scoped group, see render_frame::get_frame_tasks
+
+// standard headers
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace jobs {
+
+// Forward declaration
+class task_group;
+
+struct t_job_system_params
+{
+    // Number of worker threads, 0 uses one per core minus the calling thread
+    unsigned int threads = 0;
+
+    // Pin worker `i` to core `i + 1`, leaving core 0 to the render threads
+    bool pin_threads = false;
+
+};  // struct t_job_system_params
+
+
+class job_system
+{
+public:
+    // Constructor
+    // Starts the worker threads
+    explicit job_system(t_job_system_params p_params);
+
+    // Destructor
+    // Runs the queued tasks and stops the worker threads
+    ~job_system();
+
+    // Prevent copy
+    job_system(const job_system&) = delete;
+    job_system& operator=(const job_system&) = delete;
+
+    // Number of worker threads
+    std::size_t get_worker_count() const;
+
+    // Number of tasks queued and not started yet
+    std::size_t get_queued_count() const;
+
+    // Number of tasks taken from another worker's deque
+    std::uint64_t get_steal_count() const;
+
+private:
+    // A queued task
+    struct t_task {
+        std::function<void()> function;
+        task_group* group = nullptr;
+    };
+
+    // A worker's deque
+    struct t_queue {
+        std::mutex mutex;
+        std::deque<t_task> tasks;
+    };
+
+    // Allow task_group to queue tasks and help running them
+    friend class task_group;
+
+    // Queue a task on the calling worker's deque, or on a worker's
+    //  deque in turn if called from another thread
+    void push(t_task p_task);
+
+    // Run one queued task if there is any
+    // Returns false if every deque was empty
+    bool run_one();
+
+    // Take a task, from the calling worker's deque first
+    bool pop(t_task& p_task);
+
+    // Run a task and report its completion to its group
+    void execute(t_task& p_task);
+
+    // Worker thread entry point
+    void run_worker(const std::size_t p_index);
+
+    // Index of the calling thread's deque, or `m_queues.size()` if
+    //  the thread isn't one of this system's workers
+    std::size_t get_own_queue() const;
+
+private:
+    // One deque per worker
+    std::vector<std::unique_ptr<t_queue>> m_queues;
+
+    // Worker threads
+    std::vector<std::thread> m_workers;
+
+    // Next deque for tasks queued from outside the workers
+    std::atomic<std::size_t> m_next_queue{ 0 };
+
+    // Tasks queued and not started yet
+    std::atomic<std::size_t> m_queued{ 0 };
+
+    // Tasks taken from another worker's deque
+    std::atomic<std::uint64_t> m_steals{ 0 };
+
+    // Idle workers sleep until a task is queued
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_sleep_condition;
+    bool m_stop = false;
+
+};  // class job_system
+
+
+// Tasks that can be waited for together
+class task_group
+{
+public:
+    // Constructor
+    explicit task_group(job_system& p_system);
+
+    // Destructor
+    // Waits for the group's tasks, their errors are lost
+    ~task_group();
+
+    // Prevent copy
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+
+    // Queue a task
+    // Tasks may queue more tasks in their own group
+    void run(std::function<void()> p_task);
+
+    // Split [p_begin, p_end) in chunks of at most `p_grain` indices
+    //  and queue `p_task(chunk_begin, chunk_end)` for each
+    void run_range(
+        const std::size_t p_begin,
+        const std::size_t p_end,
+        const std::size_t p_grain,
+        std::function<void(std::size_t, std::size_t)> p_task);
+
+    // Run queued tasks until every task of the group completed, then
+    //  sleep until the tasks running elsewhere complete
+    // Rethrows the first error raised by a task
+    void wait();
+
+    // Is every task of the group completed?
+    bool is_done() const;
+
+    // Get the system running the tasks
+    job_system& get_job_system();
+
+private:
+    // Allow job_system to report completions
+    friend class job_system;
+
+    // Called by job_system when one of the group's tasks completed
+    void complete(std::exception_ptr p_error);
+
+private:
+    // System running the tasks
+    job_system* m_system = nullptr;
+
+    // Tasks queued and not completed yet
+    std::atomic<std::size_t> m_pending{ 0 };
+
+    // Waiters sleep until the last task completes
+    // The last completion is made under the mutex, so a waiter seeing the
+    //  group done can destroy it
+    std::mutex m_done_mutex;
+    std::condition_variable m_done_condition;
+
+    // First error raised by a task
+    std::mutex m_error_mutex;
+    std::exception_ptr m_error;
+
+};  // class task_group
+
+
+// Job system shared by the library, created on first use
+// Uses one worker per core minus the calling thread
+job_system& get_default_job_system();
+
+}   // namespace jobs
+}   // namespace rf
+}   // namespace ft
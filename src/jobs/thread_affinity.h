@@ -0,0 +1,15 @@
+#pragma once
+
+// Thread placement helpers for the job system
+
+namespace ft {
+namespace rf {
+namespace jobs {
+
+// Restrict the calling thread to the core `p_core`
+// Returns false if the core doesn't exist or if the system refused
+bool set_current_thread_affinity(const unsigned int p_core);
+
+}   // namespace jobs
+}   // namespace rf
+}   // namespace ft
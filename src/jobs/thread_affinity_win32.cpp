@@ -0,0 +1,23 @@
+#include "thread_affinity.h"
+
+// ft_base_lib headers
+#include "base/platform.h"
+#include "base/windows_include.h"
+
+#ifdef FT_OS_WINDOWS
+
+// Restrict the calling thread to the core `p_core`
+// Returns false if the core doesn't exist or if the system refused
+bool ft::rf::jobs::set_current_thread_affinity(const unsigned int p_core)
+{
+    // Affinity masks only cover the calling thread's processor group
+    if (p_core >= sizeof(::DWORD_PTR) * 8)
+    {
+        return false;
+    }
+
+    const auto mask = static_cast<::DWORD_PTR>(1) << p_core;
+    return ::SetThreadAffinityMask(::GetCurrentThread(), mask) != 0;
+}
+
+#endif  // FT_OS_WINDOWS
@@ -0,0 +1,255 @@
+#include "async_program_compiler.h"
+
+// project headers
+#include "call_opengl_function.h"
+#include "make_current.h"
+#include "opengl_context.h"
+#include "program_cache.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// standard headers
+#include <chrono>
+#include <exception>
+#include <optional>
+
+// Has the build completed?
+bool ft::rf::context::t_async_program::is_ready() const
+{
+    return program.valid() &&
+        program.wait_for(std::chrono::seconds{ 0 }) == std::future_status::ready;
+}
+
+
+// The program if it was built successfully
+// `p_fallback` while the build is pending or if it failed
+unsigned int ft::rf::context::t_async_program::get_or(const unsigned int p_fallback) const
+{
+    if (is_ready() == false)
+    {
+        return p_fallback;
+    }
+
+    try
+    {
+        return program.get();
+    }
+    catch (...)
+    {
+        return p_fallback;
+    }
+}
+
+
+// Constructor
+// `p_context` must be active on the calling thread
+ft::rf::context::async_program_compiler::async_program_compiler(opengl_context & p_context) :
+    m_context(p_context)
+{
+    if (GLEW_KHR_parallel_shader_compile != 0)
+    {
+        // Let the driver choose how many compiler threads to use
+        m_driver_parallel = true;
+        call_opengl<err::context_init>(glMaxShaderCompilerThreadsKHR, GLuint{ 0xFFFFFFFF });
+    }
+    else if (GLEW_ARB_parallel_shader_compile != 0)
+    {
+        m_driver_parallel = true;
+        call_opengl<err::context_init>(glMaxShaderCompilerThreadsARB, GLuint{ 0xFFFFFFFF });
+    }
+    else
+    {
+        // Build on a worker thread with a context sharing `p_context`'s objects
+        m_worker_context = std::make_unique<opengl_context>(
+            p_context,
+            opengl_context::t_shared_ctor_tag{});
+        m_worker = std::thread([this]() { run_worker(); });
+    }
+}
+
+
+// Destructor
+// Stops the worker thread, pending builds are abandoned
+ft::rf::context::async_program_compiler::~async_program_compiler()
+{
+    {
+        std::lock_guard<decltype(m_jobs_mutex)> lock{ m_jobs_mutex };
+        m_stop = true;
+    }
+    m_jobs_condition.notify_all();
+
+    if (m_worker.joinable())
+    {
+        m_worker.join();
+    }
+}
+
+
+// Start building a program
+// The context must be active on the calling thread
+// If `p_cache` is provided, the binary is stored in it once built
+ft::rf::context::t_async_program
+ft::rf::context::async_program_compiler::compile(
+    const t_program_source & p_source,
+    program_cache * p_cache)
+{
+    auto pending = t_pending{};
+    pending.source = p_source;
+    pending.cache = p_cache;
+
+    auto result = t_async_program{ pending.promise.get_future().share() };
+    const auto retrievable = p_cache != nullptr;
+
+    if (m_driver_parallel)
+    {
+        // Returns right away, the driver compiles in the background
+        try
+        {
+            pending.build = start_program_build(p_source, retrievable);
+        }
+        catch (...)
+        {
+            pending.promise.set_exception(std::current_exception());
+            return result;
+        }
+    }
+    else
+    {
+        auto job = t_worker_job{ p_source, retrievable, {} };
+        pending.worker_result = job.result.get_future();
+        {
+            std::lock_guard<decltype(m_jobs_mutex)> lock{ m_jobs_mutex };
+            m_jobs.push_back(std::move(job));
+        }
+        m_jobs_condition.notify_one();
+    }
+
+    m_pending.push_back(std::move(pending));
+    return result;
+}
+
+
+// Complete the builds that finished
+// The context must be active on the calling thread
+// Built programs are recorded in the GPU memory tracker
+void ft::rf::context::async_program_compiler::poll()
+{
+    std::size_t i = 0;
+    while (i < m_pending.size())
+    {
+        auto & pending = m_pending[i];
+
+        const auto done = m_driver_parallel ?
+            is_program_build_complete(pending.build) :
+            pending.worker_result.wait_for(std::chrono::seconds{ 0 }) == std::future_status::ready;
+
+        if (done == false)
+        {
+            ++i;
+            continue;
+        }
+
+        try
+        {
+            const auto program = m_driver_parallel ?
+                finish_program_build(pending.build) :
+                pending.worker_result.get();
+
+            // Worker programs were created in a context sharing m_context's objects
+            track_program(m_context, program);
+
+            if (pending.cache != nullptr)
+            {
+                // The program is usable even if its binary can't be stored
+                try {
+                    pending.cache->store(pending.source, program);
+                }
+                catch (...) {}
+            }
+
+            pending.promise.set_value(program);
+        }
+        catch (...)
+        {
+            pending.promise.set_exception(std::current_exception());
+        }
+
+        // Order doesn't matter, swap with the last build
+        if (i + 1 != m_pending.size())
+        {
+            pending = std::move(m_pending.back());
+        }
+        m_pending.pop_back();
+    }
+}
+
+
+// Does the driver build programs in parallel by itself?
+bool ft::rf::context::async_program_compiler::is_driver_parallel() const
+{
+    return m_driver_parallel;
+}
+
+
+// Number of builds not yet completed
+std::size_t ft::rf::context::async_program_compiler::get_pending_count() const
+{
+    return m_pending.size();
+}
+
+
+// Worker thread entry point
+void ft::rf::context::async_program_compiler::run_worker()
+{
+    // If the shared context can't be activated every job fails
+    std::exception_ptr failure;
+    std::optional<make_current<opengl_context>> active;
+    try
+    {
+        active.emplace(*m_worker_context);
+    }
+    catch (...)
+    {
+        failure = std::current_exception();
+    }
+
+    while (true)
+    {
+        auto job = t_worker_job{};
+        {
+            std::unique_lock<decltype(m_jobs_mutex)> lock{ m_jobs_mutex };
+            m_jobs_condition.wait(lock, [this]() {
+                return m_stop || m_jobs.empty() == false;
+            });
+
+            if (m_stop) {
+                return;
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        if (failure != nullptr)
+        {
+            job.result.set_exception(failure);
+            continue;
+        }
+
+        try
+        {
+            const auto program = build_program(job.source, job.retrievable);
+
+            // The program must be complete before another context uses it
+            call_opengl<err::context_edit_error>(glFinish);
+
+            job.result.set_value(program);
+        }
+        catch (...)
+        {
+            job.result.set_exception(std::current_exception());
+        }
+    }
+}
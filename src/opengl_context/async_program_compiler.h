@@ -0,0 +1,124 @@
+#pragma once
+
+// Builds shader programs without blocking the thread that owns the context
+// Uses KHR_parallel_shader_compile when the driver supports it, otherwise
+//  programs are built by a worker thread owning a shared context
+// Results are handed back by `poll`, on the thread that owns the context
+
+// project headers
+#include "shader_program.h"
+
+// standard headers
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+// Forward declaration
+class opengl_context;
+class program_cache;
+
+// A program being built asynchronously
+struct t_async_program
+{
+    // Holds the program's name, or the build error, once the build completes
+    std::shared_future<unsigned int> program;
+
+    // Has the build completed?
+    bool is_ready() const;
+
+    // The program if it was built successfully
+    // `p_fallback` while the build is pending or if it failed
+    unsigned int get_or(const unsigned int p_fallback) const;
+
+};  // struct t_async_program
+
+
+class async_program_compiler
+{
+public:
+    // Constructor
+    // `p_context` must be active on the calling thread
+    explicit async_program_compiler(opengl_context& p_context);
+
+    // Destructor
+    // Stops the worker thread, pending builds are abandoned
+    ~async_program_compiler();
+
+    // Prevent copy
+    async_program_compiler(const async_program_compiler&) = delete;
+    async_program_compiler& operator=(const async_program_compiler&) = delete;
+
+    // Start building a program
+    // The context must be active on the calling thread
+    // If `p_cache` is provided, the binary is stored in it once built
+    t_async_program compile(const t_program_source& p_source, program_cache* p_cache);
+
+    // Complete the builds that finished
+    // The context must be active on the calling thread
+    // Built programs are recorded in the GPU memory tracker
+    void poll();
+
+    // Does the driver build programs in parallel by itself?
+    bool is_driver_parallel() const;
+
+    // Number of builds not yet completed
+    std::size_t get_pending_count() const;
+
+private:
+    // A build waiting to be completed by `poll`
+    struct t_pending {
+        t_program_source source;
+        program_cache* cache = nullptr;
+        std::promise<unsigned int> promise;
+
+        // Driver-side build, with KHR_parallel_shader_compile
+        t_program_build build;
+
+        // Worker-side build, without it
+        std::future<unsigned int> worker_result;
+    };
+
+    // A build to run on the worker thread
+    struct t_worker_job {
+        t_program_source source;
+        bool retrievable = false;
+        std::promise<unsigned int> result;
+    };
+
+    // Worker thread entry point
+    void run_worker();
+
+private:
+    // Context the programs are handed to, and tracked for
+    const opengl_context& m_context;
+
+    // Does the driver build programs in parallel by itself?
+    bool m_driver_parallel = false;
+
+    // Builds waiting to be completed
+    std::vector<t_pending> m_pending;
+
+    // Worker thread and its shared context, without driver support
+    std::unique_ptr<opengl_context> m_worker_context;
+    std::thread m_worker;
+
+    // Jobs for the worker thread
+    std::mutex m_jobs_mutex;
+    std::condition_variable m_jobs_condition;
+    std::deque<t_worker_job> m_jobs;
+    bool m_stop = false;
+
+};  // class async_program_compiler
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
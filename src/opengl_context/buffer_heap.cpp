@@ -0,0 +1,632 @@
+#include "buffer_heap.h"
+
+// project headers
+#include "call_opengl_function.h"
+#include "gpu_memory_tracker.h"
+#include "make_current.h"
+#include "object_caches.h"
+#include "opengl_context.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+#include <bit>
+
+// First vertex of the range in its buffer, for vertices of `p_stride` bytes
+// The range must have been allocated with an alignment of `p_stride`
+std::int32_t ft::rf::context::t_buffer_range::get_base_vertex(const std::size_t p_stride) const
+{
+    FT_ASSERT(p_stride > 0 && offset % p_stride == 0);
+    return static_cast<std::int32_t>(offset / p_stride);
+}
+
+
+// First index of the range in its buffer, for indices of `p_index_size` bytes
+std::uint32_t ft::rf::context::t_buffer_range::get_first_index(const std::size_t p_index_size) const
+{
+    FT_ASSERT(p_index_size > 0 && offset % p_index_size == 0);
+    return static_cast<std::uint32_t>(offset / p_index_size);
+}
+
+
+// Share of the free bytes outside the largest free block, 0 when
+//  every free byte is contiguous
+double ft::rf::context::buffer_heap::t_stats::get_fragmentation() const
+{
+    const auto free_bytes = reserved_bytes - used_bytes;
+    if (free_bytes == 0) {
+        return 0.0;
+    }
+    return 1.0 - static_cast<double>(largest_free_block) / static_cast<double>(free_bytes);
+}
+
+
+// Constructor
+// Pages are created on first use
+ft::rf::context::buffer_heap::buffer_heap(opengl_context & p_context, const t_buffer_heap_params & p_params) :
+    m_context(&p_context),
+    m_params(p_params)
+{
+    FT_ASSERT(p_params.page_size > 0);
+
+    for (auto & lists : m_free_lists) {
+        lists.fill(s_null);
+    }
+}
+
+
+// Destructor
+// Releases every page, handles are no longer valid
+ft::rf::context::buffer_heap::~buffer_heap()
+{
+    auto active = make_current{ *m_context };
+
+    for (auto & page : m_pages)
+    {
+        if (page.buffer != 0)
+        {
+            call_opengl_skip_errors(glDeleteBuffers, 1, &page.buffer);
+            get_gpu_memory_tracker().untrack(*m_context, t_gpu_memory_category::buffer, page.buffer);
+            m_context->notify_object_deleted(t_object_kind::buffer, page.buffer);
+        }
+    }
+}
+
+
+// Reserve `p_size` bytes at an offset multiple of `p_alignment`
+// Creates a page if no free block is large enough
+ft::rf::context::buffer_heap::t_handle
+ft::rf::context::buffer_heap::allocate(const std::size_t p_size, const std::size_t p_alignment)
+{
+    FT_ASSERT(p_size > 0 && p_alignment > 0);
+
+    auto offset = std::size_t{ 0 };
+    auto block = try_place(p_size, p_alignment, offset);
+    if (block == s_null)
+    {
+        // Room for the range wherever the alignment puts it
+        auto active = make_current{ *m_context };
+        const auto page = add_page(p_size + p_alignment - 1);
+        block = place(m_pages[page].first, p_size, p_alignment, offset);
+    }
+
+    const auto handle = m_next_handle++;
+    m_allocations.emplace(handle, t_allocation{ block, offset, p_size, p_alignment });
+    return handle;
+}
+
+
+// Reserve a range and upload `p_size` bytes of `p_data` to it
+ft::rf::context::buffer_heap::t_handle
+ft::rf::context::buffer_heap::allocate(const void* p_data, const std::size_t p_size, const std::size_t p_alignment)
+{
+    const auto handle = allocate(p_size, p_alignment);
+    write(handle, 0, p_data, p_size);
+    return handle;
+}
+
+
+// Release an allocation, unknown handles are ignored
+// The range's block is merged with its free neighbors right away, draws
+//  already issued keep reading the old content since later uploads are
+//  ordered after them
+void ft::rf::context::buffer_heap::free(const t_handle p_handle)
+{
+    const auto found = m_allocations.find(p_handle);
+    if (found == m_allocations.end()) {
+        return;
+    }
+
+    const auto block = found->second.block;
+    m_pages[m_blocks[block].page].used -= m_blocks[block].size;
+    release_block(block);
+    m_allocations.erase(found);
+}
+
+
+// Upload `p_size` bytes at `p_offset` in an allocation
+void ft::rf::context::buffer_heap::write(
+    const t_handle p_handle,
+    const std::size_t p_offset,
+    const void* p_data,
+    const std::size_t p_size)
+{
+    const auto range = get_range(p_handle);
+    FT_ASSERT(range.buffer != 0 && p_offset + p_size <= range.size);
+
+    auto active = make_current{ *m_context };
+
+    call_opengl<err::context_edit_error>(glBindBuffer, GL_COPY_WRITE_BUFFER, range.buffer);
+    call_opengl<err::context_edit_error>(
+        glBufferSubData,
+        GL_COPY_WRITE_BUFFER,
+        static_cast<GLintptr>(range.offset + p_offset),
+        static_cast<GLsizeiptr>(p_size),
+        p_data);
+}
+
+
+// Where an allocation currently lives
+// Can change after `defragment`, query it again once `get_generation` changes
+ft::rf::context::t_buffer_range ft::rf::context::buffer_heap::get_range(const t_handle p_handle) const
+{
+    const auto found = m_allocations.find(p_handle);
+    if (found == m_allocations.end()) {
+        return {};
+    }
+
+    const auto & allocation = found->second;
+    const auto & block = m_blocks[allocation.block];
+    return { m_pages[block.page].buffer, block.offset + allocation.offset, allocation.size };
+}
+
+
+// Incremented every time `defragment` moves an allocation
+std::uint64_t ft::rf::context::buffer_heap::get_generation() const
+{
+    return m_generation;
+}
+
+
+// Empty the least used pages into the free space of the others, then
+//  release the empty pages
+// Stops once about `p_max_bytes` were copied, ranges move on the GPU
+//  with glCopyBufferSubData and are ordered with previous draws
+ft::rf::context::buffer_heap::t_defragment_result
+ft::rf::context::buffer_heap::defragment(const std::uint64_t p_max_bytes)
+{
+    auto result = t_defragment_result{};
+
+    // Pages with allocations, least used first
+    auto order = std::vector<std::uint32_t>{};
+    auto free_bytes = std::uint64_t{ 0 };
+    for (std::uint32_t i = 0; i < m_pages.size(); ++i)
+    {
+        const auto & page = m_pages[i];
+        if (page.buffer != 0 && page.used > 0)
+        {
+            order.push_back(i);
+            free_bytes += page.size - page.used;
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](const std::uint32_t p_left, const std::uint32_t p_right) {
+        return m_pages[p_left].used < m_pages[p_right].used;
+    });
+
+    // Drain pages while the remaining ones have room for their content
+    auto drained_bytes = std::uint64_t{ 0 };
+    for (const auto index : order)
+    {
+        auto & page = m_pages[index];
+        const auto remaining_free = free_bytes - (page.size - page.used);
+        if (drained_bytes + page.used > remaining_free) {
+            break;
+        }
+        page.draining = true;
+        drained_bytes += page.used;
+        free_bytes = remaining_free;
+    }
+
+    auto active = make_current{ *m_context };
+
+    for (auto & entry : m_allocations)
+    {
+        auto & allocation = entry.second;
+        if (result.moved_bytes >= p_max_bytes) {
+            break;
+        }
+
+        const auto old_block = allocation.block;
+        const auto old_page = m_blocks[old_block].page;
+        if (m_pages[old_page].draining == false) {
+            continue;
+        }
+
+        // Free space can be too fragmented for this range, it stays
+        auto offset = std::size_t{ 0 };
+        const auto new_block = try_place(allocation.size, allocation.alignment, offset);
+        if (new_block == s_null) {
+            continue;
+        }
+
+        call_opengl<err::context_edit_error>(glBindBuffer, GL_COPY_READ_BUFFER, m_pages[old_page].buffer);
+        call_opengl<err::context_edit_error>(glBindBuffer, GL_COPY_WRITE_BUFFER, m_pages[m_blocks[new_block].page].buffer);
+        call_opengl<err::context_edit_error>(
+            glCopyBufferSubData,
+            GL_COPY_READ_BUFFER,
+            GL_COPY_WRITE_BUFFER,
+            static_cast<GLintptr>(m_blocks[old_block].offset + allocation.offset),
+            static_cast<GLintptr>(m_blocks[new_block].offset + offset),
+            static_cast<GLsizeiptr>(allocation.size));
+
+        m_pages[old_page].used -= m_blocks[old_block].size;
+        release_block(old_block);
+        allocation.block = new_block;
+        allocation.offset = offset;
+
+        ++result.moved_allocations;
+        result.moved_bytes += allocation.size;
+    }
+
+    for (auto & page : m_pages) {
+        page.draining = false;
+    }
+
+    if (result.moved_allocations > 0) {
+        ++m_generation;
+    }
+    result.released_pages = trim();
+    return result;
+}
+
+
+// Release the pages without allocations
+// Returns the number of pages released
+std::size_t ft::rf::context::buffer_heap::trim()
+{
+    auto active = make_current{ *m_context };
+
+    std::size_t released = 0;
+    for (auto & page : m_pages)
+    {
+        if (page.buffer != 0 && page.used == 0)
+        {
+            release_page(page);
+            ++released;
+        }
+    }
+    return released;
+}
+
+
+// Get the current state of the heap
+ft::rf::context::buffer_heap::t_stats ft::rf::context::buffer_heap::get_stats() const
+{
+    auto stats = t_stats{};
+    stats.allocations = m_allocations.size();
+    for (const auto & page : m_pages)
+    {
+        if (page.buffer != 0)
+        {
+            ++stats.pages;
+            stats.reserved_bytes += page.size;
+            stats.used_bytes += page.used;
+        }
+    }
+    for (const auto & block : m_blocks)
+    {
+        if (block.free && block.unused == false)
+        {
+            ++stats.free_blocks;
+            stats.largest_free_block = std::max<std::uint64_t>(stats.largest_free_block, block.size);
+        }
+    }
+    return stats;
+}
+
+
+// Size class of a free block of `p_size` bytes
+// Small sizes map linearly to the first class, larger ones to the power
+//  of two below them and one of its 16 steps
+void ft::rf::context::buffer_heap::get_class(const std::size_t p_size, unsigned int & p_first, unsigned int & p_second)
+{
+    const auto units = p_size / s_granularity;
+    if (units < s_second_level_count)
+    {
+        p_first = 0;
+        p_second = static_cast<unsigned int>(units);
+        return;
+    }
+
+    const auto high_bit = static_cast<unsigned int>(std::bit_width(units) - 1);
+    p_first = high_bit - s_second_level_bits + 1;
+    p_second = static_cast<unsigned int>(units >> (high_bit - s_second_level_bits)) - s_second_level_count;
+    if (p_first >= s_first_level_count)
+    {
+        p_first = s_first_level_count - 1;
+        p_second = s_second_level_count - 1;
+    }
+}
+
+
+// Smallest size class whose blocks all hold `p_size` bytes
+// Rounds the size up to the next class boundary
+bool ft::rf::context::buffer_heap::get_search_class(const std::size_t p_size, unsigned int & p_first, unsigned int & p_second)
+{
+    auto units = (p_size + s_granularity - 1) / s_granularity;
+    if (units >= s_second_level_count)
+    {
+        const auto high_bit = static_cast<unsigned int>(std::bit_width(units) - 1);
+        units += (std::size_t{ 1 } << (high_bit - s_second_level_bits)) - 1;
+
+        // Larger than any class
+        if (std::bit_width(units) - s_second_level_bits > s_first_level_count - 1) {
+            return false;
+        }
+    }
+    get_class(units * s_granularity, p_first, p_second);
+    return true;
+}
+
+
+// Add a free block to its size class' list
+void ft::rf::context::buffer_heap::insert_free(const std::uint32_t p_block)
+{
+    auto first = 0u;
+    auto second = 0u;
+    get_class(m_blocks[p_block].size, first, second);
+
+    auto & head = m_free_lists[first][second];
+    auto & block = m_blocks[p_block];
+    block.free = true;
+    block.previous_free = s_null;
+    block.next_free = head;
+    if (head != s_null) {
+        m_blocks[head].previous_free = p_block;
+    }
+    head = p_block;
+
+    m_first_level_map |= std::uint64_t{ 1 } << first;
+    m_second_level_maps[first] |= 1u << second;
+}
+
+
+// Remove a free block from its size class' list
+void ft::rf::context::buffer_heap::remove_free(const std::uint32_t p_block)
+{
+    auto first = 0u;
+    auto second = 0u;
+    get_class(m_blocks[p_block].size, first, second);
+
+    auto & block = m_blocks[p_block];
+    if (block.previous_free != s_null) {
+        m_blocks[block.previous_free].next_free = block.next_free;
+    }
+    else {
+        m_free_lists[first][second] = block.next_free;
+    }
+    if (block.next_free != s_null) {
+        m_blocks[block.next_free].previous_free = block.previous_free;
+    }
+    block.previous_free = s_null;
+    block.next_free = s_null;
+    block.free = false;
+
+    if (m_free_lists[first][second] == s_null)
+    {
+        m_second_level_maps[first] &= ~(1u << second);
+        if (m_second_level_maps[first] == 0) {
+            m_first_level_map &= ~(std::uint64_t{ 1 } << first);
+        }
+    }
+}
+
+
+// Find a free block of at least `p_size` bytes outside the draining pages
+// Returns `s_null` if there is none
+// Without draining pages the head of the first non-empty list is taken
+std::uint32_t ft::rf::context::buffer_heap::find_free(const std::size_t p_size) const
+{
+    auto first = 0u;
+    auto second = 0u;
+    if (get_search_class(p_size, first, second) == false) {
+        return s_null;
+    }
+
+    auto second_map = m_second_level_maps[first] & (~0u << second);
+    while (true)
+    {
+        if (second_map == 0)
+        {
+            // Next non-empty first level class
+            const auto first_map = (first + 1 < s_first_level_count) ?
+                m_first_level_map & (~std::uint64_t{ 0 } << (first + 1)) : 0;
+            if (first_map == 0) {
+                return s_null;
+            }
+            first = static_cast<unsigned int>(std::countr_zero(first_map));
+            second_map = m_second_level_maps[first];
+        }
+
+        second = static_cast<unsigned int>(std::countr_zero(second_map));
+        for (auto block = m_free_lists[first][second]; block != s_null; block = m_blocks[block].next_free)
+        {
+            if (m_pages[m_blocks[block].page].draining == false) {
+                return block;
+            }
+        }
+        second_map &= ~(1u << second);
+    }
+}
+
+
+// Get an unused block slot
+std::uint32_t ft::rf::context::buffer_heap::new_block()
+{
+    if (m_unused_blocks.empty() == false)
+    {
+        const auto index = m_unused_blocks.back();
+        m_unused_blocks.pop_back();
+        m_blocks[index] = t_block{};
+        return index;
+    }
+
+    m_blocks.emplace_back();
+    return static_cast<std::uint32_t>(m_blocks.size() - 1);
+}
+
+
+// Split a block after its first `p_size` bytes, returns the second part
+// The second part isn't in a free list
+std::uint32_t ft::rf::context::buffer_heap::split(const std::uint32_t p_block, const std::size_t p_size)
+{
+    FT_ASSERT(p_size > 0 && p_size < m_blocks[p_block].size);
+
+    const auto index = new_block();
+    auto & block = m_blocks[p_block];
+    auto & rest = m_blocks[index];
+    rest.offset = block.offset + p_size;
+    rest.size = block.size - p_size;
+    rest.page = block.page;
+    rest.previous = p_block;
+    rest.next = block.next;
+    if (block.next != s_null) {
+        m_blocks[block.next].previous = index;
+    }
+    block.next = index;
+    block.size = p_size;
+    return index;
+}
+
+
+// Merge a free block with its free neighbors and insert the result
+void ft::rf::context::buffer_heap::release_block(std::uint32_t p_block)
+{
+    // Absorb a block into the one before it
+    const auto merge = [this](const std::uint32_t p_first, const std::uint32_t p_second)
+    {
+        auto & first = m_blocks[p_first];
+        auto & second = m_blocks[p_second];
+        first.size += second.size;
+        first.next = second.next;
+        if (second.next != s_null) {
+            m_blocks[second.next].previous = p_first;
+        }
+        second = t_block{};
+        second.unused = true;
+        m_unused_blocks.push_back(p_second);
+    };
+
+    const auto previous = m_blocks[p_block].previous;
+    if (previous != s_null && m_blocks[previous].free)
+    {
+        remove_free(previous);
+        merge(previous, p_block);
+        p_block = previous;
+    }
+
+    const auto next = m_blocks[p_block].next;
+    if (next != s_null && m_blocks[next].free)
+    {
+        remove_free(next);
+        merge(p_block, next);
+    }
+
+    insert_free(p_block);
+}
+
+
+// Create a page of at least `p_size` bytes, returns its index
+// The context must be active
+std::uint32_t ft::rf::context::buffer_heap::add_page(const std::size_t p_size)
+{
+    const auto size = (std::max(m_params.page_size, p_size) + s_granularity - 1) / s_granularity * s_granularity;
+
+    unsigned int buffer = 0;
+    call_opengl<err::context_edit_error>(glGenBuffers, 1, &buffer);
+    call_opengl<err::context_edit_error>(glBindBuffer, GL_COPY_WRITE_BUFFER, buffer);
+    call_opengl<err::context_edit_error>(
+        glBufferData,
+        GL_COPY_WRITE_BUFFER,
+        static_cast<GLsizeiptr>(size),
+        nullptr,
+        m_params.dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+
+    get_gpu_memory_tracker().track(*m_context, t_gpu_memory_category::buffer, buffer, size, "buffer_heap");
+
+    // Reuse the slot of a released page
+    auto index = static_cast<std::uint32_t>(m_pages.size());
+    for (std::uint32_t i = 0; i < m_pages.size(); ++i)
+    {
+        if (m_pages[i].buffer == 0)
+        {
+            index = i;
+            break;
+        }
+    }
+    if (index == m_pages.size()) {
+        m_pages.emplace_back();
+    }
+
+    const auto block = new_block();
+    m_blocks[block].size = size;
+    m_blocks[block].page = index;
+    insert_free(block);
+
+    m_pages[index] = t_page{ buffer, size, 0, block };
+    return index;
+}
+
+
+// Carve an aligned range out of a free block
+// Returns the allocated block, the range's offset in it is set in `p_offset`
+// Padding too small to be worth a free block stays in the allocation
+std::uint32_t ft::rf::context::buffer_heap::place(
+    const std::uint32_t p_block,
+    const std::size_t p_size,
+    const std::size_t p_alignment,
+    std::size_t & p_offset)
+{
+    remove_free(p_block);
+
+    auto block = p_block;
+    const auto start = m_blocks[block].offset;
+    auto padding = (start + p_alignment - 1) / p_alignment * p_alignment - start;
+    FT_ASSERT(padding + p_size <= m_blocks[block].size);
+
+    if (padding >= s_granularity)
+    {
+        block = split(p_block, padding);
+        insert_free(p_block);
+        padding = 0;
+    }
+
+    const auto end = padding + p_size;
+    if (m_blocks[block].size - end >= s_granularity) {
+        insert_free(split(block, end));
+    }
+
+    m_pages[m_blocks[block].page].used += m_blocks[block].size;
+    p_offset = padding;
+    return block;
+}
+
+
+// Carve a range out of any page that isn't draining
+// Returns `s_null` if no free block is large enough
+std::uint32_t ft::rf::context::buffer_heap::try_place(
+    const std::size_t p_size,
+    const std::size_t p_alignment,
+    std::size_t & p_offset)
+{
+    const auto block = find_free(p_size + p_alignment - 1);
+    if (block == s_null) {
+        return s_null;
+    }
+    return place(block, p_size, p_alignment, p_offset);
+}
+
+
+// Release a page without allocations
+// The context must be active
+void ft::rf::context::buffer_heap::release_page(t_page & p_page)
+{
+    FT_ASSERT(p_page.used == 0);
+
+    // An empty page is a single free block
+    remove_free(p_page.first);
+    m_blocks[p_page.first] = t_block{};
+    m_blocks[p_page.first].unused = true;
+    m_unused_blocks.push_back(p_page.first);
+
+    call_opengl_skip_errors(glDeleteBuffers, 1, &p_page.buffer);
+    get_gpu_memory_tracker().untrack(*m_context, t_gpu_memory_category::buffer, p_page.buffer);
+    m_context->notify_object_deleted(t_object_kind::buffer, p_page.buffer);
+    p_page = t_page{};
+}
@@ -0,0 +1,248 @@
+#pragma once
+
+// Sub-allocates vertex and index ranges from a few large buffers
+//
+// Ranges are carved out of pages, each page is a single OpenGL buffer, with
+//  a two level segregated fit allocator (TLSF) : free blocks are kept in
+//  lists by size class and a pair of bitmaps finds a large enough list in
+//  constant time, freed blocks are merged with their free neighbors
+// Meshes sharing a page share its buffer, they are drawn from the same
+//  vertex array with a base vertex and first index instead of a bind
+// Buffers are only bound to the copy targets, the element array binding
+//  of the current vertex array is never changed
+
+// standard headers
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+// Forward declaration
+class opengl_context;
+
+// Where an allocation currently lives
+struct t_buffer_range
+{
+    unsigned int buffer = 0;
+    std::size_t offset = 0;
+    std::size_t size = 0;
+
+    // First vertex of the range in its buffer, for vertices of `p_stride` bytes
+    // The range must have been allocated with an alignment of `p_stride`
+    std::int32_t get_base_vertex(const std::size_t p_stride) const;
+
+    // First index of the range in its buffer, for indices of `p_index_size` bytes
+    std::uint32_t get_first_index(const std::size_t p_index_size) const;
+
+};  // struct t_buffer_range
+
+
+struct t_buffer_heap_params
+{
+    // Size of a page, larger allocations get a page of their own
+    std::size_t page_size = std::size_t{ 64 } * 1024 * 1024;
+
+    // Ranges are rewritten often, GL_DYNAMIC_DRAW pages instead of GL_STATIC_DRAW
+    bool dynamic = false;
+
+};  // struct t_buffer_heap_params
+
+
+class buffer_heap
+{
+public:
+    // Identifies an allocation, 0 is never used
+    using t_handle = std::uint64_t;
+
+    // Current state of the heap
+    struct t_stats {
+        std::size_t pages = 0;
+        std::size_t allocations = 0;
+        std::size_t free_blocks = 0;
+        std::uint64_t reserved_bytes = 0;   // Size of every page
+        std::uint64_t used_bytes = 0;       // Bytes handed out, alignment padding included
+        std::uint64_t largest_free_block = 0;
+
+        // Share of the free bytes outside the largest free block, 0 when
+        //  every free byte is contiguous
+        double get_fragmentation() const;
+    };
+
+    // Work done by a call to `defragment`
+    struct t_defragment_result {
+        std::size_t moved_allocations = 0;
+        std::uint64_t moved_bytes = 0;
+        std::size_t released_pages = 0;
+    };
+
+public:
+    // Constructor
+    // Pages are created on first use
+    explicit buffer_heap(opengl_context& p_context, const t_buffer_heap_params& p_params = {});
+
+    // Destructor
+    // Releases every page, handles are no longer valid
+    ~buffer_heap();
+
+    // Prevent copy
+    buffer_heap(const buffer_heap&) = delete;
+    buffer_heap& operator=(const buffer_heap&) = delete;
+
+    // Reserve `p_size` bytes at an offset multiple of `p_alignment`
+    // The alignment doesn't need to be a power of two, use the vertex
+    //  stride for ranges drawn with a base vertex
+    // Creates a page if no free block is large enough
+    t_handle allocate(const std::size_t p_size, const std::size_t p_alignment = 4);
+
+    // Reserve a range and upload `p_size` bytes of `p_data` to it
+    t_handle allocate(const void* p_data, const std::size_t p_size, const std::size_t p_alignment = 4);
+
+    // Release an allocation, unknown handles are ignored
+    void free(const t_handle p_handle);
+
+    // Upload `p_size` bytes at `p_offset` in an allocation
+    void write(const t_handle p_handle, const std::size_t p_offset, const void* p_data, const std::size_t p_size);
+
+    // Where an allocation currently lives
+    // Can change after `defragment`, query it again once `get_generation` changes
+    t_buffer_range get_range(const t_handle p_handle) const;
+
+    // Incremented every time `defragment` moves an allocation
+    std::uint64_t get_generation() const;
+
+    // Empty the least used pages into the free space of the others, then
+    //  release the empty pages
+    // Stops once about `p_max_bytes` were copied, ranges move on the GPU
+    //  with glCopyBufferSubData and are ordered with previous draws
+    t_defragment_result defragment(const std::uint64_t p_max_bytes = UINT64_MAX);
+
+    // Release the pages without allocations
+    // Returns the number of pages released
+    std::size_t trim();
+
+    // Get the current state of the heap
+    t_stats get_stats() const;
+
+private:
+    // Size classes : powers of two split in 16 linear steps
+    static constexpr unsigned int s_second_level_bits = 4;
+    static constexpr unsigned int s_second_level_count = 1u << s_second_level_bits;
+    static constexpr unsigned int s_first_level_count = 48;
+
+    // Sizes are classified in units of this many bytes
+    static constexpr std::size_t s_granularity = 16;
+
+    // No block index
+    static constexpr std::uint32_t s_null = UINT32_MAX;
+
+    // A free or allocated part of a page
+    struct t_block {
+        std::size_t offset = 0;
+        std::size_t size = 0;
+        std::uint32_t page = 0;
+
+        // Neighbors in the page, by offset
+        std::uint32_t previous = s_null;
+        std::uint32_t next = s_null;
+
+        // Neighbors in the free list of the block's size class
+        std::uint32_t previous_free = s_null;
+        std::uint32_t next_free = s_null;
+
+        bool free = false;
+        bool unused = false;    // In `m_unused_blocks`
+    };
+
+    struct t_page {
+        unsigned int buffer = 0;
+        std::size_t size = 0;
+        std::size_t used = 0;
+        std::uint32_t first = s_null;   // Block at offset 0
+
+        // Being emptied by `defragment`, no range is placed in it
+        bool draining = false;
+    };
+
+    struct t_allocation {
+        std::uint32_t block = s_null;
+        std::size_t offset = 0;         // Offset of the aligned range in the block
+        std::size_t size = 0;           // Requested size
+        std::size_t alignment = 1;
+    };
+
+    // Size class of a free block of `p_size` bytes
+    static void get_class(const std::size_t p_size, unsigned int& p_first, unsigned int& p_second);
+
+    // Smallest size class whose blocks all hold `p_size` bytes
+    static bool get_search_class(const std::size_t p_size, unsigned int& p_first, unsigned int& p_second);
+
+    // Add or remove a free block from its size class' list
+    void insert_free(const std::uint32_t p_block);
+    void remove_free(const std::uint32_t p_block);
+
+    // Find a free block of at least `p_size` bytes outside the draining pages
+    // Returns `s_null` if there is none
+    std::uint32_t find_free(const std::size_t p_size) const;
+
+    // Get an unused block slot
+    std::uint32_t new_block();
+
+    // Split a block after its first `p_size` bytes, returns the second part
+    // The second part isn't in a free list
+    std::uint32_t split(const std::uint32_t p_block, const std::size_t p_size);
+
+    // Merge a free block with its free neighbors and insert the result
+    void release_block(std::uint32_t p_block);
+
+    // Create a page of at least `p_size` bytes, returns its index
+    // The context must be active
+    std::uint32_t add_page(const std::size_t p_size);
+
+    // Carve an aligned range out of a free block
+    // Returns the allocated block, the range's offset in it is set in `p_offset`
+    std::uint32_t place(const std::uint32_t p_block, const std::size_t p_size, const std::size_t p_alignment, std::size_t& p_offset);
+
+    // Carve a range out of any page that isn't draining
+    // Returns `s_null` if no free block is large enough
+    std::uint32_t try_place(const std::size_t p_size, const std::size_t p_alignment, std::size_t& p_offset);
+
+    // Release a page without allocations
+    // The context must be active
+    void release_page(t_page& p_page);
+
+private:
+    // Context owning the pages
+    opengl_context* m_context = nullptr;
+
+    // Heap parameters
+    t_buffer_heap_params m_params;
+
+    // Every block, unused slots are recycled
+    std::vector<t_block> m_blocks;
+    std::vector<std::uint32_t> m_unused_blocks;
+
+    // Pages, released pages keep their slot with no buffer
+    std::vector<t_page> m_pages;
+
+    // Free lists by size class, and the bitmaps of the non-empty ones
+    std::array<std::array<std::uint32_t, s_second_level_count>, s_first_level_count> m_free_lists;
+    std::uint64_t m_first_level_map = 0;
+    std::array<std::uint32_t, s_first_level_count> m_second_level_maps = {};
+
+    // Live allocations
+    std::unordered_map<t_handle, t_allocation> m_allocations;
+    t_handle m_next_handle = 1;
+
+    // Incremented when allocations move
+    std::uint64_t m_generation = 0;
+
+};  // class buffer_heap
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
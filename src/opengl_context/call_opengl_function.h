@@ -4,6 +4,8 @@
 
 // project headers
 #include "basegl/opengl_headers.h"
+#include "gl_dispatch.h"
+#include "null_gl.h"
 #include "opengl_debug.h"
 
 // standard headers
@@ -25,6 +27,14 @@ auto call_opengl(
         "Expected an exception type that implements `ft::base::error::except_base\n"
         "See ft::base::error::except_impl");
 
+    // Count the call
+    // The null dispatch answers it instead of the driver, the error checks
+    //  still run so their cost is part of the measured overhead
+    context::count_gl_call();
+    auto function = context::is_null_gl_dispatch() ?
+        context::null_gl::resolve(p_function) :
+        p_function;
+
     // Check if there are any undetected errors
     debug::assert_no_pending_errors();
 
@@ -32,10 +42,10 @@ auto call_opengl(
 
     if constexpr (is_void == false)
     {
-        auto result = p_function(std::forward<Args>(p_args)...);
+        auto result = function(std::forward<Args>(p_args)...);
 
         // Check the stored error code
-        const auto error = glGetError();
+        const auto error = debug::get_error();
         if (error != GL_NO_ERROR)
         {
             // An OpenGL function shouldn't generate more than 1 error
@@ -51,10 +61,10 @@ auto call_opengl(
     }
     else
     {
-        p_function(std::forward<Args>(p_args)...);
+        function(std::forward<Args>(p_args)...);
 
         // Check the stored error code
-        const auto error = glGetError();
+        const auto error = debug::get_error();
         if (error != GL_NO_ERROR)
         {
             // An OpenGL function shouldn't generate more than 1 error
@@ -78,6 +88,14 @@ auto call_opengl_skip_errors(
     Function p_function,
     Args&& ... p_args) noexcept
 {
+    // Count the call
+    // The null dispatch answers it instead of the driver, the error checks
+    //  still run so their cost is part of the measured overhead
+    context::count_gl_call();
+    auto function = context::is_null_gl_dispatch() ?
+        context::null_gl::resolve(p_function) :
+        p_function;
+
     // Check if there are any undetected errors
     debug::assert_no_pending_errors();
 
@@ -85,10 +103,10 @@ auto call_opengl_skip_errors(
 
     if constexpr (is_void == false)
     {
-        auto result = p_function(std::forward<Args>(p_args)...);
+        auto result = function(std::forward<Args>(p_args)...);
 
         // Check the stored error code
-        const auto error = glGetError();
+        const auto error = debug::get_error();
         if (error != GL_NO_ERROR)
         {
             // An OpenGL function shouldn't generate more than 1 error
@@ -101,10 +119,10 @@ auto call_opengl_skip_errors(
     }
     else
     {
-        p_function(std::forward<Args>(p_args)...);
+        function(std::forward<Args>(p_args)...);
 
         // Check the stored error code
-        if (glGetError() != GL_NO_ERROR)
+        if (debug::get_error() != GL_NO_ERROR)
         {
             // An OpenGL function shouldn't generate more than 1 error
             debug::assert_no_pending_errors();
@@ -0,0 +1,446 @@
+#include "command_buffer.h"
+
+// project headers
+#include "call_opengl_function.h"
+#include "make_current.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace {
+
+using t_opcode = ft::rf::context::command_buffer::t_opcode;
+
+// Precedes every command's arguments
+struct t_command_header
+{
+    t_opcode opcode;
+    std::uint16_t size;     // Size of the arguments, rounded to `g_command_alignment`
+};
+
+// Commands start on 4 byte boundaries
+constexpr std::size_t g_command_alignment = 4;
+
+// Arguments of the commands
+struct t_name_arguments
+{
+    std::uint32_t name;
+};
+
+struct t_texture_arguments
+{
+    std::uint32_t unit;
+    std::uint32_t texture;
+};
+
+struct t_uniform_range_arguments
+{
+    std::uint32_t binding;
+    std::uint32_t buffer;
+    std::uint64_t offset;
+    std::uint64_t size;
+};
+
+struct t_mode_arguments
+{
+    std::uint32_t mode;
+};
+
+static_assert(sizeof(t_command_header) == g_command_alignment);
+
+
+// Round `p_size` up to the command alignment
+constexpr std::size_t align_size(const std::size_t p_size)
+{
+    return (p_size + g_command_alignment - 1) / g_command_alignment * g_command_alignment;
+}
+
+
+// Read a command's arguments
+// The stream is only 4 byte aligned, the arguments are copied out
+template<class T>
+T read_arguments(const std::byte* p_arguments)
+{
+    auto result = T{};
+    std::memcpy(&result, p_arguments, sizeof(T));
+    return result;
+}
+
+}   // anonymous namespace
+
+
+// Constructor
+// Reserves `p_capacity` bytes, the only allocation the buffer makes
+ft::rf::context::command_buffer::command_buffer(const std::size_t p_capacity) :
+    m_storage{ new std::byte[p_capacity] },
+    m_capacity{ p_capacity }
+{}
+
+
+// Move constructor
+// The moved-from buffer is left empty, without storage
+ft::rf::context::command_buffer::command_buffer(command_buffer && p_other) noexcept :
+    m_storage{ std::move(p_other.m_storage) },
+    m_capacity{ std::exchange(p_other.m_capacity, 0) },
+    m_size{ std::exchange(p_other.m_size, 0) },
+    m_count{ std::exchange(p_other.m_count, 0) }
+{}
+
+
+// Move assignment
+// The moved-from buffer is left empty, without storage
+ft::rf::context::command_buffer &
+ft::rf::context::command_buffer::operator=(command_buffer && p_other) noexcept
+{
+    if (this != &p_other)
+    {
+        m_storage = std::move(p_other.m_storage);
+        m_capacity = std::exchange(p_other.m_capacity, 0);
+        m_size = std::exchange(p_other.m_size, 0);
+        m_count = std::exchange(p_other.m_count, 0);
+    }
+    return *this;
+}
+
+
+// Record a program change
+void ft::rf::context::command_buffer::use_program(const unsigned int p_program)
+{
+    record(t_opcode::use_program, t_name_arguments{ p_program });
+}
+
+
+// Record a vertex array change
+void ft::rf::context::command_buffer::bind_vertex_array(const unsigned int p_vertex_array)
+{
+    record(t_opcode::bind_vertex_array, t_name_arguments{ p_vertex_array });
+}
+
+
+// Record a 2D texture binding
+void ft::rf::context::command_buffer::bind_texture(const std::uint32_t p_unit, const unsigned int p_texture)
+{
+    FT_ASSERT(p_unit < s_max_texture_units);
+    record(t_opcode::bind_texture, t_texture_arguments{ p_unit, p_texture });
+}
+
+
+// Record a uniform buffer range binding
+void ft::rf::context::command_buffer::bind_uniform_range(
+    const std::uint32_t p_binding,
+    const unsigned int p_buffer,
+    const std::size_t p_offset,
+    const std::size_t p_size)
+{
+    record(t_opcode::bind_uniform_range, t_uniform_range_arguments{ p_binding, p_buffer, p_offset, p_size });
+}
+
+
+// Record a blending mode change
+void ft::rf::context::command_buffer::set_blending_mode(const opengl_context::t_blend_mode p_mode)
+{
+    record(t_opcode::set_blending_mode, t_mode_arguments{ static_cast<std::uint32_t>(p_mode) });
+}
+
+
+// Record a depth testing mode change
+void ft::rf::context::command_buffer::set_depth_test_mode(const opengl_context::t_depth_buffering p_mode)
+{
+    record(t_opcode::set_depth_test_mode, t_mode_arguments{ static_cast<std::uint32_t>(p_mode) });
+}
+
+
+// Record a culling mode change
+void ft::rf::context::command_buffer::set_culling_mode(const opengl_context::t_culling_mode p_mode)
+{
+    record(t_opcode::set_culling_mode, t_mode_arguments{ static_cast<std::uint32_t>(p_mode) });
+}
+
+
+// Record a polygon mode change
+void ft::rf::context::command_buffer::set_polygon_mode(const opengl_context::t_polygon_mode p_mode)
+{
+    record(t_opcode::set_polygon_mode, t_mode_arguments{ static_cast<std::uint32_t>(p_mode) });
+}
+
+
+// Record an indexed draw
+void ft::rf::context::command_buffer::draw(const t_draw & p_draw)
+{
+    record(t_opcode::draw, p_draw);
+}
+
+
+// Forget the recorded commands, keeps the storage
+void ft::rf::context::command_buffer::reset()
+{
+    m_size = 0;
+    m_count = 0;
+}
+
+
+// Recorded bytes
+std::span<const std::byte> ft::rf::context::command_buffer::get_data() const
+{
+    return { m_storage.get(), m_size };
+}
+
+
+// Number of recorded commands
+std::size_t ft::rf::context::command_buffer::get_command_count() const
+{
+    return m_count;
+}
+
+
+// Size of the storage in bytes
+std::size_t ft::rf::context::command_buffer::get_capacity() const
+{
+    return m_capacity;
+}
+
+
+// Append a command and its arguments
+template<class T>
+void ft::rf::context::command_buffer::record(const t_opcode p_opcode, const T & p_arguments)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    constexpr auto size = align_size(sizeof(T));
+    if (m_capacity - m_size < sizeof(t_command_header) + size)
+    {
+        throw t_except_full("Command buffer is full");
+    }
+
+    const auto header = t_command_header{ p_opcode, static_cast<std::uint16_t>(size) };
+    std::memcpy(m_storage.get() + m_size, &header, sizeof(header));
+    std::memcpy(m_storage.get() + m_size + sizeof(header), &p_arguments, sizeof(T));
+
+    m_size += sizeof(header) + size;
+    ++m_count;
+}
+
+
+// Constructor
+ft::rf::context::command_submitter::command_submitter(opengl_context & p_context) :
+    m_context(&p_context)
+{}
+
+
+// Replay `p_buffers` in order
+void ft::rf::context::command_submitter::submit(std::span<const command_buffer* const> p_buffers)
+{
+    m_last_command_count = 0;
+    m_last_skipped_count = 0;
+
+    auto active = make_current{ *m_context };
+    reset_state();
+    for (const auto* buffer : p_buffers)
+    {
+        FT_ASSERT(buffer != nullptr);
+        replay(*buffer);
+    }
+}
+
+
+// Replay a single buffer
+void ft::rf::context::command_submitter::submit(const command_buffer & p_buffer)
+{
+    const command_buffer* buffers[] = { &p_buffer };
+    submit(buffers);
+}
+
+
+// Commands replayed by the last submission
+std::size_t ft::rf::context::command_submitter::get_last_command_count() const
+{
+    return m_last_command_count;
+}
+
+
+// Commands skipped by the last submission because their state was already set
+std::size_t ft::rf::context::command_submitter::get_last_skipped_count() const
+{
+    return m_last_skipped_count;
+}
+
+
+// Unbind the cached objects and clear the cache
+// Objects may have been bound outside the submitter since the last
+//  submission, the cache only lives for one submission
+// Program and vertex array are unbound, texture and uniform bindings are
+//  marked unknown so their first command is always applied
+void ft::rf::context::command_submitter::reset_state()
+{
+    m_program = 0;
+    m_vertex_array = 0;
+    m_active_unit = 0;
+    m_textures.fill(s_unknown);
+    m_uniform_ranges.fill({});
+    call_opengl<err::context_edit_error>(glUseProgram, GLuint{ 0 });
+    call_opengl<err::context_edit_error>(glBindVertexArray, GLuint{ 0 });
+    call_opengl<err::context_edit_error>(glActiveTexture, GLenum{ GL_TEXTURE0 });
+}
+
+
+// Replay one buffer, the context must already be active
+void ft::rf::context::command_submitter::replay(const command_buffer & p_buffer)
+{
+    auto & context = *m_context;
+
+    const auto data = p_buffer.get_data();
+    std::size_t position = 0;
+    while (position < data.size())
+    {
+        const auto header = read_arguments<t_command_header>(data.data() + position);
+        const auto* arguments = data.data() + position + sizeof(header);
+        position += sizeof(header) + header.size;
+        ++m_last_command_count;
+
+        switch (header.opcode)
+        {
+        case t_opcode::use_program:
+        {
+            const auto program = read_arguments<t_name_arguments>(arguments).name;
+            if (program == m_program) {
+                ++m_last_skipped_count;
+                break;
+            }
+            call_opengl<err::context_edit_error>(glUseProgram, program);
+            m_program = program;
+            break;
+        }
+
+        case t_opcode::bind_vertex_array:
+        {
+            const auto vertex_array = read_arguments<t_name_arguments>(arguments).name;
+            if (vertex_array == m_vertex_array) {
+                ++m_last_skipped_count;
+                break;
+            }
+            call_opengl<err::context_edit_error>(glBindVertexArray, vertex_array);
+            m_vertex_array = vertex_array;
+            break;
+        }
+
+        case t_opcode::bind_texture:
+        {
+            const auto texture = read_arguments<t_texture_arguments>(arguments);
+            if (m_textures[texture.unit] == texture.texture) {
+                ++m_last_skipped_count;
+                break;
+            }
+            if (m_active_unit != texture.unit)
+            {
+                call_opengl<err::context_edit_error>(
+                    glActiveTexture,
+                    static_cast<GLenum>(GL_TEXTURE0 + texture.unit));
+                m_active_unit = texture.unit;
+            }
+            call_opengl<err::context_edit_error>(glBindTexture, GL_TEXTURE_2D, texture.texture);
+            m_textures[texture.unit] = texture.texture;
+            break;
+        }
+
+        case t_opcode::bind_uniform_range:
+        {
+            const auto range = read_arguments<t_uniform_range_arguments>(arguments);
+            const auto bound = t_uniform_range{
+                range.buffer,
+                static_cast<std::size_t>(range.offset),
+                static_cast<std::size_t>(range.size) };
+
+            // Bindings past the tracked ones are always applied
+            const auto tracked = range.binding < s_max_uniform_bindings;
+            if (tracked && m_uniform_ranges[range.binding] == bound) {
+                ++m_last_skipped_count;
+                break;
+            }
+            call_opengl<err::context_edit_error>(
+                glBindBufferRange,
+                GL_UNIFORM_BUFFER,
+                range.binding,
+                range.buffer,
+                static_cast<GLintptr>(range.offset),
+                static_cast<GLsizeiptr>(range.size));
+            if (tracked) {
+                m_uniform_ranges[range.binding] = bound;
+            }
+            break;
+        }
+
+        // The context tracks its own render modes
+        case t_opcode::set_blending_mode:
+        {
+            const auto mode = static_cast<opengl_context::t_blend_mode>(read_arguments<t_mode_arguments>(arguments).mode);
+            if (context.get_blending_mode() == mode) {
+                ++m_last_skipped_count;
+                break;
+            }
+            context.set_blending_mode(mode);
+            break;
+        }
+
+        case t_opcode::set_depth_test_mode:
+        {
+            const auto mode = static_cast<opengl_context::t_depth_buffering>(read_arguments<t_mode_arguments>(arguments).mode);
+            if (context.get_depth_test_mode() == mode) {
+                ++m_last_skipped_count;
+                break;
+            }
+            context.set_depth_test_mode(mode);
+            break;
+        }
+
+        case t_opcode::set_culling_mode:
+        {
+            const auto mode = static_cast<opengl_context::t_culling_mode>(read_arguments<t_mode_arguments>(arguments).mode);
+            if (context.get_culling_mode() == mode) {
+                ++m_last_skipped_count;
+                break;
+            }
+            context.set_culling_mode(mode);
+            break;
+        }
+
+        case t_opcode::set_polygon_mode:
+        {
+            const auto mode = static_cast<opengl_context::t_polygon_mode>(read_arguments<t_mode_arguments>(arguments).mode);
+            if (context.get_polygon_mode() == mode) {
+                ++m_last_skipped_count;
+                break;
+            }
+            context.set_polygon_mode(mode);
+            break;
+        }
+
+        case t_opcode::draw:
+        {
+            const auto command = read_arguments<command_buffer::t_draw>(arguments);
+            call_opengl<err::context_edit_error>(
+                glDrawElementsInstancedBaseVertexBaseInstance,
+                GL_TRIANGLES,
+                static_cast<GLsizei>(command.index_count),
+                GL_UNSIGNED_INT,
+                reinterpret_cast<const void*>(
+                    static_cast<std::size_t>(command.first_index) * sizeof(std::uint32_t)),
+                static_cast<GLsizei>(command.instance_count),
+                static_cast<GLint>(command.base_vertex),
+                static_cast<GLuint>(command.base_instance));
+            break;
+        }
+
+        default:
+            err::context_edit_error::raise("unknown command in command buffer");
+        }
+    }
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+// Deferred OpenGL commands
+//
+// A command_buffer is a compact binary stream of GL level commands recorded
+//  without any context, so scene traversal can be split across threads :
+//  each thread records its own buffer, then the thread owning the context
+//  replays them in order with a command_submitter
+// Recording never allocates, the storage is reserved by the constructor
+//  and reused after `reset`
+
+// project headers
+#include "opengl_context.h"
+
+// standard headers
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+class command_buffer
+{
+public:
+    // Raised when a command doesn't fit in the remaining storage
+    struct t_except_full : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    // Default storage size in bytes
+    static constexpr std::size_t s_default_capacity = 256 * 1024;
+
+    // Texture units commands can bind
+    static constexpr std::uint32_t s_max_texture_units = 16;
+
+    // A single indexed draw of triangles using 32 bit unsigned indices
+    struct t_draw
+    {
+        std::uint32_t index_count = 0;
+        std::uint32_t instance_count = 1;
+        std::uint32_t first_index = 0;
+        std::int32_t base_vertex = 0;
+        std::uint32_t base_instance = 0;
+    };
+
+    // Command identifiers
+    enum class t_opcode : std::uint16_t {
+        use_program,
+        bind_vertex_array,
+        bind_texture,
+        bind_uniform_range,
+        set_blending_mode,
+        set_depth_test_mode,
+        set_culling_mode,
+        set_polygon_mode,
+        draw
+    };
+
+public:
+    // Constructor
+    // Reserves `p_capacity` bytes, the only allocation the buffer makes
+    explicit command_buffer(const std::size_t p_capacity = s_default_capacity);
+
+    // Prevent copy
+    command_buffer(const command_buffer&) = delete;
+    command_buffer& operator=(const command_buffer&) = delete;
+
+    // Move allowed
+    // The moved-from buffer is left empty, without storage
+    command_buffer(command_buffer&& p_other) noexcept;
+    command_buffer& operator=(command_buffer&& p_other) noexcept;
+
+    // Record commands
+    // Never calls OpenGL, raises t_except_full if the storage is exhausted
+    void use_program(const unsigned int p_program);
+    void bind_vertex_array(const unsigned int p_vertex_array);
+    void bind_texture(const std::uint32_t p_unit, const unsigned int p_texture);
+    void bind_uniform_range(
+        const std::uint32_t p_binding,
+        const unsigned int p_buffer,
+        const std::size_t p_offset,
+        const std::size_t p_size);
+    void set_blending_mode(const opengl_context::t_blend_mode p_mode);
+    void set_depth_test_mode(const opengl_context::t_depth_buffering p_mode);
+    void set_culling_mode(const opengl_context::t_culling_mode p_mode);
+    void set_polygon_mode(const opengl_context::t_polygon_mode p_mode);
+    void draw(const t_draw& p_draw);
+
+    // Forget the recorded commands, keeps the storage
+    void reset();
+
+    // Recorded bytes
+    std::span<const std::byte> get_data() const;
+
+    // Number of recorded commands
+    std::size_t get_command_count() const;
+
+    // Size of the storage in bytes
+    std::size_t get_capacity() const;
+
+private:
+    // Append a command and its arguments
+    template<class T>
+    void record(const t_opcode p_opcode, const T& p_arguments);
+
+private:
+    // Storage, `m_size` bytes are used
+    std::unique_ptr<std::byte[]> m_storage;
+    std::size_t m_capacity = 0;
+    std::size_t m_size = 0;
+
+    // Number of recorded commands
+    std::size_t m_count = 0;
+
+};  // class command_buffer
+
+
+// Replays command buffers on the thread owning a context
+// The bound state is cached across the buffers of one submission,
+//  commands setting a state that is already bound are skipped
+// Every submission starts from a clean binding state, so code binding
+//  objects directly between submissions can't desynchronize the cache
+class command_submitter
+{
+public:
+    // Constructor
+    explicit command_submitter(opengl_context& p_context);
+
+    // Prevent copy
+    command_submitter(const command_submitter&) = delete;
+    command_submitter& operator=(const command_submitter&) = delete;
+
+    // Replay `p_buffers` in order
+    // Must be called from the thread that may activate the context
+    void submit(std::span<const command_buffer* const> p_buffers);
+
+    // Replay a single buffer
+    void submit(const command_buffer& p_buffer);
+
+    // Commands replayed and skipped by the last submission
+    std::size_t get_last_command_count() const;
+    std::size_t get_last_skipped_count() const;
+
+private:
+    // Unbind the cached objects and clear the cache
+    // The context must already be active
+    void reset_state();
+
+    // Replay one buffer, the context must already be active
+    void replay(const command_buffer& p_buffer);
+
+private:
+    // Cached name of a binding whose state isn't known
+    static constexpr unsigned int s_unknown = ~0u;
+
+    // A uniform buffer range binding
+    struct t_uniform_range {
+        unsigned int buffer = s_unknown;
+        std::size_t offset = 0;
+        std::size_t size = 0;
+
+        bool operator==(const t_uniform_range&) const = default;
+    };
+
+    // Uniform block bindings tracked by the cache
+    static constexpr std::uint32_t s_max_uniform_bindings = 16;
+
+    // Context the commands are replayed to
+    opengl_context* m_context = nullptr;
+
+    // Bound state, reset at the start of every submission
+    unsigned int m_program = 0;
+    unsigned int m_vertex_array = 0;
+    std::uint32_t m_active_unit = 0;
+    std::array<unsigned int, command_buffer::s_max_texture_units> m_textures = {};
+    std::array<t_uniform_range, s_max_uniform_bindings> m_uniform_ranges = {};
+
+    // Statistics of the last submission
+    std::size_t m_last_command_count = 0;
+    std::size_t m_last_skipped_count = 0;
+
+};  // class command_submitter
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
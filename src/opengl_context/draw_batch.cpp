@@ -0,0 +1,322 @@
+#include "draw_batch.h"
+
+// project headers
+#include "call_opengl_function.h"
+#include "gpu_memory_tracker.h"
+#include "make_current.h"
+#include "object_caches.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <tuple>
+
+namespace {
+    // Order in which the states of opaque draws are submitted
+    // Draws are grouped by the most expensive state changes
+    auto make_state_order(const ft::rf::context::draw_batch::t_state & p_state)
+    {
+        return std::tie(
+            p_state.blending,
+            p_state.depth,
+            p_state.culling,
+            p_state.polygon,
+            p_state.program,
+            p_state.vertex_array,
+            p_state.textures);
+    }
+}   // anonymous namespace
+
+
+// Constructor
+ft::rf::context::draw_batch::draw_batch(opengl_context & p_context) :
+    m_context(&p_context)
+{}
+
+
+// Destructor
+// Releases the indirect command buffer
+ft::rf::context::draw_batch::~draw_batch()
+{
+    if (m_buffer != 0)
+    {
+        auto active = make_current{ *m_context };
+        call_opengl_skip_errors(glDeleteBuffers, 1, &m_buffer);
+        get_gpu_memory_tracker().untrack(*m_context, t_gpu_memory_category::buffer, m_buffer);
+        m_context->notify_object_deleted(t_object_kind::buffer, m_buffer);
+    }
+}
+
+
+// Queue a draw
+// `p_depth` is the draw's distance from the viewer, larger is farther
+// It orders blended draws, which are issued farthest first, and is
+//  ignored for opaque draws
+// Never calls OpenGL
+void ft::rf::context::draw_batch::add(const t_state & p_state, const t_draw & p_draw, const float p_depth)
+{
+    FT_ASSERT(std::isnan(p_depth) == false);
+
+    const auto state = intern_state(p_state);
+    const auto order = static_cast<std::uint64_t>(m_requests.size());
+    const auto blended = (p_state.blending != opengl_context::t_blend_mode::disabled);
+    m_requests.push_back({ order, state, p_draw, blended, p_depth });
+}
+
+
+// Sort the queued draws and issue them
+// Opaque draws go first, sorted by state, then blended draws from
+//  back to front, in queue order when their depths are equal
+// Clears the queue
+void ft::rf::context::draw_batch::submit()
+{
+    m_last_call_count = 0;
+    if (m_requests.empty())
+    {
+        clear();
+        return;
+    }
+
+    // Rank the distinct states and build the sort keys
+    // Queue order is kept within a state
+    std::vector<std::uint32_t> ranks(m_states.size());
+    {
+        std::vector<std::uint32_t> sorted(m_states.size());
+        std::iota(sorted.begin(), sorted.end(), 0u);
+        std::sort(sorted.begin(), sorted.end(), [this](auto p_lhs, auto p_rhs) {
+            return make_state_order(m_states[p_lhs]) < make_state_order(m_states[p_rhs]);
+        });
+        for (std::uint32_t rank = 0; rank < sorted.size(); ++rank)
+        {
+            ranks[sorted[rank]] = rank;
+        }
+    }
+    for (auto & request : m_requests)
+    {
+        if (request.blended == false) {
+            request.key |= static_cast<std::uint64_t>(ranks[request.state]) << 32;
+        }
+    }
+
+    // Blended draws keep their back to front order, consecutive ones
+    //  still share a call when their states match
+    std::sort(m_requests.begin(), m_requests.end(), [](const auto & p_lhs, const auto & p_rhs) {
+        if (p_lhs.blended != p_rhs.blended) {
+            return p_rhs.blended;
+        }
+        if (p_lhs.blended && p_lhs.depth != p_rhs.depth) {
+            return p_lhs.depth > p_rhs.depth;
+        }
+        return p_lhs.key < p_rhs.key;
+    });
+
+    // Build every indirect command on the CPU
+    m_commands.clear();
+    m_commands.reserve(m_requests.size());
+    for (const auto & request : m_requests)
+    {
+        m_commands.push_back(request.draw);
+    }
+
+    auto active = make_current{ *m_context };
+    m_has_bound = false;
+
+    const auto multi_draw = GLEW_ARB_multi_draw_indirect != 0;
+    if (multi_draw)
+    {
+        // Upload all commands at once, the storage is only reallocated
+        //  when the buffer is too small
+        const auto size = m_commands.size() * sizeof(t_draw);
+        if (m_buffer == 0)
+        {
+            call_opengl<err::context_edit_error>(glGenBuffers, 1, &m_buffer);
+        }
+        call_opengl<err::context_edit_error>(glBindBuffer, GL_DRAW_INDIRECT_BUFFER, m_buffer);
+        if (size > m_buffer_size)
+        {
+            m_buffer_size = std::max(size, m_buffer_size * 2);
+            call_opengl<err::context_edit_error>(
+                glBufferData,
+                GL_DRAW_INDIRECT_BUFFER,
+                static_cast<GLsizeiptr>(m_buffer_size),
+                nullptr,
+                GL_STREAM_DRAW);
+            get_gpu_memory_tracker().track(*m_context, t_gpu_memory_category::buffer, m_buffer, m_buffer_size, "draw_batch");
+        }
+        call_opengl<err::context_edit_error>(
+            glBufferSubData,
+            GL_DRAW_INDIRECT_BUFFER,
+            GLintptr{ 0 },
+            static_cast<GLsizeiptr>(size),
+            m_commands.data());
+    }
+
+    // Issue one call per run of identical state
+    std::size_t first = 0;
+    while (first < m_requests.size())
+    {
+        const auto state = m_requests[first].state;
+        auto last = first + 1;
+        while (last < m_requests.size() && m_requests[last].state == state)
+        {
+            ++last;
+        }
+
+        apply_state(m_states[state]);
+
+        if (multi_draw)
+        {
+            call_opengl<err::context_edit_error>(
+                glMultiDrawElementsIndirect,
+                GL_TRIANGLES,
+                GL_UNSIGNED_INT,
+                reinterpret_cast<const void*>(first * sizeof(t_draw)),
+                static_cast<GLsizei>(last - first),
+                GLsizei{ 0 });
+            ++m_last_call_count;
+        }
+        else
+        {
+            // No indirect support, fall back to one draw per command
+            for (auto i = first; i < last; ++i)
+            {
+                const auto & command = m_commands[i];
+                call_opengl<err::context_edit_error>(
+                    glDrawElementsInstancedBaseVertexBaseInstance,
+                    GL_TRIANGLES,
+                    static_cast<GLsizei>(command.index_count),
+                    GL_UNSIGNED_INT,
+                    reinterpret_cast<const void*>(
+                        static_cast<std::size_t>(command.first_index) * sizeof(std::uint32_t)),
+                    static_cast<GLsizei>(command.instance_count),
+                    static_cast<GLint>(command.base_vertex),
+                    static_cast<GLuint>(command.base_instance));
+            }
+            m_last_call_count += last - first;
+        }
+
+        first = last;
+    }
+
+    clear();
+}
+
+
+// Drop the queued draws without issuing them
+void ft::rf::context::draw_batch::clear()
+{
+    m_requests.clear();
+    m_states.clear();
+    m_state_ids.clear();
+}
+
+
+// Number of queued draws
+std::size_t ft::rf::context::draw_batch::get_draw_count() const
+{
+    return m_requests.size();
+}
+
+
+// Number of draw calls issued by the last `submit`
+std::size_t ft::rf::context::draw_batch::get_last_call_count() const
+{
+    return m_last_call_count;
+}
+
+
+// Find or add a state, returns its index in `m_states`
+std::uint32_t ft::rf::context::draw_batch::intern_state(const t_state & p_state)
+{
+    // Consecutive draws very often share their state
+    if (m_requests.empty() == false && m_states[m_requests.back().state] == p_state)
+    {
+        return m_requests.back().state;
+    }
+
+    const auto next = static_cast<std::uint32_t>(m_states.size());
+    const auto [iter, inserted] = m_state_ids.try_emplace(p_state, next);
+    if (inserted)
+    {
+        m_states.push_back(p_state);
+    }
+    return iter->second;
+}
+
+
+// Apply a state, skipping what is already bound
+// The context must already be active
+void ft::rf::context::draw_batch::apply_state(const t_state & p_state)
+{
+    auto & context = *m_context;
+
+    if (context.get_blending_mode() != p_state.blending) {
+        context.set_blending_mode(p_state.blending);
+    }
+    if (context.get_depth_test_mode() != p_state.depth) {
+        context.set_depth_test_mode(p_state.depth);
+    }
+    if (context.get_culling_mode() != p_state.culling) {
+        context.set_culling_mode(p_state.culling);
+    }
+    if (context.get_polygon_mode() != p_state.polygon) {
+        context.set_polygon_mode(p_state.polygon);
+    }
+
+    if (m_has_bound == false || m_bound.program != p_state.program)
+    {
+        call_opengl<err::context_edit_error>(glUseProgram, p_state.program);
+    }
+    if (m_has_bound == false || m_bound.vertex_array != p_state.vertex_array)
+    {
+        call_opengl<err::context_edit_error>(glBindVertexArray, p_state.vertex_array);
+    }
+    for (std::size_t unit = 0; unit < s_max_textures; ++unit)
+    {
+        if (m_has_bound == false || m_bound.textures[unit] != p_state.textures[unit])
+        {
+            call_opengl<err::context_edit_error>(
+                glActiveTexture,
+                static_cast<GLenum>(GL_TEXTURE0 + unit));
+            call_opengl<err::context_edit_error>(
+                glBindTexture,
+                GL_TEXTURE_2D,
+                p_state.textures[unit]);
+        }
+    }
+
+    m_bound = p_state;
+    m_has_bound = true;
+}
+
+
+// Hashes a render state
+std::size_t ft::rf::context::draw_batch::t_state_hash::operator()(const t_state & p_state) const
+{
+    // FNV-1a over the state's fields
+    std::uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const std::uint64_t p_value) {
+        hash ^= p_value;
+        hash *= 1099511628211ull;
+    };
+
+    mix(p_state.program);
+    mix(p_state.vertex_array);
+    for (const auto texture : p_state.textures) {
+        mix(texture);
+    }
+    mix(static_cast<std::uint64_t>(p_state.blending));
+    mix(static_cast<std::uint64_t>(p_state.depth));
+    mix(static_cast<std::uint64_t>(p_state.culling));
+    mix(static_cast<std::uint64_t>(p_state.polygon));
+
+    return static_cast<std::size_t>(hash);
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+// Collects indexed draw requests during a frame and issues them as
+//  few glMultiDrawElementsIndirect calls as possible
+// Opaque draws are sorted by render state so each state is applied once,
+//  blended draws follow them back to front so transparency composes
+//  correctly, and the indirect commands are built on the CPU in a single
+//  buffer
+
+// project headers
+#include "opengl_context.h"
+
+// standard headers
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+class draw_batch
+{
+public:
+    // Maximum number of 2D textures a draw can bind
+    static constexpr std::size_t s_max_textures = 4;
+
+    // Render state shared by consecutive draws
+    // All draws render triangles using 32 bit unsigned indices
+    struct t_state
+    {
+        unsigned int program = 0;
+        unsigned int vertex_array = 0;
+
+        // Textures bound to units 0 to `s_max_textures - 1`
+        std::array<unsigned int, s_max_textures> textures = {};
+
+        opengl_context::t_blend_mode blending = opengl_context::t_blend_mode::disabled;
+        opengl_context::t_depth_buffering depth = opengl_context::t_depth_buffering::disabled;
+        opengl_context::t_culling_mode culling = opengl_context::t_culling_mode::no_culling;
+        opengl_context::t_polygon_mode polygon = opengl_context::t_polygon_mode::fill;
+
+        bool operator==(const t_state&) const = default;
+    };
+
+    // A single indexed draw
+    // Layout matches OpenGL's DrawElementsIndirectCommand
+    struct t_draw
+    {
+        std::uint32_t index_count = 0;
+        std::uint32_t instance_count = 1;
+        std::uint32_t first_index = 0;
+        std::int32_t base_vertex = 0;
+        std::uint32_t base_instance = 0;
+    };
+
+public:
+    // Constructor
+    explicit draw_batch(opengl_context& p_context);
+
+    // Destructor
+    // Releases the indirect command buffer
+    ~draw_batch();
+
+    // Prevent copy
+    draw_batch(const draw_batch&) = delete;
+    draw_batch& operator=(const draw_batch&) = delete;
+
+    // Queue a draw
+    // `p_depth` is the draw's distance from the viewer, larger is farther
+    // It orders blended draws, which are issued farthest first, and is
+    //  ignored for opaque draws
+    // Never calls OpenGL
+    void add(const t_state& p_state, const t_draw& p_draw, const float p_depth = 0.f);
+
+    // Sort the queued draws and issue them
+    // Opaque draws go first, sorted by state, then blended draws from
+    //  back to front, in queue order when their depths are equal
+    // Clears the queue
+    void submit();
+
+    // Drop the queued draws without issuing them
+    void clear();
+
+    // Number of queued draws
+    std::size_t get_draw_count() const;
+
+    // Number of draw calls issued by the last `submit`
+    std::size_t get_last_call_count() const;
+
+private:
+    // Find or add a state, returns its index in `m_states`
+    std::uint32_t intern_state(const t_state& p_state);
+
+    // Apply a state, skipping what is already bound
+    void apply_state(const t_state& p_state);
+
+private:
+    // A queued draw
+    struct t_request {
+        // Sort key of opaque draws, state rank in the high bits and queue
+        //  order in the low bits, only the queue order for blended draws
+        std::uint64_t key;
+        std::uint32_t state;
+        t_draw draw;
+
+        // Blended draws are sorted by depth
+        bool blended;
+        float depth;
+    };
+
+    // Context the draws are issued to
+    opengl_context* m_context = nullptr;
+
+    // Hashes a render state
+    struct t_state_hash {
+        std::size_t operator()(const t_state& p_state) const;
+    };
+
+    // Distinct states used this frame and their index
+    std::vector<t_state> m_states;
+    std::unordered_map<t_state, std::uint32_t, t_state_hash> m_state_ids;
+
+    // Queued draws
+    std::vector<t_request> m_requests;
+
+    // Indirect commands in submission order, reused between frames
+    std::vector<t_draw> m_commands;
+
+    // Indirect command buffer and its current capacity in bytes
+    unsigned int m_buffer = 0;
+    std::size_t m_buffer_size = 0;
+
+    // Last applied state, invalid until the first submit applies one
+    t_state m_bound;
+    bool m_has_bound = false;
+
+    // Draw calls issued by the last submit
+    std::size_t m_last_call_count = 0;
+
+};  // class draw_batch
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,200 @@
+#include "frame_readback.h"
+
+// project headers
+#include "call_opengl_function.h"
+#include "gpu_memory_tracker.h"
+#include "make_current.h"
+#include "object_caches.h"
+#include "opengl_context.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+namespace {
+
+// Maximum time to wait for the oldest frame, in nanoseconds
+constexpr GLuint64 g_wait_timeout = 1000000000;
+
+}   // anonymous namespace
+
+
+// Constructor
+// Up to `p_depth` frames can be in flight
+ft::rf::context::frame_readback::frame_readback(opengl_context & p_context, const std::size_t p_depth) :
+    m_context(&p_context),
+    m_slots(p_depth)
+{
+    FT_ASSERT(p_depth > 0);
+
+    auto active = make_current{ *m_context };
+
+    for (auto & slot : m_slots)
+    {
+        call_opengl<err::context_init>(glGenBuffers, 1, &slot.buffer);
+    }
+}
+
+
+// Destructor
+// Releases the pixel buffers, frames in flight are abandoned
+ft::rf::context::frame_readback::~frame_readback()
+{
+    auto active = make_current{ *m_context };
+
+    for (auto & slot : m_slots)
+    {
+        if (slot.fence != nullptr)
+        {
+            call_opengl_skip_errors(glDeleteSync, static_cast<GLsync>(slot.fence));
+        }
+        call_opengl_skip_errors(glDeleteBuffers, 1, &slot.buffer);
+        get_gpu_memory_tracker().untrack(*m_context, t_gpu_memory_category::buffer, slot.buffer);
+        m_context->notify_object_deleted(t_object_kind::buffer, slot.buffer);
+    }
+}
+
+
+// Start reading the bottom-left `p_width` x `p_height` pixels of the
+//  read framebuffer
+// Frames that completed are passed to `p_done` first, if every buffer
+//  is still in flight the oldest frame is waited for
+void ft::rf::context::frame_readback::read(
+    const int p_width,
+    const int p_height,
+    const std::uint64_t p_number,
+    const t_callback & p_done)
+{
+    FT_ASSERT(p_width > 0 && p_height > 0);
+
+    auto active = make_current{ *m_context };
+
+    poll(p_done);
+    if (m_pending == m_slots.size())
+    {
+        deliver(m_slots[m_first], p_done);
+    }
+
+    auto & slot = m_slots[(m_first + m_pending) % m_slots.size()];
+    const auto size = static_cast<std::size_t>(p_width) * p_height * 4;
+
+    call_opengl<err::context_edit_error>(glBindBuffer, GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (slot.capacity < size)
+    {
+        call_opengl<err::context_edit_error>(
+            glBufferData,
+            GL_PIXEL_PACK_BUFFER,
+            static_cast<GLsizeiptr>(size),
+            nullptr,
+            GL_STREAM_READ);
+        slot.capacity = size;
+        get_gpu_memory_tracker().track(*m_context, t_gpu_memory_category::buffer, slot.buffer, size, "frame_readback");
+    }
+
+    // The copy into the buffer is queued, it doesn't wait for the GPU
+    // RGBA8 rows are always 4 byte aligned, no need to change GL_PACK_ALIGNMENT
+    call_opengl<err::context_edit_error>(
+        glReadPixels,
+        0, 0,
+        p_width, p_height,
+        GL_RGBA,
+        GL_UNSIGNED_BYTE,
+        nullptr);           // Offset in the bound pixel buffer
+    call_opengl<err::context_edit_error>(glBindBuffer, GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = call_opengl_fail_value<err::context_edit_error, GLsync{ nullptr }>(
+        glFenceSync,
+        GL_SYNC_GPU_COMMANDS_COMPLETE,
+        GLbitfield{ 0 });
+
+    slot.result = { p_number, std::chrono::steady_clock::now(), p_width, p_height, nullptr };
+    ++m_pending;
+}
+
+
+// Pass the frames that completed to `p_done`
+// If `p_wait` is true, waits for every frame in flight
+void ft::rf::context::frame_readback::poll(const t_callback & p_done, const bool p_wait)
+{
+    auto active = make_current{ *m_context };
+
+    // Frames complete in order, stop at the first one still in flight
+    while (m_pending > 0)
+    {
+        auto & slot = m_slots[m_first];
+        if (p_wait == false)
+        {
+            const auto status = call_opengl<err::context_edit_error>(
+                glClientWaitSync,
+                static_cast<GLsync>(slot.fence),
+                GLbitfield{ 0 },
+                GLuint64{ 0 });
+            if (status == GL_TIMEOUT_EXPIRED)
+            {
+                return;
+            }
+        }
+
+        deliver(slot, p_done);
+    }
+}
+
+
+// Number of frames in flight
+std::size_t ft::rf::context::frame_readback::get_pending_count() const
+{
+    return m_pending;
+}
+
+
+// Map a completed slot, pass it to `p_done` and release its fence
+void ft::rf::context::frame_readback::deliver(t_slot & p_slot, const t_callback & p_done)
+{
+    // Waits if the copy isn't done yet
+    const auto status = call_opengl<err::context_edit_error>(
+        glClientWaitSync,
+        static_cast<GLsync>(p_slot.fence),
+        GLbitfield{ GL_SYNC_FLUSH_COMMANDS_BIT },
+        g_wait_timeout);
+    call_opengl_skip_errors(glDeleteSync, static_cast<GLsync>(p_slot.fence));
+    p_slot.fence = nullptr;
+
+    m_first = (m_first + 1) % m_slots.size();
+    --m_pending;
+
+    if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+    {
+        // The frame is skipped rather than blocking forever
+        return;
+    }
+
+    const auto size = static_cast<std::size_t>(p_slot.result.width) * p_slot.result.height * 4;
+
+    call_opengl<err::context_edit_error>(glBindBuffer, GL_PIXEL_PACK_BUFFER, p_slot.buffer);
+    const auto pixels = call_opengl_fail_value<err::context_edit_error, nullptr>(
+        glMapBufferRange,
+        GL_PIXEL_PACK_BUFFER,
+        GLintptr{ 0 },
+        static_cast<GLsizeiptr>(size),
+        GLbitfield{ GL_MAP_READ_BIT });
+
+    auto result = p_slot.result;
+    result.pixels = static_cast<const std::uint8_t*>(pixels);
+
+    try
+    {
+        p_done(result);
+    }
+    catch (...)
+    {
+        call_opengl_skip_errors(glUnmapBuffer, GL_PIXEL_PACK_BUFFER);
+        call_opengl_skip_errors(glBindBuffer, GL_PIXEL_PACK_BUFFER, 0);
+        throw;
+    }
+
+    call_opengl_skip_errors(glUnmapBuffer, GL_PIXEL_PACK_BUFFER);
+    call_opengl_skip_errors(glBindBuffer, GL_PIXEL_PACK_BUFFER, 0);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+// Reads finished frames back to the CPU without stalling the pipeline
+// Each frame is copied into one of a ring of pixel buffers with a fence,
+//  and mapped only once the GPU signals the fence, a few frames later
+
+// standard headers
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+// Forward declaration
+class opengl_context;
+
+class frame_readback
+{
+public:
+    // A frame whose pixels reached the CPU
+    // RGBA8, tightly packed rows stored bottom-up
+    struct t_result {
+        std::uint64_t number = 0;
+        std::chrono::steady_clock::time_point time;
+        int width = 0;
+        int height = 0;
+        const std::uint8_t* pixels = nullptr;   // Only valid during the callback
+    };
+
+    // Receives the frames read back, in order
+    using t_callback = std::function<void(const t_result&)>;
+
+    // Default number of frames in flight
+    static constexpr std::size_t s_default_depth = 3;
+
+public:
+    // Constructor
+    // Up to `p_depth` frames can be in flight
+    explicit frame_readback(opengl_context& p_context, const std::size_t p_depth = s_default_depth);
+
+    // Destructor
+    // Releases the pixel buffers, frames in flight are abandoned
+    ~frame_readback();
+
+    // Prevent copy
+    frame_readback(const frame_readback&) = delete;
+    frame_readback& operator=(const frame_readback&) = delete;
+
+    // Start reading the bottom-left `p_width` x `p_height` pixels of the
+    //  read framebuffer
+    // Frames that completed are passed to `p_done` first, if every buffer
+    //  is still in flight the oldest frame is waited for
+    void read(
+        const int p_width,
+        const int p_height,
+        const std::uint64_t p_number,
+        const t_callback& p_done);
+
+    // Pass the frames that completed to `p_done`
+    // If `p_wait` is true, waits for every frame in flight
+    void poll(const t_callback& p_done, const bool p_wait = false);
+
+    // Number of frames in flight
+    std::size_t get_pending_count() const;
+
+private:
+    struct t_slot {
+        unsigned int buffer = 0;    // Pixel buffer
+        std::size_t capacity = 0;   // Size of the buffer's storage
+        void* fence = nullptr;      // GLsync signaled when the copy is done
+        t_result result;            // Frame being read, without pixels
+    };
+
+    // Map a completed slot, pass it to `p_done` and release its fence
+    void deliver(t_slot& p_slot, const t_callback& p_done);
+
+private:
+    // Context owning the buffers
+    opengl_context* m_context = nullptr;
+
+    // Ring of pixel buffers
+    std::vector<t_slot> m_slots;
+
+    // Oldest frame in flight and number of frames in flight
+    std::size_t m_first = 0;
+    std::size_t m_pending = 0;
+
+};  // class frame_readback
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
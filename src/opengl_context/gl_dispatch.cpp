@@ -0,0 +1,75 @@
+#include "gl_dispatch.h"
+
+// standard headers
+#include <atomic>
+
+namespace {
+
+#if defined(FT_RF_NULL_GL)
+constexpr auto g_default_dispatch = ft::rf::context::t_gl_dispatch::null;
+#else
+constexpr auto g_default_dispatch = ft::rf::context::t_gl_dispatch::driver;
+#endif
+
+// Selected dispatch
+std::atomic<ft::rf::context::t_gl_dispatch> g_dispatch{ g_default_dispatch };
+
+// Counters
+// Relaxed, they are only read for statistics
+std::atomic<std::uint64_t> g_calls{ 0 };
+std::atomic<std::uint64_t> g_context_switches{ 0 };
+
+}   // anonymous namespace
+
+
+// Select the dispatch
+void ft::rf::context::set_gl_dispatch(const t_gl_dispatch p_dispatch)
+{
+    g_dispatch.store(p_dispatch, std::memory_order_relaxed);
+}
+
+
+// Get the selected dispatch
+ft::rf::context::t_gl_dispatch ft::rf::context::get_gl_dispatch()
+{
+    return g_dispatch.load(std::memory_order_relaxed);
+}
+
+
+// Is the null dispatch selected?
+bool ft::rf::context::is_null_gl_dispatch()
+{
+    return get_gl_dispatch() == t_gl_dispatch::null;
+}
+
+
+// Get the counters since the last reset, for all threads
+ft::rf::context::t_gl_dispatch_counters ft::rf::context::get_gl_dispatch_counters()
+{
+    return {
+        g_calls.load(std::memory_order_relaxed),
+        g_context_switches.load(std::memory_order_relaxed)
+    };
+}
+
+
+// Reset the counters to 0
+void ft::rf::context::reset_gl_dispatch_counters()
+{
+    g_calls.store(0, std::memory_order_relaxed);
+    g_context_switches.store(0, std::memory_order_relaxed);
+}
+
+
+// Count a call
+void ft::rf::context::count_gl_call()
+{
+    g_calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+// Count a context switch
+void ft::rf::context::count_gl_context_switch()
+{
+    g_context_switches.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+// Selects where OpenGL calls made through `call_opengl` and
+//  `opengl_function` are sent, and counts them
+//
+// The null dispatch never touches the driver : the calls are answered by
+//  null_gl with minimal fake state, which is used to measure the library's
+//  own CPU overhead
+// It is the default when built with FT_RF_NULL_GL, and can be selected at
+//  run time with `set_gl_dispatch` before creating any render frame or context
+// Changing the dispatch while contexts exist is not supported
+
+// standard headers
+#include <cstdint>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+enum class t_gl_dispatch {
+    driver, // Default mode
+    null    // Never calls the driver
+};
+
+// Call counters, counted with every dispatch
+struct t_gl_dispatch_counters
+{
+    // Calls made through `call_opengl` and its variants
+    std::uint64_t calls = 0;
+
+    // Contexts made active by `make_current`
+    std::uint64_t context_switches = 0;
+
+};  // struct t_gl_dispatch_counters
+
+
+// Select the dispatch
+void set_gl_dispatch(const t_gl_dispatch p_dispatch);
+
+// Get the selected dispatch
+t_gl_dispatch get_gl_dispatch();
+
+// Is the null dispatch selected?
+bool is_null_gl_dispatch();
+
+// Get the counters since the last reset, for all threads
+t_gl_dispatch_counters get_gl_dispatch_counters();
+
+// Reset the counters to 0
+void reset_gl_dispatch_counters();
+
+// Count a call
+void count_gl_call();
+
+// Count a context switch
+void count_gl_context_switch();
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,318 @@
+#include "gpu_memory_tracker.h"
+
+// project headers
+#include "call_opengl_function.h"
+#include "opengl_context.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// standard headers
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Bytes per texel of an internal format
+// Unknown formats count as 4, the most common size
+std::uint64_t get_texel_size(const GLenum p_internal_format)
+{
+    switch (p_internal_format)
+    {
+    case GL_R8:
+    case GL_STENCIL_INDEX8:
+        return 1;
+    case GL_RG8:
+    case GL_R16F:
+    case GL_DEPTH_COMPONENT16:
+        return 2;
+    case GL_RGB8:
+    case GL_SRGB8:
+    case GL_DEPTH_COMPONENT24:
+        return 3;
+    case GL_RGBA8:
+    case GL_SRGB8_ALPHA8:
+    case GL_RG16F:
+    case GL_R32F:
+    case GL_R11F_G11F_B10F:
+    case GL_RGB10_A2:
+    case GL_DEPTH24_STENCIL8:
+    case GL_DEPTH_COMPONENT32F:
+        return 4;
+    case GL_RGBA16F:
+    case GL_RG32F:
+    case GL_DEPTH32F_STENCIL8:
+        return 8;
+    case GL_RGBA32F:
+        return 16;
+    default:
+        return 4;
+    }
+}
+
+}   // anonymous namespace
+
+
+// Record that object `p_name` of `p_category` uses `p_bytes` for `p_tag`
+// Replaces the object's previous record
+void ft::rf::context::gpu_memory_tracker::track(
+    const opengl_context & p_context,
+    const t_gpu_memory_category p_category,
+    const unsigned int p_name,
+    const std::uint64_t p_bytes,
+    std::string_view p_tag)
+{
+    auto crossings = std::vector<t_budget_event>{};
+    auto callback = t_callback{};
+    {
+        std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+
+        auto [found, is_new] = m_objects.try_emplace(t_object_key{ p_context.get_share_group(), p_category, p_name });
+        auto & object = found->second;
+        const auto old_bytes = static_cast<std::int64_t>(object.bytes);
+        const auto new_bytes = static_cast<std::int64_t>(p_bytes);
+
+        // The previous record's tag loses the object
+        if (is_new == false && object.tag != p_tag)
+        {
+            auto & old_tag = m_tags[object.tag];
+            apply(old_tag, -old_bytes, -1, { t_scope::tag, p_category, object.tag });
+            apply(m_tags[std::string{ p_tag }], new_bytes, 1, { t_scope::tag, p_category, std::string{ p_tag } });
+        }
+        else
+        {
+            apply(m_tags[std::string{ p_tag }], new_bytes - old_bytes, is_new ? 1 : 0, { t_scope::tag, p_category, std::string{ p_tag } });
+        }
+
+        apply(m_categories[static_cast<std::size_t>(p_category)], new_bytes - old_bytes, is_new ? 1 : 0, { t_scope::category, p_category });
+        apply(m_total, new_bytes - old_bytes, is_new ? 1 : 0, { t_scope::total });
+
+        object.bytes = p_bytes;
+        object.tag = p_tag;
+
+        crossings.swap(m_crossings);
+        if (crossings.empty() == false) {
+            callback = m_callback;
+        }
+    }
+
+    if (callback != nullptr)
+    {
+        for (const auto & crossing : crossings) {
+            callback(crossing);
+        }
+    }
+}
+
+
+// Forget object `p_name`, does nothing if it isn't recorded
+void ft::rf::context::gpu_memory_tracker::untrack(
+    const opengl_context & p_context,
+    const t_gpu_memory_category p_category,
+    const unsigned int p_name)
+{
+    auto crossings = std::vector<t_budget_event>{};
+    auto callback = t_callback{};
+    {
+        std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+
+        const auto found = m_objects.find(t_object_key{ p_context.get_share_group(), p_category, p_name });
+        if (found == m_objects.end())
+        {
+            return;
+        }
+
+        const auto bytes = static_cast<std::int64_t>(found->second.bytes);
+        const auto & tag = found->second.tag;
+        apply(m_tags[tag], -bytes, -1, { t_scope::tag, p_category, tag });
+        apply(m_categories[static_cast<std::size_t>(p_category)], -bytes, -1, { t_scope::category, p_category });
+        apply(m_total, -bytes, -1, { t_scope::total });
+        m_objects.erase(found);
+
+        crossings.swap(m_crossings);
+        if (crossings.empty() == false) {
+            callback = m_callback;
+        }
+    }
+
+    if (callback != nullptr)
+    {
+        for (const auto & crossing : crossings) {
+            callback(crossing);
+        }
+    }
+}
+
+
+// Get the usage of every object
+ft::rf::context::gpu_memory_tracker::t_usage
+ft::rf::context::gpu_memory_tracker::get_total_usage() const
+{
+    std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+    return m_total.usage;
+}
+
+
+// Get the usage of a category
+ft::rf::context::gpu_memory_tracker::t_usage
+ft::rf::context::gpu_memory_tracker::get_usage(const t_gpu_memory_category p_category) const
+{
+    std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+    return m_categories[static_cast<std::size_t>(p_category)].usage;
+}
+
+
+// Get the usage of a tag
+ft::rf::context::gpu_memory_tracker::t_usage
+ft::rf::context::gpu_memory_tracker::get_usage(std::string_view p_tag) const
+{
+    std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+    const auto found = m_tags.find(p_tag);
+    return (found != m_tags.end()) ? found->second.usage : t_usage{};
+}
+
+
+// Get the usage of every tag
+std::map<std::string, ft::rf::context::gpu_memory_tracker::t_usage, std::less<>>
+ft::rf::context::gpu_memory_tracker::get_tag_usages() const
+{
+    std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+
+    auto result = std::map<std::string, t_usage, std::less<>>{};
+    for (const auto & [tag, account] : m_tags)
+    {
+        result.emplace(tag, account.usage);
+    }
+    return result;
+}
+
+
+// Set a budget on every object, 0 removes it
+void ft::rf::context::gpu_memory_tracker::set_total_budget(const std::uint64_t p_bytes)
+{
+    std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+    m_total.budget = p_bytes;
+}
+
+
+// Set a budget on a category, 0 removes it
+void ft::rf::context::gpu_memory_tracker::set_budget(
+    const t_gpu_memory_category p_category,
+    const std::uint64_t p_bytes)
+{
+    std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+    m_categories[static_cast<std::size_t>(p_category)].budget = p_bytes;
+}
+
+
+// Set a budget on a tag, 0 removes it
+void ft::rf::context::gpu_memory_tracker::set_budget(std::string_view p_tag, const std::uint64_t p_bytes)
+{
+    std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+    m_tags[std::string{ p_tag }].budget = p_bytes;
+}
+
+
+// Set the function told about budget crossings
+void ft::rf::context::gpu_memory_tracker::set_budget_callback(t_callback p_callback)
+{
+    std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+    m_callback = std::move(p_callback);
+}
+
+
+// Ask the driver how much video memory there is
+// A context must be active on the calling thread
+std::optional<ft::rf::context::gpu_memory_tracker::t_driver_memory>
+ft::rf::context::gpu_memory_tracker::query_driver_memory()
+{
+    // Both extensions report kilobytes
+    constexpr std::uint64_t kilobyte = 1024;
+
+    if (GLEW_NVX_gpu_memory_info != 0)
+    {
+        auto total = GLint{ 0 };
+        auto available = GLint{ 0 };
+        call_opengl<err::context_edit_error>(glGetIntegerv, GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &total);
+        call_opengl<err::context_edit_error>(glGetIntegerv, GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+        return t_driver_memory{
+            static_cast<std::uint64_t>(total) * kilobyte,
+            static_cast<std::uint64_t>(available) * kilobyte };
+    }
+
+    if (GLEW_ATI_meminfo != 0)
+    {
+        // Free memory of the pool, largest free block, free auxiliary
+        //  memory and largest auxiliary free block
+        // The pool's total size isn't reported
+        GLint values[4] = {};
+        call_opengl<err::context_edit_error>(glGetIntegerv, GL_TEXTURE_FREE_MEMORY_ATI, values);
+        return t_driver_memory{ 0, static_cast<std::uint64_t>(values[0]) * kilobyte };
+    }
+
+    return std::nullopt;
+}
+
+
+// Apply a change to an account, records the budget crossing if any
+// The lock must be held
+void ft::rf::context::gpu_memory_tracker::apply(
+    t_account & p_account,
+    const std::int64_t p_delta,
+    const std::int64_t p_object_delta,
+    t_budget_event p_event)
+{
+    auto & usage = p_account.usage;
+    const auto before = usage.bytes;
+
+    usage.bytes = static_cast<std::uint64_t>(static_cast<std::int64_t>(usage.bytes) + p_delta);
+    usage.objects = static_cast<std::uint64_t>(static_cast<std::int64_t>(usage.objects) + p_object_delta);
+    usage.peak_bytes = std::max(usage.peak_bytes, usage.bytes);
+
+    if (p_account.budget == 0)
+    {
+        return;
+    }
+
+    const auto was_over = before > p_account.budget;
+    const auto is_over = usage.bytes > p_account.budget;
+    if (was_over != is_over)
+    {
+        p_event.bytes = usage.bytes;
+        p_event.budget = p_account.budget;
+        p_event.exceeded = is_over;
+        m_crossings.push_back(std::move(p_event));
+    }
+}
+
+
+// Tracker for the process
+ft::rf::context::gpu_memory_tracker & ft::rf::context::get_gpu_memory_tracker()
+{
+    static auto tracker = gpu_memory_tracker{};
+    return tracker;
+}
+
+
+// Estimated size of a texture's storage
+std::uint64_t ft::rf::context::estimate_texture_size(
+    const unsigned int p_internal_format,
+    const int p_width,
+    const int p_height,
+    const int p_layers,
+    const int p_levels)
+{
+    const auto texel_size = get_texel_size(p_internal_format);
+
+    std::uint64_t result = 0;
+    auto width = std::max(p_width, 1);
+    auto height = std::max(p_height, 1);
+    for (int level = 0; level < std::max(p_levels, 1); ++level)
+    {
+        result += static_cast<std::uint64_t>(width) * height * texel_size;
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+    return result * static_cast<std::uint64_t>(std::max(p_layers, 1));
+}
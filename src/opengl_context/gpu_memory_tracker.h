@@ -0,0 +1,178 @@
+#pragma once
+
+// Accounts for the GPU memory used by OpenGL objects
+//
+// Objects are recorded with an estimated size, a category and an owner tag
+// Usage is summed per category, per tag and in total, with high-water marks
+// Budgets can be set on each sum, a callback is told when usage crosses
+//  a budget in either direction
+// The library records the objects it creates, applications record theirs
+//  with `track` and `untrack`
+// Objects are identified by their context's share group and their name,
+//  unshared contexts hand out the same names for different objects
+// The driver's own view of video memory is available through
+//  `query_driver_memory` when it exposes NVX_gpu_memory_info or ATI_meminfo
+
+// standard headers
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+enum class t_gpu_memory_category {
+    texture,
+    buffer,
+    renderbuffer,
+    program
+};
+
+// Number of categories
+constexpr std::size_t g_gpu_memory_category_count = 4;
+
+// Forward declaration
+class opengl_context;
+
+
+class gpu_memory_tracker
+{
+public:
+    // Usage of a category, a tag or of every object
+    struct t_usage {
+        std::uint64_t bytes = 0;
+        std::uint64_t peak_bytes = 0;
+        std::uint64_t objects = 0;
+    };
+
+    // What a budget applies to
+    enum class t_scope {
+        total,
+        category,
+        tag
+    };
+
+    // Reported when usage crosses a budget
+    struct t_budget_event {
+        t_scope scope = t_scope::total;
+        t_gpu_memory_category category = t_gpu_memory_category::texture;   // For category budgets
+        std::string tag;                                                    // For tag budgets
+        std::uint64_t bytes = 0;
+        std::uint64_t budget = 0;
+        bool exceeded = true;   // False when usage went back under the budget
+    };
+
+    // Called without the tracker's lock, may call the tracker
+    using t_callback = std::function<void(const t_budget_event&)>;
+
+    // Video memory reported by the driver, in bytes
+    struct t_driver_memory {
+        std::uint64_t total = 0;        // 0 if unknown
+        std::uint64_t available = 0;
+    };
+
+public:
+    // Record that object `p_name` of `p_category` uses `p_bytes` for `p_tag`
+    // `p_context` is the context the object was created with, or one
+    //  sharing its objects
+    // Replaces the object's previous record, when its storage is respecified
+    void track(
+        const opengl_context& p_context,
+        const t_gpu_memory_category p_category,
+        const unsigned int p_name,
+        const std::uint64_t p_bytes,
+        std::string_view p_tag);
+
+    // Forget object `p_name`, does nothing if it isn't recorded
+    void untrack(
+        const opengl_context& p_context,
+        const t_gpu_memory_category p_category,
+        const unsigned int p_name);
+
+    // Get the usage of every object, of a category or of a tag
+    t_usage get_total_usage() const;
+    t_usage get_usage(const t_gpu_memory_category p_category) const;
+    t_usage get_usage(std::string_view p_tag) const;
+
+    // Get the usage of every tag
+    std::map<std::string, t_usage, std::less<>> get_tag_usages() const;
+
+    // Set a budget in bytes, 0 removes it
+    void set_total_budget(const std::uint64_t p_bytes);
+    void set_budget(const t_gpu_memory_category p_category, const std::uint64_t p_bytes);
+    void set_budget(std::string_view p_tag, const std::uint64_t p_bytes);
+
+    // Set the function told about budget crossings
+    void set_budget_callback(t_callback p_callback);
+
+    // Ask the driver how much video memory there is
+    // A context must be active on the calling thread
+    // Returns nothing if the driver has no memory information extension
+    static std::optional<t_driver_memory> query_driver_memory();
+
+private:
+    // A recorded object
+    struct t_object {
+        std::uint64_t bytes = 0;
+        std::string tag;
+    };
+
+    // Identifies an object : share group, category and name
+    using t_object_key = std::tuple<std::uint64_t, t_gpu_memory_category, unsigned int>;
+
+    // A sum with its budget
+    struct t_account {
+        t_usage usage;
+        std::uint64_t budget = 0;
+    };
+
+    // Apply a change to an account, records the budget crossing if any
+    // The lock must be held
+    void apply(t_account& p_account, const std::int64_t p_delta, const std::int64_t p_object_delta, t_budget_event p_event);
+
+private:
+    // Protects everything below
+    mutable std::mutex m_mutex;
+
+    // Recorded objects by share group, category and name
+    std::map<t_object_key, t_object> m_objects;
+
+    // Sums
+    t_account m_total;
+    std::array<t_account, g_gpu_memory_category_count> m_categories;
+    std::map<std::string, t_account, std::less<>> m_tags;
+
+    // Told about budget crossings
+    t_callback m_callback;
+
+    // Crossings found while the lock is held, reported once it is released
+    std::vector<t_budget_event> m_crossings;
+
+};  // class gpu_memory_tracker
+
+
+// Tracker for the process, sums the objects of every context
+gpu_memory_tracker& get_gpu_memory_tracker();
+
+// Estimated size of a texture's storage
+// `p_levels` mip levels starting at `p_width` x `p_height`, times `p_layers`
+std::uint64_t estimate_texture_size(
+    const unsigned int p_internal_format,
+    const int p_width,
+    const int p_height,
+    const int p_layers = 1,
+    const int p_levels = 1);
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,103 @@
+#include "gpu_timer.h"
+
+// project headers
+#include "call_opengl_function.h"
+#include "make_current.h"
+#include "opengl_context.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+
+// Constructor
+// Up to `p_depth` measurements can be in flight, further ones are skipped
+ft::rf::context::gpu_timer::gpu_timer(opengl_context & p_context, const std::size_t p_depth) :
+    m_context(&p_context),
+    m_queries(p_depth)
+{
+    FT_ASSERT(p_depth > 0);
+
+    auto active = make_current{ *m_context };
+    call_opengl<err::context_init>(glGenQueries, static_cast<GLsizei>(m_queries.size()), m_queries.data());
+}
+
+
+// Destructor
+ft::rf::context::gpu_timer::~gpu_timer()
+{
+    auto active = make_current{ *m_context };
+    if (m_running)
+    {
+        call_opengl_skip_errors(glEndQuery, GL_TIME_ELAPSED);
+    }
+    call_opengl_skip_errors(glDeleteQueries, static_cast<GLsizei>(m_queries.size()), m_queries.data());
+}
+
+
+// Start measuring
+void ft::rf::context::gpu_timer::begin()
+{
+    FT_ASSERT(m_running == false);
+
+    // Skip this measurement rather than waiting for an old one
+    if (m_pending == m_queries.size())
+    {
+        return;
+    }
+
+    auto active = make_current{ *m_context };
+    const auto query = m_queries[(m_first + m_pending) % m_queries.size()];
+    call_opengl<err::context_edit_error>(glBeginQuery, GL_TIME_ELAPSED, query);
+    m_running = true;
+}
+
+
+// Stop measuring
+void ft::rf::context::gpu_timer::end()
+{
+    if (m_running == false)
+    {
+        return;
+    }
+
+    auto active = make_current{ *m_context };
+    call_opengl<err::context_edit_error>(glEndQuery, GL_TIME_ELAPSED);
+    m_running = false;
+    ++m_pending;
+}
+
+
+// Collect the measurements the GPU finished
+// Returns true and sets `p_nanoseconds` to the latest one if there is any
+bool ft::rf::context::gpu_timer::poll(std::uint64_t & p_nanoseconds)
+{
+    auto active = make_current{ *m_context };
+
+    // Queries complete in order, stop at the first one still in flight
+    auto found = false;
+    while (m_pending > 0)
+    {
+        const auto query = m_queries[m_first];
+
+        auto available = GLint{ 0 };
+        call_opengl<err::context_edit_error>(glGetQueryObjectiv, query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == 0)
+        {
+            break;
+        }
+
+        auto elapsed = GLuint64{ 0 };
+        call_opengl<err::context_edit_error>(glGetQueryObjectui64v, query, GL_QUERY_RESULT, &elapsed);
+        p_nanoseconds = elapsed;
+        found = true;
+
+        m_first = (m_first + 1) % m_queries.size();
+        --m_pending;
+    }
+
+    return found;
+}
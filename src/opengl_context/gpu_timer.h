@@ -0,0 +1,66 @@
+#pragma once
+
+// Measures the GPU time spent between `begin` and `end` with timer queries
+// Results arrive a few frames late, the queries are only read once
+//  the GPU made them available so the CPU never waits
+
+// standard headers
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+// Forward declaration
+class opengl_context;
+
+class gpu_timer
+{
+public:
+    // Default number of measurements in flight
+    static constexpr std::size_t s_default_depth = 4;
+
+public:
+    // Constructor
+    // Up to `p_depth` measurements can be in flight, further ones are skipped
+    explicit gpu_timer(opengl_context& p_context, const std::size_t p_depth = s_default_depth);
+
+    // Destructor
+    ~gpu_timer();
+
+    // Prevent copy
+    gpu_timer(const gpu_timer&) = delete;
+    gpu_timer& operator=(const gpu_timer&) = delete;
+
+    // Start measuring
+    // Timer queries can't be nested, a single measurement can be running
+    void begin();
+
+    // Stop measuring
+    void end();
+
+    // Collect the measurements the GPU finished
+    // Returns true and sets `p_nanoseconds` to the latest one if there is any
+    bool poll(std::uint64_t& p_nanoseconds);
+
+private:
+    // Context owning the queries
+    opengl_context* m_context = nullptr;
+
+    // Ring of GL_TIME_ELAPSED queries
+    std::vector<unsigned int> m_queries;
+
+    // Oldest measurement in flight and number of measurements in flight
+    std::size_t m_first = 0;
+    std::size_t m_pending = 0;
+
+    // Is a measurement running?
+    bool m_running = false;
+
+};  // class gpu_timer
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,594 @@
+#include "image_decoder.h"
+
+// project headers
+#include "inflate.h"
+#include "simd/pixel_kernels.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// First bytes of every PNG file
+constexpr std::array<std::uint8_t, 8> g_png_signature = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+// Largest width or height accepted, above any texture size limit
+constexpr std::uint32_t g_max_size = 1 << 16;
+
+
+// Does `p_path` have extension `p_extension`, ignoring case?
+bool has_extension(const std::filesystem::path & p_path, const char* p_extension)
+{
+    auto extension = p_path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](const char p_char) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(p_char)));
+    });
+    return extension == p_extension;
+}
+
+
+// Read a big endian 32 bit integer
+std::uint32_t read_u32_be(const std::uint8_t* p_data)
+{
+    return (std::uint32_t{ p_data[0] } << 24) | (std::uint32_t{ p_data[1] } << 16) |
+        (std::uint32_t{ p_data[2] } << 8) | std::uint32_t{ p_data[3] };
+}
+
+
+// Read a little endian 16 bit integer
+std::uint16_t read_u16_le(const std::uint8_t* p_data)
+{
+    return static_cast<std::uint16_t>(p_data[0] | (p_data[1] << 8));
+}
+
+
+// Make an image of `p_width` x `p_height` with one level
+ft::rf::context::t_texture_image make_image(const std::uint32_t p_width, const std::uint32_t p_height)
+{
+    if (p_width == 0 || p_height == 0 || p_width > g_max_size || p_height > g_max_size)
+    {
+        ft::rf::err::context_edit_error::raise("Invalid image size");
+    }
+
+    auto result = ft::rf::context::t_texture_image{};
+    result.width = static_cast<int>(p_width);
+    result.height = static_cast<int>(p_height);
+    result.levels.emplace_back(static_cast<std::size_t>(p_width) * p_height * 4);
+    return result;
+}
+
+
+// Paeth predictor of PNG's filter type 4
+std::uint8_t paeth(const int p_left, const int p_up, const int p_up_left)
+{
+    const auto estimate = p_left + p_up - p_up_left;
+    const auto left_distance = std::abs(estimate - p_left);
+    const auto up_distance = std::abs(estimate - p_up);
+    const auto up_left_distance = std::abs(estimate - p_up_left);
+    if (left_distance <= up_distance && left_distance <= up_left_distance) {
+        return static_cast<std::uint8_t>(p_left);
+    }
+    if (up_distance <= up_left_distance) {
+        return static_cast<std::uint8_t>(p_up);
+    }
+    return static_cast<std::uint8_t>(p_up_left);
+}
+
+
+// Undo the filter of each row in place
+// `p_data` holds each row prefixed by its filter type
+void unfilter_png(
+    std::vector<std::uint8_t> & p_data,
+    const std::size_t p_row_size,
+    const std::size_t p_pixel_size,
+    const std::uint32_t p_height)
+{
+    const std::uint8_t* previous = nullptr;
+    for (std::uint32_t y = 0; y < p_height; ++y)
+    {
+        auto* row = p_data.data() + y * (p_row_size + 1);
+        const auto filter = row[0];
+        ++row;
+
+        for (std::size_t x = 0; x < p_row_size; ++x)
+        {
+            const int left = (x >= p_pixel_size) ? row[x - p_pixel_size] : 0;
+            const int up = (previous != nullptr) ? previous[x] : 0;
+            const int up_left = (previous != nullptr && x >= p_pixel_size) ? previous[x - p_pixel_size] : 0;
+
+            switch (filter)
+            {
+            case 0:
+                break;
+            case 1:
+                row[x] = static_cast<std::uint8_t>(row[x] + left);
+                break;
+            case 2:
+                row[x] = static_cast<std::uint8_t>(row[x] + up);
+                break;
+            case 3:
+                row[x] = static_cast<std::uint8_t>(row[x] + (left + up) / 2);
+                break;
+            case 4:
+                row[x] = static_cast<std::uint8_t>(row[x] + paeth(left, up, up_left));
+                break;
+            default:
+                ft::rf::err::context_edit_error::raise("Invalid PNG filter type");
+            }
+        }
+        previous = row;
+    }
+}
+
+
+// Sample `p_index` of a row of `p_depth` bit samples, at full precision
+std::uint32_t get_png_sample(const std::uint8_t* p_row, const std::size_t p_index, const int p_depth)
+{
+    if (p_depth == 8) {
+        return p_row[p_index];
+    }
+    if (p_depth == 16) {
+        return (std::uint32_t{ p_row[p_index * 2] } << 8) | p_row[p_index * 2 + 1];
+    }
+
+    // Smaller samples are packed from the most significant bit
+    const auto bit = p_index * p_depth;
+    const auto shift = 8 - p_depth - static_cast<int>(bit % 8);
+    return (p_row[bit / 8] >> shift) & ((1u << p_depth) - 1);
+}
+
+
+// Scale a `p_depth` bit sample to 8 bits
+std::uint8_t scale_png_sample(const std::uint32_t p_sample, const int p_depth)
+{
+    if (p_depth == 8) {
+        return static_cast<std::uint8_t>(p_sample);
+    }
+    if (p_depth == 16) {
+        return static_cast<std::uint8_t>(p_sample >> 8);
+    }
+    return static_cast<std::uint8_t>(p_sample * 255 / ((1u << p_depth) - 1));
+}
+
+}   // anonymous namespace
+
+
+// Can this decoder decode the file at `p_path` holding `p_data`?
+bool ft::rf::context::png_decoder::accepts(
+    const std::filesystem::path &,
+    std::span<const std::uint8_t> p_data) const
+{
+    return p_data.size() >= g_png_signature.size() &&
+        std::equal(g_png_signature.begin(), g_png_signature.end(), p_data.begin());
+}
+
+
+// Decode a file's contents into a single level image
+ft::rf::context::t_texture_image
+ft::rf::context::png_decoder::decode(std::span<const std::uint8_t> p_data) const
+{
+    if (accepts({}, p_data) == false)
+    {
+        err::context_edit_error::raise("Not a PNG file");
+    }
+
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    int depth = 0;
+    int color_type = -1;
+    std::vector<std::uint8_t> palette;                  // RGBA entries
+    std::vector<std::uint8_t> compressed;
+    std::array<std::uint32_t, 3> transparent_key = {};  // Gray or RGB sample made transparent
+    bool has_key = false;
+
+    // Chunks : length, type, data and CRC, which isn't checked
+    auto position = g_png_signature.size();
+    while (true)
+    {
+        if (p_data.size() - position < 12)
+        {
+            err::context_edit_error::raise("Truncated PNG file");
+        }
+        const auto length = read_u32_be(p_data.data() + position);
+        const auto* type = p_data.data() + position + 4;
+        const auto* data = p_data.data() + position + 8;
+        if (length > p_data.size() - position - 12)
+        {
+            err::context_edit_error::raise("Truncated PNG chunk");
+        }
+        position += 12 + length;
+
+        if (std::memcmp(type, "IHDR", 4) == 0)
+        {
+            if (length < 13)
+            {
+                err::context_edit_error::raise("Invalid PNG header");
+            }
+            width = read_u32_be(data);
+            height = read_u32_be(data + 4);
+            depth = data[8];
+            color_type = data[9];
+            if (data[12] != 0)
+            {
+                err::context_edit_error::raise("Interlaced PNG images aren't supported");
+            }
+        }
+        else if (std::memcmp(type, "PLTE", 4) == 0)
+        {
+            palette.assign(static_cast<std::size_t>(length / 3) * 4, 255);
+            for (std::uint32_t entry = 0; entry < length / 3; ++entry)
+            {
+                std::memcpy(palette.data() + entry * 4, data + entry * 3, 3);
+            }
+        }
+        else if (std::memcmp(type, "tRNS", 4) == 0)
+        {
+            if (color_type == 3)
+            {
+                for (std::uint32_t entry = 0; entry < length && entry * 4 < palette.size(); ++entry)
+                {
+                    palette[entry * 4 + 3] = data[entry];
+                }
+            }
+            else if ((color_type == 0 && length >= 2) || (color_type == 2 && length >= 6))
+            {
+                for (std::uint32_t channel = 0; channel * 2 < length && channel < 3; ++channel)
+                {
+                    transparent_key[channel] = (std::uint32_t{ data[channel * 2] } << 8) | data[channel * 2 + 1];
+                }
+                has_key = true;
+            }
+        }
+        else if (std::memcmp(type, "IDAT", 4) == 0)
+        {
+            compressed.insert(compressed.end(), data, data + length);
+        }
+        else if (std::memcmp(type, "IEND", 4) == 0)
+        {
+            break;
+        }
+    }
+
+    int channels = 0;
+    switch (color_type)
+    {
+    case 0: channels = 1; break;
+    case 2: channels = 3; break;
+    case 3: channels = 1; break;
+    case 4: channels = 2; break;
+    case 6: channels = 4; break;
+    default:
+        err::context_edit_error::raise("Invalid PNG color type");
+    }
+    const auto valid_depth =
+        (depth == 8) ||
+        (depth == 16 && color_type != 3) ||
+        ((depth == 1 || depth == 2 || depth == 4) && (color_type == 0 || color_type == 3));
+    if (valid_depth == false)
+    {
+        err::context_edit_error::raise("Invalid PNG bit depth");
+    }
+    if (color_type == 3 && palette.empty())
+    {
+        err::context_edit_error::raise("PNG image without a palette");
+    }
+
+    auto result = make_image(width, height);
+
+    const auto row_size = (static_cast<std::size_t>(width) * channels * depth + 7) / 8;
+    const auto pixel_size = std::max<std::size_t>(static_cast<std::size_t>(channels * depth / 8), 1);
+    auto pixels = std::vector<std::uint8_t>{};
+    try
+    {
+        pixels = zlib_decompress(compressed, (row_size + 1) * height);
+    }
+    catch (const t_except_inflate & p_error)
+    {
+        err::context_edit_error::raise(p_error.what());
+    }
+    if (pixels.size() < (row_size + 1) * height)
+    {
+        err::context_edit_error::raise("Truncated PNG image data");
+    }
+    unfilter_png(pixels, row_size, pixel_size, height);
+
+    auto* out = result.levels[0].data();
+    for (std::uint32_t y = 0; y < height; ++y)
+    {
+        const auto* row = pixels.data() + y * (row_size + 1) + 1;
+
+        // 8 bit RGB and RGBA rows only need their alpha filled in
+        if (depth == 8 && (color_type == 6 || (color_type == 2 && has_key == false)))
+        {
+            if (color_type == 6) {
+                std::memcpy(out, row, static_cast<std::size_t>(width) * 4);
+            }
+            else {
+                simd::expand_rgb_rgba(row, out, width);
+            }
+            out += static_cast<std::size_t>(width) * 4;
+            continue;
+        }
+
+        for (std::uint32_t x = 0; x < width; ++x, out += 4)
+        {
+            const auto first = static_cast<std::size_t>(x) * channels;
+            if (color_type == 3)
+            {
+                const auto entry = get_png_sample(row, first, depth) * 4;
+                if (entry >= palette.size())
+                {
+                    err::context_edit_error::raise("PNG palette index out of range");
+                }
+                std::memcpy(out, palette.data() + entry, 4);
+                continue;
+            }
+
+            std::array<std::uint32_t, 4> samples = {};
+            for (int channel = 0; channel < channels; ++channel)
+            {
+                samples[channel] = get_png_sample(row, first + channel, depth);
+            }
+
+            if (channels <= 2)
+            {
+                // Gray, with or without alpha
+                const auto gray = scale_png_sample(samples[0], depth);
+                out[0] = out[1] = out[2] = gray;
+                out[3] = (channels == 2) ? scale_png_sample(samples[1], depth) :
+                    (has_key && samples[0] == transparent_key[0]) ? 0 : 255;
+            }
+            else
+            {
+                out[0] = scale_png_sample(samples[0], depth);
+                out[1] = scale_png_sample(samples[1], depth);
+                out[2] = scale_png_sample(samples[2], depth);
+                out[3] = (channels == 4) ? scale_png_sample(samples[3], depth) :
+                    (has_key &&
+                        samples[0] == transparent_key[0] &&
+                        samples[1] == transparent_key[1] &&
+                        samples[2] == transparent_key[2]) ? 0 : 255;
+            }
+        }
+    }
+
+    return result;
+}
+
+
+// Can this decoder decode the file at `p_path` holding `p_data`?
+bool ft::rf::context::tga_decoder::accepts(
+    const std::filesystem::path & p_path,
+    std::span<const std::uint8_t>) const
+{
+    // TGA files have no signature
+    return has_extension(p_path, ".tga");
+}
+
+
+// Decode a file's contents into a single level image
+ft::rf::context::t_texture_image
+ft::rf::context::tga_decoder::decode(std::span<const std::uint8_t> p_data) const
+{
+    constexpr std::size_t header_size = 18;
+    if (p_data.size() < header_size)
+    {
+        err::context_edit_error::raise("Truncated TGA header");
+    }
+
+    const auto id_length = p_data[0];
+    const auto has_map = p_data[1] != 0;
+    const auto image_type = p_data[2];
+    const auto map_first = read_u16_le(p_data.data() + 3);
+    const auto map_length = read_u16_le(p_data.data() + 5);
+    const auto map_depth = p_data[7];
+    const auto width = read_u16_le(p_data.data() + 12);
+    const auto height = read_u16_le(p_data.data() + 14);
+    const auto depth = p_data[16];
+    const auto descriptor = p_data[17];
+
+    const auto mapped = (image_type == 1 || image_type == 9);
+    const auto gray = (image_type == 3 || image_type == 11);
+    const auto rle = (image_type >= 9);
+    if (image_type != 1 && image_type != 2 && image_type != 3 &&
+        image_type != 9 && image_type != 10 && image_type != 11)
+    {
+        err::context_edit_error::raise("Unsupported TGA image type");
+    }
+    if (mapped && (has_map == false || depth != 8))
+    {
+        err::context_edit_error::raise("Invalid TGA color map");
+    }
+
+    // Convert one stored pixel of `p_depth` bits, BGR(A) order, to RGBA
+    const auto convert = [gray](const std::uint8_t* p_pixel, const int p_depth, std::uint8_t* p_out)
+    {
+        if (gray && p_depth == 8)
+        {
+            p_out[0] = p_out[1] = p_out[2] = p_pixel[0];
+            p_out[3] = 255;
+        }
+        else if (p_depth == 15 || p_depth == 16)
+        {
+            // A1R5G5B5, the attribute bit isn't reliable enough to use as alpha
+            const auto value = read_u16_le(p_pixel);
+            p_out[0] = static_cast<std::uint8_t>(((value >> 10) & 0x1F) * 255 / 31);
+            p_out[1] = static_cast<std::uint8_t>(((value >> 5) & 0x1F) * 255 / 31);
+            p_out[2] = static_cast<std::uint8_t>((value & 0x1F) * 255 / 31);
+            p_out[3] = 255;
+        }
+        else if (p_depth == 24 || p_depth == 32)
+        {
+            p_out[0] = p_pixel[2];
+            p_out[1] = p_pixel[1];
+            p_out[2] = p_pixel[0];
+            p_out[3] = (p_depth == 32) ? p_pixel[3] : 255;
+        }
+        else
+        {
+            err::context_edit_error::raise("Unsupported TGA pixel depth");
+        }
+    };
+
+    auto position = header_size + id_length;
+
+    // The color map, converted to RGBA
+    std::vector<std::uint8_t> map;
+    if (has_map)
+    {
+        const auto entry_size = static_cast<std::size_t>((map_depth + 7) / 8);
+        const auto map_size = entry_size * map_length;
+        if (p_data.size() < position + map_size)
+        {
+            err::context_edit_error::raise("Truncated TGA color map");
+        }
+        if (mapped)
+        {
+            map.resize(static_cast<std::size_t>(map_first + map_length) * 4);
+            for (std::size_t entry = 0; entry < map_length; ++entry)
+            {
+                convert(p_data.data() + position + entry * entry_size, map_depth, map.data() + (map_first + entry) * 4);
+            }
+        }
+        position += map_size;
+    }
+
+    auto result = make_image(width, height);
+    const auto pixel_size = static_cast<std::size_t>((depth + 7) / 8);
+    const auto pixel_count = static_cast<std::size_t>(width) * height;
+
+    // Pixels in file order, converted to RGBA
+    auto decoded = std::vector<std::uint8_t>(pixel_count * 4);
+    const auto store = [&](const std::uint8_t* p_pixel, const std::size_t p_index)
+    {
+        auto* out = decoded.data() + p_index * 4;
+        if (mapped)
+        {
+            const auto entry = static_cast<std::size_t>(p_pixel[0]) * 4;
+            if (entry + 4 > map.size())
+            {
+                err::context_edit_error::raise("TGA color map index out of range");
+            }
+            std::memcpy(out, map.data() + entry, 4);
+        }
+        else
+        {
+            convert(p_pixel, depth, out);
+        }
+    };
+
+    // Uncompressed images are a single run of pixels
+    for (std::size_t index = 0; index < pixel_count;)
+    {
+        auto count = pixel_count - index;
+        auto repeat = false;
+        if (rle)
+        {
+            if (position >= p_data.size())
+            {
+                err::context_edit_error::raise("Truncated TGA packet");
+            }
+            const auto packet = p_data[position++];
+            count = static_cast<std::size_t>(packet & 0x7F) + 1;
+            repeat = (packet & 0x80) != 0;
+        }
+        count = std::min(count, pixel_count - index);
+
+        const auto stored = repeat ? pixel_size : pixel_size * count;
+        if (p_data.size() < position + stored)
+        {
+            err::context_edit_error::raise("Truncated TGA image data");
+        }
+        if (repeat == false && mapped == false && (depth == 24 || depth == 32))
+        {
+            // BGR(A) runs are converted at once
+            auto* out = decoded.data() + index * 4;
+            if (depth == 24) {
+                simd::expand_rgb_rgba(p_data.data() + position, out, count);
+                simd::swizzle_rgba_bgra(out, out, count);
+            }
+            else {
+                simd::swizzle_rgba_bgra(p_data.data() + position, out, count);
+            }
+        }
+        else
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                store(p_data.data() + position + (repeat ? 0 : i * pixel_size), index + i);
+            }
+        }
+        position += stored;
+        index += count;
+    }
+
+    // Rows are stored bottom-up unless the descriptor says otherwise,
+    //  columns right to left if bit 4 is set
+    const auto bottom_up = (descriptor & 0x20) == 0;
+    const auto right_to_left = (descriptor & 0x10) != 0;
+    const auto row_size = static_cast<std::size_t>(width) * 4;
+    for (std::size_t y = 0; y < height; ++y)
+    {
+        const auto* source = decoded.data() + (bottom_up ? height - 1 - y : y) * row_size;
+        auto* target = result.levels[0].data() + y * row_size;
+        if (right_to_left)
+        {
+            for (std::size_t x = 0; x < width; ++x)
+            {
+                std::memcpy(target + x * 4, source + (width - 1 - x) * 4, 4);
+            }
+        }
+        else
+        {
+            std::memcpy(target, source, row_size);
+        }
+    }
+
+    return result;
+}
+
+
+// Constructor
+// Accepts ".raw" files of exactly `p_width` x `p_height` pixels
+ft::rf::context::raw_decoder::raw_decoder(const int p_width, const int p_height) :
+    m_width(p_width),
+    m_height(p_height)
+{
+    FT_ASSERT(p_width > 0 && p_height > 0);
+}
+
+
+// Can this decoder decode the file at `p_path` holding `p_data`?
+bool ft::rf::context::raw_decoder::accepts(
+    const std::filesystem::path & p_path,
+    std::span<const std::uint8_t> p_data) const
+{
+    return has_extension(p_path, ".raw") &&
+        p_data.size() == static_cast<std::size_t>(m_width) * m_height * 4;
+}
+
+
+// Decode a file's contents into a single level image
+ft::rf::context::t_texture_image
+ft::rf::context::raw_decoder::decode(std::span<const std::uint8_t> p_data) const
+{
+    auto result = make_image(static_cast<std::uint32_t>(m_width), static_cast<std::uint32_t>(m_height));
+    if (p_data.size() != result.levels[0].size())
+    {
+        err::context_edit_error::raise("Raw image of the wrong size");
+    }
+    std::memcpy(result.levels[0].data(), p_data.data(), p_data.size());
+    return result;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+// Turns image files into RGBA8 pixels for the image pipeline
+// Decoders are tried in turn on each file, the first one accepting it
+//  decodes it, see image_pipeline::add_decoder
+
+// project headers
+#include "texture_image.h"
+
+// standard headers
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+class image_decoder
+{
+public:
+    // Destructor
+    virtual ~image_decoder() = default;
+
+    // Can this decoder decode the file at `p_path` holding `p_data`?
+    virtual bool accepts(const std::filesystem::path& p_path, std::span<const std::uint8_t> p_data) const = 0;
+
+    // Decode a file's contents into a single level image
+    // Called from worker threads, possibly concurrently
+    // Raises err::context_edit_error if the file is invalid
+    virtual t_texture_image decode(std::span<const std::uint8_t> p_data) const = 0;
+
+};  // class image_decoder
+
+
+// PNG images of any color type and bit depth, without interlacing
+class png_decoder : public image_decoder
+{
+public:
+    bool accepts(const std::filesystem::path& p_path, std::span<const std::uint8_t> p_data) const override;
+    t_texture_image decode(std::span<const std::uint8_t> p_data) const override;
+
+};  // class png_decoder
+
+
+// TGA images, true color, grayscale or color mapped, with or without
+//  run-length encoding
+class tga_decoder : public image_decoder
+{
+public:
+    bool accepts(const std::filesystem::path& p_path, std::span<const std::uint8_t> p_data) const override;
+    t_texture_image decode(std::span<const std::uint8_t> p_data) const override;
+
+};  // class tga_decoder
+
+
+// Headerless RGBA8 files of a known size, top row first, like the frames
+//  written by frame_recorder's raw format
+class raw_decoder : public image_decoder
+{
+public:
+    // Constructor
+    // Accepts ".raw" files of exactly `p_width` x `p_height` pixels
+    raw_decoder(const int p_width, const int p_height);
+
+    bool accepts(const std::filesystem::path& p_path, std::span<const std::uint8_t> p_data) const override;
+    t_texture_image decode(std::span<const std::uint8_t> p_data) const override;
+
+private:
+    // Size of the images
+    int m_width = 0;
+    int m_height = 0;
+
+};  // class raw_decoder
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,448 @@
+#include "image_pipeline.h"
+
+// project headers
+#include "call_opengl_function.h"
+#include "gpu_memory_tracker.h"
+#include "make_current.h"
+#include "object_caches.h"
+#include "opengl_context.h"
+#include "jobs/job_system.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// standard headers
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <utility>
+
+namespace {
+
+// Owner tag of the textures in the GPU memory tracker
+constexpr const char* g_tracker_tag = "image_pipeline";
+
+// Time the upload thread waits on the oldest fence before checking
+//  for new uploads, in nanoseconds
+constexpr GLuint64 g_fence_poll = 1000000;
+
+
+// Throughput of `p_amount` done in `p_busy`
+double get_rate(const std::uint64_t p_amount, const std::chrono::nanoseconds p_busy)
+{
+    if (p_busy.count() <= 0)
+    {
+        return 0.0;
+    }
+    return static_cast<double>(p_amount) / std::chrono::duration<double>(p_busy).count();
+}
+
+}   // anonymous namespace
+
+
+// Has the load completed?
+bool ft::rf::context::t_async_texture::is_ready() const
+{
+    return texture.valid() &&
+        texture.wait_for(std::chrono::seconds{ 0 }) == std::future_status::ready;
+}
+
+
+// The texture if it was loaded successfully
+// `p_fallback` while the load is pending or if it failed
+unsigned int ft::rf::context::t_async_texture::get_or(const unsigned int p_fallback) const
+{
+    if (is_ready() == false)
+    {
+        return p_fallback;
+    }
+
+    try
+    {
+        return texture.get();
+    }
+    catch (...)
+    {
+        return p_fallback;
+    }
+}
+
+
+// Throughput while busy, 0 before the first item
+double ft::rf::context::t_image_stage_metrics::get_items_per_second() const
+{
+    return get_rate(items, busy);
+}
+
+
+// Throughput while busy, 0 before the first item
+double ft::rf::context::t_image_stage_metrics::get_bytes_per_second() const
+{
+    return get_rate(bytes, busy);
+}
+
+
+// Constructor
+// `p_context` must be active on the calling thread
+// PNG and TGA decoders are added
+ft::rf::context::image_pipeline::image_pipeline(
+    opengl_context & p_context,
+    const t_image_pipeline_params & p_params) :
+    m_params(p_params)
+{
+    m_decoders.push_back(std::make_shared<tga_decoder>());
+    m_decoders.push_back(std::make_shared<png_decoder>());
+
+    auto & system = (m_params.job_system != nullptr) ?
+        *m_params.job_system :
+        jobs::get_default_job_system();
+    m_tasks = std::make_unique<jobs::task_group>(system);
+
+    m_upload_context = std::make_unique<opengl_context>(
+        p_context,
+        opengl_context::t_shared_ctor_tag{});
+    m_uploader = std::thread([this]() { run_uploader(); });
+}
+
+
+// Destructor
+// Waits for the decodes in progress and stops the upload thread,
+//  loads not completed are abandoned
+ft::rf::context::image_pipeline::~image_pipeline()
+{
+    m_tasks.reset();
+
+    {
+        std::lock_guard<decltype(m_uploads_mutex)> lock{ m_uploads_mutex };
+        m_stop = true;
+    }
+    m_uploads_condition.notify_all();
+    m_uploader.join();
+}
+
+
+// Add a decoder, tried before the ones added earlier
+void ft::rf::context::image_pipeline::add_decoder(std::shared_ptr<const image_decoder> p_decoder)
+{
+    std::lock_guard<decltype(m_decoders_mutex)> lock{ m_decoders_mutex };
+    m_decoders.push_back(std::move(p_decoder));
+}
+
+
+// Start loading the image file at `p_path`
+ft::rf::context::t_async_texture
+ft::rf::context::image_pipeline::load(const std::filesystem::path & p_path)
+{
+    auto load = std::make_shared<t_load>();
+    load->path = p_path;
+    {
+        std::lock_guard<decltype(m_decoders_mutex)> lock{ m_decoders_mutex };
+        load->decoders = m_decoders;
+    }
+
+    auto result = t_async_texture{ load->promise.get_future().share() };
+    {
+        std::lock_guard<decltype(m_metrics_mutex)> lock{ m_metrics_mutex };
+        ++m_metrics.pending;
+    }
+
+    m_tasks->run([this, load]() { decode(load); });
+    return result;
+}
+
+
+// Get the work done by each stage
+ft::rf::context::t_image_pipeline_metrics
+ft::rf::context::image_pipeline::get_metrics() const
+{
+    std::lock_guard<decltype(m_metrics_mutex)> lock{ m_metrics_mutex };
+    return m_metrics;
+}
+
+
+// Read and decode a file
+void ft::rf::context::image_pipeline::decode(const std::shared_ptr<t_load> & p_load)
+{
+    const auto start = std::chrono::steady_clock::now();
+    auto size = std::uint64_t{ 0 };
+    try
+    {
+        auto file = std::ifstream{ p_load->path, std::ios::binary };
+        if (file.is_open() == false)
+        {
+            throw t_except_load("Can't open image file " + p_load->path.string());
+        }
+        const auto data = std::vector<std::uint8_t>{
+            std::istreambuf_iterator<char>{ file },
+            std::istreambuf_iterator<char>{} };
+        size = data.size();
+
+        // Later decoders override earlier ones
+        const image_decoder* decoder = nullptr;
+        for (auto found = p_load->decoders.rbegin(); found != p_load->decoders.rend(); ++found)
+        {
+            if ((*found)->accepts(p_load->path, data))
+            {
+                decoder = found->get();
+                break;
+            }
+        }
+        if (decoder == nullptr)
+        {
+            throw t_except_load("No decoder for image file " + p_load->path.string());
+        }
+
+        p_load->image = decoder->decode(data);
+        p_load->decoders.clear();
+    }
+    catch (...)
+    {
+        p_load->promise.set_exception(std::current_exception());
+        fail(m_metrics.decode);
+        return;
+    }
+    record(m_metrics.decode, size, start);
+
+    if (m_params.generate_mip_levels)
+    {
+        m_tasks->run([this, p_load]() { generate_mip_levels(p_load); });
+    }
+    else
+    {
+        queue_upload(p_load);
+    }
+}
+
+
+// Generate the mip chain of a decoded image
+void ft::rf::context::image_pipeline::generate_mip_levels(const std::shared_ptr<t_load> & p_load)
+{
+    const auto start = std::chrono::steady_clock::now();
+    try
+    {
+        context::generate_mip_levels(p_load->image);
+    }
+    catch (...)
+    {
+        p_load->promise.set_exception(std::current_exception());
+        fail(m_metrics.mipmap);
+        return;
+    }
+
+    auto size = std::uint64_t{ 0 };
+    for (std::size_t level = 1; level < p_load->image.levels.size(); ++level)
+    {
+        size += p_load->image.levels[level].size();
+    }
+    record(m_metrics.mipmap, size, start);
+
+    queue_upload(p_load);
+}
+
+
+// Hand a load to the upload thread
+void ft::rf::context::image_pipeline::queue_upload(std::shared_ptr<t_load> p_load)
+{
+    {
+        std::lock_guard<decltype(m_uploads_mutex)> lock{ m_uploads_mutex };
+        m_uploads.push_back(std::move(p_load));
+    }
+    m_uploads_condition.notify_one();
+}
+
+
+// Count a failed load in `p_stage`
+// The load's promise must already hold the error
+void ft::rf::context::image_pipeline::fail(t_image_stage_metrics & p_stage)
+{
+    std::lock_guard<decltype(m_metrics_mutex)> lock{ m_metrics_mutex };
+    ++p_stage.failures;
+    --m_metrics.pending;
+}
+
+
+// Add an item to a stage's metrics
+void ft::rf::context::image_pipeline::record(
+    t_image_stage_metrics & p_stage,
+    const std::uint64_t p_bytes,
+    const std::chrono::steady_clock::time_point p_start)
+{
+    const auto busy = std::chrono::steady_clock::now() - p_start;
+
+    std::lock_guard<decltype(m_metrics_mutex)> lock{ m_metrics_mutex };
+    ++p_stage.items;
+    p_stage.bytes += p_bytes;
+    p_stage.busy += std::chrono::duration_cast<std::chrono::nanoseconds>(busy);
+}
+
+
+// Upload thread entry point
+void ft::rf::context::image_pipeline::run_uploader()
+{
+    // If the shared context can't be activated every upload fails
+    std::exception_ptr failure;
+    std::optional<make_current<opengl_context>> active;
+    try
+    {
+        active.emplace(*m_upload_context);
+    }
+    catch (...)
+    {
+        failure = std::current_exception();
+    }
+
+    // Uploads the GPU hasn't completed yet, oldest first
+    std::deque<t_in_flight> in_flight;
+
+    while (true)
+    {
+        auto uploads = std::deque<std::shared_ptr<t_load>>{};
+        {
+            std::unique_lock<decltype(m_uploads_mutex)> lock{ m_uploads_mutex };
+            if (in_flight.empty())
+            {
+                m_uploads_condition.wait(lock, [this]() { return m_stop || m_uploads.empty() == false; });
+            }
+            if (m_stop)
+            {
+                break;
+            }
+            uploads.swap(m_uploads);
+        }
+
+        for (auto & load : uploads)
+        {
+            if (failure != nullptr)
+            {
+                load->promise.set_exception(failure);
+                fail(m_metrics.upload);
+                continue;
+            }
+
+            try
+            {
+                in_flight.push_back(upload(load));
+            }
+            catch (...)
+            {
+                load->promise.set_exception(std::current_exception());
+                fail(m_metrics.upload);
+            }
+        }
+
+        // Hand over the textures the GPU finished, waiting a little for
+        //  the oldest one rather than spinning
+        while (in_flight.empty() == false)
+        {
+            auto & oldest = in_flight.front();
+            const auto status = call_opengl_skip_errors(
+                glClientWaitSync,
+                static_cast<GLsync>(oldest.fence),
+                GLbitfield{ GL_SYNC_FLUSH_COMMANDS_BIT },
+                g_fence_poll);
+            if (status == GL_TIMEOUT_EXPIRED)
+            {
+                break;
+            }
+            call_opengl_skip_errors(glDeleteSync, static_cast<GLsync>(oldest.fence));
+
+            if (status == GL_WAIT_FAILED)
+            {
+                call_opengl_skip_errors(glDeleteTextures, 1, &oldest.texture);
+                m_upload_context->notify_object_deleted(t_object_kind::texture, oldest.texture);
+                oldest.load->promise.set_exception(std::make_exception_ptr(
+                    t_except_load("Upload of image file " + oldest.load->path.string() + " failed")));
+                fail(m_metrics.upload);
+            }
+            else
+            {
+                get_gpu_memory_tracker().track(*m_upload_context, t_gpu_memory_category::texture, oldest.texture, oldest.bytes, g_tracker_tag);
+                oldest.load->promise.set_value(oldest.texture);
+                {
+                    std::lock_guard<decltype(m_metrics_mutex)> lock{ m_metrics_mutex };
+                    --m_metrics.pending;
+                }
+            }
+            in_flight.pop_front();
+        }
+    }
+
+    // Abandoned uploads, their futures report a broken promise
+    for (auto & upload : in_flight)
+    {
+        call_opengl_skip_errors(glDeleteSync, static_cast<GLsync>(upload.fence));
+        call_opengl_skip_errors(glDeleteTextures, 1, &upload.texture);
+        m_upload_context->notify_object_deleted(t_object_kind::texture, upload.texture);
+    }
+}
+
+
+// Create a texture from a load's levels and fence it
+// The shared context must be active
+ft::rf::context::image_pipeline::t_in_flight
+ft::rf::context::image_pipeline::upload(std::shared_ptr<t_load> p_load)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto & image = p_load->image;
+    const auto levels = static_cast<GLsizei>(image.levels.size());
+
+    auto result = t_in_flight{};
+    result.load = std::move(p_load);
+
+    call_opengl<err::context_edit_error>(glGenTextures, 1, &result.texture);
+    try
+    {
+        call_opengl<err::context_edit_error>(glBindTexture, GL_TEXTURE_2D, result.texture);
+        call_opengl<err::context_edit_error>(
+            glTexStorage2D,
+            GL_TEXTURE_2D,
+            levels,
+            GL_RGBA8,
+            static_cast<GLsizei>(image.width),
+            static_cast<GLsizei>(image.height));
+
+        // RGBA8 rows are always 4 byte aligned, no need to change GL_UNPACK_ALIGNMENT
+        auto width = image.width;
+        auto height = image.height;
+        for (GLint level = 0; level < levels; ++level)
+        {
+            call_opengl<err::context_edit_error>(
+                glTexSubImage2D,
+                GL_TEXTURE_2D,
+                level,
+                GLint{ 0 }, GLint{ 0 },
+                static_cast<GLsizei>(width),
+                static_cast<GLsizei>(height),
+                GLenum{ GL_RGBA },
+                GLenum{ GL_UNSIGNED_BYTE },
+                image.levels[level].data());
+            result.bytes += image.levels[level].size();
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+        }
+
+        const auto min_filter = (levels > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+        call_opengl<err::context_edit_error>(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GLint{ min_filter });
+        call_opengl<err::context_edit_error>(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GLint{ GL_LINEAR });
+        call_opengl<err::context_edit_error>(glBindTexture, GL_TEXTURE_2D, GLuint{ 0 });
+
+        result.fence = call_opengl_fail_value<err::context_edit_error, GLsync{ nullptr }>(
+            glFenceSync,
+            GL_SYNC_GPU_COMMANDS_COMPLETE,
+            GLbitfield{ 0 });
+    }
+    catch (...)
+    {
+        call_opengl_skip_errors(glDeleteTextures, 1, &result.texture);
+        m_upload_context->notify_object_deleted(t_object_kind::texture, result.texture);
+        throw;
+    }
+
+    // The pixels were copied by the driver
+    result.load->image = {};
+    record(m_metrics.upload, result.bytes, start);
+    return result;
+}
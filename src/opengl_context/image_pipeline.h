@@ -0,0 +1,206 @@
+#pragma once
+
+// Loads image files into textures without blocking the render thread
+//
+// Each file goes through three stages :
+//  - decode, on the job system, reads the file and decodes it with the
+//    first decoder accepting it
+//  - mipmap, on the job system, generates the mip chain on the CPU
+//  - upload, on a worker thread owning a shared context, creates the
+//    texture and waits for a fence before handing it over
+// The texture is complete on the GPU once its future is ready, any
+//  context sharing objects with the pipeline's can use it right away
+
+// project headers
+#include "image_decoder.h"
+
+// standard headers
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace ft {
+namespace rf {
+
+// Forward declaration
+namespace jobs {
+class job_system;
+class task_group;
+}   // namespace jobs
+
+namespace context {
+
+// Forward declaration
+class opengl_context;
+
+// A texture being loaded asynchronously
+struct t_async_texture
+{
+    // Holds the texture's name, or the load error, once the upload completes
+    std::shared_future<unsigned int> texture;
+
+    // Has the load completed?
+    bool is_ready() const;
+
+    // The texture if it was loaded successfully
+    // `p_fallback` while the load is pending or if it failed
+    unsigned int get_or(const unsigned int p_fallback) const;
+
+};  // struct t_async_texture
+
+
+// Work done by one stage of the pipeline since its creation
+struct t_image_stage_metrics
+{
+    std::uint64_t items = 0;
+    std::uint64_t failures = 0;
+
+    // Bytes read by decode, generated by mipmap, uploaded by upload
+    std::uint64_t bytes = 0;
+
+    // Time the stage's threads spent working
+    std::chrono::nanoseconds busy{ 0 };
+
+    // Throughput while busy, 0 before the first item
+    double get_items_per_second() const;
+    double get_bytes_per_second() const;
+
+};  // struct t_image_stage_metrics
+
+
+struct t_image_pipeline_metrics
+{
+    t_image_stage_metrics decode;
+    t_image_stage_metrics mipmap;
+    t_image_stage_metrics upload;
+
+    // Loads not completed yet
+    std::size_t pending = 0;
+
+};  // struct t_image_pipeline_metrics
+
+
+struct t_image_pipeline_params
+{
+    // Generate the mip chain of the images
+    bool generate_mip_levels = true;
+
+    // Runs the decode and mipmap stages, the library's default job
+    //  system if null
+    jobs::job_system* job_system = nullptr;
+
+};  // struct t_image_pipeline_params
+
+
+class image_pipeline
+{
+public:
+    // Raised by the futures of files no decoder accepts or that can't be read
+    struct t_except_load : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+public:
+    // Constructor
+    // `p_context` must be active on the calling thread
+    // PNG and TGA decoders are added
+    explicit image_pipeline(opengl_context& p_context, const t_image_pipeline_params& p_params = {});
+
+    // Destructor
+    // Waits for the decodes in progress and stops the upload thread,
+    //  loads not completed are abandoned
+    ~image_pipeline();
+
+    // Prevent copy
+    image_pipeline(const image_pipeline&) = delete;
+    image_pipeline& operator=(const image_pipeline&) = delete;
+
+    // Add a decoder, tried before the ones added earlier
+    void add_decoder(std::shared_ptr<const image_decoder> p_decoder);
+
+    // Start loading the image file at `p_path`
+    t_async_texture load(const std::filesystem::path& p_path);
+
+    // Get the work done by each stage
+    t_image_pipeline_metrics get_metrics() const;
+
+private:
+    // A load going through the stages
+    struct t_load {
+        std::filesystem::path path;
+        std::vector<std::shared_ptr<const image_decoder>> decoders;
+        t_texture_image image;
+        std::promise<unsigned int> promise;
+    };
+
+    // An upload waiting for the GPU
+    struct t_in_flight {
+        std::shared_ptr<t_load> load;
+        unsigned int texture = 0;
+        void* fence = nullptr;  // GLsync signaled when the upload is done
+        std::uint64_t bytes = 0;
+    };
+
+    // Read and decode a file
+    void decode(const std::shared_ptr<t_load>& p_load);
+
+    // Generate the mip chain of a decoded image
+    void generate_mip_levels(const std::shared_ptr<t_load>& p_load);
+
+    // Hand a load to the upload thread
+    void queue_upload(std::shared_ptr<t_load> p_load);
+
+    // Count a failed load in `p_stage`
+    // The load's promise must already hold the error
+    void fail(t_image_stage_metrics& p_stage);
+
+    // Add an item to a stage's metrics
+    void record(t_image_stage_metrics& p_stage, const std::uint64_t p_bytes, const std::chrono::steady_clock::time_point p_start);
+
+    // Upload thread entry point
+    void run_uploader();
+
+    // Create a texture from a load's levels and fence it
+    // The shared context must be active
+    t_in_flight upload(std::shared_ptr<t_load> p_load);
+
+private:
+    // Pipeline parameters
+    t_image_pipeline_params m_params;
+
+    // Decoders, the last one is tried first
+    mutable std::mutex m_decoders_mutex;
+    std::vector<std::shared_ptr<const image_decoder>> m_decoders;
+
+    // Work done by each stage
+    mutable std::mutex m_metrics_mutex;
+    t_image_pipeline_metrics m_metrics;
+
+    // Uploads waiting for the upload thread
+    std::mutex m_uploads_mutex;
+    std::condition_variable m_uploads_condition;
+    std::deque<std::shared_ptr<t_load>> m_uploads;
+    bool m_stop = false;
+
+    // Upload thread and its shared context
+    std::unique_ptr<opengl_context> m_upload_context;
+    std::thread m_uploader;
+
+    // Decodes and mipmaps in progress, destroyed first so it waits
+    //  for them before the members they use are destroyed
+    std::unique_ptr<jobs::task_group> m_tasks;
+
+};  // class image_pipeline
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
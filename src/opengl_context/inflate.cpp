@@ -0,0 +1,413 @@
+#include "inflate.h"
+
+// standard headers
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace {
+
+using ft::rf::context::t_except_inflate;
+
+// Longest code of a deflate huffman table
+constexpr int g_max_bits = 15;
+
+// Base length and extra bits of length symbols 257 to 285
+constexpr std::array<std::uint16_t, 29> g_length_base = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+constexpr std::array<std::uint8_t, 29> g_length_extra = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+// Base distance and extra bits of distance symbols 0 to 29
+constexpr std::array<std::uint16_t, 30> g_distance_base = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+constexpr std::array<std::uint8_t, 30> g_distance_extra = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// Order in which code length code lengths are stored
+constexpr std::array<std::uint8_t, 19> g_code_length_order = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+
+// Reads a deflate stream's bits, least significant first
+class bit_reader
+{
+public:
+    explicit bit_reader(std::span<const std::uint8_t> p_data) :
+        m_data(p_data)
+    {}
+
+    // Read `p_count` bits
+    std::uint32_t get_bits(const int p_count)
+    {
+        std::uint32_t result = 0;
+        for (int i = 0; i < p_count; ++i)
+        {
+            if (m_position >= m_data.size())
+            {
+                throw t_except_inflate("Truncated deflate stream");
+            }
+            const auto bit = (m_data[m_position] >> m_bit) & 1u;
+            result |= bit << i;
+            if (++m_bit == 8)
+            {
+                m_bit = 0;
+                ++m_position;
+            }
+        }
+        return result;
+    }
+
+    // Skip to the next byte boundary
+    void align()
+    {
+        if (m_bit != 0)
+        {
+            m_bit = 0;
+            ++m_position;
+        }
+    }
+
+    // Bytes left after the current byte boundary
+    std::span<const std::uint8_t> get_remaining() const
+    {
+        return m_data.subspan(std::min(m_position, m_data.size()));
+    }
+
+    // Move forward by `p_count` bytes, must be aligned
+    void skip(const std::size_t p_count)
+    {
+        m_position += p_count;
+    }
+
+private:
+    std::span<const std::uint8_t> m_data;
+    std::size_t m_position = 0;
+    int m_bit = 0;
+};
+
+
+// Canonical huffman table
+// Codes are decoded one bit at a time by counting codes of each length
+struct t_huffman
+{
+    std::array<std::uint16_t, g_max_bits + 1> counts = {};
+    std::array<std::uint16_t, 288> symbols = {};
+};
+
+
+// Build a table from the code length of each symbol
+// Incomplete tables are accepted, some streams use them for distances
+t_huffman make_huffman(const std::uint8_t* p_lengths, const std::size_t p_count)
+{
+    auto result = t_huffman{};
+    for (std::size_t symbol = 0; symbol < p_count; ++symbol)
+    {
+        ++result.counts[p_lengths[symbol]];
+    }
+    result.counts[0] = 0;
+
+    int left = 1;
+    for (int length = 1; length <= g_max_bits; ++length)
+    {
+        left = left * 2 - result.counts[length];
+        if (left < 0)
+        {
+            throw t_except_inflate("Over-subscribed huffman table");
+        }
+    }
+
+    std::array<std::uint16_t, g_max_bits + 1> offsets = {};
+    for (int length = 1; length < g_max_bits; ++length)
+    {
+        offsets[length + 1] = offsets[length] + result.counts[length];
+    }
+    for (std::size_t symbol = 0; symbol < p_count; ++symbol)
+    {
+        if (p_lengths[symbol] != 0)
+        {
+            result.symbols[offsets[p_lengths[symbol]]++] = static_cast<std::uint16_t>(symbol);
+        }
+    }
+    return result;
+}
+
+
+// Decode one symbol
+int decode(bit_reader & p_reader, const t_huffman & p_table)
+{
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int length = 1; length <= g_max_bits; ++length)
+    {
+        code |= static_cast<int>(p_reader.get_bits(1));
+        const int count = p_table.counts[length];
+        if (code - first < count)
+        {
+            return p_table.symbols[index + code - first];
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    throw t_except_inflate("Invalid huffman code");
+}
+
+
+// Decode a compressed block's symbols until its end
+void inflate_codes(
+    bit_reader & p_reader,
+    const t_huffman & p_lengths,
+    const t_huffman & p_distances,
+    std::vector<std::uint8_t> & p_output)
+{
+    while (true)
+    {
+        const auto symbol = decode(p_reader, p_lengths);
+        if (symbol < 256)
+        {
+            p_output.push_back(static_cast<std::uint8_t>(symbol));
+            continue;
+        }
+        if (symbol == 256)
+        {
+            return;
+        }
+
+        const auto length_index = static_cast<std::size_t>(symbol - 257);
+        if (length_index >= g_length_base.size())
+        {
+            throw t_except_inflate("Invalid length symbol");
+        }
+        const auto length = g_length_base[length_index] + p_reader.get_bits(g_length_extra[length_index]);
+
+        const auto distance_index = static_cast<std::size_t>(decode(p_reader, p_distances));
+        if (distance_index >= g_distance_base.size())
+        {
+            throw t_except_inflate("Invalid distance symbol");
+        }
+        const auto distance = g_distance_base[distance_index] + p_reader.get_bits(g_distance_extra[distance_index]);
+        if (distance > p_output.size())
+        {
+            throw t_except_inflate("Distance before the start of the stream");
+        }
+
+        // The copy may overlap what it writes, one byte at a time
+        auto from = p_output.size() - distance;
+        for (std::uint32_t i = 0; i < length; ++i)
+        {
+            p_output.push_back(p_output[from++]);
+        }
+    }
+}
+
+
+// Read the tables of a dynamic block
+std::pair<t_huffman, t_huffman> read_dynamic_tables(bit_reader & p_reader)
+{
+    const auto length_count = p_reader.get_bits(5) + 257;
+    const auto distance_count = p_reader.get_bits(5) + 1;
+    const auto code_length_count = p_reader.get_bits(4) + 4;
+    if (length_count > 286 || distance_count > 30)
+    {
+        throw t_except_inflate("Too many symbols in dynamic block");
+    }
+
+    std::array<std::uint8_t, 19> code_lengths = {};
+    for (std::uint32_t i = 0; i < code_length_count; ++i)
+    {
+        code_lengths[g_code_length_order[i]] = static_cast<std::uint8_t>(p_reader.get_bits(3));
+    }
+    const auto code_length_table = make_huffman(code_lengths.data(), code_lengths.size());
+
+    // Literal/length and distance code lengths form a single sequence
+    std::array<std::uint8_t, 286 + 30> lengths = {};
+    std::uint32_t index = 0;
+    while (index < length_count + distance_count)
+    {
+        const auto symbol = decode(p_reader, code_length_table);
+        if (symbol < 16)
+        {
+            lengths[index++] = static_cast<std::uint8_t>(symbol);
+            continue;
+        }
+
+        std::uint8_t value = 0;
+        std::uint32_t repeat = 0;
+        if (symbol == 16)
+        {
+            if (index == 0)
+            {
+                throw t_except_inflate("Repeat without a previous length");
+            }
+            value = lengths[index - 1];
+            repeat = 3 + p_reader.get_bits(2);
+        }
+        else if (symbol == 17)
+        {
+            repeat = 3 + p_reader.get_bits(3);
+        }
+        else
+        {
+            repeat = 11 + p_reader.get_bits(7);
+        }
+
+        if (index + repeat > length_count + distance_count)
+        {
+            throw t_except_inflate("Code lengths overflow");
+        }
+        while (repeat-- > 0)
+        {
+            lengths[index++] = value;
+        }
+    }
+
+    if (lengths[256] == 0)
+    {
+        throw t_except_inflate("Dynamic block without an end code");
+    }
+
+    return {
+        make_huffman(lengths.data(), length_count),
+        make_huffman(lengths.data() + length_count, distance_count) };
+}
+
+
+// Tables of fixed blocks
+const std::pair<t_huffman, t_huffman> & get_fixed_tables()
+{
+    static const auto tables = []()
+    {
+        std::array<std::uint8_t, 288> lengths = {};
+        for (std::size_t symbol = 0; symbol < lengths.size(); ++symbol)
+        {
+            lengths[symbol] =
+                (symbol < 144) ? 8 :
+                (symbol < 256) ? 9 :
+                (symbol < 280) ? 7 : 8;
+        }
+        std::array<std::uint8_t, 30> distances;
+        distances.fill(5);
+        return std::make_pair(
+            make_huffman(lengths.data(), lengths.size()),
+            make_huffman(distances.data(), distances.size()));
+    }();
+    return tables;
+}
+
+
+// Adler-32 checksum of a zlib stream's data
+std::uint32_t get_adler32(const std::vector<std::uint8_t> & p_data)
+{
+    constexpr std::uint32_t modulo = 65521;
+
+    // Largest run that can't overflow the sums
+    constexpr std::size_t run = 5552;
+
+    std::uint32_t a = 1;
+    std::uint32_t b = 0;
+    for (std::size_t start = 0; start < p_data.size(); start += run)
+    {
+        const auto end = std::min(start + run, p_data.size());
+        for (auto i = start; i < end; ++i)
+        {
+            a += p_data[i];
+            b += a;
+        }
+        a %= modulo;
+        b %= modulo;
+    }
+    return (b << 16) | a;
+}
+
+}   // anonymous namespace
+
+
+// Decompress a zlib stream (RFC 1950) of deflate data (RFC 1951)
+// `p_size_hint` is the expected decompressed size, if known
+// Raises t_except_inflate if the stream is invalid
+std::vector<std::uint8_t> ft::rf::context::zlib_decompress(
+    std::span<const std::uint8_t> p_data,
+    const std::size_t p_size_hint)
+{
+    if (p_data.size() < 6)
+    {
+        throw t_except_inflate("Truncated zlib stream");
+    }
+
+    const auto method = p_data[0];
+    const auto flags = p_data[1];
+    if ((method & 0x0F) != 8 || (method * 256 + flags) % 31 != 0)
+    {
+        throw t_except_inflate("Not a deflate zlib stream");
+    }
+    if ((flags & 0x20) != 0)
+    {
+        throw t_except_inflate("Preset dictionaries aren't supported");
+    }
+
+    auto output = std::vector<std::uint8_t>{};
+    output.reserve(p_size_hint);
+
+    auto reader = bit_reader{ p_data.subspan(2) };
+    auto last = false;
+    while (last == false)
+    {
+        last = reader.get_bits(1) != 0;
+        const auto type = reader.get_bits(2);
+        if (type == 0)
+        {
+            // Stored block, the length and its complement follow
+            reader.align();
+            const auto block = reader.get_remaining();
+            if (block.size() < 4)
+            {
+                throw t_except_inflate("Truncated stored block");
+            }
+            const auto length = static_cast<std::size_t>(block[0] | (block[1] << 8));
+            const auto complement = static_cast<std::size_t>(block[2] | (block[3] << 8));
+            if (length != (~complement & 0xFFFF) || block.size() < 4 + length)
+            {
+                throw t_except_inflate("Invalid stored block");
+            }
+            output.insert(output.end(), block.begin() + 4, block.begin() + 4 + length);
+            reader.skip(4 + length);
+        }
+        else if (type == 1)
+        {
+            const auto & tables = get_fixed_tables();
+            inflate_codes(reader, tables.first, tables.second, output);
+        }
+        else if (type == 2)
+        {
+            const auto tables = read_dynamic_tables(reader);
+            inflate_codes(reader, tables.first, tables.second, output);
+        }
+        else
+        {
+            throw t_except_inflate("Invalid deflate block type");
+        }
+    }
+
+    // The big endian checksum follows the last block
+    reader.align();
+    const auto checksum = reader.get_remaining();
+    if (checksum.size() < 4)
+    {
+        throw t_except_inflate("Missing zlib checksum");
+    }
+    const auto expected =
+        (std::uint32_t{ checksum[0] } << 24) | (std::uint32_t{ checksum[1] } << 16) |
+        (std::uint32_t{ checksum[2] } << 8) | std::uint32_t{ checksum[3] };
+    if (get_adler32(output) != expected)
+    {
+        throw t_except_inflate("zlib checksum mismatch");
+    }
+
+    return output;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+// Decompresses zlib streams, as stored in PNG images
+// Supports every deflate block type, but no preset dictionary
+
+// standard headers
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+// Raised when a stream is malformed or truncated
+struct t_except_inflate : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// Decompress a zlib stream (RFC 1950) of deflate data (RFC 1951)
+// `p_size_hint` is the expected decompressed size, if known
+// Raises t_except_inflate if the stream is invalid
+std::vector<std::uint8_t> zlib_decompress(std::span<const std::uint8_t> p_data, const std::size_t p_size_hint = 0);
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,218 @@
+#include "input_latency_tracker.h"
+
+// project headers
+#include "call_opengl_function.h"
+#include "make_current.h"
+#include "opengl_context.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// Frames between two calibrations of the GPU clock
+// Both clocks drift slowly, a few seconds apart is plenty
+constexpr std::size_t g_calibration_period = 300;
+
+
+// Add a sample to a window of recent samples
+void add_sample(
+    std::vector<std::chrono::nanoseconds> & p_samples,
+    std::size_t & p_next,
+    const std::size_t p_window,
+    const std::chrono::nanoseconds p_sample)
+{
+    if (p_samples.size() < p_window)
+    {
+        p_samples.push_back(p_sample);
+        return;
+    }
+
+    // Full, overwrite the oldest
+    p_samples[p_next] = p_sample;
+    p_next = (p_next + 1) % p_window;
+}
+
+
+// Current steady_clock time in nanoseconds
+std::int64_t get_cpu_time()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}   // anonymous namespace
+
+
+// Summarize `p_samples`
+// The samples are sorted in place
+ft::rf::context::t_latency_distribution
+ft::rf::context::make_latency_distribution(std::span<std::chrono::nanoseconds> p_samples)
+{
+    auto result = t_latency_distribution{};
+    if (p_samples.empty())
+    {
+        return result;
+    }
+
+    std::sort(p_samples.begin(), p_samples.end());
+
+    // Nearest rank percentiles
+    const auto percentile = [&p_samples](const std::size_t p_percent) {
+        const auto rank = (p_percent * p_samples.size() + 99) / 100;
+        return p_samples[std::max<std::size_t>(rank, 1) - 1];
+    };
+
+    result.count = p_samples.size();
+    result.min = p_samples.front();
+    result.max = p_samples.back();
+    result.mean = std::accumulate(p_samples.begin(), p_samples.end(), std::chrono::nanoseconds{ 0 })
+        / static_cast<std::int64_t>(p_samples.size());
+    result.p50 = percentile(50);
+    result.p95 = percentile(95);
+    result.p99 = percentile(99);
+    return result;
+}
+
+
+// Constructor
+// The distributions cover the last `p_window` frames that consumed input
+ft::rf::context::input_latency_tracker::input_latency_tracker(
+    opengl_context & p_context,
+    const std::size_t p_window) :
+    m_context(&p_context),
+    m_window(p_window)
+{
+    FT_ASSERT(p_window > 0);
+
+    auto active = make_current{ *m_context };
+    calibrate();
+}
+
+
+// Destructor
+ft::rf::context::input_latency_tracker::~input_latency_tracker()
+{
+    auto active = make_current{ *m_context };
+    for (const auto & pending : m_pending)
+    {
+        call_opengl_skip_errors(glDeleteQueries, 1, &pending.query);
+    }
+    if (m_free_queries.empty() == false)
+    {
+        call_opengl_skip_errors(
+            glDeleteQueries,
+            static_cast<GLsizei>(m_free_queries.size()),
+            m_free_queries.data());
+    }
+}
+
+
+// Record a frame submitted now that consumed input received at `p_input`
+// Must be called after the frame's last command
+void ft::rf::context::input_latency_tracker::submit(const std::chrono::steady_clock::time_point p_input)
+{
+    const auto now = std::chrono::steady_clock::now();
+    add_sample(m_submit_samples, m_next_submit, m_window,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - p_input));
+
+    auto active = make_current{ *m_context };
+
+    if (++m_since_calibration >= g_calibration_period)
+    {
+        calibrate();
+    }
+
+    auto query = GLuint{ 0 };
+    if (m_free_queries.empty() == false)
+    {
+        query = m_free_queries.back();
+        m_free_queries.pop_back();
+    }
+    else
+    {
+        call_opengl<err::context_edit_error>(glGenQueries, 1, &query);
+    }
+
+    // Written once every previous command completed
+    call_opengl<err::context_edit_error>(glQueryCounter, query, GL_TIMESTAMP);
+    m_pending.push_back({ query, p_input });
+}
+
+
+// Collect the GPU completion times that are available
+// Never waits for the GPU
+void ft::rf::context::input_latency_tracker::poll()
+{
+    if (m_pending.empty())
+    {
+        return;
+    }
+
+    auto active = make_current{ *m_context };
+
+    // Queries complete in order, stop at the first one still in flight
+    while (m_pending.empty() == false)
+    {
+        const auto & pending = m_pending.front();
+
+        auto available = GLint{ 0 };
+        call_opengl<err::context_edit_error>(glGetQueryObjectiv, pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == 0)
+        {
+            break;
+        }
+
+        auto gpu_time = GLuint64{ 0 };
+        call_opengl<err::context_edit_error>(glGetQueryObjectui64v, pending.query, GL_QUERY_RESULT, &gpu_time);
+
+        const auto complete = m_gpu_offset + static_cast<std::int64_t>(gpu_time);
+        const auto input = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            pending.input.time_since_epoch()).count();
+
+        // Calibration error can't make the GPU finish before the input arrived
+        add_sample(m_gpu_samples, m_next_gpu, m_window,
+            std::chrono::nanoseconds{ std::max<std::int64_t>(complete - input, 0) });
+
+        m_free_queries.push_back(pending.query);
+        m_pending.pop_front();
+    }
+}
+
+
+// Get the distributions over the recent frames
+ft::rf::context::input_latency_tracker::t_stats
+ft::rf::context::input_latency_tracker::get_stats() const
+{
+    auto submit = m_submit_samples;
+    auto gpu = m_gpu_samples;
+
+    auto result = t_stats{};
+    result.input_to_submit = make_latency_distribution(submit);
+    result.input_to_gpu_complete = make_latency_distribution(gpu);
+    return result;
+}
+
+
+// Measure the offset between the GPU and CPU clocks
+// The context must be active
+void ft::rf::context::input_latency_tracker::calibrate()
+{
+    // The GPU's current time is read without waiting for queued commands,
+    //  bracketing it with the CPU clock bounds the error by the call's duration
+    const auto before = get_cpu_time();
+    auto gpu_time = GLint64{ 0 };
+    call_opengl<err::context_edit_error>(glGetInteger64v, GL_TIMESTAMP, &gpu_time);
+    const auto after = get_cpu_time();
+
+    m_gpu_offset = before + (after - before) / 2 - static_cast<std::int64_t>(gpu_time);
+    m_since_calibration = 0;
+}
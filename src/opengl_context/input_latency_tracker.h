@@ -0,0 +1,119 @@
+#pragma once
+
+// Measures the latency between input and the frames that consume it
+//
+// For every frame that consumed input, the time of the oldest event is
+//  compared with the CPU time the frame was submitted and with the time
+//  the GPU finished it
+// GPU completion comes from a timestamp query written after the frame's
+//  commands, converted to the CPU clock with a periodically recalibrated
+//  offset between the two clocks
+
+// standard headers
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+// Forward declaration
+class opengl_context;
+
+// Summary of a set of latencies
+struct t_latency_distribution
+{
+    std::size_t count = 0;
+    std::chrono::nanoseconds min{ 0 };
+    std::chrono::nanoseconds max{ 0 };
+    std::chrono::nanoseconds mean{ 0 };
+    std::chrono::nanoseconds p50{ 0 };
+    std::chrono::nanoseconds p95{ 0 };
+    std::chrono::nanoseconds p99{ 0 };
+
+};  // struct t_latency_distribution
+
+// Summarize `p_samples`
+// The samples are sorted in place
+t_latency_distribution make_latency_distribution(std::span<std::chrono::nanoseconds> p_samples);
+
+
+class input_latency_tracker
+{
+public:
+    // Latencies of the frames that consumed input
+    struct t_stats {
+        t_latency_distribution input_to_submit;
+        t_latency_distribution input_to_gpu_complete;
+    };
+
+    // Default number of recent frames the distributions cover
+    static constexpr std::size_t s_default_window = 512;
+
+public:
+    // Constructor
+    // The distributions cover the last `p_window` frames that consumed input
+    explicit input_latency_tracker(opengl_context& p_context, const std::size_t p_window = s_default_window);
+
+    // Destructor
+    ~input_latency_tracker();
+
+    // Prevent copy
+    input_latency_tracker(const input_latency_tracker&) = delete;
+    input_latency_tracker& operator=(const input_latency_tracker&) = delete;
+
+    // Record a frame submitted now that consumed input received at `p_input`
+    // Must be called after the frame's last command
+    void submit(const std::chrono::steady_clock::time_point p_input);
+
+    // Collect the GPU completion times that are available
+    // Never waits for the GPU
+    void poll();
+
+    // Get the distributions over the recent frames
+    t_stats get_stats() const;
+
+private:
+    // A frame waiting for its timestamp
+    struct t_pending {
+        unsigned int query = 0;
+        std::chrono::steady_clock::time_point input;
+    };
+
+    // Measure the offset between the GPU and CPU clocks
+    void calibrate();
+
+private:
+    // Context issuing the queries
+    opengl_context* m_context = nullptr;
+
+    // Number of samples kept
+    std::size_t m_window = s_default_window;
+
+    // Frames waiting for their timestamp, oldest first
+    std::deque<t_pending> m_pending;
+
+    // Timestamp queries no longer in use
+    std::vector<unsigned int> m_free_queries;
+
+    // CPU time of GPU time 0, in steady_clock nanoseconds
+    std::int64_t m_gpu_offset = 0;
+
+    // Frames submitted since the last calibration
+    std::size_t m_since_calibration = 0;
+
+    // Recent samples, used as rings once full
+    std::vector<std::chrono::nanoseconds> m_submit_samples;
+    std::vector<std::chrono::nanoseconds> m_gpu_samples;
+    std::size_t m_next_submit = 0;
+    std::size_t m_next_gpu = 0;
+
+};  // class input_latency_tracker
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,368 @@
+#include "mailbox_presenter.h"
+
+// project headers
+#include "call_opengl_function.h"
+#include "gpu_memory_tracker.h"
+#include "make_current.h"
+#include "object_caches.h"
+#include "opengl_context.h"
+#include "opengl_function.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+#include <optional>
+#include <utility>
+
+
+// Constructor
+// Creates the present thread and its context sharing `p_context`'s objects
+ft::rf::context::mailbox_presenter::mailbox_presenter(
+    opengl_context & p_context,
+    t_swap p_swap,
+    const std::size_t p_count) :
+    m_context(&p_context),
+    m_swap(std::move(p_swap)),
+    m_targets(p_count)
+{
+    // One target is shown, one waits and one is rendered
+    FT_ASSERT(p_count >= s_default_count);
+
+    {
+        auto active = make_current{ *m_context };
+        for (auto & target : m_targets)
+        {
+            call_opengl<err::context_init>(glGenTextures, 1, &target.color);
+            call_opengl<err::context_init>(glGenRenderbuffers, 1, &target.depth);
+            call_opengl<err::context_init>(glGenFramebuffers, 1, &target.framebuffer);
+        }
+    }
+
+    m_present_context = std::make_unique<opengl_context>(
+        p_context,
+        opengl_context::t_shared_ctor_tag{});
+    m_presenter = std::thread([this]() { run_presenter(); });
+}
+
+
+// Destructor
+// Stops the present thread, a frame waiting to be shown is dropped
+ft::rf::context::mailbox_presenter::~mailbox_presenter()
+{
+    {
+        std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+        m_stop = true;
+    }
+    m_ready_condition.notify_all();
+    m_presenter.join();
+
+    auto active = make_current{ *m_context };
+    for (auto & target : m_targets)
+    {
+        if (target.fence != nullptr) {
+            call_opengl_skip_errors(glDeleteSync, static_cast<GLsync>(target.fence));
+        }
+        if (target.release != nullptr) {
+            call_opengl_skip_errors(glDeleteSync, static_cast<GLsync>(target.release));
+        }
+        call_opengl_skip_errors(glDeleteFramebuffers, 1, &target.framebuffer);
+        call_opengl_skip_errors(glDeleteRenderbuffers, 1, &target.depth);
+        call_opengl_skip_errors(glDeleteTextures, 1, &target.color);
+        get_gpu_memory_tracker().untrack(*m_context, t_gpu_memory_category::renderbuffer, target.depth);
+        get_gpu_memory_tracker().untrack(*m_context, t_gpu_memory_category::texture, target.color);
+        m_context->notify_object_deleted(t_object_kind::renderbuffer, target.depth);
+        m_context->notify_object_deleted(t_object_kind::texture, target.color);
+    }
+}
+
+
+// Bind a free target of `p_width` x `p_height` pixels as the framebuffer
+//  of the rendering context
+void ft::rf::context::mailbox_presenter::begin_frame(const int p_width, const int p_height)
+{
+    FT_ASSERT(p_width > 0 && p_height > 0);
+
+    void* release = nullptr;
+    {
+        std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+        rethrow_presenter_error();
+
+        // At most one target is shown and one is ready, there is always a free one
+        const auto found = std::find_if(m_targets.begin(), m_targets.end(), [](const t_target & p_target) {
+            return p_target.state == t_state::free;
+        });
+        FT_ASSERT(found != m_targets.end());
+
+        m_rendering = static_cast<std::size_t>(found - m_targets.begin());
+        found->state = t_state::rendering;
+        release = std::exchange(found->release, nullptr);
+    }
+
+    auto & target = m_targets[m_rendering];
+    auto active = make_current{ *m_context };
+
+    // The present thread's blit must read the target before it is drawn over
+    if (release != nullptr)
+    {
+        call_opengl<err::context_edit_error>(glWaitSync, static_cast<GLsync>(release), GLbitfield{ 0 }, GLuint64{ GL_TIMEOUT_IGNORED });
+        call_opengl_skip_errors(glDeleteSync, static_cast<GLsync>(release));
+    }
+
+    if (target.width != p_width || target.height != p_height)
+    {
+        target.width = p_width;
+        target.height = p_height;
+        allocate(target);
+    }
+
+    call_opengl<err::context_edit_error>(glBindFramebuffer, GL_FRAMEBUFFER, target.framebuffer);
+}
+
+
+// Hand the target bound by `begin_frame` to the present thread
+void ft::rf::context::mailbox_presenter::end_frame()
+{
+    {
+        std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+        rethrow_presenter_error();
+    }
+
+    auto & target = m_targets[m_rendering];
+    FT_ASSERT(target.state == t_state::rendering);
+
+    auto active = make_current{ *m_context };
+
+    // The fence must reach the GPU before the present context waits for it
+    const auto fence = call_opengl_fail_value<err::context_edit_error, GLsync{ nullptr }>(
+        glFenceSync,
+        GL_SYNC_GPU_COMMANDS_COMPLETE,
+        GLbitfield{ 0 });
+    call_opengl<err::context_edit_error>(glFlush);
+    call_opengl<err::context_edit_error>(glBindFramebuffer, GL_FRAMEBUFFER, GLuint{ 0 });
+
+    void* discarded = nullptr;
+    {
+        std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+
+        // The frame that was waiting will never be shown
+        if (m_has_ready)
+        {
+            auto & replaced = m_targets[m_ready];
+            replaced.state = t_state::free;
+            discarded = std::exchange(replaced.fence, nullptr);
+            ++m_stats.discarded;
+        }
+
+        target.fence = fence;
+        target.end_time = std::chrono::steady_clock::now();
+        target.state = t_state::ready;
+        m_ready = m_rendering;
+        m_has_ready = true;
+    }
+    m_ready_condition.notify_one();
+
+    if (discarded != nullptr)
+    {
+        call_opengl_skip_errors(glDeleteSync, static_cast<GLsync>(discarded));
+    }
+}
+
+
+// Get the presentation statistics
+ft::rf::context::mailbox_presenter::t_stats
+ft::rf::context::mailbox_presenter::get_stats() const
+{
+    std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+    return m_stats;
+}
+
+
+// Present thread entry point
+void ft::rf::context::mailbox_presenter::run_presenter()
+{
+    // Nothing can be shown if the context can't be activated, the error
+    //  is reported to the renderer by its next frame
+    std::optional<make_current<opengl_context>> active;
+    try
+    {
+        active.emplace(*m_present_context);
+    }
+    catch (...)
+    {
+        std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+        m_error = std::current_exception();
+        return;
+    }
+
+    // Wait for the display on swap, the renderer doesn't
+    // Drivers without the extension usually synchronize by default
+    try
+    {
+        auto swap_interval = opengl_function<PFNWGLSWAPINTERVALEXTPROC>("wglSwapIntervalEXT");
+        swap_interval(1);
+    }
+    catch (...)
+    {
+    }
+
+    // Framebuffers aren't shared, the present context reads through its own
+    auto framebuffer = GLuint{ 0 };
+    call_opengl_skip_errors(glGenFramebuffers, 1, &framebuffer);
+
+    while (true)
+    {
+        std::size_t index = 0;
+        GLsync fence = nullptr;
+        {
+            std::unique_lock<decltype(m_mutex)> lock{ m_mutex };
+            m_ready_condition.wait(lock, [this]() {
+                return m_stop || m_has_ready;
+            });
+            if (m_stop) {
+                break;
+            }
+
+            index = m_ready;
+            m_has_ready = false;
+            m_targets[index].state = t_state::presenting;
+            fence = static_cast<GLsync>(std::exchange(m_targets[index].fence, nullptr));
+        }
+
+        // Only this thread touches a target while it is being presented
+        auto & target = m_targets[index];
+
+        call_opengl_skip_errors(glWaitSync, fence, GLbitfield{ 0 }, GLuint64{ GL_TIMEOUT_IGNORED });
+        call_opengl_skip_errors(glDeleteSync, fence);
+
+        call_opengl_skip_errors(glBindFramebuffer, GL_READ_FRAMEBUFFER, framebuffer);
+        call_opengl_skip_errors(glFramebufferTexture2D, GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.color, GLint{ 0 });
+        call_opengl_skip_errors(glBindFramebuffer, GL_DRAW_FRAMEBUFFER, GLuint{ 0 });
+        call_opengl_skip_errors(
+            glBlitFramebuffer,
+            0, 0, target.width, target.height,
+            0, 0, target.width, target.height,
+            GLbitfield{ GL_COLOR_BUFFER_BIT },
+            GLenum{ GL_NEAREST });
+
+        const auto release = call_opengl_skip_errors(
+            glFenceSync,
+            GL_SYNC_GPU_COMMANDS_COMPLETE,
+            GLbitfield{ 0 });
+        call_opengl_skip_errors(glFlush);
+
+        const auto end_time = target.end_time;
+        {
+            std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+            target.release = release;
+            target.state = t_state::free;
+        }
+
+        // Blocks until the display picks up the frame
+        try
+        {
+            m_swap();
+        }
+        catch (...)
+        {
+            std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+            m_error = std::current_exception();
+            break;
+        }
+
+        const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - end_time);
+        {
+            std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+            ++m_stats.presented;
+            m_total_latency += latency;
+            m_stats.last_latency = latency;
+            m_stats.average_latency = m_total_latency / static_cast<std::int64_t>(m_stats.presented);
+            m_stats.max_latency = std::max(m_stats.max_latency, latency);
+        }
+    }
+
+    call_opengl_skip_errors(glDeleteFramebuffers, 1, &framebuffer);
+}
+
+
+// Rethrow the present thread's error, if it stopped on one
+// `m_mutex` must be locked
+void ft::rf::context::mailbox_presenter::rethrow_presenter_error() const
+{
+    if (m_error != nullptr)
+    {
+        std::rethrow_exception(m_error);
+    }
+}
+
+
+// Allocate a target's storage for its size
+// The rendering context must be active
+void ft::rf::context::mailbox_presenter::allocate(t_target & p_target)
+{
+    // Texture storage is respecified in place, the present context
+    //  attaches the texture again for every blit
+    call_opengl<err::context_edit_error>(glBindTexture, GL_TEXTURE_2D, p_target.color);
+    call_opengl<err::context_edit_error>(
+        glTexImage2D,
+        GL_TEXTURE_2D,
+        GLint{ 0 },
+        GLint{ GL_RGBA8 },
+        p_target.width, p_target.height,
+        GLint{ 0 },
+        GLenum{ GL_RGBA },
+        GLenum{ GL_UNSIGNED_BYTE },
+        nullptr);
+    call_opengl<err::context_edit_error>(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GLint{ GL_NEAREST });
+    call_opengl<err::context_edit_error>(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GLint{ GL_NEAREST });
+    call_opengl<err::context_edit_error>(glBindTexture, GL_TEXTURE_2D, GLuint{ 0 });
+
+    call_opengl<err::context_edit_error>(glBindRenderbuffer, GL_RENDERBUFFER, p_target.depth);
+    call_opengl<err::context_edit_error>(
+        glRenderbufferStorage,
+        GL_RENDERBUFFER,
+        GL_DEPTH24_STENCIL8,
+        p_target.width, p_target.height);
+    call_opengl<err::context_edit_error>(glBindRenderbuffer, GL_RENDERBUFFER, GLuint{ 0 });
+
+    auto & tracker = get_gpu_memory_tracker();
+    tracker.track(
+        *m_context,
+        t_gpu_memory_category::texture,
+        p_target.color,
+        estimate_texture_size(GL_RGBA8, p_target.width, p_target.height),
+        "mailbox_presenter");
+    tracker.track(
+        *m_context,
+        t_gpu_memory_category::renderbuffer,
+        p_target.depth,
+        estimate_texture_size(GL_DEPTH24_STENCIL8, p_target.width, p_target.height),
+        "mailbox_presenter");
+
+    call_opengl<err::context_edit_error>(glBindFramebuffer, GL_FRAMEBUFFER, p_target.framebuffer);
+    call_opengl<err::context_edit_error>(
+        glFramebufferTexture2D,
+        GL_FRAMEBUFFER,
+        GL_COLOR_ATTACHMENT0,
+        GL_TEXTURE_2D,
+        p_target.color,
+        GLint{ 0 });
+    call_opengl<err::context_edit_error>(
+        glFramebufferRenderbuffer,
+        GL_FRAMEBUFFER,
+        GL_DEPTH_STENCIL_ATTACHMENT,
+        GL_RENDERBUFFER,
+        p_target.depth);
+
+    const auto status = call_opengl<err::context_edit_error>(glCheckFramebufferStatus, GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        err::context_edit_error::raise("mailbox target framebuffer is incomplete");
+    }
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+// Mailbox presentation
+//
+// Frames are rendered into a ring of offscreen targets instead of the
+//  window's back buffer
+// A present thread with its own context sharing the targets waits for
+//  the display, then blits the newest completed target and swaps
+// A completed frame that is replaced by a newer one before the present
+//  thread picks it up is discarded, the renderer never waits for the display
+
+// standard headers
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+// Forward declaration
+class opengl_context;
+
+class mailbox_presenter
+{
+public:
+    // Presentation statistics
+    struct t_stats {
+        // Frames shown and frames replaced before they could be shown
+        std::uint64_t presented = 0;
+        std::uint64_t discarded = 0;
+
+        // Time between a frame's `end_frame` and the return of its swap
+        std::chrono::nanoseconds last_latency{ 0 };
+        std::chrono::nanoseconds average_latency{ 0 };
+        std::chrono::nanoseconds max_latency{ 0 };
+    };
+
+    // Shows the window's back buffer, called on the present thread
+    using t_swap = std::function<void()>;
+
+    // Default number of targets, the minimum for mailbox presentation
+    static constexpr std::size_t s_default_count = 3;
+
+public:
+    // Constructor
+    // Creates the present thread and its context sharing `p_context`'s objects
+    mailbox_presenter(opengl_context& p_context, t_swap p_swap, const std::size_t p_count = s_default_count);
+
+    // Destructor
+    // Stops the present thread, a frame waiting to be shown is dropped
+    ~mailbox_presenter();
+
+    // Prevent copy
+    mailbox_presenter(const mailbox_presenter&) = delete;
+    mailbox_presenter& operator=(const mailbox_presenter&) = delete;
+
+    // Bind a free target of `p_width` x `p_height` pixels as the framebuffer
+    //  of the rendering context
+    // Rethrows the present thread's error if it stopped
+    void begin_frame(const int p_width, const int p_height);
+
+    // Hand the target bound by `begin_frame` to the present thread
+    // Rethrows the present thread's error if it stopped
+    void end_frame();
+
+    // Get the presentation statistics
+    t_stats get_stats() const;
+
+private:
+    enum class t_state {
+        free,
+        rendering,
+        ready,      // Completed, waiting for the present thread
+        presenting
+    };
+
+    struct t_target {
+        unsigned int color = 0;         // RGBA8 texture, shared with the present context
+        unsigned int depth = 0;         // Depth and stencil renderbuffer
+        unsigned int framebuffer = 0;   // Rendering context's framebuffer
+        int width = 0;
+        int height = 0;
+        t_state state = t_state::free;
+        void* fence = nullptr;          // GLsync, rendering completed
+        void* release = nullptr;        // GLsync, present blit completed
+        std::chrono::steady_clock::time_point end_time;
+    };
+
+    // Present thread entry point
+    void run_presenter();
+
+    // Rethrow the present thread's error, if it stopped on one
+    // `m_mutex` must be locked
+    void rethrow_presenter_error() const;
+
+    // Allocate a target's storage for its size
+    // The rendering context must be active
+    void allocate(t_target& p_target);
+
+private:
+    // Context rendering into the targets
+    opengl_context* m_context = nullptr;
+
+    // Context used by the present thread
+    std::unique_ptr<opengl_context> m_present_context;
+
+    // Shows the back buffer
+    t_swap m_swap;
+
+    // Ring of targets
+    std::vector<t_target> m_targets;
+
+    // Target bound by `begin_frame`, and newest ready target
+    std::size_t m_rendering = 0;
+    std::size_t m_ready = 0;
+    bool m_has_ready = false;
+
+    // Presentation statistics
+    t_stats m_stats;
+
+    // Sum of the latencies, for the average
+    std::chrono::nanoseconds m_total_latency{ 0 };
+
+    // Present thread synchronization
+    mutable std::mutex m_mutex;
+    std::condition_variable m_ready_condition;
+    bool m_stop = false;
+    std::thread m_presenter;
+
+    // Error that stopped the present thread
+    std::exception_ptr m_error;
+
+};  // class mailbox_presenter
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,435 @@
+#include "null_gl.h"
+
+// standard headers
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Next object name, shared by every kind of object
+std::atomic<GLuint> g_next_name{ 1 };
+
+// Binary returned for every program
+constexpr char g_program_binary[] = "ft_render_frame_lib null program";
+constexpr GLenum g_program_binary_format = 1;
+
+
+// Accept any arguments and return a default value
+template<class R, class ... Args>
+R APIENTRY ignore(Args...)
+{
+    if constexpr (std::is_void_v<R> == false)
+    {
+        return R{};
+    }
+}
+
+
+// Replace a function loaded by GLEW with `ignore`
+template<class R, class ... Args>
+void install_ignore(R (APIENTRY*& p_function)(Args...))
+{
+    p_function = &ignore<R, Args...>;
+}
+
+
+// Map an exported function to `ignore`
+template<class R, class ... Args>
+void export_ignore(std::unordered_map<void*, void*> & p_exports, R (APIENTRY* p_function)(Args...))
+{
+    p_exports[reinterpret_cast<void*>(p_function)] = reinterpret_cast<void*>(&ignore<R, Args...>);
+}
+
+
+// Map an exported function to a null implementation
+template<class Function>
+void export_function(std::unordered_map<void*, void*> & p_exports, Function p_function, Function p_null)
+{
+    p_exports[reinterpret_cast<void*>(p_function)] = reinterpret_cast<void*>(p_null);
+}
+
+
+// glGen*
+void APIENTRY gen_names(GLsizei p_count, GLuint* p_names)
+{
+    for (GLsizei i = 0; i < p_count; ++i)
+    {
+        p_names[i] = g_next_name.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+
+// glCreateShader
+GLuint APIENTRY create_shader(GLenum)
+{
+    return g_next_name.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+// glCreateProgram
+GLuint APIENTRY create_program()
+{
+    return g_next_name.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+// glGetIntegerv
+void APIENTRY get_integer(GLenum p_name, GLint* p_value)
+{
+    switch (p_name)
+    {
+    case GL_MAJOR_VERSION:                      *p_value = 4; break;
+    case GL_MINOR_VERSION:                      *p_value = 6; break;
+    case GL_MAX_TEXTURE_SIZE:                   *p_value = 16384; break;
+    case GL_MAX_ARRAY_TEXTURE_LAYERS:           *p_value = 2048; break;
+    case GL_MAX_UNIFORM_BLOCK_SIZE:             *p_value = 65536; break;
+    case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT:    *p_value = 256; break;
+    case GL_NUM_PROGRAM_BINARY_FORMATS:         *p_value = 1; break;
+    case GL_PROGRAM_BINARY_FORMATS:             *p_value = g_program_binary_format; break;
+    default:                                    *p_value = 0; break;
+    }
+}
+
+
+// glGetInteger64v
+void APIENTRY get_integer_64(GLenum, GLint64* p_value)
+{
+    *p_value = 0;
+}
+
+
+// glGetString
+const GLubyte* APIENTRY get_string(GLenum p_name)
+{
+    const char* value = "";
+    switch (p_name)
+    {
+    case GL_VENDOR:                     value = "ft_render_frame_lib"; break;
+    case GL_RENDERER:                   value = "null"; break;
+    case GL_VERSION:                    value = "4.6 null"; break;
+    case GL_SHADING_LANGUAGE_VERSION:   value = "4.60"; break;
+    default:                            break;
+    }
+    return reinterpret_cast<const GLubyte*>(value);
+}
+
+
+// glGetShaderiv and glGetProgramiv
+void APIENTRY get_object_parameter(GLuint, GLenum p_name, GLint* p_value)
+{
+    switch (p_name)
+    {
+    case GL_COMPILE_STATUS:
+    case GL_LINK_STATUS:
+    case GL_VALIDATE_STATUS:
+    case GL_COMPLETION_STATUS_KHR:
+        *p_value = GL_TRUE;
+        break;
+    case GL_PROGRAM_BINARY_LENGTH:
+        *p_value = static_cast<GLint>(sizeof(g_program_binary));
+        break;
+    default:
+        *p_value = 0;
+        break;
+    }
+}
+
+
+// glGetProgramBinary
+void APIENTRY get_program_binary(GLuint, GLsizei p_size, GLsizei* p_length, GLenum* p_format, void* p_binary)
+{
+    const auto length = std::min<GLsizei>(p_size, static_cast<GLsizei>(sizeof(g_program_binary)));
+    std::memcpy(p_binary, g_program_binary, static_cast<std::size_t>(length));
+
+    if (p_length != nullptr) {
+        *p_length = length;
+    }
+    *p_format = g_program_binary_format;
+}
+
+
+// glGetFramebufferAttachmentParameteriv
+// Framebuffers have no attachments
+void APIENTRY get_framebuffer_attachment_parameter(GLenum, GLenum, GLenum, GLint* p_value)
+{
+    *p_value = 0;
+}
+
+
+// glCheckFramebufferStatus
+GLenum APIENTRY check_framebuffer_status(GLenum)
+{
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+
+// glFenceSync
+GLsync APIENTRY fence_sync(GLenum, GLbitfield)
+{
+    const auto name = static_cast<std::uintptr_t>(g_next_name.fetch_add(1, std::memory_order_relaxed));
+    return reinterpret_cast<GLsync>(name);
+}
+
+
+// glClientWaitSync
+// Every command completes immediately
+GLenum APIENTRY client_wait_sync(GLsync, GLbitfield, GLuint64)
+{
+    return GL_ALREADY_SIGNALED;
+}
+
+
+// glGetQueryObjectiv
+// Every query is available immediately
+void APIENTRY get_query_object(GLuint, GLenum p_name, GLint* p_value)
+{
+    *p_value = (p_name == GL_QUERY_RESULT_AVAILABLE) ? GL_TRUE : 0;
+}
+
+
+// glGetQueryObjectui64v
+// Every measurement takes no time
+void APIENTRY get_query_object_64(GLuint, GLenum, GLuint64* p_value)
+{
+    *p_value = 0;
+}
+
+
+// glMapBufferRange
+// Buffers have no storage, every mapping returns the calling thread's scratch memory
+void* APIENTRY map_buffer_range(GLenum, GLintptr, GLsizeiptr p_length, GLbitfield)
+{
+    thread_local std::vector<std::byte> scratch;
+    if (scratch.size() < static_cast<std::size_t>(p_length))
+    {
+        scratch.resize(static_cast<std::size_t>(p_length));
+    }
+    return scratch.data();
+}
+
+
+// glUnmapBuffer
+GLboolean APIENTRY unmap_buffer(GLenum)
+{
+    return GL_TRUE;
+}
+
+
+// wglChoosePixelFormatARB
+BOOL WINAPI choose_pixel_format(HDC, const int*, const FLOAT*, UINT, int* p_format, UINT* p_count)
+{
+    *p_format = 1;
+    *p_count = 1;
+    return TRUE;
+}
+
+
+// wglCreateContextAttribsARB
+HGLRC WINAPI create_context_attribs(HDC, HGLRC, const int*)
+{
+    return ft::rf::context::null_gl::create_context();
+}
+
+
+// wglSwapIntervalEXT
+BOOL WINAPI swap_interval(int)
+{
+    return TRUE;
+}
+
+
+// Null implementations of the functions exported by opengl32.dll
+const std::unordered_map<void*, void*> & get_exports()
+{
+    static const auto exports = []() {
+        auto result = std::unordered_map<void*, void*>{};
+
+        export_function(result, &glGetError, &ft::rf::context::null_gl::get_error);
+        export_function(result, &glGetIntegerv, &get_integer);
+        export_function(result, &glGetString, &get_string);
+        export_function(result, &glGenTextures, &gen_names);
+
+        export_ignore(result, &glBindTexture);
+        export_ignore(result, &glBlendFunc);
+        export_ignore(result, &glClear);
+        export_ignore(result, &glClearColor);
+        export_ignore(result, &glCullFace);
+        export_ignore(result, &glDeleteTextures);
+        export_ignore(result, &glDepthFunc);
+        export_ignore(result, &glDepthMask);
+        export_ignore(result, &glDisable);
+        export_ignore(result, &glEnable);
+        export_ignore(result, &glFinish);
+        export_ignore(result, &glFlush);
+        export_ignore(result, &glPixelStorei);
+        export_ignore(result, &glPolygonMode);
+        export_ignore(result, &glReadPixels);
+        export_ignore(result, &glScissor);
+        export_ignore(result, &glTexImage2D);
+        export_ignore(result, &glTexParameteri);
+        export_ignore(result, &glTexSubImage2D);
+        export_ignore(result, &glViewport);
+
+        return result;
+    }();
+    return exports;
+}
+
+}   // anonymous namespace
+
+
+// Replace the function pointers and extension flags loaded by GLEW
+// The null dispatch's equivalent of glewInit
+void ft::rf::context::null_gl::install()
+{
+    // Objects
+    glGenBuffers = &gen_names;
+    glCreateShader = &create_shader;
+    glCreateProgram = &create_program;
+    install_ignore(glDeleteBuffers);
+    install_ignore(glDeleteShader);
+    install_ignore(glDeleteProgram);
+
+    // Queries
+    glGetShaderiv = &get_object_parameter;
+    glGetProgramiv = &get_object_parameter;
+    glGetProgramBinary = &get_program_binary;
+    glCheckFramebufferStatus = &check_framebuffer_status;
+    install_ignore(glGetShaderInfoLog);
+    install_ignore(glGetProgramInfoLog);
+
+    // Programs
+    install_ignore(glShaderSource);
+    install_ignore(glCompileShader);
+    install_ignore(glAttachShader);
+    install_ignore(glDetachShader);
+    install_ignore(glLinkProgram);
+    install_ignore(glProgramParameteri);
+    install_ignore(glProgramBinary);
+    install_ignore(glUseProgram);
+    install_ignore(glMaxShaderCompilerThreadsKHR);
+    install_ignore(glMaxShaderCompilerThreadsARB);
+
+    // Buffers and textures
+    install_ignore(glBindBuffer);
+    install_ignore(glBindBufferRange);
+    install_ignore(glBufferData);
+    install_ignore(glBufferSubData);
+    install_ignore(glCopyBufferSubData);
+    install_ignore(glActiveTexture);
+    install_ignore(glTexStorage2D);
+    install_ignore(glTexStorage3D);
+    install_ignore(glTexSubImage3D);
+    install_ignore(glCopyImageSubData);
+    glMapBufferRange = &map_buffer_range;
+    glUnmapBuffer = &unmap_buffer;
+
+    // Framebuffers
+    glGenFramebuffers = &gen_names;
+    glGenRenderbuffers = &gen_names;
+    install_ignore(glDeleteFramebuffers);
+    install_ignore(glDeleteRenderbuffers);
+    install_ignore(glBindFramebuffer);
+    install_ignore(glBindRenderbuffer);
+    install_ignore(glRenderbufferStorage);
+    install_ignore(glFramebufferTexture);
+    install_ignore(glFramebufferTexture2D);
+    install_ignore(glFramebufferTextureLayer);
+    install_ignore(glFramebufferRenderbuffer);
+    install_ignore(glBlitFramebuffer);
+    install_ignore(glInvalidateFramebuffer);
+    install_ignore(glDrawBuffers);
+    glGetFramebufferAttachmentParameteriv = &get_framebuffer_attachment_parameter;
+
+    // Synchronization
+    glFenceSync = &fence_sync;
+    glClientWaitSync = &client_wait_sync;
+    install_ignore(glDeleteSync);
+    install_ignore(glWaitSync);
+
+    // Timer queries
+    glGenQueries = &gen_names;
+    glGetQueryObjectiv = &get_query_object;
+    glGetQueryObjectui64v = &get_query_object_64;
+    install_ignore(glDeleteQueries);
+    install_ignore(glBeginQuery);
+    install_ignore(glEndQuery);
+    install_ignore(glQueryCounter);
+    glGetInteger64v = &get_integer_64;
+
+    // Samplers
+    glGenSamplers = &gen_names;
+    install_ignore(glDeleteSamplers);
+    install_ignore(glSamplerParameteri);
+    install_ignore(glSamplerParameterf);
+    install_ignore(glSamplerParameterfv);
+
+    // Drawing
+    glGenVertexArrays = &gen_names;
+    install_ignore(glDeleteVertexArrays);
+    install_ignore(glBindVertexArray);
+    install_ignore(glEnableVertexAttribArray);
+    install_ignore(glVertexAttribPointer);
+    install_ignore(glVertexAttribIPointer);
+    install_ignore(glVertexAttribDivisor);
+    install_ignore(glDrawElementsInstancedBaseVertexBaseInstance);
+    install_ignore(glMultiDrawElementsIndirect);
+
+    // Debugging
+    install_ignore(glDebugMessageCallback);
+
+    // Extensions the library uses when available
+    GLEW_KHR_parallel_shader_compile = GL_TRUE;
+    GLEW_ARB_parallel_shader_compile = GL_TRUE;
+    GLEW_ARB_multi_draw_indirect = GL_TRUE;
+    GLEW_ARB_invalidate_subdata = GL_TRUE;
+    GLEW_ARB_copy_image = GL_TRUE;
+}
+
+
+// Find the null implementation of a function exported by opengl32.dll
+// Returns nullptr if `p_function` isn't one
+void* ft::rf::context::null_gl::find_export(void* p_function)
+{
+    const auto & exports = get_exports();
+    const auto found = exports.find(p_function);
+    return found != exports.end() ? found->second : nullptr;
+}
+
+
+// Null implementation of a WGL extension function
+// Returns nullptr if there is none
+void* ft::rf::context::null_gl::get_proc_address(const char* p_name)
+{
+    const auto name = std::string_view{ p_name };
+    if (name == "wglChoosePixelFormatARB") {
+        return reinterpret_cast<void*>(&choose_pixel_format);
+    }
+    if (name == "wglCreateContextAttribsARB") {
+        return reinterpret_cast<void*>(&create_context_attribs);
+    }
+    if (name == "wglSwapIntervalEXT") {
+        return reinterpret_cast<void*>(&swap_interval);
+    }
+    return nullptr;
+}
+
+
+// Fake render context handle
+HGLRC ft::rf::context::null_gl::create_context()
+{
+    const auto handle = static_cast<std::uintptr_t>(g_next_name.fetch_add(1, std::memory_order_relaxed));
+    return reinterpret_cast<HGLRC>(handle);
+}
+
+
+// glGetError, the null dispatch never generates errors
+GLenum APIENTRY ft::rf::context::null_gl::get_error()
+{
+    return GL_NO_ERROR;
+}
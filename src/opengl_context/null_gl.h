@@ -0,0 +1,62 @@
+#pragma once
+
+// OpenGL implementation used by the null dispatch
+// Every function accepts its arguments and returns plausible results
+//  from minimal fake state, without touching the driver :
+//  - Object names are unique and never 0
+//  - Shaders compile, programs link and framebuffers are complete
+//  - Limits and strings are fixed values of a GL 4.6 implementation
+//
+// Functions loaded by GLEW are replaced by `install`, functions exported
+//  by opengl32.dll are redirected by `resolve`
+// Functions the library starts using must be added to null_gl.cpp
+
+// OpenGL headers
+#include "basegl/opengl_headers.h"
+
+// standard headers
+#include <type_traits>
+
+namespace ft {
+namespace rf {
+namespace context {
+namespace null_gl {
+
+// Replace the function pointers and extension flags loaded by GLEW
+// The null dispatch's equivalent of glewInit
+void install();
+
+// Find the null implementation of a function exported by opengl32.dll
+// Returns nullptr if `p_function` isn't one
+void* find_export(void* p_function);
+
+// Get the null implementation of a function
+// Returns `p_function` if there is none, which is the case for
+//  functions loaded by GLEW since `install` already replaced them
+template<class Function>
+Function resolve(Function p_function)
+{
+    if constexpr (std::is_pointer_v<Function>)
+    {
+        if (auto found = find_export(reinterpret_cast<void*>(p_function)))
+        {
+            return reinterpret_cast<Function>(found);
+        }
+    }
+    return p_function;
+}
+
+// Null implementation of a WGL extension function
+// Returns nullptr if there is none
+void* get_proc_address(const char* p_name);
+
+// Fake render context handle
+HGLRC create_context();
+
+// glGetError, the null dispatch never generates errors
+GLenum APIENTRY get_error();
+
+}   // namespace null_gl
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,621 @@
+#include "object_caches.h"
+
+// project headers
+#include "call_opengl_function.h"
+#include "make_current.h"
+#include "opengl_context.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+#include <bit>
+#include <string>
+#include <type_traits>
+
+namespace {
+
+// Append a value to a key
+template<class T>
+void push(std::vector<std::uint32_t> & p_key, const T p_value)
+{
+    if constexpr (std::is_same_v<T, float>) {
+        p_key.push_back(std::bit_cast<std::uint32_t>(p_value));
+    }
+    else if constexpr (std::is_enum_v<T>) {
+        p_key.push_back(static_cast<std::uint32_t>(p_value));
+    }
+    else if constexpr (sizeof(T) > sizeof(std::uint32_t)) {
+        p_key.push_back(static_cast<std::uint32_t>(p_value));
+        p_key.push_back(static_cast<std::uint32_t>(static_cast<std::uint64_t>(p_value) >> 32));
+    }
+    else {
+        p_key.push_back(static_cast<std::uint32_t>(p_value));
+    }
+}
+
+
+// OpenGL component type of a vertex attribute
+GLenum get_gl_type(const ft::rf::context::t_attribute_type p_type)
+{
+    using ft::rf::context::t_attribute_type;
+    switch (p_type)
+    {
+    case t_attribute_type::float16: return GL_HALF_FLOAT;
+    case t_attribute_type::int8: return GL_BYTE;
+    case t_attribute_type::uint8: return GL_UNSIGNED_BYTE;
+    case t_attribute_type::int16: return GL_SHORT;
+    case t_attribute_type::uint16: return GL_UNSIGNED_SHORT;
+    case t_attribute_type::int32: return GL_INT;
+    case t_attribute_type::uint32: return GL_UNSIGNED_INT;
+    default: return GL_FLOAT;
+    }
+}
+
+
+// OpenGL wrapping mode
+GLint get_gl_wrap(const ft::rf::context::t_texture_wrap p_wrap)
+{
+    using ft::rf::context::t_texture_wrap;
+    switch (p_wrap)
+    {
+    case t_texture_wrap::mirrored_repeat: return GL_MIRRORED_REPEAT;
+    case t_texture_wrap::clamp_to_edge: return GL_CLAMP_TO_EDGE;
+    case t_texture_wrap::clamp_to_border: return GL_CLAMP_TO_BORDER;
+    default: return GL_REPEAT;
+    }
+}
+
+
+// OpenGL minification filter
+GLint get_gl_min_filter(const ft::rf::context::t_sampler_desc & p_desc)
+{
+    using ft::rf::context::t_texture_filter;
+    const auto linear = (p_desc.min_filter == t_texture_filter::linear);
+    if (p_desc.mip_mapping == false) {
+        return linear ? GL_LINEAR : GL_NEAREST;
+    }
+    if (p_desc.mip_filter == t_texture_filter::linear) {
+        return linear ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_LINEAR;
+    }
+    return linear ? GL_LINEAR_MIPMAP_NEAREST : GL_NEAREST_MIPMAP_NEAREST;
+}
+
+
+// Attach an image to the bound draw framebuffer
+void attach(const GLenum p_attachment, const ft::rf::context::t_framebuffer_attachment & p_image)
+{
+    using ft::rf::context::t_object_kind;
+    if (p_image.kind == t_object_kind::renderbuffer)
+    {
+        ft::rf::call_opengl<ft::rf::err::context_edit_error>(
+            glFramebufferRenderbuffer,
+            GL_DRAW_FRAMEBUFFER,
+            p_attachment,
+            GL_RENDERBUFFER,
+            p_image.name);
+    }
+    else if (p_image.layer >= 0)
+    {
+        ft::rf::call_opengl<ft::rf::err::context_edit_error>(
+            glFramebufferTextureLayer,
+            GL_DRAW_FRAMEBUFFER,
+            p_attachment,
+            p_image.name,
+            p_image.level,
+            p_image.layer);
+    }
+    else
+    {
+        ft::rf::call_opengl<ft::rf::err::context_edit_error>(
+            glFramebufferTexture,
+            GL_DRAW_FRAMEBUFFER,
+            p_attachment,
+            p_image.name,
+            p_image.level);
+    }
+}
+
+
+// Delete an object of each cached type
+// The context must be active
+void delete_vertex_array(const unsigned int p_name)
+{
+    ft::rf::call_opengl_skip_errors(glDeleteVertexArrays, 1, &p_name);
+}
+
+
+void delete_sampler(const unsigned int p_name)
+{
+    ft::rf::call_opengl_skip_errors(glDeleteSamplers, 1, &p_name);
+}
+
+
+void delete_framebuffer(const unsigned int p_name)
+{
+    ft::rf::call_opengl_skip_errors(glDeleteFramebuffers, 1, &p_name);
+}
+
+}   // anonymous namespace
+
+
+// Share of the requests served from the cache, 0 before the first one
+double ft::rf::context::t_object_cache_stats::get_hit_rate() const
+{
+    const auto requests = hits + misses;
+    if (requests == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(hits) / static_cast<double>(requests);
+}
+
+
+// Constructor
+// `p_context` must be active on the calling thread
+ft::rf::context::object_caches::object_caches(opengl_context & p_context) :
+    m_context(&p_context)
+{
+    m_vertex_arrays.destroy = &delete_vertex_array;
+    m_samplers.destroy = &delete_sampler;
+    m_framebuffers.destroy = &delete_framebuffer;
+
+    if (GLEW_EXT_texture_filter_anisotropic)
+    {
+        GLfloat maximum = 1.f;
+        call_opengl<err::context_init>(glGetFloatv, GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maximum);
+        m_max_anisotropy = std::max(maximum, 1.f);
+    }
+}
+
+
+// Destructor
+// Deletes every cached object, referenced or not
+ft::rf::context::object_caches::~object_caches()
+{
+    auto active = make_current{ *m_context };
+
+    for (auto* cache : { &m_vertex_arrays, &m_samplers, &m_framebuffers })
+    {
+        for (const auto & entry : cache->entries) {
+            cache->destroy(entry.second.name);
+        }
+        for (const auto & entry : cache->retired) {
+            cache->destroy(entry.first);
+        }
+    }
+}
+
+
+// Get a vertex array for a layout and its buffers, created on first use
+// Each call adds a reference, remove it with `release_vertex_array`
+// Binding points changed to create it are restored
+unsigned int ft::rf::context::object_caches::acquire_vertex_array(const t_vertex_array_desc & p_desc)
+{
+    auto key = t_key{};
+    key.reserve(2 + p_desc.attributes.size() * 7 + p_desc.buffers.size() * 5);
+    push(key, p_desc.index_buffer);
+    push(key, p_desc.attributes.size());
+    for (const auto & attribute : p_desc.attributes)
+    {
+        push(key, attribute.location);
+        push(key, attribute.components);
+        push(key, attribute.type);
+        push(key, attribute.normalized);
+        push(key, attribute.integer);
+        push(key, attribute.buffer);
+        push(key, attribute.offset);
+    }
+    for (const auto & buffer : p_desc.buffers)
+    {
+        push(key, buffer.buffer);
+        push(key, buffer.offset);
+        push(key, buffer.stride);
+        push(key, buffer.divisor);
+    }
+
+    auto dependencies = std::vector<std::pair<t_object_kind, unsigned int>>{};
+    for (const auto & buffer : p_desc.buffers) {
+        dependencies.emplace_back(t_object_kind::buffer, buffer.buffer);
+    }
+    if (p_desc.index_buffer != 0) {
+        dependencies.emplace_back(t_object_kind::buffer, p_desc.index_buffer);
+    }
+
+    return acquire(m_vertex_arrays, std::move(key), dependencies, [&]() {
+        return create_vertex_array(p_desc);
+    });
+}
+
+
+// Remove a reference to a vertex array
+void ft::rf::context::object_caches::release_vertex_array(const unsigned int p_vertex_array)
+{
+    release(m_vertex_arrays, p_vertex_array);
+}
+
+
+// Get a sampler, created on first use
+// Each call adds a reference, remove it with `release_sampler`
+unsigned int ft::rf::context::object_caches::acquire_sampler(const t_sampler_desc & p_desc)
+{
+    auto key = t_key{};
+    key.reserve(13);
+    push(key, p_desc.min_filter);
+    push(key, p_desc.mag_filter);
+    push(key, p_desc.mip_filter);
+    push(key, p_desc.mip_mapping);
+    push(key, p_desc.wrap_s);
+    push(key, p_desc.wrap_t);
+    push(key, p_desc.wrap_r);
+    push(key, p_desc.max_anisotropy);
+    push(key, p_desc.lod_bias);
+    for (const auto channel : p_desc.border_color) {
+        push(key, channel);
+    }
+
+    return acquire(m_samplers, std::move(key), {}, [&]() {
+        return create_sampler(p_desc);
+    });
+}
+
+
+// Remove a reference to a sampler
+void ft::rf::context::object_caches::release_sampler(const unsigned int p_sampler)
+{
+    release(m_samplers, p_sampler);
+}
+
+
+// Get a framebuffer for a set of attachments, created on first use
+// Each call adds a reference, remove it with `release_framebuffer`
+// Raises t_except_framebuffer_incomplete if the framebuffer isn't complete
+unsigned int ft::rf::context::object_caches::acquire_framebuffer(const t_framebuffer_desc & p_desc)
+{
+    auto key = t_key{};
+    auto dependencies = std::vector<std::pair<t_object_kind, unsigned int>>{};
+    const auto add = [&](const t_framebuffer_attachment & p_image)
+    {
+        push(key, p_image.kind);
+        push(key, p_image.name);
+        push(key, p_image.level);
+        push(key, p_image.layer);
+        if (p_image.name != 0) {
+            dependencies.emplace_back(p_image.kind, p_image.name);
+        }
+    };
+
+    key.reserve((t_framebuffer_desc::s_max_colors + 2) * 4);
+    for (const auto & color : p_desc.colors) {
+        add(color);
+    }
+    add(p_desc.depth);
+    add(p_desc.stencil);
+
+    return acquire(m_framebuffers, std::move(key), dependencies, [&]() {
+        return create_framebuffer(p_desc);
+    });
+}
+
+
+// Remove a reference to a framebuffer
+void ft::rf::context::object_caches::release_framebuffer(const unsigned int p_framebuffer)
+{
+    release(m_framebuffers, p_framebuffer);
+}
+
+
+// Tell the caches a buffer, texture or renderbuffer was deleted
+// The cached objects using it are rebuilt on their next use
+void ft::rf::context::object_caches::notify_deleted(const t_object_kind p_kind, const unsigned int p_name)
+{
+    const auto id = (static_cast<std::uint64_t>(p_kind) << 32) | p_name;
+    ++m_generations[id];
+}
+
+
+// Delete the cached objects without references
+// Returns the number of objects deleted
+// Invalidated objects still referenced are retired
+std::size_t ft::rf::context::object_caches::trim()
+{
+    auto active = make_current{ *m_context };
+
+    std::size_t deleted = 0;
+    for (auto* cache : { &m_vertex_arrays, &m_samplers, &m_framebuffers })
+    {
+        for (auto entry = cache->entries.begin(); entry != cache->entries.end();)
+        {
+            auto & object = entry->second;
+            const auto name = object.name;
+            if (object.references == 0)
+            {
+                cache->destroy(name);
+                ++deleted;
+            }
+            else if (is_valid(object) == false)
+            {
+                ++cache->stats.invalidations;
+                cache->retired.emplace(name, std::move(object));
+            }
+            else
+            {
+                ++entry;
+                continue;
+            }
+            cache->names.erase(name);
+            entry = cache->entries.erase(entry);
+        }
+    }
+    return deleted;
+}
+
+
+// Get the use of each cache
+ft::rf::context::t_object_caches_stats ft::rf::context::object_caches::get_stats() const
+{
+    const auto get = [](const t_cache & p_cache)
+    {
+        auto stats = p_cache.stats;
+        stats.objects = p_cache.entries.size() + p_cache.retired.size();
+        stats.referenced = p_cache.retired.size();
+        for (const auto & entry : p_cache.entries)
+        {
+            if (entry.second.references > 0) {
+                ++stats.referenced;
+            }
+        }
+        return stats;
+    };
+
+    return { get(m_vertex_arrays), get(m_samplers), get(m_framebuffers) };
+}
+
+
+// Hash a key
+std::size_t ft::rf::context::object_caches::t_key_hash::operator()(const t_key & p_key) const
+{
+    // FNV-1a over the key's words
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const auto word : p_key)
+    {
+        hash ^= word;
+        hash *= 1099511628211ull;
+    }
+    return static_cast<std::size_t>(hash);
+}
+
+
+// Find or create the object of a key, adding a reference
+// `p_dependencies` are the objects `p_create` builds it on
+unsigned int ft::rf::context::object_caches::acquire(
+    t_cache & p_cache,
+    t_key && p_key,
+    const std::vector<std::pair<t_object_kind, unsigned int>> & p_dependencies,
+    const std::function<unsigned int()> & p_create)
+{
+    auto found = p_cache.entries.find(p_key);
+    if (found != p_cache.entries.end())
+    {
+        auto & entry = found->second;
+        if (is_valid(entry))
+        {
+            ++p_cache.stats.hits;
+            ++entry.references;
+            return entry.name;
+        }
+
+        // A name it uses now refers to another object, retire it
+        ++p_cache.stats.invalidations;
+        p_cache.names.erase(entry.name);
+        if (entry.references == 0)
+        {
+            auto active = make_current{ *m_context };
+            p_cache.destroy(entry.name);
+        }
+        else {
+            p_cache.retired.emplace(entry.name, std::move(entry));
+        }
+        p_cache.entries.erase(found);
+    }
+
+    ++p_cache.stats.misses;
+
+    auto entry = t_entry{};
+    {
+        auto active = make_current{ *m_context };
+        entry.name = p_create();
+    }
+    entry.references = 1;
+    for (const auto & [kind, name] : p_dependencies) {
+        entry.dependencies.push_back({ kind, name, get_generation(kind, name) });
+    }
+
+    const auto name = entry.name;
+    auto & inserted = p_cache.entries.emplace(std::move(p_key), std::move(entry)).first->second;
+    p_cache.names.emplace(name, &inserted);
+    return name;
+}
+
+
+// Remove a reference to an object
+// Retired objects are deleted with their last reference
+void ft::rf::context::object_caches::release(t_cache & p_cache, const unsigned int p_name)
+{
+    const auto retired = p_cache.retired.find(p_name);
+    if (retired != p_cache.retired.end())
+    {
+        FT_ASSERT(retired->second.references > 0);
+        if (--retired->second.references == 0)
+        {
+            auto active = make_current{ *m_context };
+            p_cache.destroy(p_name);
+            p_cache.retired.erase(retired);
+        }
+        return;
+    }
+
+    const auto found = p_cache.names.find(p_name);
+    FT_ASSERT(found != p_cache.names.end() && found->second->references > 0);
+    if (found != p_cache.names.end() && found->second->references > 0) {
+        --found->second->references;
+    }
+}
+
+
+// Is every object an entry was built on still the same?
+bool ft::rf::context::object_caches::is_valid(const t_entry & p_entry) const
+{
+    return std::all_of(p_entry.dependencies.begin(), p_entry.dependencies.end(), [this](const t_dependency & p_dependency) {
+        return get_generation(p_dependency.kind, p_dependency.name) == p_dependency.generation;
+    });
+}
+
+
+// Current generation of an object
+std::uint32_t ft::rf::context::object_caches::get_generation(const t_object_kind p_kind, const unsigned int p_name) const
+{
+    if (m_generations.empty()) {
+        return 0;
+    }
+    const auto found = m_generations.find((static_cast<std::uint64_t>(p_kind) << 32) | p_name);
+    return found != m_generations.end() ? found->second : 0;
+}
+
+
+// Create a vertex array
+// The context must be active
+unsigned int ft::rf::context::object_caches::create_vertex_array(const t_vertex_array_desc & p_desc)
+{
+    GLint previous_array = 0;
+    GLint previous_buffer = 0;
+    call_opengl<err::context_edit_error>(glGetIntegerv, GL_VERTEX_ARRAY_BINDING, &previous_array);
+    call_opengl<err::context_edit_error>(glGetIntegerv, GL_ARRAY_BUFFER_BINDING, &previous_buffer);
+
+    GLuint vertex_array = 0;
+    call_opengl<err::context_edit_error>(glGenVertexArrays, 1, &vertex_array);
+    call_opengl<err::context_edit_error>(glBindVertexArray, vertex_array);
+
+    for (const auto & attribute : p_desc.attributes)
+    {
+        FT_ASSERT(attribute.buffer < p_desc.buffers.size());
+        const auto & source = p_desc.buffers[attribute.buffer];
+        const auto* pointer = reinterpret_cast<const void*>(source.offset + attribute.offset);
+
+        call_opengl<err::context_edit_error>(glBindBuffer, GL_ARRAY_BUFFER, source.buffer);
+        call_opengl<err::context_edit_error>(glEnableVertexAttribArray, attribute.location);
+        if (attribute.integer)
+        {
+            call_opengl<err::context_edit_error>(
+                glVertexAttribIPointer,
+                attribute.location,
+                attribute.components,
+                get_gl_type(attribute.type),
+                static_cast<GLsizei>(source.stride),
+                pointer);
+        }
+        else
+        {
+            call_opengl<err::context_edit_error>(
+                glVertexAttribPointer,
+                attribute.location,
+                attribute.components,
+                get_gl_type(attribute.type),
+                static_cast<GLboolean>(attribute.normalized ? GL_TRUE : GL_FALSE),
+                static_cast<GLsizei>(source.stride),
+                pointer);
+        }
+        if (source.divisor != 0) {
+            call_opengl<err::context_edit_error>(glVertexAttribDivisor, attribute.location, source.divisor);
+        }
+    }
+
+    // Part of the vertex array's state
+    call_opengl<err::context_edit_error>(glBindBuffer, GL_ELEMENT_ARRAY_BUFFER, p_desc.index_buffer);
+
+    call_opengl<err::context_edit_error>(glBindVertexArray, static_cast<GLuint>(previous_array));
+    call_opengl<err::context_edit_error>(glBindBuffer, GL_ARRAY_BUFFER, static_cast<GLuint>(previous_buffer));
+    return vertex_array;
+}
+
+
+// Create a sampler
+// The context must be active
+unsigned int ft::rf::context::object_caches::create_sampler(const t_sampler_desc & p_desc)
+{
+    GLuint sampler = 0;
+    call_opengl<err::context_edit_error>(glGenSamplers, 1, &sampler);
+
+    const auto mag_filter = (p_desc.mag_filter == t_texture_filter::linear) ? GL_LINEAR : GL_NEAREST;
+    call_opengl<err::context_edit_error>(glSamplerParameteri, sampler, GL_TEXTURE_MIN_FILTER, get_gl_min_filter(p_desc));
+    call_opengl<err::context_edit_error>(glSamplerParameteri, sampler, GL_TEXTURE_MAG_FILTER, mag_filter);
+    call_opengl<err::context_edit_error>(glSamplerParameteri, sampler, GL_TEXTURE_WRAP_S, get_gl_wrap(p_desc.wrap_s));
+    call_opengl<err::context_edit_error>(glSamplerParameteri, sampler, GL_TEXTURE_WRAP_T, get_gl_wrap(p_desc.wrap_t));
+    call_opengl<err::context_edit_error>(glSamplerParameteri, sampler, GL_TEXTURE_WRAP_R, get_gl_wrap(p_desc.wrap_r));
+    call_opengl<err::context_edit_error>(glSamplerParameterf, sampler, GL_TEXTURE_LOD_BIAS, p_desc.lod_bias);
+    call_opengl<err::context_edit_error>(glSamplerParameterfv, sampler, GL_TEXTURE_BORDER_COLOR, p_desc.border_color.data());
+
+    if (m_max_anisotropy > 1.f)
+    {
+        const auto anisotropy = std::clamp(p_desc.max_anisotropy, 1.f, m_max_anisotropy);
+        call_opengl<err::context_edit_error>(glSamplerParameterf, sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
+    }
+    return sampler;
+}
+
+
+// Create a framebuffer
+// The context must be active
+// Raises t_except_framebuffer_incomplete if the framebuffer isn't complete
+unsigned int ft::rf::context::object_caches::create_framebuffer(const t_framebuffer_desc & p_desc)
+{
+    GLint previous = 0;
+    call_opengl<err::context_edit_error>(glGetIntegerv, GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+
+    GLuint framebuffer = 0;
+    call_opengl<err::context_edit_error>(glGenFramebuffers, 1, &framebuffer);
+    call_opengl<err::context_edit_error>(glBindFramebuffer, GL_DRAW_FRAMEBUFFER, framebuffer);
+
+    // Fragment output `i` draws to color attachment `i`
+    auto draw_buffers = std::array<GLenum, t_framebuffer_desc::s_max_colors>{};
+    GLsizei draw_buffer_count = 0;
+    for (std::size_t i = 0; i < p_desc.colors.size(); ++i)
+    {
+        draw_buffers[i] = GL_NONE;
+        if (p_desc.colors[i].name != 0)
+        {
+            const auto attachment = static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i);
+            attach(attachment, p_desc.colors[i]);
+            draw_buffers[i] = attachment;
+            draw_buffer_count = static_cast<GLsizei>(i + 1);
+        }
+    }
+    call_opengl<err::context_edit_error>(glDrawBuffers, std::max<GLsizei>(draw_buffer_count, 1), draw_buffers.data());
+
+    if (p_desc.depth.name != 0 && p_desc.depth == p_desc.stencil) {
+        attach(GL_DEPTH_STENCIL_ATTACHMENT, p_desc.depth);
+    }
+    else
+    {
+        if (p_desc.depth.name != 0) {
+            attach(GL_DEPTH_ATTACHMENT, p_desc.depth);
+        }
+        if (p_desc.stencil.name != 0) {
+            attach(GL_STENCIL_ATTACHMENT, p_desc.stencil);
+        }
+    }
+
+    const auto status = call_opengl<err::context_edit_error>(glCheckFramebufferStatus, GL_DRAW_FRAMEBUFFER);
+    call_opengl<err::context_edit_error>(glBindFramebuffer, GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(previous));
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        call_opengl_skip_errors(glDeleteFramebuffers, 1, &framebuffer);
+        throw t_except_framebuffer_incomplete("Incomplete framebuffer, status " + std::to_string(status));
+    }
+    return framebuffer;
+}
@@ -0,0 +1,333 @@
+#pragma once
+
+// Caches of vertex arrays, samplers and framebuffers keyed by their description
+//
+// Creating these objects every frame makes the driver validate them every
+//  frame, the caches hand out the same object for the same description
+// Objects are reference counted, those without references stay cached
+//  until `trim` deletes them
+// Objects built on buffers, textures or renderbuffers remember the
+//  generation of each one, `notify_deleted` bumps the generation of a
+//  deleted object and the cached objects built on it are rebuilt on their
+//  next use since OpenGL reuses the names of deleted objects
+
+// standard headers
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+// Forward declaration
+class opengl_context;
+
+// Objects cached objects can be built on
+enum class t_object_kind {
+    buffer,
+    texture,
+    renderbuffer
+};
+
+// Component type of a vertex attribute
+enum class t_attribute_type {
+    float32,
+    float16,
+    int8,
+    uint8,
+    int16,
+    uint16,
+    int32,
+    uint32
+};
+
+struct t_vertex_attribute
+{
+    unsigned int location = 0;
+    int components = 4;
+    t_attribute_type type = t_attribute_type::float32;
+
+    // Integer types are read as floats in [0, 1] or [-1, 1]
+    bool normalized = false;
+
+    // Integer types are read as integers by the shader
+    bool integer = false;
+
+    // Index of the attribute's buffer in `t_vertex_array_desc::buffers`
+    std::uint32_t buffer = 0;
+
+    // Offset of the attribute in a vertex
+    std::uint32_t offset = 0;
+
+    bool operator==(const t_vertex_attribute&) const = default;
+};
+
+
+struct t_vertex_buffer
+{
+    unsigned int buffer = 0;
+
+    // Offset of the first vertex in the buffer
+    std::size_t offset = 0;
+
+    // Bytes between two vertices
+    std::uint32_t stride = 0;
+
+    // Instances sharing a vertex, 0 for per-vertex data
+    std::uint32_t divisor = 0;
+
+    bool operator==(const t_vertex_buffer&) const = default;
+};
+
+
+// Vertex layout and the buffers it reads from
+struct t_vertex_array_desc
+{
+    std::vector<t_vertex_attribute> attributes;
+    std::vector<t_vertex_buffer> buffers;
+
+    // Element array buffer, 0 for none
+    unsigned int index_buffer = 0;
+
+    bool operator==(const t_vertex_array_desc&) const = default;
+};
+
+
+enum class t_texture_filter {
+    nearest,
+    linear
+};
+
+enum class t_texture_wrap {
+    repeat,
+    mirrored_repeat,
+    clamp_to_edge,
+    clamp_to_border
+};
+
+struct t_sampler_desc
+{
+    t_texture_filter min_filter = t_texture_filter::linear;
+    t_texture_filter mag_filter = t_texture_filter::linear;
+
+    // Filtering between mip levels, if `mip_mapping` is set
+    t_texture_filter mip_filter = t_texture_filter::linear;
+    bool mip_mapping = true;
+
+    t_texture_wrap wrap_s = t_texture_wrap::repeat;
+    t_texture_wrap wrap_t = t_texture_wrap::repeat;
+    t_texture_wrap wrap_r = t_texture_wrap::repeat;
+
+    // Clamped to the driver's maximum, ignored without anisotropic filtering
+    float max_anisotropy = 1.f;
+
+    float lod_bias = 0.f;
+
+    // Color outside of the texture with `clamp_to_border`
+    std::array<float, 4> border_color = {};
+
+    bool operator==(const t_sampler_desc&) const = default;
+};
+
+
+struct t_framebuffer_attachment
+{
+    // A texture or a renderbuffer
+    t_object_kind kind = t_object_kind::texture;
+
+    // 0 for no attachment
+    unsigned int name = 0;
+
+    // Mip level of a texture
+    int level = 0;
+
+    // Layer of an array texture, -1 to attach every layer
+    int layer = -1;
+
+    bool operator==(const t_framebuffer_attachment&) const = default;
+};
+
+
+// Attachments of a framebuffer
+// Color attachment `i` is drawn by fragment output `i`
+struct t_framebuffer_desc
+{
+    static constexpr std::size_t s_max_colors = 8;
+
+    std::array<t_framebuffer_attachment, s_max_colors> colors = {};
+    t_framebuffer_attachment depth;
+
+    // The same as `depth` for a packed depth and stencil image
+    t_framebuffer_attachment stencil;
+
+    bool operator==(const t_framebuffer_desc&) const = default;
+};
+
+
+// Use of a cache since its creation
+struct t_object_cache_stats
+{
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+
+    // Cached objects rebuilt because an object they use was deleted
+    std::uint64_t invalidations = 0;
+
+    // Objects currently cached, and those with references
+    std::size_t objects = 0;
+    std::size_t referenced = 0;
+
+    // Share of the requests served from the cache, 0 before the first one
+    double get_hit_rate() const;
+};
+
+
+struct t_object_caches_stats
+{
+    t_object_cache_stats vertex_arrays;
+    t_object_cache_stats samplers;
+    t_object_cache_stats framebuffers;
+};
+
+
+class object_caches
+{
+public:
+    // Raised when a framebuffer's attachments don't form a complete framebuffer
+    struct t_except_framebuffer_incomplete : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+public:
+    // Constructor
+    // `p_context` must be active on the calling thread
+    explicit object_caches(opengl_context& p_context);
+
+    // Destructor
+    // Deletes every cached object, referenced or not
+    ~object_caches();
+
+    // Prevent copy
+    object_caches(const object_caches&) = delete;
+    object_caches& operator=(const object_caches&) = delete;
+
+    // Get a vertex array for a layout and its buffers, created on first use
+    // Each call adds a reference, remove it with `release_vertex_array`
+    // Binding points changed to create it are restored
+    unsigned int acquire_vertex_array(const t_vertex_array_desc& p_desc);
+
+    // Remove a reference to a vertex array
+    void release_vertex_array(const unsigned int p_vertex_array);
+
+    // Get a sampler, created on first use
+    // Each call adds a reference, remove it with `release_sampler`
+    unsigned int acquire_sampler(const t_sampler_desc& p_desc);
+
+    // Remove a reference to a sampler
+    void release_sampler(const unsigned int p_sampler);
+
+    // Get a framebuffer for a set of attachments, created on first use
+    // Each call adds a reference, remove it with `release_framebuffer`
+    // Raises t_except_framebuffer_incomplete if the framebuffer isn't complete
+    unsigned int acquire_framebuffer(const t_framebuffer_desc& p_desc);
+
+    // Remove a reference to a framebuffer
+    void release_framebuffer(const unsigned int p_framebuffer);
+
+    // Tell the caches a buffer, texture or renderbuffer was deleted
+    // The cached objects using it are rebuilt on their next use
+    void notify_deleted(const t_object_kind p_kind, const unsigned int p_name);
+
+    // Delete the cached objects without references
+    // Returns the number of objects deleted
+    std::size_t trim();
+
+    // Get the use of each cache
+    t_object_caches_stats get_stats() const;
+
+private:
+    // A description flattened to words, hashed and compared as a whole
+    using t_key = std::vector<std::uint32_t>;
+
+    struct t_key_hash {
+        std::size_t operator()(const t_key& p_key) const;
+    };
+
+    // An object a cached object is built on
+    struct t_dependency {
+        t_object_kind kind;
+        unsigned int name;
+        std::uint32_t generation;
+    };
+
+    struct t_entry {
+        unsigned int name = 0;
+        std::size_t references = 0;
+        std::vector<t_dependency> dependencies;
+    };
+
+    // The cached objects of one type
+    struct t_cache {
+        // Deletes an object of this type, the context must be active
+        void (*destroy)(const unsigned int) = nullptr;
+
+        std::unordered_map<t_key, t_entry, t_key_hash> entries;
+
+        // Entries by object name, elements of `entries` don't move
+        std::unordered_map<unsigned int, t_entry*> names;
+
+        // Invalidated objects waiting for their last reference to go away
+        std::unordered_map<unsigned int, t_entry> retired;
+
+        t_object_cache_stats stats;
+    };
+
+    // Find or create the object of a key, adding a reference
+    // `p_dependencies` are the objects `p_create` builds it on
+    unsigned int acquire(
+        t_cache& p_cache,
+        t_key&& p_key,
+        const std::vector<std::pair<t_object_kind, unsigned int>>& p_dependencies,
+        const std::function<unsigned int()>& p_create);
+
+    // Remove a reference to an object
+    void release(t_cache& p_cache, const unsigned int p_name);
+
+    // Is every object an entry was built on still the same?
+    bool is_valid(const t_entry& p_entry) const;
+
+    // Current generation of an object
+    std::uint32_t get_generation(const t_object_kind p_kind, const unsigned int p_name) const;
+
+    // Create the objects
+    // The context must be active
+    unsigned int create_vertex_array(const t_vertex_array_desc& p_desc);
+    unsigned int create_sampler(const t_sampler_desc& p_desc);
+    unsigned int create_framebuffer(const t_framebuffer_desc& p_desc);
+
+private:
+    // Context owning the objects
+    opengl_context* m_context = nullptr;
+
+    // Largest anisotropy the driver supports, 1 without anisotropic filtering
+    float m_max_anisotropy = 1.f;
+
+    t_cache m_vertex_arrays;
+    t_cache m_samplers;
+    t_cache m_framebuffers;
+
+    // Generation of each deleted object, by kind and name
+    // Objects never deleted are at generation 0
+    std::unordered_map<std::uint64_t, std::uint32_t> m_generations;
+
+};  // class object_caches
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
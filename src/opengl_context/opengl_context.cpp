@@ -7,15 +7,33 @@
 #include "basegl/opengl_headers.h"
 #include "basegl/opengl_version.h"
 
+#include "async_program_compiler.h"
 #include "call_opengl_function.h"
+#include "gl_dispatch.h"
+#include "gpu_memory_tracker.h"
+#include "image_pipeline.h"
+#include "null_gl.h"
+#include "object_caches.h"
 #include "opengl_debug.h"
 #include "opengl_function.h"
+#include "program_cache.h"
+#include "shader_program.h"
 
 // other projects
 #include "error/ft_assert.h"
 
 // standard headers
+#include <atomic>
 #include <map>
+#include <utility>
+
+namespace {
+
+// Share group given to the next context that doesn't share its objects
+std::atomic<std::uint64_t> g_next_share_group{ 1 };
+
+}   // anonymous namespace
+
 
 // Initialize an opengl context for a given render context
 ft::rf::context::opengl_context::opengl_context(
@@ -24,28 +42,27 @@ ft::rf::context::opengl_context::opengl_context(
 {
     FT_ASSERT(m_opengl_ptr != nullptr);
     m_opengl_ptr->device_context = p_hdc.value;
+    m_opengl_ptr->share_group = g_next_share_group++;
 
-    // OpenGL version to use
-    auto[major, minor] = get_version();
+    // Create the context without sharing
+    create_render_context(p_reference, nullptr);
 
-    // Temporarily make the provided context the active one
-    //  and use it to initilize this new context
-    auto active = make_current{ p_reference };
+    // Initialize debugging
+    debug::init_debugging(*this);
+}
 
-    // The context attributes to use
-    const int context_attributs[] = {
-        WGL_CONTEXT_MAJOR_VERSION_ARB, major,
-        WGL_CONTEXT_MINOR_VERSION_ARB, minor,
-        WGL_CONTEXT_PROFILE_MASK_ARB, WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
-        0
-    };
+
+// Initialize an opengl context sharing its objects with `p_share`
+// The new context renders to the same device context as `p_share`
+ft::rf::context::opengl_context::opengl_context(
+    opengl_context & p_share, t_shared_ctor_tag)
+{
+    FT_ASSERT(m_opengl_ptr != nullptr);
+    m_opengl_ptr->device_context = p_share.get_handles().device_context;
+    m_opengl_ptr->share_group = p_share.get_handles().share_group;
 
     // Create the context
-    m_opengl_ptr->render_context = call_opengl_fail_value<err::context_init, nullptr>(
-        opengl_function<PFNWGLCREATECONTEXTATTRIBSARBPROC>("wglCreateContextAttribsARB"),
-        p_hdc.value,        // Device context
-        HGLRC{ 0 },         // No sharing enabled
-        context_attributs); // Attributs to use
+    create_render_context(p_share, &p_share);
 
     // Initialize debugging
     debug::init_debugging(*this);
@@ -59,7 +76,10 @@ ft::rf::context::opengl_context::opengl_context(
 {
     FT_ASSERT(m_opengl_ptr != nullptr);
     m_opengl_ptr->device_context = p_hdc.value;
-    m_opengl_ptr->render_context = wglCreateContext(p_hdc.value);
+    m_opengl_ptr->share_group = g_next_share_group++;
+    m_opengl_ptr->render_context = is_null_gl_dispatch() ?
+        null_gl::create_context() :
+        wglCreateContext(p_hdc.value);
 
     // Initialize debugging
     debug::init_debugging(*this);
@@ -77,21 +97,9 @@ int ft::rf::context::opengl_context::assign_pixel_format(const gl::t_pixel_forma
     // Temporarily make this context the active one
     auto active = make_current{ *this };
 
-    // Create a pixel format description array
-    const auto pixel_format = make_pixel_attributs(p_format);
-
     // Choose the appropriate pixel format
-    int pixel_format_id; UINT num_formats;
-    call_opengl_fail_value<err::context_bad_pixel_format, false>(
-        opengl_function<PFNWGLCHOOSEPIXELFORMATARBPROC>("wglChoosePixelFormatARB"),
-        m_opengl_ptr->device_context,   // Device context
-        pixel_format.data(),            // Integeral attributes
-        nullptr,                        // Floating point attributes
-        1,                              // Maximum number of formats to return
-        &pixel_format_id,               // Where to write the pixel format ID
-        &num_formats);                  // How many formats were generated (limited to the max provided)
-
-    if (num_formats <= 0)
+    const auto pixel_format_id = choose_pixel_format(make_pixel_attributs(p_format));
+    if (pixel_format_id == 0)
     {
         err::context_bad_pixel_format::raise("wglChoosePixelFormatARB failed");
     }
@@ -100,6 +108,25 @@ int ft::rf::context::opengl_context::assign_pixel_format(const gl::t_pixel_forma
 }
 
 
+// Same as `assign_pixel_format`, but prefers a format whose back buffer
+//  keeps its content when swapped
+// Returns the pixel format identifier and whether the preference was met
+std::pair<int, bool> ft::rf::context::opengl_context::assign_pixel_format_preserving(
+    const gl::t_pixel_format & p_format)
+{
+    auto active = make_current{ *this };
+
+    // Copy swaps are optional, many drivers only offer exchange swaps
+    const auto copy_format_id = choose_pixel_format(make_pixel_attributs(p_format, true));
+    if (copy_format_id != 0)
+    {
+        return { copy_format_id, true };
+    }
+
+    return { assign_pixel_format(p_format), false };
+}
+
+
 // OpenGL version used
 // Returns a pair { major, minor }
 std::pair<int, int> ft::rf::context::opengl_context::get_version() const
@@ -120,20 +147,118 @@ ft::rf::context::opengl_context::get_handles() const
 }
 
 
+// Identifies the contexts sharing their objects with this one
+std::uint64_t ft::rf::context::opengl_context::get_share_group() const
+{
+    FT_ASSERT(m_opengl_ptr != nullptr);
+    return m_opengl_ptr->share_group;
+}
+
+
 // Clear all render buffers and prepare the render a new frame
 void ft::rf::context::opengl_context::clear_frame(const gl::color<float> & p_color)
+{
+    begin_pass(t_pass_actions{}, p_color);
+}
+
+
+// Apply the load actions to the bound draw framebuffer
+void ft::rf::context::opengl_context::begin_pass(
+    const t_pass_actions & p_actions,
+    const gl::color<float> & p_color)
 {
     auto active = make_current{ *this };
 
-    call_opengl<err::context_failed_to_clear_frame>(
-        glClearColor,
-        p_color.red, 
-        p_color.green, 
-        p_color.blue, 
-        1.0f);
+    const auto [has_depth, has_stencil] = get_depth_stencil_presence();
+
+    // A disabled depth test never reads the depth buffer
+    const auto depth_used = has_depth && m_depth_buffering != t_depth_buffering::disabled;
+
+    auto mask = GLbitfield{ 0 };
+    if (p_actions.color_load == t_load_action::clear) {
+        mask |= GL_COLOR_BUFFER_BIT;
+    }
+    if (p_actions.depth_load == t_load_action::clear && depth_used) {
+        mask |= GL_DEPTH_BUFFER_BIT;
+    }
+    if (p_actions.stencil_load == t_load_action::clear && has_stencil) {
+        mask |= GL_STENCIL_BUFFER_BIT;
+    }
+
+    // Invalidating ignores the scissor rectangle, it would lose the
+    //  pixels outside of it
+    if (m_scissor_enabled == false)
+    {
+        invalidate(
+            p_actions.color_load == t_load_action::dont_care,
+            p_actions.depth_load == t_load_action::dont_care || (has_depth && depth_used == false),
+            p_actions.stencil_load == t_load_action::dont_care);
+    }
+
+    if (mask == 0)
+    {
+        return;
+    }
+
+    if ((mask & GL_COLOR_BUFFER_BIT) != 0)
+    {
+        call_opengl<err::context_failed_to_clear_frame>(
+            glClearColor,
+            p_color.red, 
+            p_color.green, 
+            p_color.blue, 
+            1.0f);
+    }
     call_opengl<err::context_failed_to_clear_frame>(
         glClear,
-        GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        mask);
+}
+
+
+// Apply the store actions to the bound draw framebuffer
+void ft::rf::context::opengl_context::end_pass(const t_pass_actions & p_actions)
+{
+    auto active = make_current{ *this };
+
+    invalidate(
+        p_actions.color_store == t_store_action::discard,
+        p_actions.depth_store == t_store_action::discard,
+        p_actions.stencil_store == t_store_action::discard);
+}
+
+
+// Set the depth and stencil bits of the window's framebuffer
+void ft::rf::context::opengl_context::set_default_framebuffer_format(
+    const int p_depth_bits,
+    const int p_stencil_bits)
+{
+    m_default_depth_bits = p_depth_bits;
+    m_default_stencil_bits = p_stencil_bits;
+}
+
+
+// Restrict clears and draws to a rectangle
+void ft::rf::context::opengl_context::set_scissor(
+    const int p_x,
+    const int p_y,
+    const int p_width,
+    const int p_height)
+{
+    auto active = make_current{ *this };
+
+    call_opengl<err::context_edit_error>(glEnable, GL_SCISSOR_TEST);
+    call_opengl<err::context_edit_error>(glScissor, p_x, p_y, p_width, p_height);
+    m_scissor_enabled = true;
+}
+
+
+// Stop restricting clears and draws
+void ft::rf::context::opengl_context::disable_scissor()
+{
+    auto active = make_current{ *this };
+
+    call_opengl<err::context_edit_error>(glDisable, GL_SCISSOR_TEST);
+    m_scissor_enabled = false;
 }
 
 namespace {
@@ -313,9 +438,278 @@ ft::rf::context::opengl_context::get_blending_mode() const
 }
 
 
+// Store linked program binaries in `p_directory` and reuse them
+//  in `create_program` instead of compiling the sources again
+void ft::rf::context::opengl_context::set_program_cache_directory(
+    const std::filesystem::path & p_directory)
+{
+    m_program_cache = std::make_shared<program_cache>(p_directory);
+}
+
+
+// Compile and link a program
+// Uses the program cache if one is set
+// Raises err::context_edit_error if the program fails to build
+// Returns the program's name
+unsigned int ft::rf::context::opengl_context::create_program(const t_program_source & p_source)
+{
+    auto active = make_current{ *this };
+
+    const auto program = (m_program_cache != nullptr) ?
+        m_program_cache->load_or_build(p_source) :
+        build_program(p_source, false);
+    track_program(*this, program);
+
+    return program;
+}
+
+
+// Delete a program created by `create_program` or `create_program_async`
+void ft::rf::context::opengl_context::delete_program(const unsigned int p_program)
+{
+    auto active = make_current{ *this };
+    call_opengl<err::context_edit_error>(glDeleteProgram, p_program);
+    get_gpu_memory_tracker().untrack(*this, t_gpu_memory_category::program, p_program);
+}
+
+
+// Start building a program without blocking
+// The result becomes ready during a later call to `poll_programs`
+//  and is stored in the program cache if one is set
+ft::rf::context::t_async_program
+ft::rf::context::opengl_context::create_program_async(const t_program_source & p_source)
+{
+    auto active = make_current{ *this };
+
+    // Cached binaries load quickly enough to be used right away
+    if (m_program_cache != nullptr)
+    {
+        const auto program = m_program_cache->try_load(p_source);
+        if (program != 0)
+        {
+            track_program(*this, program);
+            auto ready = std::promise<unsigned int>{};
+            ready.set_value(program);
+            return { ready.get_future().share() };
+        }
+    }
+
+    if (m_async_compiler == nullptr)
+    {
+        m_async_compiler = std::make_shared<async_program_compiler>(*this);
+    }
+    return m_async_compiler->compile(p_source, m_program_cache.get());
+}
+
+
+// Complete the asynchronous program builds that finished
+void ft::rf::context::opengl_context::poll_programs()
+{
+    if (m_async_compiler == nullptr || m_async_compiler->get_pending_count() == 0)
+    {
+        return;
+    }
+
+    auto active = make_current{ *this };
+    m_async_compiler->poll();
+}
+
+
+// Start loading the image file at `p_path` into a texture without blocking
+// Decoding and mipmap generation run on the job system, the upload on
+//  a worker thread with a shared context, see image_pipeline
+ft::rf::context::t_async_texture
+ft::rf::context::opengl_context::load_texture(const std::filesystem::path & p_path)
+{
+    return get_image_pipeline().load(p_path);
+}
+
+
+// Add a decoder used by `load_texture`, tried before the built-in ones
+void ft::rf::context::opengl_context::add_image_decoder(std::shared_ptr<const image_decoder> p_decoder)
+{
+    get_image_pipeline().add_decoder(std::move(p_decoder));
+}
+
+
+// Get the work done by each stage of `load_texture`
+ft::rf::context::t_image_pipeline_metrics
+ft::rf::context::opengl_context::get_texture_load_metrics() const
+{
+    if (m_image_pipeline == nullptr)
+    {
+        return {};
+    }
+    return m_image_pipeline->get_metrics();
+}
+
+
+// Delete a texture created by `load_texture`
+void ft::rf::context::opengl_context::delete_texture(const unsigned int p_texture)
+{
+    auto active = make_current{ *this };
+    call_opengl<err::context_edit_error>(glDeleteTextures, 1, &p_texture);
+    get_gpu_memory_tracker().untrack(*this, t_gpu_memory_category::texture, p_texture);
+    notify_object_deleted(t_object_kind::texture, p_texture);
+}
+
+
+// Get a vertex array for a layout and its buffers, cached by description
+// Each call adds a reference, remove it with `release_vertex_array`
+unsigned int ft::rf::context::opengl_context::acquire_vertex_array(const t_vertex_array_desc & p_desc)
+{
+    auto active = make_current{ *this };
+    return get_object_caches().acquire_vertex_array(p_desc);
+}
+
+
+// Remove a reference to a vertex array
+void ft::rf::context::opengl_context::release_vertex_array(const unsigned int p_vertex_array)
+{
+    auto active = make_current{ *this };
+    get_object_caches().release_vertex_array(p_vertex_array);
+}
+
+
+// Get a sampler, cached by description
+// Each call adds a reference, remove it with `release_sampler`
+unsigned int ft::rf::context::opengl_context::acquire_sampler(const t_sampler_desc & p_desc)
+{
+    auto active = make_current{ *this };
+    return get_object_caches().acquire_sampler(p_desc);
+}
+
+
+// Remove a reference to a sampler
+void ft::rf::context::opengl_context::release_sampler(const unsigned int p_sampler)
+{
+    auto active = make_current{ *this };
+    get_object_caches().release_sampler(p_sampler);
+}
+
+
+// Get a framebuffer for a set of attachments, cached by description
+// Each call adds a reference, remove it with `release_framebuffer`
+// Raises object_caches::t_except_framebuffer_incomplete if the
+//  framebuffer isn't complete
+unsigned int ft::rf::context::opengl_context::acquire_framebuffer(const t_framebuffer_desc & p_desc)
+{
+    auto active = make_current{ *this };
+    return get_object_caches().acquire_framebuffer(p_desc);
+}
+
+
+// Remove a reference to a framebuffer
+void ft::rf::context::opengl_context::release_framebuffer(const unsigned int p_framebuffer)
+{
+    auto active = make_current{ *this };
+    get_object_caches().release_framebuffer(p_framebuffer);
+}
+
+
+// Tell the object caches a buffer, texture or renderbuffer was deleted
+// Cached objects using it are rebuilt on their next use
+void ft::rf::context::opengl_context::notify_object_deleted(const t_object_kind p_kind, const unsigned int p_name)
+{
+    // Nothing can depend on the object before the caches exist
+    if (m_object_caches == nullptr)
+    {
+        return;
+    }
+    auto active = make_current{ *this };
+    m_object_caches->notify_deleted(p_kind, p_name);
+}
+
+
+// Delete the cached vertex arrays, samplers and framebuffers without references
+// Returns the number of objects deleted
+std::size_t ft::rf::context::opengl_context::trim_object_caches()
+{
+    if (m_object_caches == nullptr)
+    {
+        return 0;
+    }
+    auto active = make_current{ *this };
+    return m_object_caches->trim();
+}
+
+
+// Get the use of the vertex array, sampler and framebuffer caches
+ft::rf::context::t_object_caches_stats
+ft::rf::context::opengl_context::get_object_cache_stats() const
+{
+    if (m_object_caches == nullptr)
+    {
+        return {};
+    }
+    return m_object_caches->get_stats();
+}
+
+
+// Get the image pipeline, creating it on first use
+ft::rf::context::image_pipeline & ft::rf::context::opengl_context::get_image_pipeline()
+{
+    if (m_image_pipeline == nullptr)
+    {
+        auto active = make_current{ *this };
+        m_image_pipeline = std::make_shared<image_pipeline>(*this);
+    }
+    return *m_image_pipeline;
+}
+
+
+// Get the object caches, creating them on first use
+ft::rf::context::object_caches & ft::rf::context::opengl_context::get_object_caches()
+{
+    if (m_object_caches == nullptr)
+    {
+        auto active = make_current{ *this };
+        m_object_caches = std::make_shared<object_caches>(*this);
+    }
+    return *m_object_caches;
+}
+
+
+// Create the render context
+// `p_reference` is used to load the context creation function
+// If `p_share` is provided, the new context shares its objects
+void ft::rf::context::opengl_context::create_render_context(
+    opengl_context & p_reference,
+    const opengl_context * p_share)
+{
+    // OpenGL version to use
+    auto[major, minor] = get_version();
+
+    // Temporarily make the provided context the active one
+    //  and use it to initilize this new context
+    auto active = make_current{ p_reference };
+
+    // The context attributes to use
+    const int context_attributs[] = {
+        WGL_CONTEXT_MAJOR_VERSION_ARB, major,
+        WGL_CONTEXT_MINOR_VERSION_ARB, minor,
+        WGL_CONTEXT_PROFILE_MASK_ARB, WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
+        0
+    };
+
+    // Context to share objects with, if any
+    const auto share = p_share != nullptr ?
+        p_share->get_handles().render_context :
+        HGLRC{ 0 };
+
+    // Create the context
+    m_opengl_ptr->render_context = call_opengl_fail_value<err::context_init, nullptr>(
+        opengl_function<PFNWGLCREATECONTEXTATTRIBSARBPROC>("wglCreateContextAttribsARB"),
+        m_opengl_ptr->device_context,   // Device context
+        share,                          // Context to share objects with
+        context_attributs);             // Attributs to use
+}
+
+
 // Construct pixel attributes from a pixel format struct
 std::vector<int> ft::rf::context::opengl_context::make_pixel_attributs(
-    const gl::t_pixel_format & p_format)
+    const gl::t_pixel_format & p_format,
+    const bool p_copy_on_swap)
 {
     std::vector<int> attributs;
 
@@ -337,12 +731,93 @@ std::vector<int> ft::rf::context::opengl_context::make_pixel_attributs(
     add_attribute(WGL_SAMPLE_BUFFERS_ARB,   p_format.multisample > 0);  // Enable anti aliasing
     add_attribute(WGL_SAMPLES_ARB,          p_format.multisample);      // Anti aliasing sample count
 
+    if (p_copy_on_swap)
+    {
+        add_attribute(WGL_SWAP_METHOD_ARB,  WGL_SWAP_COPY_ARB);         // Back buffer kept on swap
+    }
+
     // Always end the attributes array with a null
     attributs.emplace_back(0);
     return attributs;
 }
 
 
+// Invalidate attachments of the bound draw framebuffer if supported
+// The context must be active
+void ft::rf::context::opengl_context::invalidate(
+    const bool p_color,
+    const bool p_depth,
+    const bool p_stencil)
+{
+    if (GLEW_ARB_invalidate_subdata == 0 || (p_color || p_depth || p_stencil) == false)
+    {
+        return;
+    }
+
+    auto framebuffer = GLint{ 0 };
+    call_opengl<err::context_edit_error>(glGetIntegerv, GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+
+    // The window's framebuffer names its attachments differently
+    const auto is_default = (framebuffer == 0);
+    GLenum attachments[3];
+    GLsizei count = 0;
+    if (p_color) {
+        attachments[count++] = is_default ? GL_COLOR : GL_COLOR_ATTACHMENT0;
+    }
+    if (p_depth) {
+        attachments[count++] = is_default ? GL_DEPTH : GL_DEPTH_ATTACHMENT;
+    }
+    if (p_stencil) {
+        attachments[count++] = is_default ? GL_STENCIL : GL_STENCIL_ATTACHMENT;
+    }
+
+    call_opengl<err::context_edit_error>(glInvalidateFramebuffer, GL_DRAW_FRAMEBUFFER, count, attachments);
+}
+
+
+// Does the bound draw framebuffer have depth and stencil attachments?
+// The context must be active
+std::pair<bool, bool> ft::rf::context::opengl_context::get_depth_stencil_presence() const
+{
+    auto framebuffer = GLint{ 0 };
+    call_opengl<err::context_edit_error>(glGetIntegerv, GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    if (framebuffer == 0)
+    {
+        return { m_default_depth_bits > 0, m_default_stencil_bits > 0 };
+    }
+
+    auto has_attachment = [](const GLenum p_attachment) {
+        auto type = GLint{ GL_NONE };
+        call_opengl<err::context_edit_error>(
+            glGetFramebufferAttachmentParameteriv,
+            GL_DRAW_FRAMEBUFFER,
+            p_attachment,
+            GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE,
+            &type);
+        return type != GL_NONE;
+    };
+    return { has_attachment(GL_DEPTH_ATTACHMENT), has_attachment(GL_STENCIL_ATTACHMENT) };
+}
+
+
+// Choose a pixel format matching `p_attributs`
+// Returns 0 if there is none
+int ft::rf::context::opengl_context::choose_pixel_format(const std::vector<int> & p_attributs)
+{
+    int pixel_format_id = 0; UINT num_formats = 0;
+    call_opengl_fail_value<err::context_bad_pixel_format, false>(
+        opengl_function<PFNWGLCHOOSEPIXELFORMATARBPROC>("wglChoosePixelFormatARB"),
+        m_opengl_ptr->device_context,   // Device context
+        p_attributs.data(),             // Integeral attributes
+        nullptr,                        // Floating point attributes
+        1,                              // Maximum number of formats to return
+        &pixel_format_id,               // Where to write the pixel format ID
+        &num_formats);                  // How many formats were generated (limited to the max provided)
+
+    return (num_formats > 0) ? pixel_format_id : 0;
+}
+
+
 // Activate this context by making it the currently active
 //  context for the calling thread
 // Use an instance of make_current constructed with this instance
@@ -360,19 +835,28 @@ void ft::rf::context::opengl_context::activate() const
         err::context_activate_error::raise("context already in use by another thread");
     }
 
-    // Try to make the context active
-    // Can't use call_opengl because no context is active yet
-    const auto success = wglMakeCurrent(
-        m_opengl_ptr->device_context,
-        m_opengl_ptr->render_context);
-
-    if(success == false || glGetError() != GL_NO_ERROR)
+    if (is_null_gl_dispatch())
     {
-        err::context_activate_error::raise("wglMakeCurrent failed");
+        // There is no driver context, load the null functions instead
+        null_gl::install();
     }
-    
-    // You are supposed to call glewInit() after every context change
-    call_opengl_pass_value<err::context_activate_error, GLEW_OK>(glewInit);
+    else
+    {
+        // Try to make the context active
+        // Can't use call_opengl because no context is active yet
+        const auto success = wglMakeCurrent(
+            m_opengl_ptr->device_context,
+            m_opengl_ptr->render_context);
+
+        if(success == false || glGetError() != GL_NO_ERROR)
+        {
+            err::context_activate_error::raise("wglMakeCurrent failed");
+        }
+
+        // You are supposed to call glewInit() after every context change
+        call_opengl_pass_value<err::context_activate_error, GLEW_OK>(glewInit);
+    }
+    count_gl_context_switch();
 
     // Remember which thread is using this context
     (*active_thread_lock) = thread_id;
@@ -382,7 +866,10 @@ void ft::rf::context::opengl_context::activate() const
 // Make no context currently active
 void ft::rf::context::opengl_context::deactivate() const
 {
-    ::wglMakeCurrent(nullptr, nullptr);
-    glGetError();   // Ignore the error...
+    if (is_null_gl_dispatch() == false)
+    {
+        ::wglMakeCurrent(nullptr, nullptr);
+        glGetError();   // Ignore the error...
+    }
     m_active_thread.make_lock()->reset();
 }
@@ -6,11 +6,14 @@
 #include "basegl/color.h"
 #include "basegl/pixel_format.h"
 #include "make_current.h"
+#include "pass_actions.h"
 
 //  other headers
 #include "thread/lockable.h"
 
 // standard headers
+#include <cstdint>
+#include <filesystem>
 #include <memory>
 #include <optional>
 #include <stdexcept>
@@ -31,6 +34,20 @@ namespace context {
 
 // Forward declaration
 struct opengl_context_members;
+struct t_program_source;
+struct t_async_program;
+struct t_async_texture;
+struct t_image_pipeline_metrics;
+struct t_object_caches_stats;
+struct t_framebuffer_desc;
+struct t_sampler_desc;
+struct t_vertex_array_desc;
+enum class t_object_kind;
+class async_program_compiler;
+class image_decoder;
+class image_pipeline;
+class object_caches;
+class program_cache;
 
 class opengl_context
 {
@@ -69,13 +86,21 @@ public:
     struct t_legacy_ctor_tag {};
     opengl_context(const gl::basegl::hdc_wrap& p_hdc, t_legacy_ctor_tag);
 
+    // Initialize an opengl context sharing its objects with `p_share`
+    // The new context renders to the same device context as `p_share`
+    // Used to create worker contexts
+    struct t_shared_ctor_tag {};
+    opengl_context(opengl_context& p_share, t_shared_ctor_tag);
+
     // Prevent copy
     opengl_context(const opengl_context&) = delete;
     opengl_context& operator=(const opengl_context&) = delete;
 
-    // Move allowed
-    opengl_context(opengl_context&&) = default;
-    opengl_context& operator=(opengl_context&&) = default;
+    // Prevent move
+    // The program compiler, image pipeline and object caches point back
+    //  at their context, hold contexts by pointer instead
+    opengl_context(opengl_context&&) = delete;
+    opengl_context& operator=(opengl_context&&) = delete;
 
     // Initializes a render frame's pixel format
     // Must only be called once which is done by the render frame's constructor
@@ -84,6 +109,11 @@ public:
     // Returns the pixel format identifier
     int assign_pixel_format(const gl::t_pixel_format& p_format);
 
+    // Same as `assign_pixel_format`, but prefers a format whose back buffer
+    //  keeps its content when swapped, so a frame may only redraw what changed
+    // Returns the pixel format identifier and whether the preference was met
+    std::pair<int, bool> assign_pixel_format_preserving(const gl::t_pixel_format& p_format);
+
     // OpenGL version used
     // Returns a pair { major, minor }
     std::pair<int, int> get_version() const;
@@ -91,9 +121,36 @@ public:
     // Get the opengl handles for this context
     const opengl_context_members& get_handles() const;
 
+    // Identifies the contexts sharing their objects with this one
+    // Contexts created with t_shared_ctor_tag return their share's value
+    std::uint64_t get_share_group() const;
+
     // Clear all render buffers and prepare the render a new frame
+    // Only clears the scissor rectangle if one is set
+    // Same as `begin_pass` with the default actions
     void clear_frame(const gl::color<float>& p_color);
 
+    // Apply the load actions to the bound draw framebuffer
+    // Depth and stencil are only cleared if the framebuffer has them, and
+    //  depth only if depth testing is enabled, set the depth testing mode first
+    // Don't care actions invalidate the attachments when the driver supports
+    //  it and no scissor rectangle is set, otherwise they leave the contents
+    void begin_pass(const t_pass_actions& p_actions, const gl::color<float>& p_color);
+
+    // Apply the store actions to the bound draw framebuffer
+    void end_pass(const t_pass_actions& p_actions);
+
+    // Set the depth and stencil bits of the window's framebuffer
+    // Attachments of offscreen framebuffers are queried instead
+    void set_default_framebuffer_format(const int p_depth_bits, const int p_stencil_bits);
+
+    // Restrict clears and draws to a rectangle
+    // In pixels from the bottom-left corner of the framebuffer
+    void set_scissor(const int p_x, const int p_y, const int p_width, const int p_height);
+
+    // Stop restricting clears and draws, Default mode
+    void disable_scissor();
+
 
     // Set the polygon render mode
     void set_polygon_mode(const t_polygon_mode p_mode);
@@ -121,9 +178,103 @@ public:
     // Get the alpha blending mode
     t_blend_mode get_blending_mode() const;
 
+
+    // Store linked program binaries in `p_directory` and reuse them
+    //  in `create_program` instead of compiling the sources again
+    void set_program_cache_directory(const std::filesystem::path& p_directory);
+
+    // Compile and link a program
+    // Uses the program cache if one is set
+    // Raises err::context_edit_error if the program fails to build
+    // Returns the program's name
+    unsigned int create_program(const t_program_source& p_source);
+
+    // Delete a program created by `create_program` or `create_program_async`
+    void delete_program(const unsigned int p_program);
+
+    // Start building a program without blocking
+    // The result becomes ready during a later call to `poll_programs`
+    //  and is stored in the program cache if one is set
+    t_async_program create_program_async(const t_program_source& p_source);
+
+    // Complete the asynchronous program builds that finished
+    void poll_programs();
+
+
+    // Start loading the image file at `p_path` into a texture without blocking
+    // Decoding and mipmap generation run on the job system, the upload on
+    //  a worker thread with a shared context, see image_pipeline
+    t_async_texture load_texture(const std::filesystem::path& p_path);
+
+    // Add a decoder used by `load_texture`, tried before the built-in ones
+    void add_image_decoder(std::shared_ptr<const image_decoder> p_decoder);
+
+    // Get the work done by each stage of `load_texture`
+    t_image_pipeline_metrics get_texture_load_metrics() const;
+
+    // Delete a texture created by `load_texture`
+    void delete_texture(const unsigned int p_texture);
+
+
+    // Get a vertex array for a layout and its buffers, cached by description
+    // Each call adds a reference, remove it with `release_vertex_array`
+    unsigned int acquire_vertex_array(const t_vertex_array_desc& p_desc);
+
+    // Remove a reference to a vertex array
+    void release_vertex_array(const unsigned int p_vertex_array);
+
+    // Get a sampler, cached by description
+    // Each call adds a reference, remove it with `release_sampler`
+    unsigned int acquire_sampler(const t_sampler_desc& p_desc);
+
+    // Remove a reference to a sampler
+    void release_sampler(const unsigned int p_sampler);
+
+    // Get a framebuffer for a set of attachments, cached by description
+    // Each call adds a reference, remove it with `release_framebuffer`
+    // Raises object_caches::t_except_framebuffer_incomplete if the
+    //  framebuffer isn't complete
+    unsigned int acquire_framebuffer(const t_framebuffer_desc& p_desc);
+
+    // Remove a reference to a framebuffer
+    void release_framebuffer(const unsigned int p_framebuffer);
+
+    // Tell the object caches a buffer, texture or renderbuffer was deleted
+    // Cached objects using it are rebuilt on their next use
+    void notify_object_deleted(const t_object_kind p_kind, const unsigned int p_name);
+
+    // Delete the cached vertex arrays, samplers and framebuffers without references
+    // Returns the number of objects deleted
+    std::size_t trim_object_caches();
+
+    // Get the use of the vertex array, sampler and framebuffer caches
+    t_object_caches_stats get_object_cache_stats() const;
+
 private:
+    // Create the render context
+    // `p_reference` is used to load the context creation function
+    // If `p_share` is provided, the new context shares its objects
+    void create_render_context(opengl_context& p_reference, const opengl_context* p_share);
+
     // Construct pixel attributes from a pixel format struct
-    std::vector<int> make_pixel_attributs(const gl::t_pixel_format& p_format);
+    // If `p_copy_on_swap` is set, requires a back buffer that is copied on swap
+    std::vector<int> make_pixel_attributs(const gl::t_pixel_format& p_format, const bool p_copy_on_swap = false);
+
+    // Invalidate attachments of the bound draw framebuffer if supported
+    void invalidate(const bool p_color, const bool p_depth, const bool p_stencil);
+
+    // Does the bound draw framebuffer have depth and stencil attachments?
+    std::pair<bool, bool> get_depth_stencil_presence() const;
+
+    // Choose a pixel format matching `p_attributs`
+    // Returns 0 if there is none
+    int choose_pixel_format(const std::vector<int>& p_attributs);
+
+    // Get the image pipeline, creating it on first use
+    image_pipeline& get_image_pipeline();
+
+    // Get the object caches, creating them on first use
+    object_caches& get_object_caches();
 
     // Activate this context by making it the currently active
     //  context for the calling thread
@@ -153,6 +304,25 @@ private:
     // Current alpha blending mode
     t_blend_mode m_blending_mode = t_blend_mode::disabled;
 
+    // Is a scissor rectangle set?
+    bool m_scissor_enabled = false;
+
+    // Depth and stencil bits of the window's framebuffer
+    int m_default_depth_bits = 24;
+    int m_default_stencil_bits = 8;
+
+    // Cache of program binaries, if enabled
+    std::shared_ptr<program_cache> m_program_cache;
+
+    // Builds programs asynchronously, created on first use
+    std::shared_ptr<async_program_compiler> m_async_compiler;
+
+    // Loads textures asynchronously, created on first use
+    std::shared_ptr<image_pipeline> m_image_pipeline;
+
+    // Vertex arrays, samplers and framebuffers by description, created on first use
+    std::shared_ptr<object_caches> m_object_caches;
+
     // If this context is currently the active context for a thread
     //  then the thread ID of that thread is stored here
     mutable base::thread::lockable<std::optional<std::thread::id>> m_active_thread;
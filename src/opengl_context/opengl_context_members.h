@@ -2,6 +2,10 @@
 
 // Stores members that require OpenGL headers
 #include "basegl/opengl_headers.h"
+#include "gl_dispatch.h"
+
+// standard headers
+#include <cstdint>
 
 namespace ft {
 namespace rf {
@@ -9,8 +13,23 @@ namespace context {
 
 struct opengl_context_members
 {
-    HDC device_context;
-    HGLRC render_context;
+    // Destructor
+    // Releases the render context
+    ~opengl_context_members()
+    {
+        // The null dispatch's handles are fake
+        if (render_context != nullptr && is_null_gl_dispatch() == false)
+        {
+            ::wglDeleteContext(render_context);
+        }
+    }
+
+    HDC device_context = nullptr;
+    HGLRC render_context = nullptr;
+
+    // Identifies the contexts sharing their objects with this one
+    // Object names are only unique within a share group
+    std::uint64_t share_group = 0;
 
 };  // struct opengl_context_members
 
@@ -1,6 +1,8 @@
 // project headers
 #include "call_opengl_function.h"
+#include "gl_dispatch.h"
 #include "make_current.h"
+#include "null_gl.h"
 #include "opengl_context.h"
 #include "opengl_context_members.h"
 #include "opengl_debug.h"
@@ -52,7 +54,7 @@ void ft::rf::debug::assert_no_pending_errors()
     // Only used in debug builds
     if constexpr (g_is_debug)
     {
-        const auto error = glGetError();
+        const auto error = get_error();
         if (error != GL_NO_ERROR)
         {
             FT_BREAKPOINT;
@@ -62,6 +64,15 @@ void ft::rf::debug::assert_no_pending_errors()
 }
 
 
+// Get and clear the stored error code, like glGetError
+GLenum ft::rf::debug::get_error()
+{
+    return context::is_null_gl_dispatch() ?
+        context::null_gl::get_error() :
+        glGetError();
+}
+
+
 // Initializes error debuging
 // Sets up error callbacks
 void ft::rf::debug::init_debugging(context::opengl_context & p_context)
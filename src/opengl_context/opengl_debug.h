@@ -17,6 +17,10 @@ namespace debug {
 //  if glGetError is not GL_NO_ERROR
 void assert_no_pending_errors();
 
+// Get and clear the stored error code, like glGetError
+// Answered by the null dispatch when it is selected
+GLenum get_error();
+
 // Initializes error debuging
 // Sets up error callbacks
 void init_debugging(context::opengl_context& p_context);
@@ -4,6 +4,8 @@
 
 // project headers
 #include "call_opengl_function.h"
+#include "gl_dispatch.h"
+#include "null_gl.h"
 #include "basegl/opengl_except.h"
 
 // other headers
@@ -19,8 +21,21 @@ struct opengl_function
     // Implicit construction allowed
     opengl_function(const char* const p_name)
     {
-        // Load the function pointer
         using t_exception = err::context_opengl_function_not_found;
+
+        // The null dispatch has its own implementation
+        if (is_null_gl_dispatch())
+        {
+            auto pointer = null_gl::get_proc_address(p_name);
+            if (pointer == nullptr)
+            {
+                t_exception::raise("no null implementation of the opengl function");
+            }
+            function = reinterpret_cast<T>(pointer);
+            return;
+        }
+
+        // Load the function pointer
         auto pointer = call_opengl_fail_value<t_exception, nullptr>(
             wglGetProcAddress,
             p_name);
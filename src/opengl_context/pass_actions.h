@@ -0,0 +1,41 @@
+#pragma once
+
+// What happens to a framebuffer's contents at the start and at the end
+//  of a render pass
+// Tile based and software rasterizers skip loading or writing back the
+//  attachments whose contents aren't needed
+
+namespace ft {
+namespace rf {
+namespace context {
+
+// At the start of a pass
+enum class t_load_action {
+    clear,      // Fill with the clear value
+    load,       // Keep the previous contents
+    dont_care   // Contents are undefined, every pixel will be drawn over
+};
+
+// At the end of a pass
+enum class t_store_action {
+    store,      // Keep the contents
+    discard     // Contents are no longer needed
+};
+
+struct t_pass_actions
+{
+    // Depth and stencil share an attachment, they start and end alike
+    t_load_action color_load = t_load_action::clear;
+    t_load_action depth_load = t_load_action::clear;
+    t_load_action stencil_load = t_load_action::clear;
+
+    // Color is kept to be displayed, depth and stencil rarely outlive a frame
+    t_store_action color_store = t_store_action::store;
+    t_store_action depth_store = t_store_action::discard;
+    t_store_action stencil_store = t_store_action::discard;
+
+};  // struct t_pass_actions
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
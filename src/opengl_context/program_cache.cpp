@@ -0,0 +1,287 @@
+#include "program_cache.h"
+
+// project headers
+#include "call_opengl_function.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// standard headers
+#include <cstdio>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace {
+
+// Identifies a cache file and its layout
+constexpr std::uint32_t g_file_magic = 0x42505446;  // "FTPB"
+constexpr std::uint32_t g_file_version = 1;
+
+// Header written before each binary
+struct t_file_header
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t key;
+    std::uint32_t format;
+    std::uint32_t size;
+};
+
+// FNV-1a hash of a string, including its null terminator so
+//  consecutive strings can't alias each other
+void hash_string(std::uint64_t & p_hash, const std::string & p_string)
+{
+    for (const auto c : p_string)
+    {
+        p_hash ^= static_cast<unsigned char>(c);
+        p_hash *= 1099511628211ull;
+    }
+    p_hash *= 1099511628211ull;   // Null terminator
+}
+
+// Read an OpenGL string
+std::string get_gl_string(const GLenum p_name)
+{
+    const auto value = ft::rf::call_opengl<ft::rf::err::context_edit_error>(glGetString, p_name);
+    return value != nullptr ? reinterpret_cast<const char*>(value) : "";
+}
+
+}   // anonymous namespace
+
+
+// Constructor
+// Binaries are stored in `p_directory`, which is created if needed
+ft::rf::context::program_cache::program_cache(std::filesystem::path p_directory) :
+    m_directory(std::move(p_directory))
+{
+    auto error = std::error_code{};
+    std::filesystem::create_directories(m_directory, error);
+}
+
+
+// Load a program from the cache or build it and store its binary
+// The calling thread must have an active context
+// Returns the program's name
+unsigned int ft::rf::context::program_cache::load_or_build(const t_program_source & p_source)
+{
+    const auto cached = try_load(p_source);
+    if (cached != 0)
+    {
+        return cached;
+    }
+
+    const auto program = build_program(p_source, true);
+    store(p_source, program);
+    return program;
+}
+
+
+// Create a program from its cached binary
+// The calling thread must have an active context
+// Returns 0 if there is no usable binary
+unsigned int ft::rf::context::program_cache::try_load(const t_program_source & p_source)
+{
+    const auto program = read_binary(make_key(p_source));
+    if (program != 0) {
+        ++m_hit_count;
+    }
+    else {
+        ++m_miss_count;
+    }
+    return program;
+}
+
+
+// Store the binary of a program built with a retrievable binary
+// The calling thread must have an active context
+void ft::rf::context::program_cache::store(
+    const t_program_source & p_source,
+    const unsigned int p_program)
+{
+    write_binary(make_key(p_source), p_program);
+}
+
+
+// Directory holding the binaries
+const std::filesystem::path &
+ft::rf::context::program_cache::get_directory() const
+{
+    return m_directory;
+}
+
+
+// Number of programs loaded from disk
+std::size_t ft::rf::context::program_cache::get_hit_count() const
+{
+    return m_hit_count;
+}
+
+
+// Number of programs built from source
+std::size_t ft::rf::context::program_cache::get_miss_count() const
+{
+    return m_miss_count;
+}
+
+
+// Hash identifying a program for the current driver
+std::uint64_t ft::rf::context::program_cache::make_key(const t_program_source & p_source)
+{
+    if (m_driver_id.empty())
+    {
+        m_driver_id =
+            get_gl_string(GL_VENDOR) + "\n" +
+            get_gl_string(GL_RENDERER) + "\n" +
+            get_gl_string(GL_VERSION);
+    }
+
+    std::uint64_t hash = 14695981039346656037ull;
+    hash_string(hash, m_driver_id);
+    hash_string(hash, p_source.vertex);
+    hash_string(hash, p_source.geometry);
+    hash_string(hash, p_source.fragment);
+    for (const auto & [name, value] : p_source.defines)
+    {
+        hash_string(hash, name);
+        hash_string(hash, value);
+    }
+    return hash;
+}
+
+
+// Path of the binary for a given key
+std::filesystem::path
+ft::rf::context::program_cache::make_path(const std::uint64_t p_key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(p_key));
+    return m_directory / name;
+}
+
+
+// Try to create a program from a stored binary
+// Returns 0 if there is no usable binary
+unsigned int ft::rf::context::program_cache::read_binary(const std::uint64_t p_key)
+{
+    const auto path = make_path(p_key);
+
+    std::vector<char> binary;
+    t_file_header header = {};
+    {
+        auto file = std::ifstream(path, std::ios::binary);
+        if (!file) {
+            return 0;
+        }
+
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        const auto valid_header = file &&
+            header.magic == g_file_magic &&
+            header.version == g_file_version &&
+            header.key == p_key &&
+            header.size > 0;
+
+        if (valid_header)
+        {
+            binary.resize(header.size);
+            file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+        }
+        if (valid_header == false || !file)
+        {
+            binary.clear();
+        }
+    }
+
+    auto discard = [&path]() {
+        auto error = std::error_code{};
+        std::filesystem::remove(path, error);
+    };
+
+    if (binary.empty())
+    {
+        discard();
+        return 0;
+    }
+
+    const auto program = call_opengl_fail_value<err::context_edit_error, GLuint{ 0 }>(glCreateProgram);
+
+    // The driver may reject the binary with an error, for example
+    //  if the format is no longer supported, so errors are only
+    //  reflected in the link status
+    call_opengl_skip_errors(
+        glProgramBinary,
+        program,
+        static_cast<GLenum>(header.format),
+        static_cast<const void*>(binary.data()),
+        static_cast<GLsizei>(binary.size()));
+
+    GLint status = GL_FALSE;
+    call_opengl<err::context_edit_error>(glGetProgramiv, program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        call_opengl_skip_errors(glDeleteProgram, program);
+        discard();
+        return 0;
+    }
+
+    return program;
+}
+
+
+// Store a program's binary
+// Failures are ignored, the program will simply be rebuilt next time
+void ft::rf::context::program_cache::write_binary(const std::uint64_t p_key, const unsigned int p_program)
+{
+    GLint length = 0;
+    call_opengl<err::context_edit_error>(glGetProgramiv, p_program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        // The driver doesn't support program binaries
+        return;
+    }
+
+    auto binary = std::vector<char>(static_cast<std::size_t>(length));
+    GLenum format = 0;
+    GLsizei written = 0;
+    call_opengl<err::context_edit_error>(
+        glGetProgramBinary,
+        p_program,
+        length,
+        &written,
+        &format,
+        static_cast<void*>(binary.data()));
+
+    const auto header = t_file_header{
+        g_file_magic,
+        g_file_version,
+        p_key,
+        static_cast<std::uint32_t>(format),
+        static_cast<std::uint32_t>(written)
+    };
+
+    // Write to a temporary file first so that concurrent readers
+    //  never see a partially written binary
+    const auto path = make_path(p_key);
+    auto temporary = path;
+    temporary += ".tmp";
+    {
+        auto file = std::ofstream(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), written);
+        if (!file)
+        {
+            file.close();
+            auto error = std::error_code{};
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+
+    auto error = std::error_code{};
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+// Disk-backed cache of linked program binaries
+// Entries are keyed by a hash of the program's sources, its defines and the
+//  driver's vendor, renderer and version strings so a driver update
+//  naturally misses every stale entry
+// Binaries rejected by the driver are deleted and rebuilt from source
+
+// project headers
+#include "shader_program.h"
+
+// standard headers
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+class program_cache
+{
+public:
+    // Constructor
+    // Binaries are stored in `p_directory`, which is created if needed
+    explicit program_cache(std::filesystem::path p_directory);
+
+    // Load a program from the cache or build it and store its binary
+    // The calling thread must have an active context
+    // Returns the program's name
+    unsigned int load_or_build(const t_program_source& p_source);
+
+    // Create a program from its cached binary
+    // The calling thread must have an active context
+    // Returns 0 if there is no usable binary
+    unsigned int try_load(const t_program_source& p_source);
+
+    // Store the binary of a program built with a retrievable binary
+    // The calling thread must have an active context
+    void store(const t_program_source& p_source, const unsigned int p_program);
+
+    // Directory holding the binaries
+    const std::filesystem::path& get_directory() const;
+
+    // Number of programs loaded from disk
+    std::size_t get_hit_count() const;
+
+    // Number of programs built from source
+    std::size_t get_miss_count() const;
+
+private:
+    // Hash identifying a program for the current driver
+    std::uint64_t make_key(const t_program_source& p_source);
+
+    // Path of the binary for a given key
+    std::filesystem::path make_path(const std::uint64_t p_key) const;
+
+    // Try to create a program from a stored binary
+    // Returns 0 if there is no usable binary
+    unsigned int read_binary(const std::uint64_t p_key);
+
+    // Store a program's binary
+    // Failures are ignored, the program will simply be rebuilt next time
+    void write_binary(const std::uint64_t p_key, const unsigned int p_program);
+
+private:
+    // Directory holding the binaries
+    std::filesystem::path m_directory;
+
+    // Driver vendor, renderer and version, read on first use
+    std::string m_driver_id;
+
+    // Statistics
+    std::size_t m_hit_count = 0;
+    std::size_t m_miss_count = 0;
+
+};  // class program_cache
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,245 @@
+#include "shader_program.h"
+
+// project headers
+#include "call_opengl_function.h"
+#include "gpu_memory_tracker.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// standard headers
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace {
+
+// Get the info log of a shader or program
+template<class GetLength, class GetLog>
+std::string get_info_log(const GLuint p_object, GetLength p_get_length, GetLog p_get_log)
+{
+    GLint length = 0;
+    p_get_length(p_object, GL_INFO_LOG_LENGTH, &length);
+
+    std::string log(static_cast<std::size_t>(length > 0 ? length : 0), '\0');
+    if (length > 0)
+    {
+        p_get_log(p_object, length, nullptr, log.data());
+        log.resize(log.size() - 1);  // Drop the null terminator
+    }
+    return log;
+}
+
+
+// Start compiling a single stage
+// The compile status is checked by `finish_program_build`
+// Returns the shader's name
+GLuint compile_stage(const GLenum p_stage, const std::string & p_source)
+{
+    using t_except = ft::rf::err::context_edit_error;
+
+    const auto shader = ft::rf::call_opengl_fail_value<t_except, GLuint{ 0 }>(
+        glCreateShader,
+        p_stage);
+
+    const GLchar* const text = p_source.c_str();
+    ft::rf::call_opengl<t_except>(glShaderSource, shader, GLsizei{ 1 }, &text, nullptr);
+    ft::rf::call_opengl<t_except>(glCompileShader, shader);
+
+    return shader;
+}
+
+
+// Release a build's objects
+void release_build(ft::rf::context::t_program_build & p_build)
+{
+    for (const auto shader : p_build.shaders) {
+        ft::rf::call_opengl_skip_errors(glDeleteShader, shader);
+    }
+    if (p_build.program != 0) {
+        ft::rf::call_opengl_skip_errors(glDeleteProgram, p_build.program);
+    }
+    p_build = {};
+}
+
+}   // anonymous namespace
+
+
+// Insert `p_defines` into a shader source, after its #version directive
+std::string ft::rf::context::apply_defines(
+    const std::string & p_source,
+    const std::vector<std::pair<std::string, std::string>> & p_defines)
+{
+    if (p_defines.empty())
+    {
+        return p_source;
+    }
+
+    std::string defines;
+    for (const auto & [name, value] : p_defines)
+    {
+        defines += "#define " + name + " " + value + "\n";
+    }
+
+    // #version must remain the first directive
+    const auto version = p_source.find("#version");
+    if (version == std::string::npos)
+    {
+        return defines + p_source;
+    }
+
+    const auto line_end = p_source.find('\n', version);
+    if (line_end == std::string::npos)
+    {
+        return p_source + "\n" + defines;
+    }
+
+    auto result = p_source;
+    result.insert(line_end + 1, defines);
+    return result;
+}
+
+
+// Compile and link a program
+// The calling thread must have an active context
+// If `p_retrievable` is set, the binary can later be read with glGetProgramBinary
+// Returns the program's name
+unsigned int ft::rf::context::build_program(
+    const t_program_source & p_source,
+    const bool p_retrievable)
+{
+    auto build = start_program_build(p_source, p_retrievable);
+    return finish_program_build(build);
+}
+
+
+// Start compiling and linking a program without checking the result
+// With parallel shader compilation the driver builds it in the background
+ft::rf::context::t_program_build
+ft::rf::context::start_program_build(
+    const t_program_source & p_source,
+    const bool p_retrievable)
+{
+    using t_except = err::context_edit_error;
+
+    const std::array<std::pair<GLenum, const std::string*>, 3> stages = { {
+        { GL_VERTEX_SHADER, &p_source.vertex },
+        { GL_GEOMETRY_SHADER, &p_source.geometry },
+        { GL_FRAGMENT_SHADER, &p_source.fragment }
+    } };
+
+    auto build = t_program_build{};
+    try
+    {
+        build.program = call_opengl_fail_value<t_except, GLuint{ 0 }>(glCreateProgram);
+
+        // Compile and attach every stage
+        for (const auto & [stage, source] : stages)
+        {
+            if (source->empty() == false)
+            {
+                const auto shader = compile_stage(stage, apply_defines(*source, p_source.defines));
+                build.shaders.push_back(shader);
+                call_opengl<t_except>(glAttachShader, build.program, shader);
+            }
+        }
+
+        if (p_retrievable)
+        {
+            call_opengl<t_except>(
+                glProgramParameteri,
+                build.program,
+                GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                GL_TRUE);
+        }
+
+        call_opengl<t_except>(glLinkProgram, build.program);
+    }
+    catch (...)
+    {
+        release_build(build);
+        throw;
+    }
+
+    return build;
+}
+
+
+// Has the driver finished building the program?
+// Always true if parallel shader compilation isn't supported
+bool ft::rf::context::is_program_build_complete(const t_program_build & p_build)
+{
+    if (GLEW_KHR_parallel_shader_compile == 0 && GLEW_ARB_parallel_shader_compile == 0)
+    {
+        return true;
+    }
+
+    GLint complete = GL_FALSE;
+    call_opengl<err::context_edit_error>(
+        glGetProgramiv,
+        p_build.program,
+        GL_COMPLETION_STATUS_KHR,
+        &complete);
+    return complete == GL_TRUE;
+}
+
+
+// Check the result of a build and release its shaders
+// Blocks until the driver finishes building the program
+// Raises err::context_edit_error if a stage failed to compile or if the program failed to link,
+//  its message holds the driver's info log
+// Returns the program's name
+unsigned int ft::rf::context::finish_program_build(t_program_build & p_build)
+{
+    using t_except = err::context_edit_error;
+
+    // Report compilation errors first, they explain the link failure
+    for (const auto shader : p_build.shaders)
+    {
+        GLint status = GL_FALSE;
+        call_opengl<t_except>(glGetShaderiv, shader, GL_COMPILE_STATUS, &status);
+        if (status != GL_TRUE)
+        {
+            auto log = get_info_log(shader, glGetShaderiv, glGetShaderInfoLog);
+            release_build(p_build);
+            t_except::raise(("Shader compilation failed : " + log).c_str());
+        }
+    }
+
+    GLint status = GL_FALSE;
+    call_opengl<t_except>(glGetProgramiv, p_build.program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        auto log = get_info_log(p_build.program, glGetProgramiv, glGetProgramInfoLog);
+        release_build(p_build);
+        t_except::raise(("Program link failed : " + log).c_str());
+    }
+
+    // The shaders are no longer needed once linked
+    for (const auto shader : p_build.shaders)
+    {
+        call_opengl_skip_errors(glDetachShader, p_build.program, shader);
+        call_opengl_skip_errors(glDeleteShader, shader);
+    }
+
+    const auto program = p_build.program;
+    p_build = {};
+    return program;
+}
+
+
+// Record a linked program in the GPU memory tracker
+// `p_context` must be active on the calling thread, the size of the
+//  linked binary is the closest estimate available
+void ft::rf::context::track_program(const opengl_context & p_context, const unsigned int p_program)
+{
+    auto length = GLint{ 0 };
+    call_opengl_skip_errors(glGetProgramiv, p_program, GL_PROGRAM_BINARY_LENGTH, &length);
+    get_gpu_memory_tracker().track(
+        p_context,
+        t_gpu_memory_category::program,
+        p_program,
+        static_cast<std::uint64_t>(std::max(length, GLint{ 0 })),
+        "program");
+}
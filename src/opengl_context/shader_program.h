@@ -0,0 +1,73 @@
+#pragma once
+
+// Compiles and links shader programs
+
+// standard headers
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+// Forward declaration
+class opengl_context;
+
+// Sources of every stage of a program
+// Empty stages are skipped
+struct t_program_source
+{
+    std::string vertex;
+    std::string geometry;
+    std::string fragment;
+
+    // Preprocessor definitions added to every stage as { name, value }
+    std::vector<std::pair<std::string, std::string>> defines;
+
+};  // struct t_program_source
+
+
+// A program whose build was started but not checked yet
+struct t_program_build
+{
+    unsigned int program = 0;
+    std::vector<unsigned int> shaders;
+
+};  // struct t_program_build
+
+
+// Insert `p_defines` into a shader source, after its #version directive
+std::string apply_defines(
+    const std::string& p_source,
+    const std::vector<std::pair<std::string, std::string>>& p_defines);
+
+// Compile and link a program
+// The calling thread must have an active context
+// If `p_retrievable` is set, the binary can later be read with glGetProgramBinary
+// Returns the program's name
+unsigned int build_program(const t_program_source& p_source, const bool p_retrievable);
+
+// Start compiling and linking a program without checking the result
+// With parallel shader compilation the driver builds it in the background
+t_program_build start_program_build(const t_program_source& p_source, const bool p_retrievable);
+
+// Has the driver finished building the program?
+// Always true if parallel shader compilation isn't supported
+bool is_program_build_complete(const t_program_build& p_build);
+
+// Check the result of a build and release its shaders
+// Blocks until the driver finishes building the program
+// Raises err::context_edit_error if a stage failed to compile or if the program failed to link,
+//  its message holds the driver's info log
+// Returns the program's name
+unsigned int finish_program_build(t_program_build& p_build);
+
+// Record a linked program in the GPU memory tracker
+// `p_context` must be active on the calling thread, the size of the
+//  linked binary is the closest estimate available
+void track_program(const opengl_context& p_context, const unsigned int p_program);
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,418 @@
+#include "texture_atlas.h"
+
+// project headers
+#include "call_opengl_function.h"
+#include "gpu_memory_tracker.h"
+#include "make_current.h"
+#include "object_caches.h"
+#include "opengl_context.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+    // Bytes per RGBA8 pixel
+    constexpr std::size_t g_pixel_size = 4;
+
+    // Dirty rectangles are merged if their union uploads at most this
+    //  much more than the two rectangles separately
+    constexpr float g_merge_waste = 1.5f;
+}   // anonymous namespace
+
+
+// Constructor
+// Creates the array texture
+ft::rf::context::texture_atlas::texture_atlas(
+    opengl_context & p_context,
+    const t_texture_atlas_params & p_params) :
+    m_context(&p_context),
+    m_params(p_params),
+    m_layers(static_cast<std::size_t>(p_params.layers))
+{
+    FT_ASSERT(p_params.size > 0 && p_params.layers > 0 && p_params.padding >= 0);
+
+    for (auto & layer : m_layers)
+    {
+        layer.skyline.push_back({ 0, 0, m_params.size });
+    }
+
+    auto active = make_current{ *m_context };
+
+    call_opengl<err::context_edit_error>(glGenTextures, 1, &m_texture);
+    call_opengl<err::context_edit_error>(glBindTexture, GL_TEXTURE_2D_ARRAY, m_texture);
+    call_opengl<err::context_edit_error>(
+        glTexStorage3D,
+        GL_TEXTURE_2D_ARRAY,
+        GLsizei{ 1 },
+        GL_RGBA8,
+        static_cast<GLsizei>(m_params.size),
+        static_cast<GLsizei>(m_params.size),
+        static_cast<GLsizei>(m_params.layers));
+    get_gpu_memory_tracker().track(
+        *m_context,
+        t_gpu_memory_category::texture,
+        m_texture,
+        estimate_texture_size(GL_RGBA8, m_params.size, m_params.size, m_params.layers),
+        "texture_atlas");
+    call_opengl<err::context_edit_error>(glTexParameteri, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    call_opengl<err::context_edit_error>(glTexParameteri, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    call_opengl<err::context_edit_error>(glTexParameteri, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    call_opengl<err::context_edit_error>(glTexParameteri, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+
+// Destructor
+// Releases the array texture
+ft::rf::context::texture_atlas::~texture_atlas()
+{
+    auto active = make_current{ *m_context };
+    call_opengl_skip_errors(glDeleteTextures, 1, &m_texture);
+    get_gpu_memory_tracker().untrack(*m_context, t_gpu_memory_category::texture, m_texture);
+    m_context->notify_object_deleted(t_object_kind::texture, m_texture);
+}
+
+
+// Find an image, marking it as used this frame
+// Returns nothing if the image was never added or was evicted
+std::optional<ft::rf::context::texture_atlas::t_region>
+ft::rf::context::texture_atlas::find(const t_key p_key)
+{
+    const auto iter = m_entries.find(p_key);
+    if (iter == std::end(m_entries))
+    {
+        return std::nullopt;
+    }
+
+    m_layers[iter->second.layer].last_use = m_frame;
+    return make_region(iter->second);
+}
+
+
+// Add an image of `p_width` x `p_height` tightly packed RGBA8 pixels
+// Replaces any image with the same key
+// Never calls OpenGL, the pixels are uploaded by `flush`
+// Evicts the least recently used layer if no layer has room
+ft::rf::context::texture_atlas::t_region
+ft::rf::context::texture_atlas::insert(
+    const t_key p_key,
+    const int p_width,
+    const int p_height,
+    const std::uint8_t * p_pixels)
+{
+    FT_ASSERT(p_width > 0 && p_height > 0 && p_pixels != nullptr);
+
+    const auto padded_width = p_width + 2 * m_params.padding;
+    const auto padded_height = p_height + 2 * m_params.padding;
+    if (padded_width > m_params.size || padded_height > m_params.size)
+    {
+        throw t_except_full("Image is larger than an atlas layer");
+    }
+
+    // Try every layer, most recently used first to keep layers
+    //  holding stale images easy to evict
+    std::vector<int> order(m_layers.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<int>(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [this](int p_lhs, int p_rhs) {
+        return m_layers[p_lhs].last_use > m_layers[p_rhs].last_use;
+    });
+
+    std::optional<t_rect> rect;
+    int layer_index = 0;
+    for (const auto index : order)
+    {
+        rect = pack(m_layers[index], padded_width, padded_height);
+        if (rect.has_value())
+        {
+            layer_index = index;
+            break;
+        }
+    }
+
+    if (rect.has_value() == false)
+    {
+        // Empty the least recently used layer, unless it's still in use
+        layer_index = order.back();
+        if (m_layers[layer_index].last_use >= m_frame)
+        {
+            throw t_except_full("Every atlas layer is used by the current frame");
+        }
+        evict(layer_index);
+        rect = pack(m_layers[layer_index], padded_width, padded_height);
+        FT_ASSERT(rect.has_value());
+    }
+
+    auto & layer = m_layers[layer_index];
+    if (layer.pixels.empty())
+    {
+        layer.pixels.resize(
+            static_cast<std::size_t>(m_params.size) * m_params.size * g_pixel_size);
+    }
+
+    // Copy the image to the layer, clearing its padding
+    const auto stride = static_cast<std::size_t>(m_params.size) * g_pixel_size;
+    for (int row = 0; row < rect->height; ++row)
+    {
+        auto * target = layer.pixels.data() +
+            (rect->y + row) * stride + rect->x * g_pixel_size;
+        std::memset(target, 0, rect->width * g_pixel_size);
+
+        const auto image_row = row - m_params.padding;
+        if (image_row >= 0 && image_row < p_height)
+        {
+            std::memcpy(
+                target + m_params.padding * g_pixel_size,
+                p_pixels + image_row * p_width * g_pixel_size,
+                p_width * g_pixel_size);
+        }
+    }
+    mark_dirty(layer, *rect);
+
+    // Keep the region without its padding
+    auto entry = t_entry{ layer_index, {
+        rect->x + m_params.padding,
+        rect->y + m_params.padding,
+        p_width,
+        p_height } };
+    m_entries[p_key] = entry;
+    layer.last_use = m_frame;
+
+    return make_region(entry);
+}
+
+
+// Upload the regions changed since the last flush
+void ft::rf::context::texture_atlas::flush()
+{
+    const auto has_dirty = std::any_of(m_layers.begin(), m_layers.end(), [](const auto & p_layer) {
+        return p_layer.dirty.empty() == false;
+    });
+    if (has_dirty == false)
+    {
+        return;
+    }
+
+    auto active = make_current{ *m_context };
+
+    call_opengl<err::context_edit_error>(glBindTexture, GL_TEXTURE_2D_ARRAY, m_texture);
+    call_opengl<err::context_edit_error>(glPixelStorei, GL_UNPACK_ALIGNMENT, 4);
+    call_opengl<err::context_edit_error>(glPixelStorei, GL_UNPACK_ROW_LENGTH, m_params.size);
+
+    for (std::size_t index = 0; index < m_layers.size(); ++index)
+    {
+        auto & layer = m_layers[index];
+        for (const auto & rect : layer.dirty)
+        {
+            call_opengl<err::context_edit_error>(glPixelStorei, GL_UNPACK_SKIP_PIXELS, rect.x);
+            call_opengl<err::context_edit_error>(glPixelStorei, GL_UNPACK_SKIP_ROWS, rect.y);
+            call_opengl<err::context_edit_error>(
+                glTexSubImage3D,
+                GL_TEXTURE_2D_ARRAY,
+                GLint{ 0 },
+                rect.x, rect.y, static_cast<GLint>(index),
+                rect.width, rect.height, GLsizei{ 1 },
+                GL_RGBA,
+                GL_UNSIGNED_BYTE,
+                static_cast<const void*>(layer.pixels.data()));
+        }
+        layer.dirty.clear();
+    }
+
+    // Restore the default unpacking state
+    call_opengl<err::context_edit_error>(glPixelStorei, GL_UNPACK_ROW_LENGTH, 0);
+    call_opengl<err::context_edit_error>(glPixelStorei, GL_UNPACK_SKIP_PIXELS, 0);
+    call_opengl<err::context_edit_error>(glPixelStorei, GL_UNPACK_SKIP_ROWS, 0);
+}
+
+
+// Start a new frame
+// Images used during the current frame are never evicted
+void ft::rf::context::texture_atlas::next_frame()
+{
+    ++m_frame;
+}
+
+
+// Name of the array texture
+unsigned int ft::rf::context::texture_atlas::get_texture() const
+{
+    return m_texture;
+}
+
+
+// Number of images in the atlas
+std::size_t ft::rf::context::texture_atlas::get_image_count() const
+{
+    return m_entries.size();
+}
+
+
+// Number of layers emptied to make room
+std::size_t ft::rf::context::texture_atlas::get_eviction_count() const
+{
+    return m_eviction_count;
+}
+
+
+// Find a spot for a `p_width` x `p_height` rectangle in a layer
+// Uses the bottom-left skyline heuristic
+std::optional<ft::rf::context::texture_atlas::t_rect>
+ft::rf::context::texture_atlas::pack(t_layer & p_layer, const int p_width, const int p_height)
+{
+    auto & skyline = p_layer.skyline;
+
+    auto best_index = skyline.size();
+    auto best_top = std::numeric_limits<int>::max();
+    auto best_width = std::numeric_limits<int>::max();
+    auto best_y = 0;
+
+    for (std::size_t i = 0; i < skyline.size(); ++i)
+    {
+        // Rest the rectangle on the highest node it spans
+        const auto x = skyline[i].x;
+        if (x + p_width > m_params.size) {
+            break;
+        }
+
+        auto y = 0;
+        auto width_left = p_width;
+        for (auto j = i; width_left > 0; ++j)
+        {
+            y = std::max(y, skyline[j].y);
+            width_left -= skyline[j].width;
+        }
+        if (y + p_height > m_params.size) {
+            continue;
+        }
+
+        const auto top = y + p_height;
+        if (top < best_top || (top == best_top && skyline[i].width < best_width))
+        {
+            best_index = i;
+            best_top = top;
+            best_width = skyline[i].width;
+            best_y = y;
+        }
+    }
+
+    if (best_index == skyline.size())
+    {
+        return std::nullopt;
+    }
+
+    const auto rect = t_rect{ skyline[best_index].x, best_y, p_width, p_height };
+
+    // Raise the skyline over the rectangle
+    skyline.insert(skyline.begin() + best_index, { rect.x, best_top, p_width });
+    for (auto j = best_index + 1; j < skyline.size();)
+    {
+        const auto & previous = skyline[j - 1];
+        const auto previous_end = previous.x + previous.width;
+        if (skyline[j].x >= previous_end) {
+            break;
+        }
+
+        const auto shrink = previous_end - skyline[j].x;
+        skyline[j].x += shrink;
+        skyline[j].width -= shrink;
+        if (skyline[j].width > 0) {
+            break;
+        }
+        skyline.erase(skyline.begin() + j);
+    }
+
+    // Merge neighbours at the same height
+    for (std::size_t j = 0; j + 1 < skyline.size();)
+    {
+        if (skyline[j].y == skyline[j + 1].y)
+        {
+            skyline[j].width += skyline[j + 1].width;
+            skyline.erase(skyline.begin() + j + 1);
+        }
+        else
+        {
+            ++j;
+        }
+    }
+
+    return rect;
+}
+
+
+// Remove every image of a layer
+void ft::rf::context::texture_atlas::evict(const int p_layer)
+{
+    for (auto iter = m_entries.begin(); iter != m_entries.end();)
+    {
+        if (iter->second.layer == p_layer) {
+            iter = m_entries.erase(iter);
+        }
+        else {
+            ++iter;
+        }
+    }
+
+    auto & layer = m_layers[p_layer];
+    layer.skyline.assign(1, { 0, 0, m_params.size });
+    ++m_eviction_count;
+}
+
+
+// Add a rectangle to a layer's dirty list, merging it with overlapping
+//  or nearby rectangles when that doesn't upload much more
+void ft::rf::context::texture_atlas::mark_dirty(t_layer & p_layer, t_rect p_rect)
+{
+    auto area = [](const t_rect & p_value) {
+        return static_cast<float>(p_value.width) * static_cast<float>(p_value.height);
+    };
+
+    auto & dirty = p_layer.dirty;
+    for (std::size_t i = 0; i < dirty.size();)
+    {
+        const auto & other = dirty[i];
+        const auto left = std::min(p_rect.x, other.x);
+        const auto top = std::min(p_rect.y, other.y);
+        const auto merged = t_rect{ left, top,
+            std::max(p_rect.x + p_rect.width, other.x + other.width) - left,
+            std::max(p_rect.y + p_rect.height, other.y + other.height) - top };
+
+        if (area(merged) <= (area(p_rect) + area(other)) * g_merge_waste)
+        {
+            // The merged rectangle may now reach earlier ones, start over
+            p_rect = merged;
+            dirty.erase(dirty.begin() + i);
+            i = 0;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    dirty.push_back(p_rect);
+}
+
+
+// Texture coordinates of an entry
+ft::rf::context::texture_atlas::t_region
+ft::rf::context::texture_atlas::make_region(const t_entry & p_entry) const
+{
+    const auto size = static_cast<float>(m_params.size);
+    const auto & rect = p_entry.rect;
+    return {
+        rect.x / size,
+        rect.y / size,
+        (rect.x + rect.width) / size,
+        (rect.y + rect.height) / size,
+        p_entry.layer
+    };
+}
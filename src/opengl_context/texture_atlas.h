@@ -0,0 +1,175 @@
+#pragma once
+
+// Packs many small RGBA images into the layers of a single array texture
+// Images are placed with a skyline packer, written to a CPU copy of their
+//  layer and uploaded by `flush` as a few coalesced rectangles
+// When no layer has room left, the least recently used layer is emptied
+
+// standard headers
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+// Forward declaration
+class opengl_context;
+
+struct t_texture_atlas_params
+{
+    // Width and height of a layer in pixels
+    int size = 2048;
+
+    // Number of layers of the array texture
+    int layers = 4;
+
+    // Empty pixels kept around each image to avoid filtering
+    //  its neighbours in
+    int padding = 1;
+
+};  // struct t_texture_atlas_params
+
+
+class texture_atlas
+{
+public:
+    // Where an image is stored in the atlas
+    struct t_region
+    {
+        // Texture coordinates of the image's corners
+        float u0 = 0.f;
+        float v0 = 0.f;
+        float u1 = 0.f;
+        float v1 = 0.f;
+
+        // Array texture layer holding the image
+        int layer = 0;
+    };
+
+    // Identifies an image in the atlas
+    using t_key = std::uint64_t;
+
+    // Raised when an image can't fit even after eviction
+    struct t_except_full : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+public:
+    // Constructor
+    // Creates the array texture
+    explicit texture_atlas(opengl_context& p_context, const t_texture_atlas_params& p_params = {});
+
+    // Destructor
+    // Releases the array texture
+    ~texture_atlas();
+
+    // Prevent copy
+    texture_atlas(const texture_atlas&) = delete;
+    texture_atlas& operator=(const texture_atlas&) = delete;
+
+    // Find an image, marking it as used this frame
+    // Returns nothing if the image was never added or was evicted
+    std::optional<t_region> find(const t_key p_key);
+
+    // Add an image of `p_width` x `p_height` tightly packed RGBA8 pixels
+    // Replaces any image with the same key
+    // Never calls OpenGL, the pixels are uploaded by `flush`
+    // Evicts the least recently used layer if no layer has room
+    t_region insert(const t_key p_key, const int p_width, const int p_height, const std::uint8_t* p_pixels);
+
+    // Upload the regions changed since the last flush
+    void flush();
+
+    // Start a new frame
+    // Images used during the current frame are never evicted
+    void next_frame();
+
+    // Name of the array texture
+    unsigned int get_texture() const;
+
+    // Number of images in the atlas
+    std::size_t get_image_count() const;
+
+    // Number of layers emptied to make room
+    std::size_t get_eviction_count() const;
+
+private:
+    // A rectangle in a layer, in pixels
+    struct t_rect {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    // A segment of a layer's skyline
+    struct t_skyline_node {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+    };
+
+    struct t_layer {
+        // Top of the packed area, from left to right
+        std::vector<t_skyline_node> skyline;
+
+        // CPU copy of the layer's pixels, allocated on first use
+        std::vector<std::uint8_t> pixels;
+
+        // Rectangles waiting to be uploaded
+        std::vector<t_rect> dirty;
+
+        // Last frame an image of this layer was used
+        std::uint64_t last_use = 0;
+    };
+
+    struct t_entry {
+        int layer = 0;
+        t_rect rect;
+    };
+
+    // Find a spot for a `p_width` x `p_height` rectangle in a layer
+    std::optional<t_rect> pack(t_layer& p_layer, const int p_width, const int p_height);
+
+    // Remove every image of a layer
+    void evict(const int p_layer);
+
+    // Add a rectangle to a layer's dirty list, merging it with overlapping
+    //  or nearby rectangles when that doesn't upload much more
+    void mark_dirty(t_layer& p_layer, t_rect p_rect);
+
+    // Texture coordinates of an entry
+    t_region make_region(const t_entry& p_entry) const;
+
+private:
+    // Context owning the texture
+    opengl_context* m_context = nullptr;
+
+    // Atlas parameters
+    t_texture_atlas_params m_params;
+
+    // Array texture
+    unsigned int m_texture = 0;
+
+    // Layers of the texture
+    std::vector<t_layer> m_layers;
+
+    // Images in the atlas
+    std::unordered_map<t_key, t_entry> m_entries;
+
+    // Current frame number
+    std::uint64_t m_frame = 1;
+
+    // Number of layers emptied to make room
+    std::size_t m_eviction_count = 0;
+
+};  // class texture_atlas
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
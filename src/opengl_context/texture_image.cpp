@@ -0,0 +1,49 @@
+#include "texture_image.h"
+
+// project headers
+#include "simd/pixel_kernels.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+
+// Replace the levels after the first with a complete mip chain down to 1 x 1
+void ft::rf::context::generate_mip_levels(t_texture_image & p_image)
+{
+    FT_ASSERT(p_image.width > 0 && p_image.height > 0 && p_image.levels.empty() == false);
+
+    const auto count = get_mip_level_count(p_image.width, p_image.height);
+    p_image.levels.resize(static_cast<std::size_t>(count));
+
+    auto width = p_image.width;
+    auto height = p_image.height;
+    for (int level = 1; level < count; ++level)
+    {
+        const auto & source = p_image.levels[level - 1];
+        auto & target = p_image.levels[level];
+
+        const auto target_width = std::max(width / 2, 1);
+        const auto target_height = std::max(height / 2, 1);
+        target.resize(static_cast<std::size_t>(target_width) * target_height * 4);
+        simd::downsample_2x2(source.data(), width, height, target.data());
+
+        width = target_width;
+        height = target_height;
+    }
+}
+
+
+// Number of levels of a complete mip chain for a `p_width` x `p_height` image
+int ft::rf::context::get_mip_level_count(const int p_width, const int p_height)
+{
+    auto size = std::max(p_width, p_height);
+    auto count = 1;
+    while (size > 1)
+    {
+        size /= 2;
+        ++count;
+    }
+    return count;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// CPU side pixels of a texture and its mip levels
+
+// standard headers
+#include <cstdint>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+// Pixels of a texture, RGBA8 with tightly packed rows, top row first
+// `levels[0]` is the full size image, each following level halves it
+struct t_texture_image
+{
+    int width = 0;
+    int height = 0;
+    std::vector<std::vector<std::uint8_t>> levels;
+
+};  // struct t_texture_image
+
+
+// Replace the levels after the first with a complete mip chain down to 1 x 1
+// Each level averages 2 x 2 pixels of the previous one, the last row or
+//  column of an odd size level is reused
+void generate_mip_levels(t_texture_image& p_image);
+
+// Number of levels of a complete mip chain for a `p_width` x `p_height` image
+int get_mip_level_count(const int p_width, const int p_height);
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,436 @@
+#include "texture_manager.h"
+
+// project headers
+#include "call_opengl_function.h"
+#include "gpu_memory_tracker.h"
+#include "make_current.h"
+#include "object_caches.h"
+#include "opengl_context.h"
+#include "jobs/job_system.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Owner tag of the textures in the GPU memory tracker
+constexpr const char* g_tracker_tag = "texture_manager";
+
+// Size of mip level `p_level` of a `p_size` image
+int get_level_size(const int p_size, const int p_level)
+{
+    return std::max(p_size >> p_level, 1);
+}
+
+
+// Check that an image has the size its levels announce
+bool is_valid(const ft::rf::context::t_texture_image & p_image)
+{
+    if (p_image.width <= 0 || p_image.height <= 0 || p_image.levels.empty())
+    {
+        return false;
+    }
+
+    for (std::size_t level = 0; level < p_image.levels.size(); ++level)
+    {
+        const auto width = get_level_size(p_image.width, static_cast<int>(level));
+        const auto height = get_level_size(p_image.height, static_cast<int>(level));
+        if (p_image.levels[level].size() != static_cast<std::size_t>(width) * height * 4)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+}   // anonymous namespace
+
+
+// Constructor
+ft::rf::context::texture_manager::texture_manager(
+    opengl_context & p_context,
+    const t_texture_manager_params & p_params) :
+    m_context(&p_context),
+    m_params(p_params)
+{
+    FT_ASSERT(p_params.min_levels > 0 && p_params.max_loads > 0);
+
+    auto & system = (m_params.job_system != nullptr) ?
+        *m_params.job_system :
+        jobs::get_default_job_system();
+    m_loads_group = std::make_unique<jobs::task_group>(system);
+}
+
+
+// Destructor
+// Waits for the loads in progress and releases the textures
+ft::rf::context::texture_manager::~texture_manager()
+{
+    m_loads_group.reset();
+
+    auto active = make_current{ *m_context };
+    for (auto & [handle, texture] : m_textures)
+    {
+        release(texture);
+    }
+}
+
+
+// Add a texture loaded from `p_source` when first used
+ft::rf::context::texture_manager::t_handle
+ft::rf::context::texture_manager::add(t_texture_source p_source)
+{
+    FT_ASSERT(p_source != nullptr);
+
+    const auto handle = m_next_handle++;
+    m_textures[handle].source = std::move(p_source);
+    return handle;
+}
+
+
+// Release a texture, a load in progress is discarded
+void ft::rf::context::texture_manager::remove(const t_handle p_handle)
+{
+    const auto found = m_textures.find(p_handle);
+    if (found == m_textures.end())
+    {
+        return;
+    }
+
+    if (found->second.name != 0)
+    {
+        auto active = make_current{ *m_context };
+        release(found->second);
+    }
+    m_textures.erase(found);
+}
+
+
+// Mark a texture as used this frame and get its name
+// Starts loading it if it isn't resident
+// Returns 0 while the texture has no level loaded
+unsigned int ft::rf::context::texture_manager::use(const t_handle p_handle)
+{
+    const auto found = m_textures.find(p_handle);
+    if (found == m_textures.end())
+    {
+        return 0;
+    }
+
+    auto & texture = found->second;
+    texture.last_use = m_frame;
+
+    if (texture.loading || texture.failed || m_loading >= m_params.max_loads)
+    {
+        return texture.name;
+    }
+
+    if (texture.name == 0)
+    {
+        start_load(p_handle, texture);
+    }
+    else if (texture.dropped_levels > 0)
+    {
+        // Restore the dropped levels only if they fit, otherwise they
+        //  would be dropped again on the next update
+        const auto full_size = estimate_texture_size(
+            GL_RGBA8,
+            texture.width << texture.dropped_levels,
+            texture.height << texture.dropped_levels,
+            1,
+            texture.levels + texture.dropped_levels);
+        if (m_resident_bytes - texture.bytes + full_size <= m_params.budget)
+        {
+            start_load(p_handle, texture);
+        }
+    }
+    return texture.name;
+}
+
+
+// Upload the loads that completed, enforce the budget and start a new frame
+// Textures used during the ending frame are never evicted
+void ft::rf::context::texture_manager::update()
+{
+    auto completed = std::vector<t_completed>{};
+    {
+        std::lock_guard<decltype(m_completed_mutex)> lock{ m_completed_mutex };
+        completed.swap(m_completed);
+    }
+
+    auto active = make_current{ *m_context };
+
+    for (auto & load : completed)
+    {
+        --m_loading;
+
+        // The texture may have been removed meanwhile
+        const auto found = m_textures.find(load.handle);
+        if (found == m_textures.end())
+        {
+            continue;
+        }
+
+        auto & texture = found->second;
+        texture.loading = false;
+        if (load.failed)
+        {
+            texture.failed = true;
+            ++m_failed_loads;
+            continue;
+        }
+
+        upload(texture, load.image);
+        ++m_loads;
+    }
+
+    enforce_budget();
+    ++m_frame;
+}
+
+
+// Change the budget, enforced on the next `update`
+void ft::rf::context::texture_manager::set_budget(const std::uint64_t p_bytes)
+{
+    m_params.budget = p_bytes;
+}
+
+
+// Get the counters
+ft::rf::context::texture_manager::t_stats
+ft::rf::context::texture_manager::get_stats() const
+{
+    auto result = t_stats{};
+    result.resident_bytes = m_resident_bytes;
+    result.textures = m_textures.size();
+    result.loading = m_loading;
+    result.loads = m_loads;
+    result.failed_loads = m_failed_loads;
+    result.evictions = m_evictions;
+    result.dropped_levels = m_dropped_levels;
+
+    for (const auto & [handle, texture] : m_textures)
+    {
+        if (texture.name == 0) {
+            continue;
+        }
+        if (texture.dropped_levels > 0) {
+            ++result.reduced;
+        }
+        else {
+            ++result.resident;
+        }
+    }
+    return result;
+}
+
+
+// Queue the source of a texture on the job system
+void ft::rf::context::texture_manager::start_load(const t_handle p_handle, t_texture & p_texture)
+{
+    p_texture.loading = true;
+    ++m_loading;
+
+    // The source is copied, the texture may be removed while it runs
+    m_loads_group->run([this, p_handle, source = p_texture.source]()
+    {
+        auto load = t_completed{ p_handle };
+        try
+        {
+            load.image = source();
+            load.failed = is_valid(load.image) == false;
+        }
+        catch (...)
+        {
+            load.failed = true;
+        }
+
+        std::lock_guard<decltype(m_completed_mutex)> lock{ m_completed_mutex };
+        m_completed.push_back(std::move(load));
+    });
+}
+
+
+// Create a texture from loaded pixels, replacing its previous storage
+// The context must already be active
+void ft::rf::context::texture_manager::upload(
+    t_texture & p_texture,
+    t_texture_image & p_image)
+{
+    release(p_texture);
+
+    const auto levels = static_cast<int>(p_image.levels.size());
+
+    call_opengl<err::context_edit_error>(glGenTextures, 1, &p_texture.name);
+    call_opengl<err::context_edit_error>(glBindTexture, GL_TEXTURE_2D, p_texture.name);
+    call_opengl<err::context_edit_error>(
+        glTexStorage2D,
+        GL_TEXTURE_2D,
+        static_cast<GLsizei>(levels),
+        GL_RGBA8,
+        static_cast<GLsizei>(p_image.width),
+        static_cast<GLsizei>(p_image.height));
+
+    // RGBA8 rows are always 4 byte aligned, no need to change GL_UNPACK_ALIGNMENT
+    for (int level = 0; level < levels; ++level)
+    {
+        call_opengl<err::context_edit_error>(
+            glTexSubImage2D,
+            GL_TEXTURE_2D,
+            GLint{ level },
+            GLint{ 0 }, GLint{ 0 },
+            static_cast<GLsizei>(get_level_size(p_image.width, level)),
+            static_cast<GLsizei>(get_level_size(p_image.height, level)),
+            GLenum{ GL_RGBA },
+            GLenum{ GL_UNSIGNED_BYTE },
+            p_image.levels[level].data());
+    }
+
+    const auto min_filter = (levels > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+    call_opengl<err::context_edit_error>(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GLint{ min_filter });
+    call_opengl<err::context_edit_error>(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GLint{ GL_LINEAR });
+    call_opengl<err::context_edit_error>(glBindTexture, GL_TEXTURE_2D, GLuint{ 0 });
+
+    p_texture.width = p_image.width;
+    p_texture.height = p_image.height;
+    p_texture.levels = levels;
+    p_texture.dropped_levels = 0;
+    p_texture.bytes = estimate_texture_size(GL_RGBA8, p_image.width, p_image.height, 1, levels);
+    m_resident_bytes += p_texture.bytes;
+
+    get_gpu_memory_tracker().track(*m_context, t_gpu_memory_category::texture, p_texture.name, p_texture.bytes, g_tracker_tag);
+}
+
+
+// Release memory from the least recently used textures until the
+//  budget is met
+// The context must already be active
+void ft::rf::context::texture_manager::enforce_budget()
+{
+    if (m_resident_bytes <= m_params.budget)
+    {
+        return;
+    }
+
+    // Textures used this frame are kept
+    auto candidates = std::vector<t_texture*>{};
+    for (auto & [handle, texture] : m_textures)
+    {
+        if (texture.name != 0 && texture.last_use < m_frame)
+        {
+            candidates.push_back(&texture);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const t_texture* p_left, const t_texture* p_right) {
+        return p_left->last_use < p_right->last_use;
+    });
+
+    // Each dropped level frees three quarters of a texture, try it on
+    //  every candidate before releasing any of them
+    if (m_params.drop_mip_levels && GLEW_ARB_copy_image != 0)
+    {
+        for (auto* texture : candidates)
+        {
+            while (m_resident_bytes > m_params.budget && texture->levels > m_params.min_levels)
+            {
+                drop_top_level(*texture);
+            }
+            if (m_resident_bytes <= m_params.budget) {
+                return;
+            }
+        }
+    }
+
+    for (auto* texture : candidates)
+    {
+        release(*texture);
+        ++m_evictions;
+        if (m_resident_bytes <= m_params.budget) {
+            return;
+        }
+    }
+}
+
+
+// Drop the top mip level of a texture, copying the other levels
+//  to a smaller texture
+// The context must already be active
+void ft::rf::context::texture_manager::drop_top_level(t_texture & p_texture)
+{
+    FT_ASSERT(p_texture.levels > 1);
+
+    const auto levels = p_texture.levels - 1;
+    const auto width = get_level_size(p_texture.width, 1);
+    const auto height = get_level_size(p_texture.height, 1);
+
+    auto name = GLuint{ 0 };
+    call_opengl<err::context_edit_error>(glGenTextures, 1, &name);
+    call_opengl<err::context_edit_error>(glBindTexture, GL_TEXTURE_2D, name);
+    call_opengl<err::context_edit_error>(
+        glTexStorage2D,
+        GL_TEXTURE_2D,
+        static_cast<GLsizei>(levels),
+        GL_RGBA8,
+        static_cast<GLsizei>(width),
+        static_cast<GLsizei>(height));
+
+    const auto min_filter = (levels > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+    call_opengl<err::context_edit_error>(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GLint{ min_filter });
+    call_opengl<err::context_edit_error>(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GLint{ GL_LINEAR });
+    call_opengl<err::context_edit_error>(glBindTexture, GL_TEXTURE_2D, GLuint{ 0 });
+
+    // The copy stays on the GPU
+    for (int level = 0; level < levels; ++level)
+    {
+        call_opengl<err::context_edit_error>(
+            glCopyImageSubData,
+            p_texture.name, GLenum{ GL_TEXTURE_2D }, GLint{ level + 1 }, GLint{ 0 }, GLint{ 0 }, GLint{ 0 },
+            name, GLenum{ GL_TEXTURE_2D }, GLint{ level }, GLint{ 0 }, GLint{ 0 }, GLint{ 0 },
+            static_cast<GLsizei>(get_level_size(width, level)),
+            static_cast<GLsizei>(get_level_size(height, level)),
+            GLsizei{ 1 });
+    }
+
+    const auto dropped = p_texture.dropped_levels + 1;
+    release(p_texture);
+
+    p_texture.name = name;
+    p_texture.width = width;
+    p_texture.height = height;
+    p_texture.levels = levels;
+    p_texture.dropped_levels = dropped;
+    p_texture.bytes = estimate_texture_size(GL_RGBA8, width, height, 1, levels);
+    m_resident_bytes += p_texture.bytes;
+    ++m_dropped_levels;
+
+    get_gpu_memory_tracker().track(*m_context, t_gpu_memory_category::texture, name, p_texture.bytes, g_tracker_tag);
+}
+
+
+// Release a texture's storage, keeping its source
+// The context must already be active
+void ft::rf::context::texture_manager::release(t_texture & p_texture)
+{
+    if (p_texture.name == 0)
+    {
+        return;
+    }
+
+    call_opengl_skip_errors(glDeleteTextures, 1, &p_texture.name);
+    get_gpu_memory_tracker().untrack(*m_context, t_gpu_memory_category::texture, p_texture.name);
+    m_context->notify_object_deleted(t_object_kind::texture, p_texture.name);
+
+    m_resident_bytes -= p_texture.bytes;
+    p_texture.name = 0;
+    p_texture.levels = 0;
+    p_texture.dropped_levels = 0;
+    p_texture.bytes = 0;
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+// Owns textures that can be reloaded from their source, within a memory budget
+//
+// Each texture is added with a function producing its pixels, called on the
+//  job system when the texture is first used and again after an eviction
+// Textures remember the last frame they were used, once the budget is
+//  exceeded the least recently used ones give up memory : first their top
+//  mip levels, down to `min_levels`, then the whole texture
+// A texture used again after losing memory is reloaded in the background,
+//  it keeps rendering at its reduced size, or not at all, until then
+
+// project headers
+#include "texture_image.h"
+
+// standard headers
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ft {
+namespace rf {
+
+// Forward declaration
+namespace jobs {
+class job_system;
+class task_group;
+}   // namespace jobs
+
+namespace context {
+
+// Forward declaration
+class opengl_context;
+
+// Produces a texture's pixels, called from a worker thread
+using t_texture_source = std::function<t_texture_image()>;
+
+
+struct t_texture_manager_params
+{
+    // Bytes the textures may use before some are evicted
+    std::uint64_t budget = std::uint64_t{ 512 } * 1024 * 1024;
+
+    // Drop top mip levels before evicting whole textures
+    bool drop_mip_levels = true;
+
+    // Mip levels a texture keeps when its top levels are dropped
+    int min_levels = 1;
+
+    // Maximum number of sources being loaded at once
+    std::size_t max_loads = 4;
+
+    // Runs the sources, the library's default job system if null
+    jobs::job_system* job_system = nullptr;
+
+};  // struct t_texture_manager_params
+
+
+class texture_manager
+{
+public:
+    // Identifies a texture, 0 is never used
+    using t_handle = std::uint64_t;
+
+    // Counters since creation
+    struct t_stats {
+        std::uint64_t resident_bytes = 0;   // Current estimated usage
+        std::size_t textures = 0;
+        std::size_t resident = 0;           // Textures with every level loaded
+        std::size_t reduced = 0;            // Textures with dropped levels
+        std::size_t loading = 0;
+        std::uint64_t loads = 0;
+        std::uint64_t failed_loads = 0;
+        std::uint64_t evictions = 0;        // Whole textures released
+        std::uint64_t dropped_levels = 0;
+    };
+
+public:
+    // Constructor
+    explicit texture_manager(opengl_context& p_context, const t_texture_manager_params& p_params = {});
+
+    // Destructor
+    // Waits for the loads in progress and releases the textures
+    ~texture_manager();
+
+    // Prevent copy
+    texture_manager(const texture_manager&) = delete;
+    texture_manager& operator=(const texture_manager&) = delete;
+
+    // Add a texture loaded from `p_source` when first used
+    t_handle add(t_texture_source p_source);
+
+    // Release a texture, a load in progress is discarded
+    void remove(const t_handle p_handle);
+
+    // Mark a texture as used this frame and get its name
+    // Starts loading it if it isn't resident
+    // Returns 0 while the texture has no level loaded
+    unsigned int use(const t_handle p_handle);
+
+    // Upload the loads that completed, enforce the budget and start a new frame
+    // Textures used during the ending frame are never evicted
+    void update();
+
+    // Change the budget, enforced on the next `update`
+    void set_budget(const std::uint64_t p_bytes);
+
+    // Get the counters
+    t_stats get_stats() const;
+
+private:
+    struct t_texture {
+        t_texture_source source;
+        unsigned int name = 0;          // 0 while nothing is loaded
+        int width = 0;                  // Size of the first loaded level
+        int height = 0;
+        int levels = 0;                 // Loaded levels
+        int dropped_levels = 0;         // Top levels not loaded
+        std::uint64_t bytes = 0;
+        std::uint64_t last_use = 0;
+        bool loading = false;
+        bool failed = false;            // Its source raised, never retried
+    };
+
+    // A load that completed, waiting to be uploaded
+    struct t_completed {
+        t_handle handle = 0;
+        bool failed = false;
+        t_texture_image image;
+    };
+
+    // Queue the source of a texture on the job system
+    void start_load(const t_handle p_handle, t_texture& p_texture);
+
+    // Create a texture from loaded pixels, replacing its previous storage
+    // The context must already be active
+    void upload(t_texture& p_texture, t_texture_image& p_image);
+
+    // Release memory from the least recently used textures until the
+    //  budget is met
+    // The context must already be active
+    void enforce_budget();
+
+    // Drop the top mip level of a texture, copying the other levels
+    //  to a smaller texture
+    // The context must already be active
+    void drop_top_level(t_texture& p_texture);
+
+    // Release a texture's storage, keeping its source
+    // The context must already be active
+    void release(t_texture& p_texture);
+
+private:
+    // Context owning the textures
+    opengl_context* m_context = nullptr;
+
+    // Manager parameters
+    t_texture_manager_params m_params;
+
+    // Textures by handle
+    std::unordered_map<t_handle, t_texture> m_textures;
+
+    // Next handle to give
+    t_handle m_next_handle = 1;
+
+    // Current frame number
+    std::uint64_t m_frame = 1;
+
+    // Sum of the textures' estimated sizes
+    std::uint64_t m_resident_bytes = 0;
+
+    // Number of loads in progress
+    std::size_t m_loading = 0;
+
+    // Counters
+    std::uint64_t m_loads = 0;
+    std::uint64_t m_failed_loads = 0;
+    std::uint64_t m_evictions = 0;
+    std::uint64_t m_dropped_levels = 0;
+
+    // Loads that completed, filled by the workers
+    std::mutex m_completed_mutex;
+    std::vector<t_completed> m_completed;
+
+    // Loads in progress, destroyed first so it waits for them
+    //  before the members they write to are destroyed
+    std::unique_ptr<jobs::task_group> m_loads_group;
+
+};  // class texture_manager
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,211 @@
+#include "uniform_arena.h"
+
+// project headers
+#include "call_opengl_function.h"
+#include "gpu_memory_tracker.h"
+#include "make_current.h"
+#include "object_caches.h"
+#include "opengl_context.h"
+
+// OpenGL headers
+#include "basegl/opengl_except.h"
+#include "basegl/opengl_headers.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+
+// Constructor
+// Queries the uniform buffer offset alignment of `p_context`
+ft::rf::context::uniform_arena::uniform_arena(
+    opengl_context & p_context,
+    const std::size_t p_block_size) :
+    m_context(&p_context),
+    m_block_size(p_block_size)
+{
+    FT_ASSERT(p_block_size > 0);
+
+    auto active = make_current{ *m_context };
+
+    GLint alignment = 0;
+    call_opengl<err::context_init>(
+        glGetIntegerv,
+        GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT,
+        &alignment);
+
+    m_alignment = std::max<std::size_t>(static_cast<std::size_t>(alignment), 1);
+}
+
+
+// Destructor
+// Releases the uniform buffers
+ft::rf::context::uniform_arena::~uniform_arena()
+{
+    auto active = make_current{ *m_context };
+
+    for (auto & block : m_blocks)
+    {
+        if (block.buffer != 0)
+        {
+            call_opengl_skip_errors(glDeleteBuffers, 1, &block.buffer);
+            get_gpu_memory_tracker().untrack(*m_context, t_gpu_memory_category::buffer, block.buffer);
+            m_context->notify_object_deleted(t_object_kind::buffer, block.buffer);
+        }
+    }
+}
+
+
+// Reserve `p_size` bytes for this frame
+// Never calls OpenGL, chains a new block when the current one is full
+ft::rf::context::uniform_arena::t_allocation
+ft::rf::context::uniform_arena::allocate(const std::size_t p_size)
+{
+    FT_ASSERT(p_size > 0);
+
+    // Find the first block from the current one with enough room left
+    while (m_current < m_blocks.size())
+    {
+        auto & block = m_blocks[m_current];
+        const auto offset = (block.head + m_alignment - 1) / m_alignment * m_alignment;
+        if (offset + p_size <= block.storage.size())
+        {
+            block.head = offset + p_size;
+            return { block.storage.data() + offset, m_current, offset, p_size };
+        }
+        ++m_current;
+    }
+
+    // Chain a new block, oversized allocations get a block of their own
+    auto & block = m_blocks.emplace_back();
+    block.storage.resize(std::max(m_block_size, p_size));
+    block.head = p_size;
+
+    return { block.storage.data(), m_current, 0, p_size };
+}
+
+
+// Bind an allocation to a uniform block binding point
+// Uploads the allocation's block first if it has pending data
+void ft::rf::context::uniform_arena::bind(
+    const t_allocation & p_allocation,
+    const unsigned int p_binding)
+{
+    FT_ASSERT(p_allocation.block < m_blocks.size());
+    auto & block = m_blocks[p_allocation.block];
+
+    auto active = make_current{ *m_context };
+
+    if (p_allocation.offset + p_allocation.size > block.uploaded)
+    {
+        flush_block(block);
+    }
+
+    call_opengl<err::context_edit_error>(
+        glBindBufferRange,
+        GL_UNIFORM_BUFFER,
+        p_binding,
+        block.buffer,
+        static_cast<GLintptr>(p_allocation.offset),
+        static_cast<GLsizeiptr>(p_allocation.size));
+}
+
+
+// Upload the pending data of every block
+void ft::rf::context::uniform_arena::flush()
+{
+    auto active = make_current{ *m_context };
+
+    for (auto & block : m_blocks)
+    {
+        if (block.head > block.uploaded)
+        {
+            flush_block(block);
+        }
+    }
+}
+
+
+// Recycle every block for a new frame
+// Invalidates all previous allocations
+void ft::rf::context::uniform_arena::reset()
+{
+    for (auto & block : m_blocks)
+    {
+        block.head = 0;
+        block.uploaded = 0;
+    }
+    m_current = 0;
+}
+
+
+// Offset alignment required between allocations
+std::size_t ft::rf::context::uniform_arena::get_alignment() const
+{
+    return m_alignment;
+}
+
+
+// Number of bytes allocated since the last reset
+std::size_t ft::rf::context::uniform_arena::get_used_size() const
+{
+    std::size_t total = 0;
+    for (const auto & block : m_blocks)
+    {
+        total += block.head;
+    }
+    return total;
+}
+
+
+// Number of blocks owned by the arena
+std::size_t ft::rf::context::uniform_arena::get_block_count() const
+{
+    return m_blocks.size();
+}
+
+
+// Upload the pending data of a block
+// The context must already be active
+void ft::rf::context::uniform_arena::flush_block(t_block & p_block)
+{
+    if (p_block.buffer == 0)
+    {
+        call_opengl<err::context_edit_error>(glGenBuffers, 1, &p_block.buffer);
+
+        // The storage keeps the same size when it is orphaned
+        get_gpu_memory_tracker().track(
+            *m_context,
+            t_gpu_memory_category::buffer,
+            p_block.buffer,
+            p_block.storage.size(),
+            "uniform_arena");
+    }
+
+    call_opengl<err::context_edit_error>(
+        glBindBuffer,
+        GL_UNIFORM_BUFFER,
+        p_block.buffer);
+
+    if (p_block.uploaded == 0)
+    {
+        // First upload this frame, orphan the previous storage so the
+        //  driver doesn't wait for last frame's draws to finish reading it
+        call_opengl<err::context_edit_error>(
+            glBufferData,
+            GL_UNIFORM_BUFFER,
+            static_cast<GLsizeiptr>(p_block.storage.size()),
+            nullptr,
+            GL_STREAM_DRAW);
+    }
+
+    call_opengl<err::context_edit_error>(
+        glBufferSubData,
+        GL_UNIFORM_BUFFER,
+        static_cast<GLintptr>(p_block.uploaded),
+        static_cast<GLsizeiptr>(p_block.head - p_block.uploaded),
+        p_block.storage.data() + p_block.uploaded);
+
+    p_block.uploaded = p_block.head;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+// Per-frame linear allocator for uniform block data
+// Allocations are carved out of large CPU-side blocks by bumping an offset
+//  and each block is mirrored by a single uniform buffer
+// Blocks are uploaded lazily, with one call per block, when a range is bound
+
+// standard headers
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace context {
+
+// Forward declaration
+class opengl_context;
+
+class uniform_arena
+{
+public:
+    // A range of the arena handed out by `allocate`
+    struct t_allocation {
+        std::byte* data = nullptr;  // Where to write the uniform data
+        std::size_t block = 0;      // Index of the block holding the range
+        std::size_t offset = 0;     // Offset of the range in the block's buffer
+        std::size_t size = 0;       // Size of the range in bytes
+    };
+
+    // Default size of a block
+    static constexpr std::size_t s_default_block_size = 1024 * 1024;
+
+public:
+    // Constructor
+    // Queries the uniform buffer offset alignment of `p_context`
+    explicit uniform_arena(
+        opengl_context& p_context,
+        const std::size_t p_block_size = s_default_block_size);
+
+    // Destructor
+    // Releases the uniform buffers
+    ~uniform_arena();
+
+    // Prevent copy
+    uniform_arena(const uniform_arena&) = delete;
+    uniform_arena& operator=(const uniform_arena&) = delete;
+
+    // Reserve `p_size` bytes for this frame
+    // Never calls OpenGL, chains a new block when the current one is full
+    t_allocation allocate(const std::size_t p_size);
+
+    // Reserve a range and copy `p_value` into it
+    template<class T>
+    t_allocation push(const T& p_value);
+
+    // Bind an allocation to a uniform block binding point
+    // Uploads the allocation's block first if it has pending data
+    void bind(const t_allocation& p_allocation, const unsigned int p_binding);
+
+    // Upload the pending data of every block
+    void flush();
+
+    // Recycle every block for a new frame
+    // Invalidates all previous allocations
+    void reset();
+
+    // Offset alignment required between allocations
+    std::size_t get_alignment() const;
+
+    // Number of bytes allocated since the last reset
+    std::size_t get_used_size() const;
+
+    // Number of blocks owned by the arena
+    std::size_t get_block_count() const;
+
+private:
+    struct t_block {
+        // CPU copy of the block's content
+        std::vector<std::byte> storage;
+
+        // First free byte in `storage`
+        std::size_t head = 0;
+
+        // Number of bytes of `storage` already uploaded this frame
+        std::size_t uploaded = 0;
+
+        // Uniform buffer mirroring this block, created on first upload
+        unsigned int buffer = 0;
+    };
+
+    // Upload the pending data of a block
+    void flush_block(t_block& p_block);
+
+private:
+    // Context owning the uniform buffers
+    opengl_context* m_context = nullptr;
+
+    // Size of a regular block
+    std::size_t m_block_size = s_default_block_size;
+
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    std::size_t m_alignment = 1;
+
+    // Blocks are reused in order every frame
+    std::vector<t_block> m_blocks;
+
+    // Block currently being filled
+    std::size_t m_current = 0;
+
+};  // class uniform_arena
+
+
+// Reserve a range and copy `p_value` into it
+template<class T>
+uniform_arena::t_allocation uniform_arena::push(const T& p_value)
+{
+    static_assert(std::is_trivially_copyable_v<T>,
+        "Uniform data must be trivially copyable");
+
+    auto allocation = allocate(sizeof(T));
+    std::memcpy(allocation.data, &p_value, sizeof(T));
+    return allocation;
+}
+
+}   // namespace context
+}   // namespace rf
+}   // namespace ft
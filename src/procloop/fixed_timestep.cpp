@@ -0,0 +1,81 @@
+#include "fixed_timestep.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// Constructor
+// Updates every `p_step`, running at most `p_max_steps` per frame
+// Time is counted from `p_start`
+ft::rf::procloop::fixed_timestep::fixed_timestep(
+    const std::chrono::nanoseconds p_step,
+    const std::size_t p_max_steps,
+    const t_clock::time_point p_start) :
+    m_step(p_step),
+    m_max_steps(p_max_steps),
+    m_last(p_start)
+{
+    FT_ASSERT(p_step > std::chrono::nanoseconds{ 0 });
+    FT_ASSERT(p_max_steps > 0);
+}
+
+
+// Count the time elapsed since the previous call
+// Returns the number of steps to run
+std::size_t ft::rf::procloop::fixed_timestep::advance(const t_clock::time_point p_now)
+{
+    // The clock is monotonic, but callers can pass an older time
+    if (p_now > m_last)
+    {
+        m_accumulator += p_now - m_last;
+        m_last = p_now;
+    }
+
+    auto steps = static_cast<std::uint64_t>(m_accumulator / m_step);
+    m_accumulator -= m_step * static_cast<std::int64_t>(steps);
+
+    if (steps > m_max_steps)
+    {
+        m_dropped_count += steps - m_max_steps;
+        steps = m_max_steps;
+    }
+    m_step_count += steps;
+    return static_cast<std::size_t>(steps);
+}
+
+
+// Part of a step accumulated after the last step, in [0, 1)
+// Weight of the latest simulation state when interpolating
+double ft::rf::procloop::fixed_timestep::get_alpha() const
+{
+    return std::chrono::duration<double>(m_accumulator) / std::chrono::duration<double>(m_step);
+}
+
+
+// Time simulated by a step
+std::chrono::nanoseconds ft::rf::procloop::fixed_timestep::get_step() const
+{
+    return m_step;
+}
+
+
+// Number of steps taken since the construction
+std::uint64_t ft::rf::procloop::fixed_timestep::get_step_count() const
+{
+    return m_step_count;
+}
+
+
+// Number of steps dropped by the cap since the construction
+std::uint64_t ft::rf::procloop::fixed_timestep::get_dropped_count() const
+{
+    return m_dropped_count;
+}
+
+
+// Forget the accumulated time and count again from `p_now`
+// Use after a pause, instead of catching up or dropping steps
+void ft::rf::procloop::fixed_timestep::reset(const t_clock::time_point p_now)
+{
+    m_last = p_now;
+    m_accumulator = std::chrono::nanoseconds{ 0 };
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+// Runs a simulation at a fixed rate, independently of the frame rate
+//
+// Every frame, `advance` adds the time elapsed since the previous frame
+//  to an accumulator and takes as many whole steps out of it as fit
+// The frame runs that many updates, then renders with `get_alpha` to
+//  interpolate between the last two simulation states
+// After a stall the steps are capped, the time beyond the cap is dropped
+//  so a slow update can't fall further and further behind
+
+// standard headers
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace ft {
+namespace rf {
+namespace procloop {
+
+class fixed_timestep
+{
+public:
+    using t_clock = std::chrono::steady_clock;
+
+    // Default maximum number of steps per frame
+    static constexpr std::size_t s_default_max_steps = 8;
+
+public:
+    // Constructor
+    // Updates every `p_step`, running at most `p_max_steps` per frame
+    // Time is counted from `p_start`
+    explicit fixed_timestep(
+        const std::chrono::nanoseconds p_step,
+        const std::size_t p_max_steps = s_default_max_steps,
+        const t_clock::time_point p_start = t_clock::now());
+
+    // Count the time elapsed since the previous call
+    // Returns the number of steps to run
+    std::size_t advance(const t_clock::time_point p_now = t_clock::now());
+
+    // Call `p_update(get_step())` for every step due at `p_now`
+    // Returns the number of steps run
+    template<class Update>
+    std::size_t update(Update&& p_update, const t_clock::time_point p_now = t_clock::now());
+
+    // Part of a step accumulated after the last step, in [0, 1)
+    // Weight of the latest simulation state when interpolating
+    double get_alpha() const;
+
+    // Time simulated by a step
+    std::chrono::nanoseconds get_step() const;
+
+    // Number of steps taken since the construction
+    std::uint64_t get_step_count() const;
+
+    // Number of steps dropped by the cap since the construction
+    std::uint64_t get_dropped_count() const;
+
+    // Forget the accumulated time and count again from `p_now`
+    // Use after a pause, instead of catching up or dropping steps
+    void reset(const t_clock::time_point p_now = t_clock::now());
+
+private:
+    // Time simulated by a step
+    std::chrono::nanoseconds m_step{ 0 };
+
+    // Most steps taken by a call to `advance`
+    std::size_t m_max_steps = s_default_max_steps;
+
+    // Time of the previous call to `advance`
+    t_clock::time_point m_last;
+
+    // Time elapsed and not simulated yet, less than a step between calls
+    std::chrono::nanoseconds m_accumulator{ 0 };
+
+    std::uint64_t m_step_count = 0;
+    std::uint64_t m_dropped_count = 0;
+
+};  // class fixed_timestep
+
+
+// Call `p_update(get_step())` for every step due at `p_now`
+// Returns the number of steps run
+template<class Update>
+std::size_t fixed_timestep::update(Update&& p_update, const t_clock::time_point p_now)
+{
+    const auto steps = advance(p_now);
+    for (std::size_t i = 0; i < steps; ++i)
+    {
+        p_update(m_step);
+    }
+    return steps;
+}
+
+}   // namespace procloop
+}   // namespace rf
+}   // namespace ft
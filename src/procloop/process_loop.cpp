@@ -7,6 +7,9 @@
 // ft_base_lib headers
 #include "error/ft_assert.h"
 
+// standard headers
+#include <utility>
+
 // Destructor
 // Joins the worker thread
 ft::rf::procloop::process_loop::~process_loop()
@@ -33,6 +36,96 @@ void ft::rf::procloop::process_loop::run_loop(
 }
 
 
+// The calling thread will dispatch this process loop's messages
+//  itself with `pump`, never blocking in the loop
+// `p_render_frame` must have been created by the calling thread
+void ft::rf::procloop::process_loop::attach(render_frame_impl& p_render_frame)
+{
+    FT_ASSERT(m_impl == nullptr);
+
+    m_impl.reset(new process_loop_impl());
+    m_impl->attach(p_render_frame.native_handle());
+}
+
+
+// Dispatch every pending message without blocking
+// Only called by the thread that attached the loop
+// Returns false once the loop was stopped
+bool ft::rf::procloop::process_loop::pump()
+{
+    FT_ASSERT(m_impl != nullptr);
+    return m_impl->pump();
+}
+
+
+// Block until messages arrive, `wake` is called, one of `p_handles`
+//  is signaled or `p_timeout` elapses, without dispatching anything
+// Waits forever without a timeout
+// Only called by the thread that attached the loop
+ft::rf::procloop::process_loop::t_wait_result ft::rf::procloop::process_loop::wait(
+    std::span<const t_wait_handle> p_handles,
+    const std::optional<std::chrono::milliseconds> p_timeout)
+{
+    FT_ASSERT(m_impl != nullptr);
+    FT_ASSERT(p_handles.size() <= s_max_wait_handles);
+    return m_impl->wait(p_handles, p_timeout);
+}
+
+
+// Make a `wait` in progress, or the next one, return
+// Can be called from any thread
+void ft::rf::procloop::process_loop::wake() noexcept
+{
+    if (m_impl != nullptr) {
+        m_impl->wake();
+    }
+}
+
+
+// Handle signaled by `wake`, for reactors waiting on their own
+// Such reactors must also watch the thread's message queue
+ft::rf::procloop::process_loop::t_wait_handle ft::rf::procloop::process_loop::get_wake_handle() const
+{
+    FT_ASSERT(m_impl != nullptr);
+    return m_impl->get_wake_handle();
+}
+
+
+// Call `p_callback` once, `p_delay` from now
+// Can be called from any thread, the callback runs on the loop's thread
+// Returns an id for `cancel_timer`
+ft::rf::procloop::process_loop::t_timer_id ft::rf::procloop::process_loop::add_timer(
+    const std::chrono::nanoseconds p_delay,
+    std::function<void()> p_callback)
+{
+    FT_ASSERT(m_impl != nullptr);
+    return m_impl->add_timer(p_delay, std::chrono::nanoseconds{ 0 }, std::move(p_callback));
+}
+
+
+// Call `p_callback` every `p_period`, the first time one period from now
+// Periods missed while the loop was busy are skipped, not run back to back
+// Can be called from any thread, the callback runs on the loop's thread
+// Returns an id for `cancel_timer`
+ft::rf::procloop::process_loop::t_timer_id ft::rf::procloop::process_loop::add_periodic_timer(
+    const std::chrono::nanoseconds p_period,
+    std::function<void()> p_callback)
+{
+    FT_ASSERT(m_impl != nullptr);
+    FT_ASSERT(p_period > std::chrono::nanoseconds{ 0 });
+    return m_impl->add_timer(p_period, p_period, std::move(p_callback));
+}
+
+
+// Stop a timer, a callback already running completes
+// Returns false if the timer doesn't exist or was a one-shot timer that already ran
+bool ft::rf::procloop::process_loop::cancel_timer(const t_timer_id p_id)
+{
+    FT_ASSERT(m_impl != nullptr);
+    return m_impl->cancel_timer(p_id);
+}
+
+
 // Deleter for unique_ptr to forward declared type
 void ft::rf::procloop::process_loop::impl_deleter::operator()(process_loop_impl* p_ptr)
 {
@@ -1,8 +1,26 @@
 #pragma once
 
+// Dispatches a render frame's window messages
+//
+// By default a worker thread blocks in `run_loop` until the loop is stopped
+// A thread already running a reactor can instead `attach` the loop and
+//  dispatch the messages itself : `wait` blocks until messages arrive,
+//  another thread calls `wake` or one of the reactor's own handles is
+//  signaled, and `pump` dispatches the pending messages without blocking
+//
+// Timers run on the thread dispatching the messages, from `run_loop` or
+//  `pump`, and are scheduled on the monotonic clock with a high-resolution
+//  waitable timer where the system has one
+
 // standard headers
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <future>
 #include <memory>
+#include <optional>
+#include <span>
 
 namespace ft {
 namespace rf {
@@ -17,6 +35,32 @@ class process_loop_impl;
 
 class process_loop final
 {
+public:
+    // Native handle a thread can wait on, a HANDLE on Windows
+    using t_wait_handle = void*;
+
+    // Why `wait` returned
+    struct t_wait_result {
+        enum class t_reason {
+            messages,   // Messages are waiting for `pump`
+            woken,      // `wake` was called, or an asynchronous procedure call ran
+            handle,     // One of the handles passed to `wait` is signaled
+            timers,     // Timers are due, `pump` runs them
+            timeout
+        };
+
+        t_reason reason = t_reason::timeout;
+
+        // Index of the signaled handle, for `t_reason::handle`
+        std::size_t handle = 0;
+    };
+
+    // Most handles `wait` accepts besides its own
+    static constexpr std::size_t s_max_wait_handles = 61;
+
+    // Identifies a timer, 0 is never used
+    using t_timer_id = std::uint64_t;
+
 public:
     // Constructor
     process_loop() = default;
@@ -39,6 +83,51 @@ public:
         render_frame_impl& p_render_frame,
         std::promise<void> & p_ready_to_start);
 
+    // The calling thread will dispatch this process loop's messages
+    //  itself with `pump`, never blocking in the loop
+    // `p_render_frame` must have been created by the calling thread
+    void attach(render_frame_impl& p_render_frame);
+
+    // Dispatch every pending message without blocking
+    // Only called by the thread that attached the loop
+    // Returns false once the loop was stopped
+    bool pump();
+
+    // Block until messages arrive, `wake` is called, one of `p_handles`
+    //  is signaled or `p_timeout` elapses, without dispatching anything
+    // Waits forever without a timeout
+    // Only called by the thread that attached the loop
+    t_wait_result wait(
+        std::span<const t_wait_handle> p_handles = {},
+        const std::optional<std::chrono::milliseconds> p_timeout = std::nullopt);
+
+    // Make a `wait` in progress, or the next one, return
+    // Can be called from any thread
+    void wake() noexcept;
+
+    // Handle signaled by `wake`, for reactors waiting on their own
+    // Such reactors must also watch the thread's message queue
+    t_wait_handle get_wake_handle() const;
+
+    // Call `p_callback` once, `p_delay` from now
+    // Can be called from any thread, the callback runs on the loop's thread
+    // Returns an id for `cancel_timer`
+    t_timer_id add_timer(
+        const std::chrono::nanoseconds p_delay,
+        std::function<void()> p_callback);
+
+    // Call `p_callback` every `p_period`, the first time one period from now
+    // Periods missed while the loop was busy are skipped, not run back to back
+    // Can be called from any thread, the callback runs on the loop's thread
+    // Returns an id for `cancel_timer`
+    t_timer_id add_periodic_timer(
+        const std::chrono::nanoseconds p_period,
+        std::function<void()> p_callback);
+
+    // Stop a timer, a callback already running completes
+    // Returns false if the timer doesn't exist or was a one-shot timer that already ran
+    bool cancel_timer(const t_timer_id p_id);
+
 private:
     // process_loop_impl deleter
     struct impl_deleter {
@@ -5,9 +5,62 @@
 #include "base/platform.h"
 #include "error/ft_assert.h"
 
+// standard headers
+#include <algorithm>
+#include <iterator>
+#include <ratio>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
 
 #ifdef FT_OS_WINDOWS
 
+namespace {
+
+// Wakes up within a fraction of a millisecond instead of on the next
+//  system tick, from Windows 10 version 1803
+// Not defined by older SDKs
+constexpr ::DWORD g_timer_high_resolution = 0x00000002;
+
+// Close the wake event or the timer
+void close_event(::HANDLE & p_event)
+{
+    ::CloseHandle(p_event);
+}
+
+}   // anonymous namespace
+
+
+// Constructor
+// Creates the wake event and the timer
+ft::rf::procloop::process_loop_impl::process_loop_impl()
+{
+    auto event = ::CreateEventA(
+        nullptr,    // Default security
+        FALSE,      // Auto-reset, a wait consumes the wake
+        FALSE,      // Not signaled
+        nullptr);   // Unnamed
+    if (event == nullptr)
+    {
+        throw std::runtime_error("Failed to create the process loop's wake event");
+    }
+    m_wake_event = { event, close_event };
+
+    // Older systems reject the high resolution flag, use a regular timer there
+    auto timer = ::CreateWaitableTimerExW(nullptr, nullptr, g_timer_high_resolution, TIMER_ALL_ACCESS);
+    if (timer == nullptr)
+    {
+        timer = ::CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    }
+    if (timer == nullptr)
+    {
+        throw std::runtime_error("Failed to create the process loop's timer");
+    }
+    m_timer = { timer, close_event };
+}
+
+
 // The calling thread will run this processing loop
 // It will only return when `stop()` is called
 // Sets the `p_ready` promise once the worker has started the loop
@@ -19,25 +72,23 @@ void ft::rf::procloop::process_loop_impl::run_loop(
     // Save the thread's handle
     m_worker_handle = GetCurrentThreadId();
 
-    ::MSG msg;
-    ::BOOL result;
-
     p_ready.set_value();
 
-    // Loop based on the example here :
-    //  https://docs.microsoft.com/en-us/windows/win32/api/winuser/nf-winuser-getmessagea
-    while ((result = ::GetMessageA(&msg, nullptr, 0, 0)) != 0)
+    // Sleep until messages arrive or a timer is due, `pump` returns false
+    //  once `stop()` posts WM_QUIT
+    const ::HANDLE handles[] = { m_wake_event, m_timer };
+    while (pump())
     {
-        if (result < 0)
+        const auto status = ::MsgWaitForMultipleObjectsEx(
+            static_cast<::DWORD>(std::size(handles)),
+            handles,
+            INFINITE,
+            QS_ALLINPUT,
+            MWMO_INPUTAVAILABLE | MWMO_ALERTABLE);
+        if (status == WAIT_FAILED)
         {
-            // Failed to get the next message
             break;
         }
-        else
-        {
-            ::TranslateMessage(&msg);
-            ::DispatchMessageA(&msg);
-        }
     }
 }
 
@@ -46,10 +97,217 @@ void ft::rf::procloop::process_loop_impl::run_loop(
     // Does nothing if no worker thread is running
 void ft::rf::procloop::process_loop_impl::stop() noexcept
 {
-    if (m_worker_handle.has_value())
+    if (m_attached)
+    {
+        // The thread keeps running, a WM_QUIT left in its queue would
+        //  end its other message loops
+        m_stopped = true;
+        wake();
+    }
+    else if (m_worker_handle.has_value())
     {
         ::PostThreadMessageA(m_worker_handle.value(), WM_QUIT, 0, 0);
     }
 }
 
+
+// The calling thread will dispatch the messages itself with `pump`
+void ft::rf::procloop::process_loop_impl::attach(const ::HWND)
+{
+    FT_ASSERT(m_worker_handle.has_value() == false);
+
+    m_worker_handle = GetCurrentThreadId();
+    m_attached = true;
+}
+
+
+// Run the timers due, then dispatch every pending message without blocking
+// Returns false once WM_QUIT was received
+bool ft::rf::procloop::process_loop_impl::pump()
+{
+    FT_ASSERT(m_worker_handle == GetCurrentThreadId());
+
+    if (m_stopped == false)
+    {
+        m_timers.run(timer_queue::t_clock::now());
+
+        // Set the timer again even if the earliest due time didn't change,
+        //  it may have fired slightly ahead of the monotonic clock
+        m_armed.make_lock()->reset();
+        arm_timer();
+    }
+
+    ::MSG msg;
+    while (m_stopped == false && ::PeekMessageA(&msg, nullptr, 0, 0, PM_REMOVE) != FALSE)
+    {
+        if (msg.message == WM_QUIT)
+        {
+            m_stopped = true;
+            break;
+        }
+        ::TranslateMessage(&msg);
+        ::DispatchMessageA(&msg);
+    }
+    return m_stopped == false;
+}
+
+
+// Block until messages arrive, `wake` is called, one of `p_handles`
+//  is signaled or `p_timeout` elapses
+ft::rf::procloop::process_loop::t_wait_result ft::rf::procloop::process_loop_impl::wait(
+    std::span<const process_loop::t_wait_handle> p_handles,
+    const std::optional<std::chrono::milliseconds> p_timeout)
+{
+    using t_reason = process_loop::t_wait_result::t_reason;
+
+    FT_ASSERT(m_worker_handle == GetCurrentThreadId());
+
+    auto result = process_loop::t_wait_result{};
+    // The next `pump` reports the stop
+    if (m_stopped)
+    {
+        result.reason = t_reason::woken;
+        return result;
+    }
+
+    // Timers already due, the waitable timer may have been consumed
+    //  by a wait that returned for another reason
+    const auto next_due = m_timers.get_next_due();
+    if (next_due.has_value() && next_due.value() <= timer_queue::t_clock::now())
+    {
+        result.reason = t_reason::timers;
+        return result;
+    }
+
+    // The wake event and the timer go first, the caller's handles after them
+    auto handles = std::vector<::HANDLE>{};
+    handles.reserve(p_handles.size() + 2);
+    handles.push_back(m_wake_event);
+    handles.push_back(m_timer);
+    handles.insert(handles.end(), p_handles.begin(), p_handles.end());
+
+    auto timeout = ::DWORD{ INFINITE };
+    if (p_timeout.has_value())
+    {
+        const auto milliseconds = std::max<std::chrono::milliseconds::rep>(p_timeout->count(), 0);
+        timeout = static_cast<::DWORD>(std::min<std::chrono::milliseconds::rep>(milliseconds, INFINITE - 1));
+    }
+
+    // Messages already seen by a previous peek still wake the thread,
+    //  and asynchronous procedure calls run during the wait
+    const auto status = ::MsgWaitForMultipleObjectsEx(
+        static_cast<::DWORD>(handles.size()),
+        handles.data(),
+        timeout,
+        QS_ALLINPUT,
+        MWMO_INPUTAVAILABLE | MWMO_ALERTABLE);
+
+    if (status == WAIT_OBJECT_0 || status == WAIT_IO_COMPLETION)
+    {
+        result.reason = t_reason::woken;
+    }
+    else if (status == WAIT_OBJECT_0 + 1)
+    {
+        result.reason = t_reason::timers;
+    }
+    else if (status > WAIT_OBJECT_0 + 1 && status < WAIT_OBJECT_0 + handles.size())
+    {
+        result.reason = t_reason::handle;
+        result.handle = status - WAIT_OBJECT_0 - 2;
+    }
+    else if (status == WAIT_OBJECT_0 + handles.size())
+    {
+        result.reason = t_reason::messages;
+    }
+    else if (status > WAIT_ABANDONED_0 + 1 && status < WAIT_ABANDONED_0 + handles.size())
+    {
+        // An abandoned mutex is still acquired, report it as signaled
+        result.reason = t_reason::handle;
+        result.handle = status - WAIT_ABANDONED_0 - 2;
+    }
+    else if (status == WAIT_TIMEOUT)
+    {
+        result.reason = t_reason::timeout;
+    }
+    else
+    {
+        throw std::runtime_error("Failed to wait for the process loop's messages");
+    }
+    return result;
+}
+
+
+// Signal the wake event
+void ft::rf::procloop::process_loop_impl::wake() noexcept
+{
+    ::SetEvent(m_wake_event);
+}
+
+
+// Get the wake event
+::HANDLE ft::rf::procloop::process_loop_impl::get_wake_handle() const
+{
+    return m_wake_event;
+}
+
+
+// Call `p_callback` after `p_delay`, then every `p_period` if it is positive
+ft::rf::procloop::timer_queue::t_id ft::rf::procloop::process_loop_impl::add_timer(
+    const std::chrono::nanoseconds p_delay,
+    const std::chrono::nanoseconds p_period,
+    std::function<void()> p_callback)
+{
+    const auto due = timer_queue::t_clock::now() + std::max(p_delay, std::chrono::nanoseconds{ 0 });
+    const auto id = m_timers.add(due, p_period, std::move(p_callback));
+
+    // The waitable timer can be set from any thread, the loop's thread
+    //  doesn't need to wake up to pick up the new due time
+    arm_timer();
+    return id;
+}
+
+
+// Stop a timer
+bool ft::rf::procloop::process_loop_impl::cancel_timer(const timer_queue::t_id p_id)
+{
+    // The waitable timer stays set, the loop's thread wakes up for nothing
+    //  at worst and sets it again
+    return m_timers.cancel(p_id);
+}
+
+
+// Set the waitable timer to the earliest due timer, or cancel it
+void ft::rf::procloop::process_loop_impl::arm_timer()
+{
+    auto armed = m_armed.make_lock();
+
+    // Read under the lock, so the last thread to set the timer saw the latest timers
+    const auto next_due = m_timers.get_next_due();
+    if (next_due == *armed)
+    {
+        return;
+    }
+
+    if (next_due.has_value() == false)
+    {
+        ::CancelWaitableTimer(m_timer);
+        *armed = std::nullopt;
+        return;
+    }
+
+    // Negative due times are relative, in 100 nanosecond units
+    // Relative times follow the monotonic clock, absolute ones the wall clock
+    using t_ticks = std::chrono::duration<::LONGLONG, std::ratio<1, 10'000'000>>;
+    const auto delay = std::chrono::ceil<t_ticks>(next_due.value() - timer_queue::t_clock::now());
+
+    ::LARGE_INTEGER due_time;
+    due_time.QuadPart = -std::max<::LONGLONG>(delay.count(), 1);
+    if (::SetWaitableTimer(m_timer, &due_time, 0, nullptr, nullptr, FALSE) == FALSE)
+    {
+        *armed = std::nullopt;
+        return;
+    }
+    *armed = next_due;
+}
+
 #endif  // FT_OS_WINDOWS
@@ -1,12 +1,22 @@
 #pragma once
 
+// project headers
+#include "process_loop.h"
+#include "timer_queue.h"
+
 // ft_base_lib headers
 #include "base/platform.h"
 #include "base/windows_include.h"
+#include "handle/ressource_handle.hpp"
+#include "thread/lockable.h"
 
 // standard headers
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <optional>
 #include <future>
+#include <span>
 
 #ifdef FT_OS_WINDOWS
 
@@ -17,19 +27,75 @@ namespace procloop {
 class process_loop_impl
 {
 public:
+    // Constructor
+    // Creates the wake event and the timer
+    process_loop_impl();
+
     // The calling thread will run this processing loop
     // It will only return when `stop()` is called
     // Sets the `p_ready` promise once the worker has started the loop
     void run_loop(const ::HWND p_window, std::promise<void> & p_ready);
 
+    // The calling thread will dispatch the messages itself with `pump`
+    void attach(const ::HWND p_window);
+
+    // Run the timers due, then dispatch every pending message without blocking
+    // Returns false once WM_QUIT was received
+    bool pump();
+
+    // Block until messages arrive, `wake` is called, one of `p_handles`
+    //  is signaled or `p_timeout` elapses
+    process_loop::t_wait_result wait(
+        std::span<const process_loop::t_wait_handle> p_handles,
+        const std::optional<std::chrono::milliseconds> p_timeout);
+
+    // Signal the wake event
+    void wake() noexcept;
+
+    // Get the wake event
+    ::HANDLE get_wake_handle() const;
+
+    // Call `p_callback` after `p_delay`, then every `p_period` if it is positive
+    timer_queue::t_id add_timer(
+        const std::chrono::nanoseconds p_delay,
+        const std::chrono::nanoseconds p_period,
+        std::function<void()> p_callback);
+
+    // Stop a timer
+    bool cancel_timer(const timer_queue::t_id p_id);
+
     // End the worker thread
     // Does nothing if no worker thread is running
+    // An attached loop's `pump` returns false from then on
     void stop() noexcept;
 
+private:
+    // Set the waitable timer to the earliest due timer, or cancel it
+    void arm_timer();
+
 private:
     // Native thread handle to the thread currently running this process loop
     std::optional<DWORD> m_worker_handle;
 
+    // Auto-reset event signaled by `wake`
+    base::handle::ressource_handle<::HANDLE, nullptr> m_wake_event;
+
+    // Timers run by `pump`
+    timer_queue m_timers;
+
+    // Auto-reset waitable timer, signaled when the earliest timer is due
+    base::handle::ressource_handle<::HANDLE, nullptr> m_timer;
+
+    // Due time the waitable timer is set to, if it is set
+    // Also serializes the calls setting the waitable timer
+    base::thread::lockable<std::optional<timer_queue::t_clock::time_point>> m_armed;
+
+    // Are the messages dispatched by `pump` instead of `run_loop`?
+    bool m_attached = false;
+
+    // Was the attached loop stopped, or WM_QUIT received by `pump`?
+    std::atomic<bool> m_stopped = false;
+
 };  // class process_loop_impl
 
 }   // namespace procloop
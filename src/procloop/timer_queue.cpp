@@ -0,0 +1,166 @@
+#include "timer_queue.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Heaps smaller than this are never compacted, their cancelled timers
+//  cost little
+constexpr std::size_t g_compact_min_size = 64;
+
+}   // anonymous namespace
+
+
+// Call `p_callback` once `p_due` is reached
+// If `p_period` is positive, call it again every `p_period` after that
+ft::rf::procloop::timer_queue::t_id ft::rf::procloop::timer_queue::add(
+    const t_clock::time_point p_due,
+    const std::chrono::nanoseconds p_period,
+    t_callback p_callback)
+{
+    FT_ASSERT(p_callback != nullptr);
+
+    auto state = m_state.make_lock();
+    const auto id = state->next_id++;
+
+    auto timer = t_timer{};
+    timer.period = std::max(p_period, std::chrono::nanoseconds{ 0 });
+    timer.callback = std::make_shared<t_callback>(std::move(p_callback));
+    state->timers.emplace(id, std::move(timer));
+
+    state->heap.push_back({ p_due, id });
+    std::push_heap(state->heap.begin(), state->heap.end(), &is_later);
+    return id;
+}
+
+
+// Stop a timer
+// A callback already running completes
+// Returns false if the timer doesn't exist or was a one-shot timer that already ran
+bool ft::rf::procloop::timer_queue::cancel(const t_id p_id)
+{
+    auto state = m_state.make_lock();
+    if (state->timers.erase(p_id) == 0)
+    {
+        return false;
+    }
+
+    // Keep the top valid so `get_next_due` doesn't report a cancelled timer
+    drop_cancelled(*state);
+    compact(*state);
+    return true;
+}
+
+
+// Run the timers due at `p_now`, in order of due time
+// Periodic timers keep their phase : periods missed entirely are
+//  skipped instead of being run back to back
+// Returns the number of callbacks run
+std::size_t ft::rf::procloop::timer_queue::run(const t_clock::time_point p_now)
+{
+    auto count = std::size_t{ 0 };
+    while (true)
+    {
+        std::shared_ptr<t_callback> callback;
+        {
+            auto state = m_state.make_lock();
+            drop_cancelled(*state);
+            if (state->heap.empty() || state->heap.front().due > p_now)
+            {
+                break;
+            }
+
+            std::pop_heap(state->heap.begin(), state->heap.end(), &is_later);
+            auto entry = state->heap.back();
+            state->heap.pop_back();
+
+            auto timer = state->timers.find(entry.id);
+            callback = timer->second.callback;
+
+            const auto period = timer->second.period;
+            if (period > std::chrono::nanoseconds{ 0 })
+            {
+                const auto missed = (p_now - entry.due) / period;
+                entry.due += period * (missed + 1);
+                state->heap.push_back(entry);
+                std::push_heap(state->heap.begin(), state->heap.end(), &is_later);
+            }
+            else
+            {
+                state->timers.erase(timer);
+            }
+        }
+
+        // Unlocked, the callback can add or cancel timers
+        (*callback)();
+        ++count;
+    }
+    return count;
+}
+
+
+// When the earliest timer is due, if there is one
+std::optional<ft::rf::procloop::timer_queue::t_clock::time_point>
+ft::rf::procloop::timer_queue::get_next_due() const
+{
+    auto state = m_state.make_lock();
+    if (state->heap.empty())
+    {
+        return std::nullopt;
+    }
+    return state->heap.front().due;
+}
+
+
+// Number of timers waiting
+std::size_t ft::rf::procloop::timer_queue::get_count() const
+{
+    return m_state.make_lock()->timers.size();
+}
+
+
+// Order of the heap, the earliest due time at the top
+// Timers due at the same time run in the order they were added
+bool ft::rf::procloop::timer_queue::is_later(const t_entry & p_lhs, const t_entry & p_rhs)
+{
+    if (p_lhs.due != p_rhs.due)
+    {
+        return p_lhs.due > p_rhs.due;
+    }
+    return p_lhs.id > p_rhs.id;
+}
+
+
+// Remove the cancelled timers at the top of the heap
+void ft::rf::procloop::timer_queue::drop_cancelled(t_state & p_state)
+{
+    while (p_state.heap.empty() == false && p_state.timers.contains(p_state.heap.front().id) == false)
+    {
+        std::pop_heap(p_state.heap.begin(), p_state.heap.end(), &is_later);
+        p_state.heap.pop_back();
+    }
+}
+
+
+// Remove every cancelled timer and rebuild the heap, if they make up
+//  most of it
+// Rebuilding is linear and happens after at least as many cancellations,
+//  a constant cost per cancellation
+void ft::rf::procloop::timer_queue::compact(t_state & p_state)
+{
+    const auto cancelled = p_state.heap.size() - p_state.timers.size();
+    if (p_state.heap.size() < g_compact_min_size || cancelled * 2 <= p_state.heap.size())
+    {
+        return;
+    }
+
+    std::erase_if(p_state.heap, [&p_state](const t_entry & p_entry) {
+        return p_state.timers.contains(p_entry.id) == false;
+    });
+    std::make_heap(p_state.heap.begin(), p_state.heap.end(), &is_later);
+}
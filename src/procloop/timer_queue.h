@@ -0,0 +1,107 @@
+#pragma once
+
+// One-shot and periodic timers on the monotonic clock
+//
+// Timers are kept in a min-heap ordered by due time, cancelled timers are
+//  dropped lazily when they reach the top, or all at once when they make
+//  up most of the heap
+// Timers can be added and cancelled from any thread, they are run by
+//  the thread calling `run`, without the queue locked so callbacks can
+//  add and cancel timers
+
+// other projects
+#include "thread/lockable.h"
+
+// standard headers
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace procloop {
+
+class timer_queue
+{
+public:
+    using t_clock = std::chrono::steady_clock;
+
+    // Identifies a timer, 0 is never used
+    using t_id = std::uint64_t;
+
+    using t_callback = std::function<void()>;
+
+public:
+    // Call `p_callback` once `p_due` is reached
+    // If `p_period` is positive, call it again every `p_period` after that
+    t_id add(
+        const t_clock::time_point p_due,
+        const std::chrono::nanoseconds p_period,
+        t_callback p_callback);
+
+    // Stop a timer
+    // A callback already running completes
+    // Returns false if the timer doesn't exist or was a one-shot timer that already ran
+    bool cancel(const t_id p_id);
+
+    // Run the timers due at `p_now`, in order of due time
+    // Periodic timers keep their phase : periods missed entirely are
+    //  skipped instead of being run back to back
+    // Returns the number of callbacks run
+    std::size_t run(const t_clock::time_point p_now);
+
+    // When the earliest timer is due, if there is one
+    std::optional<t_clock::time_point> get_next_due() const;
+
+    // Number of timers waiting
+    std::size_t get_count() const;
+
+private:
+    // Position of a timer in the heap
+    struct t_entry {
+        t_clock::time_point due;
+        t_id id;
+    };
+
+    struct t_timer {
+        std::chrono::nanoseconds period{ 0 };
+
+        // Shared with a run in progress, which may outlive the timer
+        std::shared_ptr<t_callback> callback;
+    };
+
+    struct t_state {
+        // Min-heap on due time, may hold cancelled timers
+        // Every timer not cancelled has exactly one entry
+        std::vector<t_entry> heap;
+
+        // Timers not cancelled
+        std::unordered_map<t_id, t_timer> timers;
+
+        t_id next_id = 1;
+    };
+
+    // Order of the heap, the earliest due time at the top
+    // Timers due at the same time run in the order they were added
+    static bool is_later(const t_entry& p_lhs, const t_entry& p_rhs);
+
+    // Remove the cancelled timers at the top of the heap
+    static void drop_cancelled(t_state& p_state);
+
+    // Remove every cancelled timer and rebuild the heap, if they make up
+    //  most of it
+    static void compact(t_state& p_state);
+
+private:
+    mutable base::thread::lockable<t_state> m_state;
+
+};  // class timer_queue
+
+}   // namespace procloop
+}   // namespace rf
+}   // namespace ft
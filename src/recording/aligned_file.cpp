@@ -0,0 +1,117 @@
+#include "aligned_file.h"
+#include "aligned_file_impl.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+
+// Constructor
+// Creates or replaces the file at `p_path`
+ft::rf::recording::aligned_file::aligned_file(
+    const std::filesystem::path & p_path,
+    const bool p_unbuffered,
+    const std::size_t p_buffer_size) :
+    m_impl{ new aligned_file_impl(p_path, p_unbuffered) },
+    m_capacity{ std::max((p_buffer_size + s_alignment - 1) / s_alignment * s_alignment, s_alignment) }
+{
+    m_buffer.reset(static_cast<std::byte*>(
+        ::operator new(m_capacity, std::align_val_t{ s_alignment })));
+}
+
+
+// Destructor
+// Closes the file, errors are ignored
+ft::rf::recording::aligned_file::~aligned_file()
+{
+    try {
+        close();
+    }
+    catch (...) {}
+}
+
+
+// Append `p_size` bytes
+void ft::rf::recording::aligned_file::write(const void * p_data, const std::size_t p_size)
+{
+    FT_ASSERT(m_impl != nullptr);
+
+    auto* data = static_cast<const std::byte*>(p_data);
+    auto remaining = p_size;
+    while (remaining > 0)
+    {
+        const auto count = std::min(remaining, m_capacity - m_used);
+        std::memcpy(m_buffer.get() + m_used, data, count);
+        m_used += count;
+        data += count;
+        remaining -= count;
+
+        if (m_used == m_capacity)
+        {
+            flush_blocks();
+        }
+    }
+    m_size += p_size;
+}
+
+
+// Write the buffered data and close the file
+void ft::rf::recording::aligned_file::close()
+{
+    if (m_impl == nullptr)
+    {
+        return;
+    }
+
+    // Pad the last block, the padding is then cut off
+    if (m_used > 0)
+    {
+        const auto padded = (m_used + s_alignment - 1) / s_alignment * s_alignment;
+        std::memset(m_buffer.get() + m_used, 0, padded - m_used);
+        m_impl->write(m_buffer.get(), padded);
+        m_used = 0;
+    }
+    m_impl->set_size(m_size);
+
+    m_impl.reset();
+}
+
+
+// Number of bytes written so far
+std::uint64_t ft::rf::recording::aligned_file::get_size() const
+{
+    return m_size;
+}
+
+
+// Write the full blocks of the buffer, keeping the remainder
+void ft::rf::recording::aligned_file::flush_blocks()
+{
+    const auto blocks = m_used / s_alignment * s_alignment;
+    if (blocks == 0)
+    {
+        return;
+    }
+
+    m_impl->write(m_buffer.get(), blocks);
+    std::memmove(m_buffer.get(), m_buffer.get() + blocks, m_used - blocks);
+    m_used -= blocks;
+}
+
+
+// Buffer deleter
+void ft::rf::recording::aligned_file::buffer_deleter::operator()(std::byte* p_ptr)
+{
+    ::operator delete(p_ptr, std::align_val_t{ s_alignment });
+}
+
+
+// Deleter for unique_ptr to forward declared type
+void ft::rf::recording::aligned_file::impl_deleter::operator()(aligned_file_impl* p_ptr)
+{
+    delete p_ptr;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+// Sequential file writer going through a large aligned buffer
+// The buffer is only written out in full, aligned blocks so the file can
+//  be opened without the operating system's cache
+// The padding added to the last block is cut off by `close`
+
+// standard headers
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+
+namespace ft {
+namespace rf {
+namespace recording {
+
+// Platform-dependent component of this class
+class aligned_file_impl;
+
+class aligned_file final
+{
+public:
+    // Raised when the file can't be opened or written
+    struct t_except_io : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    // Alignment of the buffer and of every write
+    // A multiple of the sector size of common disks
+    static constexpr std::size_t s_alignment = 4096;
+
+    // Default size of the buffer
+    static constexpr std::size_t s_default_buffer_size = 8 * 1024 * 1024;
+
+public:
+    // Constructor
+    // Creates or replaces the file at `p_path`
+    // If `p_unbuffered` is true the writes bypass the operating system's cache
+    // `p_buffer_size` is rounded up to a multiple of `s_alignment`
+    aligned_file(
+        const std::filesystem::path& p_path,
+        const bool p_unbuffered,
+        const std::size_t p_buffer_size = s_default_buffer_size);
+
+    // Destructor
+    // Closes the file, errors are ignored
+    ~aligned_file();
+
+    // Not copiable
+    aligned_file(const aligned_file&) = delete;
+    void operator=(const aligned_file&) = delete;
+
+    // Append `p_size` bytes
+    void write(const void* p_data, const std::size_t p_size);
+
+    // Write the buffered data and close the file
+    void close();
+
+    // Number of bytes written so far
+    std::uint64_t get_size() const;
+
+private:
+    // Write the full blocks of the buffer, keeping the remainder
+    void flush_blocks();
+
+    // Buffer deleter
+    struct buffer_deleter {
+        void operator()(std::byte*);
+    };
+
+    // aligned_file_impl deleter
+    struct impl_deleter {
+        void operator()(aligned_file_impl*);
+    };
+
+private:
+    // Holds the actual implementation
+    std::unique_ptr<aligned_file_impl, impl_deleter> m_impl;
+
+    // Aligned buffer
+    std::unique_ptr<std::byte, buffer_deleter> m_buffer;
+    std::size_t m_capacity = 0;
+    std::size_t m_used = 0;
+
+    // Number of bytes written so far, including the buffered ones
+    std::uint64_t m_size = 0;
+
+};  // class aligned_file
+
+}   // namespace recording
+}   // namespace rf
+}   // namespace ft
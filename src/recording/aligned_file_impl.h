@@ -0,0 +1,13 @@
+#pragma once
+
+// Platform agnostic header for the platform-dependent component
+//  of aligned_file
+
+// ft_base_lib headers
+#include "base/platform.h"
+
+#ifdef FT_OS_WINDOWS
+    #include "aligned_file_impl_win32.h"
+#else
+    #error Unsupported platform
+#endif
@@ -0,0 +1,73 @@
+#include "aligned_file_impl_win32.h"
+#include "aligned_file.h"
+
+// standard headers
+#include <algorithm>
+
+#ifdef FT_OS_WINDOWS
+
+// Create or replace a file
+// Unbuffered files require aligned addresses and sizes
+ft::rf::recording::aligned_file_impl::aligned_file_impl(
+    const std::filesystem::path & p_path,
+    const bool p_unbuffered)
+{
+    const ::DWORD flags = p_unbuffered ?
+        FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH :
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN;
+
+    auto file = ::CreateFileA(
+        p_path.string().c_str(),
+        GENERIC_WRITE,
+        0,              // No sharing
+        nullptr,        // Default security
+        CREATE_ALWAYS,
+        flags,
+        nullptr);       // No template
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw aligned_file::t_except_io("Failed to create " + p_path.string());
+    }
+
+    m_file = { file, [](::HANDLE & p_file) {
+        ::CloseHandle(p_file);
+    } };
+}
+
+
+// Write `p_size` bytes at the end of the file
+void ft::rf::recording::aligned_file_impl::write(const void * p_data, const std::size_t p_size)
+{
+    // WriteFile takes 32 bit sizes
+    constexpr std::size_t max_write = 1u << 30;
+
+    auto* data = static_cast<const std::byte*>(p_data);
+    auto remaining = p_size;
+    while (remaining > 0)
+    {
+        const auto count = static_cast<::DWORD>(std::min(remaining, max_write));
+        ::DWORD written = 0;
+        if (::WriteFile(m_file, data, count, &written, nullptr) == FALSE || written != count)
+        {
+            throw aligned_file::t_except_io("Failed to write to file");
+        }
+        data += written;
+        remaining -= written;
+    }
+}
+
+
+// Cut the file to `p_size` bytes
+void ft::rf::recording::aligned_file_impl::set_size(const std::uint64_t p_size)
+{
+    ::FILE_END_OF_FILE_INFO info = {};
+    info.EndOfFile.QuadPart = static_cast<::LONGLONG>(p_size);
+
+    if (::SetFileInformationByHandle(m_file, FileEndOfFileInfo, &info, sizeof(info)) == FALSE)
+    {
+        throw aligned_file::t_except_io("Failed to set the file size");
+    }
+}
+
+#endif  // FT_OS_WINDOWS
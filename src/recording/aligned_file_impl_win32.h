@@ -0,0 +1,42 @@
+#pragma once
+
+// ft_base_lib headers
+#include "base/platform.h"
+#include "base/windows_include.h"
+#include "handle/ressource_handle.hpp"
+
+// standard headers
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#ifdef FT_OS_WINDOWS
+
+namespace ft {
+namespace rf {
+namespace recording {
+
+class aligned_file_impl
+{
+public:
+    // Create or replace a file
+    // Unbuffered files require aligned addresses and sizes
+    aligned_file_impl(const std::filesystem::path& p_path, const bool p_unbuffered);
+
+    // Write `p_size` bytes at the end of the file
+    void write(const void* p_data, const std::size_t p_size);
+
+    // Cut the file to `p_size` bytes
+    void set_size(const std::uint64_t p_size);
+
+private:
+    // File handle
+    base::handle::ressource_handle<::HANDLE, nullptr> m_file;
+
+};  // class aligned_file_impl
+
+}   // namespace recording
+}   // namespace rf
+}   // namespace ft
+
+#endif  // FT_OS_WINDOWS
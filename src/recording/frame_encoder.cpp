@@ -0,0 +1,267 @@
+#include "frame_encoder.h"
+
+// project headers
+#include "simd/pixel_kernels.h"
+
+// standard headers
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+// Row `p_row` of a top-down frame
+const std::uint8_t* get_row(const ft::rf::t_frame & p_frame, const int p_row)
+{
+    return p_frame.pixels + static_cast<std::size_t>(p_row) * p_frame.stride;
+}
+
+
+// CRC-32 used by PNG chunks
+constexpr auto g_crc_table = []() {
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i = 0; i < 256; ++i)
+    {
+        auto value = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            value = (value & 1) != 0 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+        }
+        table[i] = value;
+    }
+    return table;
+}();
+
+std::uint32_t update_crc(std::uint32_t p_crc, const std::uint8_t* p_data, const std::size_t p_size)
+{
+    for (std::size_t i = 0; i < p_size; ++i) {
+        p_crc = g_crc_table[(p_crc ^ p_data[i]) & 0xFF] ^ (p_crc >> 8);
+    }
+    return p_crc;
+}
+
+
+// Adler-32 used by zlib streams
+struct t_adler
+{
+    std::uint32_t a = 1;
+    std::uint32_t b = 0;
+
+    void update(const std::uint8_t* p_data, std::size_t p_size)
+    {
+        // Largest run before the sums can overflow
+        constexpr std::size_t max_run = 5552;
+        while (p_size > 0)
+        {
+            const auto run = std::min(p_size, max_run);
+            for (std::size_t i = 0; i < run; ++i)
+            {
+                a += p_data[i];
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+            p_data += run;
+            p_size -= run;
+        }
+    }
+
+    std::uint32_t value() const {
+        return (b << 16) | a;
+    }
+};
+
+
+// Big endian 32 bit value
+std::array<std::uint8_t, 4> big_endian(const std::uint32_t p_value)
+{
+    return {
+        static_cast<std::uint8_t>(p_value >> 24),
+        static_cast<std::uint8_t>(p_value >> 16),
+        static_cast<std::uint8_t>(p_value >> 8),
+        static_cast<std::uint8_t>(p_value)
+    };
+}
+
+
+// Writes a PNG chunk's data while computing its CRC
+class t_chunk_writer
+{
+public:
+    t_chunk_writer(ft::rf::recording::aligned_file & p_file, const char (&p_type)[5], const std::uint32_t p_size) :
+        m_file(p_file)
+    {
+        const auto size = big_endian(p_size);
+        m_file.write(size.data(), size.size());
+        write(reinterpret_cast<const std::uint8_t*>(p_type), 4);
+    }
+
+    void write(const std::uint8_t* p_data, const std::size_t p_size)
+    {
+        m_crc = update_crc(m_crc, p_data, p_size);
+        m_file.write(p_data, p_size);
+    }
+
+    void end()
+    {
+        const auto crc = big_endian(m_crc ^ 0xFFFFFFFFu);
+        m_file.write(crc.data(), crc.size());
+    }
+
+private:
+    ft::rf::recording::aligned_file & m_file;
+    std::uint32_t m_crc = 0xFFFFFFFFu;
+};
+
+}   // anonymous namespace
+
+
+// Raw RGBA8 frames back to back, without any header
+void ft::rf::recording::write_raw_frame(aligned_file & p_file, const t_frame & p_frame)
+{
+    const auto row_size = static_cast<std::size_t>(p_frame.width) * 4;
+    if (p_frame.stride == row_size)
+    {
+        p_file.write(p_frame.pixels, row_size * p_frame.height);
+        return;
+    }
+
+    for (int y = 0; y < p_frame.height; ++y)
+    {
+        p_file.write(get_row(p_frame, y), row_size);
+    }
+}
+
+
+// YUV4MPEG2 stream header, 4:4:4 chroma
+void ft::rf::recording::write_y4m_header(
+    aligned_file & p_file,
+    const int p_width,
+    const int p_height,
+    const int p_frame_rate)
+{
+    char header[128];
+    const auto length = std::snprintf(header, sizeof(header),
+        "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n",
+        p_width, p_height, p_frame_rate);
+    p_file.write(header, static_cast<std::size_t>(length));
+}
+
+
+// YUV4MPEG2 frame, BT.601 limited range
+// `p_scratch` is reused between frames to hold the planes
+void ft::rf::recording::write_y4m_frame(
+    aligned_file & p_file,
+    const t_frame & p_frame,
+    std::vector<std::uint8_t> & p_scratch)
+{
+    const auto plane_size = static_cast<std::size_t>(p_frame.width) * p_frame.height;
+    p_scratch.resize(plane_size * 3);
+    auto* y_plane = p_scratch.data();
+    auto* u_plane = y_plane + plane_size;
+    auto* v_plane = u_plane + plane_size;
+
+    // The planes are laid out like the pixels, packed frames convert at once
+    if (p_frame.stride == static_cast<std::size_t>(p_frame.width) * 4)
+    {
+        simd::rgba_to_yuv444(p_frame.pixels, y_plane, u_plane, v_plane, plane_size);
+    }
+    else
+    {
+        for (int y = 0; y < p_frame.height; ++y)
+        {
+            const auto offset = static_cast<std::size_t>(y) * p_frame.width;
+            simd::rgba_to_yuv444(
+                get_row(p_frame, y),
+                y_plane + offset,
+                u_plane + offset,
+                v_plane + offset,
+                static_cast<std::size_t>(p_frame.width));
+        }
+    }
+
+    constexpr char frame_header[] = "FRAME\n";
+    p_file.write(frame_header, sizeof(frame_header) - 1);
+    p_file.write(p_scratch.data(), p_scratch.size());
+}
+
+
+// Complete RGBA8 PNG image, stored without compression
+void ft::rf::recording::write_png(aligned_file & p_file, const t_frame & p_frame)
+{
+    constexpr std::uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    p_file.write(signature, sizeof(signature));
+
+    {   // Header : dimensions, 8 bits per channel, RGBA, no interlacing
+        auto chunk = t_chunk_writer{ p_file, "IHDR", 13 };
+        const auto width = big_endian(static_cast<std::uint32_t>(p_frame.width));
+        const auto height = big_endian(static_cast<std::uint32_t>(p_frame.height));
+        constexpr std::uint8_t format[] = { 8, 6, 0, 0, 0 };
+        chunk.write(width.data(), width.size());
+        chunk.write(height.data(), height.size());
+        chunk.write(format, sizeof(format));
+        chunk.end();
+    }
+
+    // Each row starts with its filter type, 0 for none
+    const auto row_size = static_cast<std::size_t>(p_frame.width) * 4;
+    const auto raw_size = (row_size + 1) * p_frame.height;
+
+    // zlib stream of stored deflate blocks
+    constexpr std::size_t max_block = 65535;
+    const auto block_count = std::max<std::size_t>((raw_size + max_block - 1) / max_block, 1);
+    const auto stream_size = 2 + raw_size + block_count * 5 + 4;
+
+    {
+        auto chunk = t_chunk_writer{ p_file, "IDAT", static_cast<std::uint32_t>(stream_size) };
+        constexpr std::uint8_t zlib_header[] = { 0x78, 0x01 };
+        chunk.write(zlib_header, sizeof(zlib_header));
+
+        auto adler = t_adler{};
+        auto block_left = std::size_t{ 0 };
+        auto raw_left = raw_size;
+
+        // Write raw bytes, starting a new block every `max_block` bytes
+        auto write_raw = [&](const std::uint8_t* p_data, std::size_t p_size) {
+            adler.update(p_data, p_size);
+            while (p_size > 0)
+            {
+                if (block_left == 0)
+                {
+                    block_left = std::min(raw_left, max_block);
+                    const auto length = static_cast<std::uint16_t>(block_left);
+                    const auto final_block = raw_left == block_left;
+                    const std::uint8_t block_header[] = {
+                        static_cast<std::uint8_t>(final_block ? 1 : 0),
+                        static_cast<std::uint8_t>(length),
+                        static_cast<std::uint8_t>(length >> 8),
+                        static_cast<std::uint8_t>(~length),
+                        static_cast<std::uint8_t>(~length >> 8)
+                    };
+                    chunk.write(block_header, sizeof(block_header));
+                }
+
+                const auto count = std::min(p_size, block_left);
+                chunk.write(p_data, count);
+                p_data += count;
+                p_size -= count;
+                block_left -= count;
+                raw_left -= count;
+            }
+        };
+
+        constexpr std::uint8_t filter = 0;
+        for (int y = 0; y < p_frame.height; ++y)
+        {
+            write_raw(&filter, 1);
+            write_raw(get_row(p_frame, y), row_size);
+        }
+
+        const auto checksum = big_endian(adler.value());
+        chunk.write(checksum.data(), checksum.size());
+        chunk.end();
+    }
+
+    auto chunk = t_chunk_writer{ p_file, "IEND", 0 };
+    chunk.end();
+}
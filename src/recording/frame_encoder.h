@@ -0,0 +1,36 @@
+#pragma once
+
+// Writes frames to a file in the formats supported by frame_recorder
+// Frames are written top row first, the way video and image formats
+//  store them, and must be given top row first too : render_frame's rows
+//  are bottom-up, frame_recorder flips them when it copies a frame
+
+// project headers
+#include "aligned_file.h"
+#include "renderframe/frame_sink.h"
+
+// standard headers
+#include <cstdint>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace recording {
+
+// Raw RGBA8 frames back to back, without any header
+void write_raw_frame(aligned_file& p_file, const t_frame& p_frame);
+
+// YUV4MPEG2 stream header, 4:4:4 chroma
+void write_y4m_header(aligned_file& p_file, const int p_width, const int p_height, const int p_frame_rate);
+
+// YUV4MPEG2 frame, BT.601 limited range
+// `p_scratch` is reused between frames to hold the planes
+void write_y4m_frame(aligned_file& p_file, const t_frame& p_frame, std::vector<std::uint8_t>& p_scratch);
+
+// Complete RGBA8 PNG image, stored without compression to keep up
+//  with the frame rate
+void write_png(aligned_file& p_file, const t_frame& p_frame);
+
+}   // namespace recording
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,232 @@
+#include "frame_recorder.h"
+
+// project headers
+#include "aligned_file.h"
+#include "frame_encoder.h"
+#include "simd/pixel_kernels.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+
+// Constructor
+// Opens the output and starts the I/O thread
+ft::rf::recording::frame_recorder::frame_recorder(t_recorder_params p_params) :
+    m_params{ std::move(p_params) }
+{
+    // Without room for a frame, the block policy would wait forever
+    FT_ASSERT(m_params.queue_depth > 0);
+
+    if (m_params.format == t_recording_format::png)
+    {
+        std::filesystem::create_directories(m_params.path);
+    }
+
+    m_writer = std::thread([this]() { run_writer(); });
+}
+
+
+// Destructor
+// Writes the queued frames and closes the output
+ft::rf::recording::frame_recorder::~frame_recorder()
+{
+    {
+        std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+        m_stop = true;
+    }
+    m_queued_condition.notify_all();
+    m_writer.join();
+}
+
+
+// Queue a frame for the I/O thread
+// Rethrows the I/O thread's error if writing failed
+void ft::rf::recording::frame_recorder::on_frame(const t_frame & p_frame)
+{
+    std::unique_lock<decltype(m_mutex)> lock{ m_mutex };
+
+    if (m_error != nullptr)
+    {
+        std::rethrow_exception(m_error);
+    }
+
+    // Single file formats keep the size of the first frame
+    if (m_width == 0)
+    {
+        m_width = p_frame.width;
+        m_height = p_frame.height;
+    }
+    else if (m_params.format != t_recording_format::png &&
+        (p_frame.width != m_width || p_frame.height != m_height))
+    {
+        ++m_dropped;
+        return;
+    }
+
+    if (m_queue.size() >= m_params.queue_depth)
+    {
+        if (m_params.overflow == t_overflow_policy::drop)
+        {
+            ++m_dropped;
+            return;
+        }
+
+        m_written_condition.wait(lock, [this]() {
+            return m_queue.size() < m_params.queue_depth || m_error != nullptr;
+        });
+        if (m_error != nullptr)
+        {
+            std::rethrow_exception(m_error);
+        }
+    }
+
+    // Reuse a buffer to avoid allocating every frame
+    auto pixels = std::vector<std::uint8_t>{};
+    if (m_free_buffers.empty() == false)
+    {
+        pixels = std::move(m_free_buffers.back());
+        m_free_buffers.pop_back();
+    }
+
+    // The copy is made without the lock, the I/O thread
+    //  only touches frames once they are queued
+    lock.unlock();
+
+    // The encoder takes frames top row first, the copy flips them
+    const auto row_size = static_cast<std::size_t>(p_frame.width) * 4;
+    pixels.resize(row_size * p_frame.height);
+    simd::flip_rows(p_frame.pixels, p_frame.stride, pixels.data(), row_size, row_size, p_frame.height);
+
+    auto queued = t_queued_frame{ p_frame, std::move(pixels) };
+    queued.frame.stride = row_size;
+
+    lock.lock();
+    m_queue.push_back(std::move(queued));
+    m_max_queue_depth = std::max(m_max_queue_depth, m_queue.size());
+    lock.unlock();
+
+    m_queued_condition.notify_one();
+}
+
+
+// Number of frames written
+std::uint64_t ft::rf::recording::frame_recorder::get_written_count() const
+{
+    std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+    return m_written;
+}
+
+
+// Number of frames dropped
+std::uint64_t ft::rf::recording::frame_recorder::get_dropped_count() const
+{
+    std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+    return m_dropped;
+}
+
+
+// Highest number of frames that were waiting at once
+std::size_t ft::rf::recording::frame_recorder::get_max_queue_depth() const
+{
+    std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+    return m_max_queue_depth;
+}
+
+
+// Number of frames waiting for the I/O thread
+std::size_t ft::rf::recording::frame_recorder::get_queue_depth() const
+{
+    std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+    return m_queue.size();
+}
+
+
+// I/O thread entry point
+void ft::rf::recording::frame_recorder::run_writer()
+{
+    // Single file formats are opened once, with the first frame
+    std::unique_ptr<aligned_file> file;
+    std::vector<std::uint8_t> scratch;
+
+    try
+    {
+        while (true)
+        {
+            auto queued = t_queued_frame{};
+            {
+                std::unique_lock<decltype(m_mutex)> lock{ m_mutex };
+                m_queued_condition.wait(lock, [this]() {
+                    return m_stop || m_queue.empty() == false;
+                });
+
+                // Queued frames are written before stopping
+                if (m_queue.empty()) {
+                    break;
+                }
+                queued = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+
+            queued.frame.pixels = queued.pixels.data();
+            const auto & frame = queued.frame;
+
+            switch (m_params.format)
+            {
+            case t_recording_format::raw:
+                if (file == nullptr) {
+                    file = std::make_unique<aligned_file>(m_params.path, m_params.unbuffered, m_params.buffer_size);
+                }
+                write_raw_frame(*file, frame);
+                break;
+
+            case t_recording_format::y4m:
+                if (file == nullptr) {
+                    file = std::make_unique<aligned_file>(m_params.path, m_params.unbuffered, m_params.buffer_size);
+                    write_y4m_header(*file, frame.width, frame.height, m_params.frame_rate);
+                }
+                write_y4m_frame(*file, frame, scratch);
+                break;
+
+            case t_recording_format::png:
+            default:
+            {
+                char name[32];
+                std::snprintf(name, sizeof(name), "frame_%08llu.png",
+                    static_cast<unsigned long long>(frame.number));
+
+                // Images are small, a buffer the size of one is enough
+                auto image = aligned_file{
+                    m_params.path / name,
+                    m_params.unbuffered,
+                    std::min(m_params.buffer_size, queued.pixels.size() + aligned_file::s_alignment) };
+                write_png(image, frame);
+                image.close();
+                break;
+            }
+            }
+
+            {
+                std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+                ++m_written;
+                m_free_buffers.push_back(std::move(queued.pixels));
+            }
+            m_written_condition.notify_all();
+        }
+
+        if (file != nullptr) {
+            file->close();
+        }
+    }
+    catch (...)
+    {
+        // Reported by the next `on_frame`, the recording stops here
+        std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+        m_error = std::current_exception();
+        m_written_condition.notify_all();
+    }
+}
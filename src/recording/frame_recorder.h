@@ -0,0 +1,134 @@
+#pragma once
+
+// Frame sink writing the frames of a render_frame to disk
+// Frames are copied into a bounded queue and written by a dedicated
+//  I/O thread, so `end_frame` never waits on the file system unless
+//  the block policy is selected and the queue is full
+
+// project headers
+#include "renderframe/frame_sink.h"
+
+// standard headers
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace recording {
+
+enum class t_recording_format {
+    raw,    // RGBA8 frames back to back in a single file
+    y4m,    // YUV4MPEG2 4:4:4 video in a single file
+    png     // One PNG image per frame in a directory
+};
+
+// What to do with a frame when the queue is full
+enum class t_overflow_policy {
+    drop,   // Discard the frame, the render loop never waits
+    block   // Wait for the I/O thread, no frame is lost
+};
+
+struct t_recorder_params
+{
+    // File to write, or directory for PNG sequences
+    std::filesystem::path path;
+
+    t_recording_format format = t_recording_format::y4m;
+    t_overflow_policy overflow = t_overflow_policy::drop;
+
+    // Maximum number of frames waiting for the I/O thread, at least 1
+    std::size_t queue_depth = 8;
+
+    // Bypass the operating system's file cache
+    bool unbuffered = true;
+
+    // Size of the aligned write buffer
+    std::size_t buffer_size = 8 * 1024 * 1024;
+
+    // Frame rate written in the Y4M header
+    int frame_rate = 60;
+
+};  // struct t_recorder_params
+
+
+class frame_recorder : public frame_sink
+{
+public:
+    // Constructor
+    // Opens the output and starts the I/O thread
+    explicit frame_recorder(t_recorder_params p_params);
+
+    // Destructor
+    // Writes the queued frames and closes the output
+    ~frame_recorder() override;
+
+    // Prevent copy
+    frame_recorder(const frame_recorder&) = delete;
+    frame_recorder& operator=(const frame_recorder&) = delete;
+
+    // Queue a frame for the I/O thread
+    // Rethrows the I/O thread's error if writing failed
+    void on_frame(const t_frame& p_frame) override;
+
+    // Number of frames written
+    std::uint64_t get_written_count() const;
+
+    // Number of frames dropped because the queue was full or
+    //  because their size changed during a single file recording
+    std::uint64_t get_dropped_count() const override;
+
+    // Highest number of frames that were waiting at once
+    std::size_t get_max_queue_depth() const;
+
+    // Number of frames waiting for the I/O thread
+    std::size_t get_queue_depth() const override;
+
+private:
+    // A copy of a frame, rows stored top row first
+    struct t_queued_frame {
+        t_frame frame;
+        std::vector<std::uint8_t> pixels;
+    };
+
+    // I/O thread entry point
+    void run_writer();
+
+private:
+    // Recording parameters
+    t_recorder_params m_params;
+
+    // Frames waiting for the I/O thread, and buffers to reuse
+    std::deque<t_queued_frame> m_queue;
+    std::vector<std::vector<std::uint8_t>> m_free_buffers;
+
+    // Dimensions of the first frame, single file formats can't change size
+    int m_width = 0;
+    int m_height = 0;
+
+    // Statistics
+    std::uint64_t m_written = 0;
+    std::uint64_t m_dropped = 0;
+    std::size_t m_max_queue_depth = 0;
+
+    // Error raised by the I/O thread
+    std::exception_ptr m_error;
+
+    // I/O thread synchronization
+    mutable std::mutex m_mutex;
+    std::condition_variable m_queued_condition;
+    std::condition_variable m_written_condition;
+    bool m_stop = false;
+    std::thread m_writer;
+
+};  // class frame_recorder
+
+}   // namespace recording
+}   // namespace rf
+}   // namespace ft
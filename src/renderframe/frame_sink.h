@@ -0,0 +1,57 @@
+#pragma once
+
+// Receives the frames rendered by a render_frame
+// See render_frame::add_frame_sink
+
+// standard headers
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace ft {
+namespace rf {
+
+// A finished frame's pixels
+// RGBA8, rows stored bottom-up like an OpenGL framebuffer
+struct t_frame
+{
+    // Frame number, starting at 1
+    std::uint64_t number = 0;
+
+    // When the frame was finished
+    std::chrono::steady_clock::time_point time;
+
+    // Dimensions in pixels
+    int width = 0;
+    int height = 0;
+
+    // Bytes between the start of two rows
+    std::size_t stride = 0;
+
+    // Pixels, only valid during the call that provides them
+    const std::uint8_t* pixels = nullptr;
+
+};  // struct t_frame
+
+
+class frame_sink
+{
+public:
+    // Destructor
+    virtual ~frame_sink() = default;
+
+    // Called for every frame once its pixels were read back, in order
+    // Runs on the thread calling render_frame::end_frame and delays it,
+    //  slow sinks should hand the frame to another thread
+    virtual void on_frame(const t_frame& p_frame) = 0;
+
+    // Number of frames the sink discarded, reported by render_frame's metrics
+    virtual std::uint64_t get_dropped_count() const { return 0; }
+
+    // Number of frames waiting in the sink, reported by render_frame's metrics
+    virtual std::size_t get_queue_depth() const { return 0; }
+
+};  // class frame_sink
+
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,46 @@
+#pragma once
+
+// Input received by a render frame's window
+// See render_frame::poll_events
+
+// standard headers
+#include <chrono>
+#include <cstdint>
+
+namespace ft {
+namespace rf {
+
+enum class t_input_kind {
+    key_down,
+    key_up,
+    mouse_move,
+    button_down,
+    button_up,
+    wheel
+};
+
+enum class t_mouse_button {
+    left,
+    right,
+    middle
+};
+
+struct t_input_event
+{
+    t_input_kind kind = t_input_kind::mouse_move;
+
+    // Virtual key code for key events, t_mouse_button for button events
+    //  and the wheel's movement for wheel events, 120 per notch
+    std::int32_t code = 0;
+
+    // Cursor position in client coordinates, for mouse events
+    std::int32_t x = 0;
+    std::int32_t y = 0;
+
+    // When the process loop received the event
+    std::chrono::steady_clock::time_point time;
+
+};  // struct t_input_event
+
+}   // namespace rf
+}   // namespace ft
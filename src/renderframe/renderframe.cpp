@@ -1,18 +1,60 @@
 // Implementation for the platform agnostic component of renderframe
 
 // Project headers
+#include "frame_sink.h"
+#include "jobs/job_system.h"
+#include "opengl_context/frame_readback.h"
+#include "opengl_context/gl_dispatch.h"
+#include "opengl_context/gpu_timer.h"
+#include "opengl_context/uniform_arena.h"
 #include "procloop/process_loop.h"
 #include "renderframe.h"
 #include "renderframe_impl.h"
+#include "sharedmem/shared_metrics.h"
 
 // ft_base_lib headers
 #include "error/ft_assert.h"
 
+// standard headers
+#include <algorithm>
+
+namespace {
+
+// Make the read back callback passing frames to `p_sinks`
+ft::rf::context::frame_readback::t_callback make_sink_callback(
+    const std::vector<std::shared_ptr<ft::rf::frame_sink>> & p_sinks)
+{
+    return [&p_sinks](const ft::rf::context::frame_readback::t_result & p_result) {
+        auto frame = ft::rf::t_frame{};
+        frame.number = p_result.number;
+        frame.time = p_result.time;
+        frame.width = p_result.width;
+        frame.height = p_result.height;
+        frame.stride = static_cast<std::size_t>(p_result.width) * 4;
+        frame.pixels = p_result.pixels;
+
+        for (const auto & sink : p_sinks) {
+            sink->on_frame(frame);
+        }
+    };
+}
+
+}   // anonymous namespace
+
 
 // Constructor
 ft::rf::render_frame::render_frame(t_render_frame_params p_params) :
     m_params{std::move(p_params)}
 {
+    // The calling thread owns the window and dispatches its messages
+    if (m_params.external_loop)
+    {
+        m_impl.reset(new render_frame_impl(m_params));
+        m_process_loop.reset(new procloop::process_loop());
+        m_process_loop->attach(*m_impl);
+        return;
+    }
+
     // Create a promise to know when initialization finishes
     auto ready = std::promise<void>{};
     auto ready_future = ready.get_future();
@@ -34,6 +76,18 @@ ft::rf::render_frame::render_frame(t_render_frame_params p_params) :
 }
 
 
+// Destructor
+// Passes the frames still being read back to the sinks first
+ft::rf::render_frame::~render_frame()
+{
+    // Destructors can't report the sinks' errors
+    try {
+        flush_frame_sinks();
+    }
+    catch (...) {}
+}
+
+
 // Get the window's initial parameters
 const ft::rf::t_render_frame_params &
 ft::rf::render_frame::get_params() const
@@ -58,11 +112,141 @@ ft::rf::render_frame::get_opengl_context() const
 }
 
 
+// Get the per-frame uniform data arena
+// Created on first use and reset by `start_frame`
+ft::rf::context::uniform_arena &
+ft::rf::render_frame::get_uniform_arena()
+{
+    if (m_uniform_arena == nullptr)
+    {
+        m_uniform_arena.reset(new context::uniform_arena(get_opengl_context()));
+    }
+    return *m_uniform_arena;
+}
+
+
+// Get the tasks that must complete before the frame is submitted
+// Runs on the params' job system or the library's default one, created
+//  on first use
+ft::rf::jobs::task_group &
+ft::rf::render_frame::get_frame_tasks()
+{
+    if (m_frame_tasks == nullptr)
+    {
+        auto & system = (m_params.job_system != nullptr) ?
+            *m_params.job_system :
+            jobs::get_default_job_system();
+        m_frame_tasks.reset(new jobs::task_group(system));
+    }
+    return *m_frame_tasks;
+}
+
+
 // Clear the current frame and prepare to start drawing to it
-void ft::rf::render_frame::start_frame()
+// With damage tracking, returns false if nothing is damaged
+bool ft::rf::render_frame::start_frame()
 {
+    // Hand out the programs that finished building in the background,
+    //  skipped frames included so their futures still become ready
+    get_opengl_context().poll_programs();
+
+    if (m_params.damage_tracking)
+    {
+        const auto size = m_impl->get_client_size();
+        if (size.x() != m_damage_width || size.y() != m_damage_height)
+        {
+            m_damage_width = size.x();
+            m_damage_height = size.y();
+            m_full_damage = true;
+        }
+
+        // Nothing changed, the displayed frame is still correct
+        if (m_full_damage == false && m_damage.has_value() == false)
+        {
+            return false;
+        }
+    }
+
+    // Last frame's uniform data is no longer needed
+    if (m_uniform_arena != nullptr)
+    {
+        m_uniform_arena->reset();
+    }
+
+    // Measure the frame's GPU time from the clear
+    if (m_gpu_timer != nullptr)
+    {
+        m_gpu_timer->begin();
+    }
+
+    // Bind the mailbox target before clearing it
+    m_impl->prepare_frame();
+
+    if (m_params.damage_tracking)
+    {
+        // Partial redraws need the previous frame's pixels
+        auto & context = get_opengl_context();
+        if (m_full_damage || m_impl->is_back_buffer_preserved() == false)
+        {
+            context.disable_scissor();
+        }
+        else
+        {
+            const auto & damage = *m_damage;
+            context.set_scissor(damage.x, damage.y, damage.width, damage.height);
+        }
+
+        m_full_damage = false;
+        m_damage.reset();
+    }
+
     const auto & background = get_params().background;
-    m_impl->get_opengl_context().clear_frame(background);
+    m_impl->get_opengl_context().begin_pass(m_pass_actions, background);
+    return true;
+}
+
+
+// Set what happens to the framebuffer's contents at the start and at
+//  the end of every frame
+void ft::rf::render_frame::set_pass_actions(const context::t_pass_actions & p_actions)
+{
+    m_pass_actions = p_actions;
+}
+
+
+// Mark a rectangle that the next frame must redraw
+void ft::rf::render_frame::add_damage(const t_damage_rect & p_rect)
+{
+    // Clip to the window, the scissor rectangle is a single union
+    const auto left = std::max(p_rect.x, 0);
+    const auto bottom = std::max(p_rect.y, 0);
+    const auto right = std::min(p_rect.x + p_rect.width, m_damage_width);
+    const auto top = std::min(p_rect.y + p_rect.height, m_damage_height);
+    if (right <= left || top <= bottom)
+    {
+        // Outside the window, nothing to redraw
+        return;
+    }
+
+    if (m_damage.has_value() == false)
+    {
+        m_damage = t_damage_rect{ left, bottom, right - left, top - bottom };
+        return;
+    }
+
+    auto & damage = *m_damage;
+    const auto union_left = std::min(damage.x, left);
+    const auto union_bottom = std::min(damage.y, bottom);
+    const auto union_right = std::max(damage.x + damage.width, right);
+    const auto union_top = std::max(damage.y + damage.height, top);
+    damage = { union_left, union_bottom, union_right - union_left, union_top - union_bottom };
+}
+
+
+// Mark the whole window as damaged
+void ft::rf::render_frame::damage_all()
+{
+    m_full_damage = true;
 }
 
 
@@ -70,7 +254,179 @@ void ft::rf::render_frame::start_frame()
 // If double buffering is used, display it
 void ft::rf::render_frame::end_frame()
 {
+    // The frame's CPU work must be done before it is submitted
+    if (m_frame_tasks != nullptr)
+    {
+        m_frame_tasks->wait();
+    }
+
+    ++m_frame_count;
+
+    if (m_gpu_timer != nullptr)
+    {
+        m_gpu_timer->end();
+    }
+
+    // Read the back buffer before it is swapped
+    if (m_frame_sinks.empty() == false)
+    {
+        const auto size = m_impl->get_client_size();
+        if (size.x() > 0 && size.y() > 0)
+        {
+            m_frame_readback->read(size.x(), size.y(), m_frame_count, make_sink_callback(m_frame_sinks));
+        }
+    }
+
+    // After the read back, which needs the color contents
+    get_opengl_context().end_pass(m_pass_actions);
+
+    // Written after the frame's commands, before the swap
+    if (m_input_latency != nullptr)
+    {
+        if (m_frame_input.has_value())
+        {
+            m_input_latency->submit(*m_frame_input);
+            m_frame_input.reset();
+        }
+        m_input_latency->poll();
+    }
+
     m_impl->display_frame();
+
+    if (m_metrics != nullptr)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const auto counters = context::get_gl_dispatch_counters();
+        m_gpu_timer->poll(m_last_gpu_time);
+
+        auto metrics = sharedmem::t_frame_metrics{};
+        metrics.frame_number = m_frame_count;
+        metrics.time = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count());
+        metrics.frame_time = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_last_frame_end).count());
+        metrics.gpu_time = m_last_gpu_time;
+        metrics.gl_calls = counters.calls - m_last_gl_calls;
+        metrics.context_switches = counters.context_switches - m_last_context_switches;
+        metrics.readback_queue_depth = (m_frame_readback != nullptr) ? m_frame_readback->get_pending_count() : 0;
+        for (const auto & sink : m_frame_sinks)
+        {
+            metrics.dropped_frames += sink->get_dropped_count();
+            metrics.sink_queue_depth += sink->get_queue_depth();
+        }
+
+        m_metrics->publish(metrics);
+
+        m_last_frame_end = now;
+        m_last_gl_calls = counters.calls;
+        m_last_context_switches = counters.context_switches;
+    }
+}
+
+
+// Send every finished frame's pixels to `p_sink`
+// The pixels are read back asynchronously and reach the sinks
+//  a few frames later, during `end_frame` or `flush_frame_sinks`
+void ft::rf::render_frame::add_frame_sink(std::shared_ptr<frame_sink> p_sink)
+{
+    FT_ASSERT(p_sink != nullptr);
+
+    if (m_frame_readback == nullptr)
+    {
+        m_frame_readback.reset(new context::frame_readback(get_opengl_context()));
+    }
+    m_frame_sinks.push_back(std::move(p_sink));
+}
+
+
+// Stop sending frames to `p_sink`
+// Frames still being read back don't reach it, flush them first
+void ft::rf::render_frame::remove_frame_sink(const frame_sink & p_sink)
+{
+    const auto found = std::find_if(m_frame_sinks.begin(), m_frame_sinks.end(),
+        [&p_sink](const std::shared_ptr<frame_sink> & p_ptr) {
+            return p_ptr.get() == &p_sink;
+        });
+
+    if (found != m_frame_sinks.end())
+    {
+        m_frame_sinks.erase(found);
+    }
+}
+
+
+// Wait for the frames being read back and pass them to the sinks
+// Rethrows the sinks' errors
+void ft::rf::render_frame::flush_frame_sinks()
+{
+    if (m_frame_readback == nullptr || m_frame_readback->get_pending_count() == 0)
+    {
+        return;
+    }
+    m_frame_readback->poll(make_sink_callback(m_frame_sinks), true);
+}
+
+
+// Number of frames finished by `end_frame`
+std::uint64_t ft::rf::render_frame::get_frame_count() const
+{
+    return m_frame_count;
+}
+
+
+// Get the presentation statistics
+ft::rf::t_present_stats ft::rf::render_frame::get_present_stats() const
+{
+    return m_impl->get_present_stats();
+}
+
+
+// Publish every finished frame's metrics in the shared memory
+//  segment named `p_name`, updated by `end_frame`
+void ft::rf::render_frame::export_metrics(const std::string & p_name)
+{
+    FT_ASSERT(m_metrics == nullptr);
+
+    m_metrics.reset(new sharedmem::shared_metrics_export(p_name));
+    m_gpu_timer.reset(new context::gpu_timer(get_opengl_context()));
+
+    const auto counters = context::get_gl_dispatch_counters();
+    m_last_frame_end = std::chrono::steady_clock::now();
+    m_last_gl_calls = counters.calls;
+    m_last_context_switches = counters.context_switches;
+}
+
+
+// Move the input events received since the last call to the end of `p_events`
+// The current frame is considered to consume them
+void ft::rf::render_frame::poll_events(std::vector<t_input_event> & p_events)
+{
+    if (m_input_latency == nullptr)
+    {
+        m_input_latency.reset(new context::input_latency_tracker(get_opengl_context()));
+    }
+
+    const auto first = p_events.size();
+    m_impl->poll_events(p_events);
+
+    // Events are in order, the first one moved is the oldest
+    if (p_events.size() > first && m_frame_input.has_value() == false)
+    {
+        m_frame_input = p_events[first].time;
+    }
+}
+
+
+// Get the input latency distributions of the recent frames that
+//  consumed input
+ft::rf::context::input_latency_tracker::t_stats
+ft::rf::render_frame::get_input_latency() const
+{
+    if (m_input_latency == nullptr)
+    {
+        return {};
+    }
+    return m_input_latency->get_stats();
 }
 
 
@@ -87,6 +443,27 @@ bool ft::rf::render_frame::is_visible() const
     return m_impl->is_visible();
 }
 
+
+// Dispatch the window's pending messages without blocking
+// Only with t_render_frame_params::external_loop, from the thread
+//  that created the render frame
+// Returns false once the process loop was stopped
+bool ft::rf::render_frame::pump_events()
+{
+    FT_ASSERT(m_params.external_loop);
+    return m_process_loop->pump();
+}
+
+
+// Get the process loop dispatching the window's messages
+// With t_render_frame_params::external_loop, its `wait` blocks until
+//  messages arrive for `pump_events` or another handle is signaled
+ft::rf::procloop::process_loop & ft::rf::render_frame::get_process_loop()
+{
+    return *m_process_loop;
+}
+
+
 // Get the underlying implementation
 ft::rf::render_frame_impl&
 ft::rf::render_frame::get_impl_obj()
@@ -103,3 +480,9 @@ void ft::rf::render_frame::t_deleter<T>::operator()(T* p_ptr)
 };
 template ft::rf::render_frame::t_deleter<ft::rf::render_frame_impl>;
 template ft::rf::render_frame::t_deleter<ft::rf::procloop::process_loop>;
+template ft::rf::render_frame::t_deleter<ft::rf::context::uniform_arena>;
+template ft::rf::render_frame::t_deleter<ft::rf::context::frame_readback>;
+template ft::rf::render_frame::t_deleter<ft::rf::context::gpu_timer>;
+template ft::rf::render_frame::t_deleter<ft::rf::jobs::task_group>;
+template ft::rf::render_frame::t_deleter<ft::rf::context::input_latency_tracker>;
+template ft::rf::render_frame::t_deleter<ft::rf::sharedmem::shared_metrics_export>;
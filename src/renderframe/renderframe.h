@@ -1,32 +1,56 @@
 #pragma once
 
 // Platform agnostic interface for a window or other render context
+#include "input_event.h"
 #include "renderframeparams.h"
+#include "opengl_context/input_latency_tracker.h"
+#include "opengl_context/pass_actions.h"
 
 // standard headers
+#include <chrono>
+#include <cstdint>
 #include <future>
 #include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace ft {
 namespace rf {
 
 // Forward declaration
 namespace context {
+    class frame_readback;
+    class gpu_timer;
     class opengl_context;
+    class uniform_arena;
+}
+namespace jobs {
+    class task_group;
 }
 namespace procloop {
     class process_loop;
 }
+namespace sharedmem {
+    class shared_metrics_export;
+}
 
 // Platform-dependent component of this class
 class render_frame_impl;
 
+// Receives finished frames
+class frame_sink;
+
 class render_frame
 {
 public:
     // Constructor
     explicit render_frame(t_render_frame_params p_params);
 
+    // Destructor
+    // Passes the frames still being read back to the sinks first
+    ~render_frame();
+
     // Get the window's initial parameters
     const t_render_frame_params& get_params() const;
 
@@ -34,17 +58,92 @@ public:
     context::opengl_context& get_opengl_context();
     const context::opengl_context& get_opengl_context() const;
 
+    // Get the per-frame uniform data arena
+    // Created on first use and reset by `start_frame`
+    context::uniform_arena& get_uniform_arena();
+
+    // Get the tasks that must complete before the frame is submitted
+    // Runs on the params' job system or the library's default one, created
+    //  on first use
+    // `end_frame` waits for the group and rethrows the first task error
+    jobs::task_group& get_frame_tasks();
+
     // Clear the current frame and prepare to start drawing to it
-    void start_frame();
+    // With damage tracking, restricts clears and draws to the damaged
+    //  area and returns false if nothing is damaged, in which case the
+    //  frame is skipped and `end_frame` must not be called
+    // Always returns true without damage tracking
+    // Polls the asynchronous program builds either way
+    bool start_frame();
+
+    // Set what happens to the framebuffer's contents at the start and at
+    //  the end of every frame
+    // The defaults clear color, depth and stencil, and discard depth and stencil
+    //  once the frame is finished
+    void set_pass_actions(const context::t_pass_actions& p_actions);
+
+    // Mark a rectangle that the next frame must redraw
+    // Only used with t_render_frame_params::damage_tracking
+    void add_damage(const t_damage_rect& p_rect);
+
+    // Mark the whole window as damaged
+    void damage_all();
 
     // Finish the current frame and display it
     // If double buffering is used, display it
     void end_frame();
 
+    // Send every finished frame's pixels to `p_sink`
+    // The pixels are read back asynchronously and reach the sinks
+    //  a few frames later, during `end_frame` or `flush_frame_sinks`
+    void add_frame_sink(std::shared_ptr<frame_sink> p_sink);
+
+    // Stop sending frames to `p_sink`
+    // Frames still being read back don't reach it, flush them first
+    void remove_frame_sink(const frame_sink& p_sink);
+
+    // Wait for the frames being read back and pass them to the sinks
+    // Rethrows the sinks' errors
+    void flush_frame_sinks();
+
+    // Number of frames finished by `end_frame`
+    std::uint64_t get_frame_count() const;
+
+    // Get the presentation statistics
+    // See t_render_frame_params::present_mode
+    t_present_stats get_present_stats() const;
+
+    // Publish every finished frame's metrics in the shared memory
+    //  segment named `p_name`, updated by `end_frame`
+    // Other processes read it with sharedmem::shared_metrics_reader
+    void export_metrics(const std::string& p_name);
+
+    // Move the input events received since the last call to the end of `p_events`
+    // The current frame is considered to consume them, its latency is
+    //  measured from the oldest one
+    void poll_events(std::vector<t_input_event>& p_events);
+
+    // Get the input latency distributions of the recent frames that
+    //  consumed input
+    // GPU completion times arrive a few frames late
+    context::input_latency_tracker::t_stats get_input_latency() const;
+
     // Show or hide the render frame
     void set_visible(const bool p_visible);
     bool is_visible() const;
 
+    // Dispatch the window's pending messages without blocking
+    // Only with t_render_frame_params::external_loop, from the thread
+    //  that created the render frame
+    // Returns false once the process loop was stopped
+    bool pump_events();
+
+    // Get the process loop dispatching the window's messages
+    // With t_render_frame_params::external_loop, its `wait` blocks until
+    //  messages arrive for `pump_events` or another handle is signaled
+    // Its timers run on the thread dispatching the messages
+    procloop::process_loop& get_process_loop();
+
 private:
     // Get the underlying implementation
     render_frame_impl& get_impl_obj();
@@ -65,6 +164,7 @@ private:
 
     // Worker thread that owns the render frame and
     //  runs its message loop
+    // Not used with t_render_frame_params::external_loop
     std::future<void> m_worker;
 
     // Actual implementation
@@ -73,6 +173,50 @@ private:
     // Process loop worker for this frame
     std::unique_ptr<procloop::process_loop, t_deleter<procloop::process_loop>> m_process_loop;
 
+    // Per-frame uniform data allocator
+    std::unique_ptr<context::uniform_arena, t_deleter<context::uniform_arena>> m_uniform_arena;
+
+    // CPU work of the current frame, created on first use
+    std::unique_ptr<jobs::task_group, t_deleter<jobs::task_group>> m_frame_tasks;
+
+    // Reads frames back for the sinks, created with the first sink
+    std::unique_ptr<context::frame_readback, t_deleter<context::frame_readback>> m_frame_readback;
+
+    // Receive the finished frames
+    std::vector<std::shared_ptr<frame_sink>> m_frame_sinks;
+
+    // Number of frames finished by `end_frame`
+    std::uint64_t m_frame_count = 0;
+
+    // Metrics segment and the GPU timer feeding it, created by `export_metrics`
+    std::unique_ptr<sharedmem::shared_metrics_export, t_deleter<sharedmem::shared_metrics_export>> m_metrics;
+    std::unique_ptr<context::gpu_timer, t_deleter<context::gpu_timer>> m_gpu_timer;
+
+    // Measures input latency, created by the first `poll_events`
+    std::unique_ptr<context::input_latency_tracker, t_deleter<context::input_latency_tracker>> m_input_latency;
+
+    // Oldest input consumed by the current frame, if any
+    std::optional<std::chrono::steady_clock::time_point> m_frame_input;
+
+    // Load and store actions of every frame
+    context::t_pass_actions m_pass_actions;
+
+    // Union of the rectangles damaged since the last frame
+    std::optional<t_damage_rect> m_damage;
+
+    // Must the next frame redraw everything?
+    bool m_full_damage = true;
+
+    // Window size of the last frame, resizing damages everything
+    int m_damage_width = 0;
+    int m_damage_height = 0;
+
+    // Values at the end of the previous frame, metrics are per frame
+    std::chrono::steady_clock::time_point m_last_frame_end;
+    std::uint64_t m_last_gl_calls = 0;
+    std::uint64_t m_last_context_switches = 0;
+    std::uint64_t m_last_gpu_time = 0;
+
 };  // class render_frame
 
 }   // namespace rf
@@ -2,10 +2,14 @@
 
 // project headers
 #include "basegl/hdc_wrap.h"
+#include "opengl_context/gl_dispatch.h"
 
 // other projects
 #include "error/ft_assert.h"
 
+// standard headers
+#include <algorithm>
+
 // Class name to use
 const char g_window_class_name[] = "ft_rf_window_class_name";
 
@@ -25,18 +29,50 @@ ft::rf::render_frame_impl::render_frame_impl(const t_render_frame_params & p_par
     auto & dummy_context = *dummy_window->m_opengl_context;
 
     {   // Use the dummy window's opengl context to set this render frame's pixel format
-        const auto format_id = dummy_context.assign_pixel_format(p_params.pixel_format);
+        // Damage tracking redraws parts of the previous frame, which needs
+        //  a back buffer that survives the swap
+        auto format_id = 0;
+        if (p_params.damage_tracking && p_params.present_mode == t_present_mode::fifo)
+        {
+            const auto [id, preserved] = dummy_context.assign_pixel_format_preserving(p_params.pixel_format);
+            format_id = id;
+            m_back_buffer_preserved = preserved || p_params.pixel_format.double_buffer == false;
+        }
+        else
+        {
+            format_id = dummy_context.assign_pixel_format(p_params.pixel_format);
+        }
         
         // Apply the pixel format to the window
-        auto context = ::GetDC(m_handle);
-        PIXELFORMATDESCRIPTOR pixel_format_descriptor;
-        ::DescribePixelFormat(context, format_id, sizeof(pixel_format_descriptor), &pixel_format_descriptor);
-        ::SetPixelFormat(context, format_id, &pixel_format_descriptor);
+        // The null dispatch's pixel formats are fake
+        if (context::is_null_gl_dispatch() == false)
+        {
+            auto context = ::GetDC(m_handle);
+            PIXELFORMATDESCRIPTOR pixel_format_descriptor;
+            ::DescribePixelFormat(context, format_id, sizeof(pixel_format_descriptor), &pixel_format_descriptor);
+            ::SetPixelFormat(context, format_id, &pixel_format_descriptor);
+        }
     }
 
     // Create an opengl context for this render frame
     m_opengl_context = std::make_unique<ft::rf::context::opengl_context>(
         get_context(), dummy_context);
+    m_opengl_context->set_default_framebuffer_format(
+        p_params.pixel_format.z_buffer_depth,
+        p_params.pixel_format.stencil_depth);
+
+    if (p_params.present_mode == t_present_mode::mailbox)
+    {
+        FT_ASSERT(p_params.pixel_format.double_buffer);
+
+        // Swaps happen on the presenter's thread
+        const auto window = native_handle();
+        m_presenter = std::make_unique<context::mailbox_presenter>(*m_opengl_context, [window]() {
+            if (context::is_null_gl_dispatch() == false) {
+                SwapBuffers(::GetDC(window));
+            }
+        });
+    }
 }
 
 
@@ -56,17 +92,75 @@ ft::rf::render_frame_impl::get_opengl_context()
 }
 
 
+// Select the framebuffer the next frame is drawn to
+void ft::rf::render_frame_impl::prepare_frame()
+{
+    if (m_presenter != nullptr)
+    {
+        // A minimized window still needs a target
+        const auto size = get_client_size();
+        m_presenter->begin_frame(std::max(size.x(), 1), std::max(size.y(), 1));
+    }
+}
+
+
 // Finish the current frame and display it
 // If double buffering is used, display it
 void ft::rf::render_frame_impl::display_frame()
 {
-    if (m_params.pixel_format.double_buffer)
+    if (m_presenter != nullptr)
+    {
+        m_presenter->end_frame();
+    }
+    else if (m_params.pixel_format.double_buffer && context::is_null_gl_dispatch() == false)
     {
         SwapBuffers(::GetDC(m_handle));
+        ++m_presented;
     }
 }
 
 
+// Does the next frame start with the previous frame's content?
+bool ft::rf::render_frame_impl::is_back_buffer_preserved() const
+{
+    return m_back_buffer_preserved;
+}
+
+
+// Get the presentation statistics
+ft::rf::t_present_stats ft::rf::render_frame_impl::get_present_stats() const
+{
+    auto result = t_present_stats{};
+    if (m_presenter == nullptr)
+    {
+        result.presented = m_presented;
+        return result;
+    }
+
+    const auto stats = m_presenter->get_stats();
+    result.presented = stats.presented;
+    result.discarded = stats.discarded;
+    result.last_latency = stats.last_latency;
+    result.average_latency = stats.average_latency;
+    result.max_latency = stats.max_latency;
+    return result;
+}
+
+
+// Get the size of the window's drawable area in pixels
+ft::math::vector<int, 2> ft::rf::render_frame_impl::get_client_size() const
+{
+    ::RECT rect = {};
+    if (::GetClientRect(m_handle, &rect) == FALSE)
+    {
+        return { 0, 0 };
+    }
+    return {
+        static_cast<int>(rect.right - rect.left),
+        static_cast<int>(rect.bottom - rect.top) };
+}
+
+
 // Get the opengl context assigned to this render frame
 const ft::rf::context::opengl_context & 
 ft::rf::render_frame_impl::get_opengl_context() const
@@ -76,6 +170,15 @@ ft::rf::render_frame_impl::get_opengl_context() const
 }
 
 
+// Move the input events received since the last call to the end of `p_events`
+void ft::rf::render_frame_impl::poll_events(std::vector<t_input_event> & p_events)
+{
+    auto events = m_events.make_lock();
+    p_events.insert(p_events.end(), events->begin(), events->end());
+    events->clear();
+}
+
+
 // Show or hide the render frame
 void ft::rf::render_frame_impl::set_visible(const bool p_visible)
 {
@@ -188,6 +291,65 @@ ft::rf::render_frame_impl::get_context() const
 ::LRESULT 
 ft::rf::render_frame_impl::window_proc(::UINT p_msg, ::WPARAM p_w_params, ::LPARAM p_l_params)
 {
+    // Timestamped on arrival, latency is measured from here
+    auto event = t_input_event{};
+    event.time = std::chrono::steady_clock::now();
+
+    // Cursor position, signed for positions outside the client area
+    const auto x = static_cast<std::int32_t>(static_cast<short>(p_l_params & 0xFFFF));
+    const auto y = static_cast<std::int32_t>(static_cast<short>((p_l_params >> 16) & 0xFFFF));
+
+    auto is_input = true;
+    switch (p_msg)
+    {
+    case WM_KEYDOWN:
+        event.kind = t_input_kind::key_down;
+        event.code = static_cast<std::int32_t>(p_w_params);
+        break;
+    case WM_KEYUP:
+        event.kind = t_input_kind::key_up;
+        event.code = static_cast<std::int32_t>(p_w_params);
+        break;
+    case WM_MOUSEMOVE:
+        event = { t_input_kind::mouse_move, 0, x, y, event.time };
+        break;
+    case WM_LBUTTONDOWN:
+        event = { t_input_kind::button_down, static_cast<std::int32_t>(t_mouse_button::left), x, y, event.time };
+        break;
+    case WM_LBUTTONUP:
+        event = { t_input_kind::button_up, static_cast<std::int32_t>(t_mouse_button::left), x, y, event.time };
+        break;
+    case WM_RBUTTONDOWN:
+        event = { t_input_kind::button_down, static_cast<std::int32_t>(t_mouse_button::right), x, y, event.time };
+        break;
+    case WM_RBUTTONUP:
+        event = { t_input_kind::button_up, static_cast<std::int32_t>(t_mouse_button::right), x, y, event.time };
+        break;
+    case WM_MBUTTONDOWN:
+        event = { t_input_kind::button_down, static_cast<std::int32_t>(t_mouse_button::middle), x, y, event.time };
+        break;
+    case WM_MBUTTONUP:
+        event = { t_input_kind::button_up, static_cast<std::int32_t>(t_mouse_button::middle), x, y, event.time };
+        break;
+    case WM_MOUSEWHEEL:
+        // The wheel's position is in screen coordinates, only the movement is kept
+        event.kind = t_input_kind::wheel;
+        event.code = static_cast<std::int32_t>(static_cast<short>((p_w_params >> 16) & 0xFFFF));
+        break;
+    default:
+        is_input = false;
+        break;
+    }
+
+    if (is_input)
+    {
+        auto events = m_events.make_lock();
+        if (events->size() == s_max_queued_events) {
+            events->pop_front();
+        }
+        events->push_back(event);
+    }
+
     return ::DefWindowProcA(m_handle, p_msg, p_w_params, p_l_params);
 }
 
@@ -202,7 +364,11 @@ ft::rf::render_frame_impl::render_frame_impl(const t_render_frame_params & p_par
     initialize();
 
     // Set the dummy pixel format
-    set_dummy_pixel_format();
+    // Pixel formats load the driver, the null dispatch doesn't need one
+    if (context::is_null_gl_dispatch() == false)
+    {
+        set_dummy_pixel_format();
+    }
 
     // Create an opengl context for this render frame
     m_opengl_context = std::make_unique<ft::rf::context::opengl_context>(
@@ -3,17 +3,22 @@
 // Platform specific component of a render_frame for Windows
 
 // this project
+#include "input_event.h"
 #include "renderframeparams.h"
 #include "window_class_win32.h"
 
+#include "opengl_context/mailbox_presenter.h"
 #include "opengl_context/opengl_context.h"
 
 // other projects
 #include "handle/ressource_handle.hpp"
 #include "base/windows_include.h"
+#include "thread/lockable.h"
 
 // standard headers
+#include <deque>
 #include <memory>
+#include <vector>
 
 namespace ft {
 
@@ -33,6 +38,9 @@ public:
         using std::runtime_error::runtime_error;
     };
 
+    // Events kept for `poll_events`, older ones are dropped
+    static constexpr std::size_t s_max_queued_events = 4096;
+
 public:
     // Default constructor
     render_frame_impl() = default;
@@ -55,16 +63,34 @@ public:
     ::HWND native_handle() const;
 
 
+    // Select the framebuffer the next frame is drawn to
+    void prepare_frame();
+
     // Finish the current frame and display it
     // If double buffering is used, display it
     void display_frame();
 
+    // Get the presentation statistics
+    t_present_stats get_present_stats() const;
+
+    // Does the next frame start with the previous frame's content?
+    // If not, every frame must be redrawn completely
+    bool is_back_buffer_preserved() const;
+
+
+    // Get the size of the window's drawable area in pixels
+    math::vector<int, 2> get_client_size() const;
+
 
     // Get the opengl context assigned to this render frame
     context::opengl_context& get_opengl_context();
     const context::opengl_context& get_opengl_context() const;
 
 
+    // Move the input events received since the last call to the end of `p_events`
+    void poll_events(std::vector<t_input_event>& p_events);
+
+
     // Show or hide the render frame
     void set_visible(const bool p_visible);
 
@@ -121,6 +147,19 @@ private:
     // The opengl context associated with this window
     std::unique_ptr<context::opengl_context> m_opengl_context;
 
+    // Presents the frames in mailbox mode
+    // Destroyed before the context it renders with
+    std::unique_ptr<context::mailbox_presenter> m_presenter;
+
+    // Frames swapped in fifo mode
+    std::uint64_t m_presented = 0;
+
+    // Is the back buffer kept when swapping?
+    bool m_back_buffer_preserved = false;
+
+    // Input events received by the process loop's thread
+    base::thread::lockable<std::deque<t_input_event>> m_events;
+
     // Is the window currently visible?
     bool m_visible = false;
 
@@ -6,11 +6,51 @@
 #include "basegl/pixel_format.h"
 
 // standard headers
+#include <chrono>
+#include <cstdint>
 #include <string>
 
 namespace ft {
 namespace rf {
 
+// Forward declaration
+namespace jobs {
+    class job_system;
+}
+
+// How finished frames reach the display
+enum class t_present_mode {
+    fifo,       // Swap the back buffer, waits when rendering faster than the display, Default mode
+    mailbox     // Render offscreen and show the newest completed frame, never waits
+};
+
+// Presentation statistics
+// Latencies are only measured by the mailbox mode
+struct t_present_stats
+{
+    // Frames shown and frames replaced before they could be shown
+    std::uint64_t presented = 0;
+    std::uint64_t discarded = 0;
+
+    // Time between a frame's `end_frame` and the return of its swap
+    std::chrono::nanoseconds last_latency{ 0 };
+    std::chrono::nanoseconds average_latency{ 0 };
+    std::chrono::nanoseconds max_latency{ 0 };
+
+};  // struct t_present_stats
+
+// A rectangle of the window that must be redrawn
+// In pixels from the bottom-left corner of the client area, like OpenGL
+struct t_damage_rect
+{
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+};  // struct t_damage_rect
+
+
 struct t_render_frame_params
 {
     std::string window_name;
@@ -21,6 +61,25 @@ struct t_render_frame_params
     // Desired pixel format
     gl::t_pixel_format pixel_format;
 
+    // How finished frames reach the display
+    // Mailbox presentation requires double buffering
+    t_present_mode present_mode = t_present_mode::fifo;
+
+    // Only redraw the rectangles marked with render_frame::add_damage,
+    //  and skip frames where nothing is damaged
+    bool damage_tracking = false;
+
+    // Create the window on the thread constructing the render frame and
+    //  let that thread dispatch its messages with render_frame::pump_events,
+    //  instead of a worker thread blocking in the process loop
+    bool external_loop = false;
+
+    // Runs the frame tasks, the library's default job system if null
+    // Set a job system created with t_job_system_params::pin_threads to
+    //  keep the workers off the render thread's core
+    // Must outlive the render frame
+    jobs::job_system* job_system = nullptr;
+
 };  // struct t_render_frame_params
 
 }   // namespace rf
@@ -0,0 +1,245 @@
+#include "shared_frame_ring.h"
+
+// project headers
+#include "simd/pixel_kernels.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+
+namespace {
+
+// Identifies a frame ring, "FTFR"
+constexpr std::uint32_t g_magic = 0x52465446;
+
+// Incremented when the layout changes
+constexpr std::uint32_t g_version = 1;
+
+// The ring header fills the first page, slots start on page boundaries
+constexpr std::size_t g_page_size = 4096;
+
+// Size of a slot's header, the pixels follow it
+constexpr std::size_t g_slot_header_size = 64;
+
+// At the start of the shared memory
+struct t_ring_header
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t slot_count;
+    std::uint32_t reserved;
+    std::uint64_t slot_stride;  // Bytes between the start of two slots
+    std::uint64_t capacity;     // Bytes available for a slot's pixels
+    std::uint64_t latest;       // Last published frame number, accessed atomically
+};
+
+// At the start of each slot
+struct t_slot_header
+{
+    std::uint32_t sequence;     // Odd while the slot is written, accessed atomically
+    std::uint32_t reserved;
+    std::uint64_t number;
+    std::int64_t time;          // steady_clock time in nanoseconds
+    std::int32_t width;
+    std::int32_t height;
+    std::uint64_t stride;
+};
+
+static_assert(sizeof(t_ring_header) <= g_page_size);
+static_assert(sizeof(t_slot_header) <= g_slot_header_size);
+static_assert(std::atomic_ref<std::uint32_t>::is_always_lock_free);
+static_assert(std::atomic_ref<std::uint64_t>::is_always_lock_free);
+
+
+// Bytes between the start of two slots
+std::size_t get_slot_stride(const std::size_t p_capacity)
+{
+    const auto size = g_slot_header_size + p_capacity;
+    return (size + g_page_size - 1) / g_page_size * g_page_size;
+}
+
+
+// Header of slot `p_index`
+template<class Byte>
+auto* get_slot(Byte* p_memory, const t_ring_header & p_header, const std::uint64_t p_index)
+{
+    auto* slot = p_memory + g_page_size + p_index * p_header.slot_stride;
+    if constexpr (std::is_const_v<Byte>) {
+        return reinterpret_cast<const t_slot_header*>(slot);
+    }
+    else {
+        return reinterpret_cast<t_slot_header*>(slot);
+    }
+}
+
+}   // anonymous namespace
+
+
+// Constructor
+// Creates the shared memory ring named `p_name`
+// Frames larger than `p_max_width` x `p_max_height` are dropped
+ft::rf::sharedmem::shared_frame_export::shared_frame_export(
+    const std::string & p_name,
+    const int p_max_width,
+    const int p_max_height,
+    const std::uint32_t p_slot_count) :
+    m_memory{
+        p_name,
+        g_page_size + p_slot_count * get_slot_stride(static_cast<std::size_t>(p_max_width) * p_max_height * 4),
+        shared_memory::t_create_tag{} },
+    m_capacity{ static_cast<std::size_t>(p_max_width) * p_max_height * 4 }
+{
+    FT_ASSERT(p_max_width > 0 && p_max_height > 0);
+    FT_ASSERT(p_slot_count > 1);
+
+    // The memory starts zeroed, every slot is empty with an even sequence
+    auto & header = *reinterpret_cast<t_ring_header*>(m_memory.get_data());
+    header.magic = g_magic;
+    header.version = g_version;
+    header.slot_count = p_slot_count;
+    header.slot_stride = get_slot_stride(m_capacity);
+    header.capacity = m_capacity;
+
+    // Publishes the header
+    std::atomic_ref<std::uint64_t>{ header.latest }.store(0, std::memory_order_release);
+}
+
+
+// Copy a frame into its slot and publish it
+void ft::rf::sharedmem::shared_frame_export::on_frame(const t_frame & p_frame)
+{
+    const auto row_size = static_cast<std::size_t>(p_frame.width) * 4;
+    if (row_size * p_frame.height > m_capacity)
+    {
+        ++m_dropped;
+        return;
+    }
+
+    auto & header = *reinterpret_cast<t_ring_header*>(m_memory.get_data());
+    auto & slot = *get_slot(m_memory.get_data(), header, p_frame.number % header.slot_count);
+
+    // Mark the slot as being written
+    auto sequence = std::atomic_ref<std::uint32_t>{ slot.sequence };
+    const auto before = sequence.load(std::memory_order_relaxed);
+    sequence.store(before + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.number = p_frame.number;
+    slot.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        p_frame.time.time_since_epoch()).count();
+    slot.width = p_frame.width;
+    slot.height = p_frame.height;
+    slot.stride = row_size;
+
+    // Rows are stored tightly packed
+    auto* pixels = reinterpret_cast<std::uint8_t*>(&slot) + g_slot_header_size;
+    // Consumers read the slot from another process, the copy bypasses
+    //  this thread's caches
+    simd::copy_rows(
+        p_frame.pixels,
+        p_frame.stride,
+        pixels,
+        row_size,
+        row_size,
+        p_frame.height);
+
+    // Publish the slot, then the frame number
+    sequence.store(before + 2, std::memory_order_release);
+    std::atomic_ref<std::uint64_t>{ header.latest }.store(p_frame.number, std::memory_order_release);
+}
+
+
+// Number of frames too large for the slots
+std::uint64_t ft::rf::sharedmem::shared_frame_export::get_dropped_count() const
+{
+    return m_dropped;
+}
+
+
+// Constructor
+// Opens the ring named `p_name`, created by a shared_frame_export
+ft::rf::sharedmem::shared_frame_reader::shared_frame_reader(const std::string & p_name) :
+    m_memory{ p_name, shared_memory::t_open_tag{} }
+{
+    if (m_memory.get_size() < g_page_size)
+    {
+        throw t_except_bad_format("Shared memory too small for a frame ring");
+    }
+
+    const auto & header = *reinterpret_cast<const t_ring_header*>(m_memory.get_data());
+    if (header.magic != g_magic || header.version != g_version)
+    {
+        throw t_except_bad_format("Shared memory isn't a frame ring");
+    }
+    if (header.slot_count == 0 || m_memory.get_size() < g_page_size + header.slot_count * header.slot_stride)
+    {
+        throw t_except_bad_format("Frame ring is truncated");
+    }
+}
+
+
+// Number of the last published frame, 0 if there is none yet
+std::uint64_t ft::rf::sharedmem::shared_frame_reader::get_latest_number() const
+{
+    // The mapping is read only, but loads never write
+    auto & header = *reinterpret_cast<t_ring_header*>(const_cast<std::byte*>(m_memory.get_data()));
+    return std::atomic_ref<std::uint64_t>{ header.latest }.load(std::memory_order_acquire);
+}
+
+
+// Call `p_read` with frame `p_number` without copying it
+// Returns false if the frame isn't in the ring or if it was overwritten
+//  while `p_read` was running
+bool ft::rf::sharedmem::shared_frame_reader::read(
+    const std::uint64_t p_number,
+    const t_callback & p_read) const
+{
+    if (p_number == 0)
+    {
+        return false;
+    }
+
+    const auto & header = *reinterpret_cast<const t_ring_header*>(m_memory.get_data());
+    const auto & slot = *get_slot(m_memory.get_data(), header, p_number % header.slot_count);
+
+    // The mapping is read only, but loads never write
+    auto sequence = std::atomic_ref<std::uint32_t>{ const_cast<std::uint32_t&>(slot.sequence) };
+    const auto before = sequence.load(std::memory_order_acquire);
+    if ((before & 1) != 0 || slot.number != p_number)
+    {
+        return false;
+    }
+
+    auto frame = t_frame{};
+    frame.number = p_number;
+    frame.time = std::chrono::steady_clock::time_point{
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::nanoseconds{ slot.time }) };
+    frame.width = slot.width;
+    frame.height = slot.height;
+    frame.stride = static_cast<std::size_t>(slot.stride);
+    frame.pixels = reinterpret_cast<const std::uint8_t*>(&slot) + g_slot_header_size;
+
+    // Reject frames with a size that doesn't fit, the slot is being reused
+    if (frame.stride * frame.height > header.capacity)
+    {
+        return false;
+    }
+
+    p_read(frame);
+
+    // The frame is valid only if the producer didn't touch the slot meanwhile
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return sequence.load(std::memory_order_relaxed) == before;
+}
+
+
+// Call `read` with the last published frame
+bool ft::rf::sharedmem::shared_frame_reader::read_latest(const t_callback & p_read) const
+{
+    return read(get_latest_number(), p_read);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+// Exports frames to other processes through a ring of slots in shared memory
+//
+// The producer writes each frame into slot `number % slot_count` and
+//  publishes it with a per-slot sequence counter : odd while the slot
+//  is being written, even once it is complete
+// Consumers map the ring once and read the pixels in place, then check
+//  that the sequence didn't change while they were reading
+// A frame stays readable until the producer wraps around the ring,
+//  `slot_count - 1` frames later
+
+// project headers
+#include "shared_memory.h"
+#include "renderframe/frame_sink.h"
+
+// standard headers
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+namespace ft {
+namespace rf {
+namespace sharedmem {
+
+// Producer side, add it to a render_frame with `add_frame_sink`
+class shared_frame_export : public frame_sink
+{
+public:
+    // Default number of slots in the ring
+    static constexpr std::uint32_t s_default_slot_count = 4;
+
+public:
+    // Constructor
+    // Creates the shared memory ring named `p_name`
+    // Frames larger than `p_max_width` x `p_max_height` are dropped
+    shared_frame_export(
+        const std::string& p_name,
+        const int p_max_width,
+        const int p_max_height,
+        const std::uint32_t p_slot_count = s_default_slot_count);
+
+    // Copy a frame into its slot and publish it
+    void on_frame(const t_frame& p_frame) override;
+
+    // Number of frames too large for the slots
+    std::uint64_t get_dropped_count() const override;
+
+private:
+    // Shared memory holding the ring
+    shared_memory m_memory;
+
+    // Bytes available for the pixels of a slot
+    std::size_t m_capacity = 0;
+
+    // Number of frames too large for the slots
+    std::uint64_t m_dropped = 0;
+
+};  // class shared_frame_export
+
+
+// Consumer side
+class shared_frame_reader
+{
+public:
+    // Raised when the shared memory isn't a frame ring
+    struct t_except_bad_format : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    // Called with a frame's pixels, still in shared memory
+    using t_callback = std::function<void(const t_frame&)>;
+
+public:
+    // Constructor
+    // Opens the ring named `p_name`, created by a shared_frame_export
+    explicit shared_frame_reader(const std::string& p_name);
+
+    // Number of the last published frame, 0 if there is none yet
+    std::uint64_t get_latest_number() const;
+
+    // Call `p_read` with frame `p_number` without copying it
+    // Returns false if the frame isn't in the ring or if it was overwritten
+    //  while `p_read` was running, in which case whatever `p_read` did with
+    //  the pixels must be discarded
+    bool read(const std::uint64_t p_number, const t_callback& p_read) const;
+
+    // Call `read` with the last published frame
+    bool read_latest(const t_callback& p_read) const;
+
+private:
+    // Shared memory holding the ring
+    shared_memory m_memory;
+
+};  // class shared_frame_reader
+
+}   // namespace sharedmem
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,51 @@
+#include "shared_memory.h"
+#include "shared_memory_impl.h"
+
+
+// Create a region of `p_size` bytes, filled with zeros
+// The region exists until every process closes it
+ft::rf::sharedmem::shared_memory::shared_memory(
+    const std::string & p_name,
+    const std::size_t p_size,
+    t_create_tag) :
+    m_impl{ new shared_memory_impl(p_name, p_size) }
+{}
+
+
+// Open a region created by another process, read only
+ft::rf::sharedmem::shared_memory::shared_memory(const std::string & p_name, t_open_tag) :
+    m_impl{ new shared_memory_impl(p_name) }
+{}
+
+
+// Destructor
+// Unmaps the region
+ft::rf::sharedmem::shared_memory::~shared_memory() = default;
+
+
+// Start of the region
+std::byte * ft::rf::sharedmem::shared_memory::get_data()
+{
+    return static_cast<std::byte*>(m_impl->get_data());
+}
+
+
+// Start of the region
+const std::byte * ft::rf::sharedmem::shared_memory::get_data() const
+{
+    return static_cast<const std::byte*>(m_impl->get_data());
+}
+
+
+// Size of the region in bytes
+std::size_t ft::rf::sharedmem::shared_memory::get_size() const
+{
+    return m_impl->get_size();
+}
+
+
+// Deleter for unique_ptr to forward declared type
+void ft::rf::sharedmem::shared_memory::impl_deleter::operator()(shared_memory_impl* p_ptr)
+{
+    delete p_ptr;
+}
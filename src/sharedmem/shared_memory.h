@@ -0,0 +1,72 @@
+#pragma once
+
+// Named memory region shared between processes
+
+// standard headers
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace ft {
+namespace rf {
+namespace sharedmem {
+
+// Platform-dependent component of this class
+class shared_memory_impl;
+
+class shared_memory final
+{
+public:
+    // Raised when the region can't be created or opened
+    struct t_except_failed : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    struct t_create_tag {};
+    struct t_open_tag {};
+
+public:
+    // Create a region of `p_size` bytes, filled with zeros
+    // The region exists until every process closes it
+    shared_memory(const std::string& p_name, const std::size_t p_size, t_create_tag);
+
+    // Open a region created by another process, read only
+    shared_memory(const std::string& p_name, t_open_tag);
+
+    // Destructor
+    // Unmaps the region
+    ~shared_memory();
+
+    // Not copiable
+    shared_memory(const shared_memory&) = delete;
+    void operator=(const shared_memory&) = delete;
+
+    // Moveable
+    shared_memory(shared_memory&&) noexcept = default;
+    shared_memory& operator=(shared_memory&&) noexcept = default;
+
+    // Start of the region
+    // Must not be written to if the region was opened read only
+    std::byte* get_data();
+    const std::byte* get_data() const;
+
+    // Size of the region in bytes
+    // May be rounded up to the page size when opened
+    std::size_t get_size() const;
+
+private:
+    // shared_memory_impl deleter
+    struct impl_deleter {
+        void operator()(shared_memory_impl*);
+    };
+
+private:
+    // Holds the actual implementation
+    std::unique_ptr<shared_memory_impl, impl_deleter> m_impl;
+
+};  // class shared_memory
+
+}   // namespace sharedmem
+}   // namespace rf
+}   // namespace ft
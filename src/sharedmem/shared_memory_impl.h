@@ -0,0 +1,13 @@
+#pragma once
+
+// Platform agnostic header for the platform-dependent component
+//  of shared_memory
+
+// ft_base_lib headers
+#include "base/platform.h"
+
+#ifdef FT_OS_WINDOWS
+    #include "shared_memory_impl_win32.h"
+#else
+    #error Unsupported platform
+#endif
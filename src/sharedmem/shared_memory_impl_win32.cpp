@@ -0,0 +1,100 @@
+#include "shared_memory_impl_win32.h"
+#include "shared_memory.h"
+
+#ifdef FT_OS_WINDOWS
+
+namespace {
+
+// Release a mapped view
+void unmap_view(void* & p_view)
+{
+    ::UnmapViewOfFile(p_view);
+}
+
+// Close a file mapping
+void close_mapping(::HANDLE & p_mapping)
+{
+    ::CloseHandle(p_mapping);
+}
+
+}   // anonymous namespace
+
+
+// Create a named file mapping of `p_size` bytes
+ft::rf::sharedmem::shared_memory_impl::shared_memory_impl(const std::string & p_name, const std::size_t p_size) :
+    m_size{ p_size }
+{
+    const auto size = static_cast<unsigned long long>(p_size);
+    auto mapping = ::CreateFileMappingA(
+        INVALID_HANDLE_VALUE,                   // Backed by the paging file
+        nullptr,                                // Default security
+        PAGE_READWRITE,
+        static_cast<::DWORD>(size >> 32),       // Size, high part
+        static_cast<::DWORD>(size),             // Size, low part
+        p_name.c_str());
+
+    if (mapping == nullptr)
+    {
+        throw shared_memory::t_except_failed("Failed to create shared memory");
+    }
+
+    // A mapping left by another instance may not match the requested size
+    //  and still be read by consumers
+    const auto already_exists = ::GetLastError() == ERROR_ALREADY_EXISTS;
+    m_mapping = { mapping, close_mapping };
+    if (already_exists)
+    {
+        throw shared_memory::t_except_failed("Shared memory already exists");
+    }
+
+    auto view = ::MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, p_size);
+    if (view == nullptr)
+    {
+        throw shared_memory::t_except_failed("Failed to map shared memory");
+    }
+    m_view = { view, unmap_view };
+}
+
+
+// Open a named file mapping, read only
+ft::rf::sharedmem::shared_memory_impl::shared_memory_impl(const std::string & p_name)
+{
+    auto mapping = ::OpenFileMappingA(FILE_MAP_READ, FALSE, p_name.c_str());
+    if (mapping == nullptr)
+    {
+        throw shared_memory::t_except_failed("Failed to open shared memory");
+    }
+    m_mapping = { mapping, close_mapping };
+
+    // Map the whole region
+    auto view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        throw shared_memory::t_except_failed("Failed to map shared memory");
+    }
+    m_view = { view, unmap_view };
+
+    // The creator's size isn't stored, use the view's size
+    ::MEMORY_BASIC_INFORMATION info;
+    if (::VirtualQuery(view, &info, sizeof(info)) == 0)
+    {
+        throw shared_memory::t_except_failed("Failed to query shared memory size");
+    }
+    m_size = info.RegionSize;
+}
+
+
+// Start of the mapped view
+void * ft::rf::sharedmem::shared_memory_impl::get_data() const
+{
+    return m_view;
+}
+
+
+// Size of the mapped view
+std::size_t ft::rf::sharedmem::shared_memory_impl::get_size() const
+{
+    return m_size;
+}
+
+#endif  // FT_OS_WINDOWS
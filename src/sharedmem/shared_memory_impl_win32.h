@@ -0,0 +1,50 @@
+#pragma once
+
+// ft_base_lib headers
+#include "base/platform.h"
+#include "base/windows_include.h"
+#include "handle/ressource_handle.hpp"
+
+// standard headers
+#include <cstddef>
+#include <string>
+
+#ifdef FT_OS_WINDOWS
+
+namespace ft {
+namespace rf {
+namespace sharedmem {
+
+// Shared memory backed by the paging file
+class shared_memory_impl
+{
+public:
+    // Create a named file mapping of `p_size` bytes
+    shared_memory_impl(const std::string& p_name, const std::size_t p_size);
+
+    // Open a named file mapping, read only
+    explicit shared_memory_impl(const std::string& p_name);
+
+    // Start of the mapped view
+    void* get_data() const;
+
+    // Size of the mapped view
+    std::size_t get_size() const;
+
+private:
+    // File mapping object
+    base::handle::ressource_handle<::HANDLE, nullptr> m_mapping;
+
+    // Mapped view, released before the mapping
+    base::handle::ressource_handle<void*, nullptr> m_view;
+
+    // Size of the mapped view
+    std::size_t m_size = 0;
+
+};  // class shared_memory_impl
+
+}   // namespace sharedmem
+}   // namespace rf
+}   // namespace ft
+
+#endif  // FT_OS_WINDOWS
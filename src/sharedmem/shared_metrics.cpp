@@ -0,0 +1,134 @@
+#include "shared_metrics.h"
+
+// standard headers
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace {
+
+// Identifies a metrics segment, "FTMT"
+constexpr std::uint32_t g_magic = 0x544D5446;
+
+// Incremented when the layout changes
+constexpr std::uint32_t g_version = 1;
+
+// At the start of the shared memory, followed by the record
+struct t_metrics_header
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t record_size;  // sizeof(t_frame_metrics) of the producer
+    std::uint32_t sequence;     // Odd while the record is written, accessed atomically
+};
+
+// Size of the segment
+constexpr std::size_t g_segment_size = sizeof(t_metrics_header) + sizeof(ft::rf::sharedmem::t_frame_metrics);
+
+// Attempts before giving up on a producer that stopped in the middle of a write
+constexpr int g_max_read_attempts = 10000;
+
+static_assert(std::is_trivially_copyable_v<ft::rf::sharedmem::t_frame_metrics>);
+static_assert(std::atomic_ref<std::uint32_t>::is_always_lock_free);
+
+
+// Record following the header
+template<class Byte>
+Byte* get_record(Byte* p_memory)
+{
+    return p_memory + sizeof(t_metrics_header);
+}
+
+}   // anonymous namespace
+
+
+// Constructor
+// Creates the segment named `p_name`
+ft::rf::sharedmem::shared_metrics_export::shared_metrics_export(const std::string & p_name) :
+    m_memory{ p_name, g_segment_size, shared_memory::t_create_tag{} }
+{
+    // The memory starts zeroed, the record is empty with an even sequence
+    auto & header = *reinterpret_cast<t_metrics_header*>(m_memory.get_data());
+    header.magic = g_magic;
+    header.version = g_version;
+    header.record_size = sizeof(t_frame_metrics);
+
+    // Publishes the header
+    std::atomic_ref<std::uint32_t>{ header.sequence }.store(0, std::memory_order_release);
+}
+
+
+// Overwrite the published metrics
+void ft::rf::sharedmem::shared_metrics_export::publish(const t_frame_metrics & p_metrics)
+{
+    auto & header = *reinterpret_cast<t_metrics_header*>(m_memory.get_data());
+
+    // Mark the record as being written
+    auto sequence = std::atomic_ref<std::uint32_t>{ header.sequence };
+    const auto before = sequence.load(std::memory_order_relaxed);
+    sequence.store(before + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(get_record(m_memory.get_data()), &p_metrics, sizeof(p_metrics));
+
+    // Publish the record
+    sequence.store(before + 2, std::memory_order_release);
+}
+
+
+// Constructor
+// Opens the segment named `p_name`, created by a shared_metrics_export
+ft::rf::sharedmem::shared_metrics_reader::shared_metrics_reader(const std::string & p_name) :
+    m_memory{ p_name, shared_memory::t_open_tag{} }
+{
+    if (m_memory.get_size() < g_segment_size)
+    {
+        throw t_except_bad_format("Shared memory too small for a metrics segment");
+    }
+
+    const auto & header = *reinterpret_cast<const t_metrics_header*>(m_memory.get_data());
+    if (header.magic != g_magic || header.version != g_version)
+    {
+        throw t_except_bad_format("Shared memory isn't a metrics segment");
+    }
+    if (header.record_size != sizeof(t_frame_metrics))
+    {
+        throw t_except_bad_format("Metrics segment has an unexpected record size");
+    }
+}
+
+
+// Copy the published metrics into `p_metrics`
+// Returns false if nothing was published yet, or if the producer
+//  stopped while writing
+bool ft::rf::sharedmem::shared_metrics_reader::read(t_frame_metrics & p_metrics) const
+{
+    const auto & header = *reinterpret_cast<const t_metrics_header*>(m_memory.get_data());
+
+    // The mapping is read only, but loads never write
+    auto sequence = std::atomic_ref<std::uint32_t>{ const_cast<std::uint32_t&>(header.sequence) };
+
+    // The producer writes a few dozen bytes, retrying succeeds quickly
+    for (int attempt = 0; attempt < g_max_read_attempts; ++attempt)
+    {
+        const auto before = sequence.load(std::memory_order_acquire);
+        if ((before & 1) != 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        auto record = t_frame_metrics{};
+        std::memcpy(&record, get_record(m_memory.get_data()), sizeof(record));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before)
+        {
+            p_metrics = record;
+            return record.frame_number != 0;
+        }
+    }
+
+    return false;
+}
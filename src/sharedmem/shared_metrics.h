@@ -0,0 +1,102 @@
+#pragma once
+
+// Publishes per-frame metrics through a fixed layout shared memory segment
+//
+// The producer overwrites a single record after every frame, guarded by a
+//  sequence counter : odd while the record is written, even once it is
+//  complete
+// Monitoring processes open the segment read only and may read it at any
+//  rate, a read that overlapped a write is retried, the producer never waits
+
+// project headers
+#include "shared_memory.h"
+
+// standard headers
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace ft {
+namespace rf {
+namespace sharedmem {
+
+// Metrics of the last finished frame
+// Every member is 64 bit wide so the layout is the same for every compiler
+struct t_frame_metrics
+{
+    // Frame number, starting at 1
+    std::uint64_t frame_number = 0;
+
+    // steady_clock time when the frame was finished, in nanoseconds
+    std::uint64_t time = 0;
+
+    // CPU time between the end of the previous frame and this one, in nanoseconds
+    std::uint64_t frame_time = 0;
+
+    // GPU time of the most recent frame measured, in nanoseconds
+    // Lags a few frames behind `frame_number`
+    std::uint64_t gpu_time = 0;
+
+    // OpenGL calls and `make_current` context switches during the frame,
+    //  counted for the whole process
+    std::uint64_t gl_calls = 0;
+    std::uint64_t context_switches = 0;
+
+    // Frames dropped by the frame sinks since the start
+    std::uint64_t dropped_frames = 0;
+
+    // Frames waiting to be read back from the GPU
+    std::uint64_t readback_queue_depth = 0;
+
+    // Frames waiting in the frame sinks' queues
+    std::uint64_t sink_queue_depth = 0;
+
+};  // struct t_frame_metrics
+
+
+// Producer side
+class shared_metrics_export
+{
+public:
+    // Constructor
+    // Creates the segment named `p_name`
+    explicit shared_metrics_export(const std::string& p_name);
+
+    // Overwrite the published metrics
+    void publish(const t_frame_metrics& p_metrics);
+
+private:
+    // Shared memory holding the segment
+    shared_memory m_memory;
+
+};  // class shared_metrics_export
+
+
+// Consumer side
+class shared_metrics_reader
+{
+public:
+    // Raised when the shared memory isn't a metrics segment
+    struct t_except_bad_format : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+public:
+    // Constructor
+    // Opens the segment named `p_name`, created by a shared_metrics_export
+    explicit shared_metrics_reader(const std::string& p_name);
+
+    // Copy the published metrics into `p_metrics`
+    // Returns false if nothing was published yet, or if the producer
+    //  stopped while writing
+    bool read(t_frame_metrics& p_metrics) const;
+
+private:
+    // Shared memory holding the segment
+    shared_memory m_memory;
+
+};  // class shared_metrics_reader
+
+}   // namespace sharedmem
+}   // namespace rf
+}   // namespace ft
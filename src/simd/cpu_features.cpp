@@ -0,0 +1,56 @@
+#include "cpu_features.h"
+
+#if defined(FT_RF_SIMD_X86) && defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+namespace {
+
+// Detect the running CPU's features
+ft::rf::simd::t_cpu_features detect_features()
+{
+    auto features = ft::rf::simd::t_cpu_features{};
+
+#if defined(FT_RF_SIMD_X86)
+    // SSE2 is part of the x86-64 baseline
+    features.sse2 = true;
+
+    #if defined(_MSC_VER)
+        int registers[4] = {};
+        __cpuid(registers, 0);
+        if (registers[0] >= 7)
+        {
+            // AVX2 also requires the OS to save the YMM registers
+            __cpuid(registers, 1);
+            const auto osxsave = (registers[2] & (1 << 27)) != 0;
+            const auto avx = (registers[2] & (1 << 28)) != 0;
+            const auto fma = (registers[2] & (1 << 12)) != 0;
+            const auto ymm_saved = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+
+            __cpuidex(registers, 7, 0);
+            features.avx2 = avx && fma && ymm_saved && (registers[1] & (1 << 5)) != 0;
+        }
+    #else
+        __builtin_cpu_init();
+        features.avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    #endif
+#endif
+
+#if defined(FT_RF_SIMD_NEON)
+    // NEON is part of the AArch64 baseline
+    features.neon = true;
+#endif
+
+    return features;
+}
+
+}   // anonymous namespace
+
+
+// Get the running CPU's features
+// Detected once, on first use
+const ft::rf::simd::t_cpu_features & ft::rf::simd::get_cpu_features()
+{
+    static const auto features = detect_features();
+    return features;
+}
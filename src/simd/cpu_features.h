@@ -0,0 +1,45 @@
+#pragma once
+
+// Compile-time and run-time detection of the vector instruction sets
+//  usable by the library's SIMD code paths
+
+// Target architecture
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+    #define FT_RF_SIMD_X86
+#endif
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+    #define FT_RF_SIMD_NEON
+#endif
+// AArch64 adds division and rounding conversions to NEON
+#if defined(FT_RF_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+    #define FT_RF_SIMD_NEON_A64
+#endif
+
+// Functions using AVX2 intrinsics must be marked with this attribute
+//  so they can live in translation units built without -mavx2
+#if defined(FT_RF_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define FT_RF_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+    #define FT_RF_TARGET_AVX2
+#endif
+
+namespace ft {
+namespace rf {
+namespace simd {
+
+// Instruction set extensions usable by the running CPU
+struct t_cpu_features
+{
+    bool sse2 = false;
+    bool avx2 = false;
+    bool neon = false;
+
+};  // struct t_cpu_features
+
+// Get the running CPU's features
+// Detected once, on first use
+const t_cpu_features& get_cpu_features();
+
+}   // namespace simd
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,1268 @@
+#include "pixel_kernels.h"
+
+// project headers
+#include "cpu_features.h"
+
+// standard headers
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(FT_RF_SIMD_X86)
+    #include <immintrin.h>
+#endif
+#if defined(FT_RF_SIMD_NEON)
+    #include <arm_neon.h>
+#endif
+
+namespace {
+
+// Widest instruction set the kernels may use, see set_kernel_path
+std::atomic<ft::rf::simd::t_kernel_path> g_path_limit{ ft::rf::simd::t_kernel_path::avx2 };
+
+// Images at least this large are copied with non-temporal stores
+// About the size of a core's L2 cache, smaller copies are likely read
+//  again while they are still cached
+constexpr std::size_t g_stream_threshold = std::size_t{ 1024 } * 1024;
+
+// Samples of the sRGB encoding function over [0, 1]
+constexpr int g_srgb_samples = 4096;
+
+
+// Decoding table : sRGB values to linear, then 8 bit alpha to [0, 1]
+// A single table lets the gather paths handle every channel at once
+const std::array<float, 512> & get_srgb_decode_table()
+{
+    static const auto table = []()
+    {
+        auto result = std::array<float, 512>{};
+        for (int i = 0; i < 256; ++i)
+        {
+            const auto value = static_cast<double>(i) / 255.0;
+            result[i] = static_cast<float>(value <= 0.04045 ?
+                value / 12.92 :
+                std::pow((value + 0.055) / 1.055, 2.4));
+            result[256 + i] = static_cast<float>(i) / 255.f;
+        }
+        return result;
+    }();
+    return table;
+}
+
+
+// Encoding table : samples of linear values to sRGB, then 8 bit alpha
+//  to itself
+const std::array<std::int32_t, g_srgb_samples + 256> & get_srgb_encode_table()
+{
+    static const auto table = []()
+    {
+        auto result = std::array<std::int32_t, g_srgb_samples + 256>{};
+        for (int i = 0; i < g_srgb_samples; ++i)
+        {
+            const auto value = static_cast<double>(i) / (g_srgb_samples - 1);
+            const auto encoded = value <= 0.0031308 ?
+                value * 12.92 :
+                1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+            result[i] = static_cast<std::int32_t>(std::lround(encoded * 255.0));
+        }
+        for (int i = 0; i < 256; ++i)
+        {
+            result[g_srgb_samples + i] = i;
+        }
+        return result;
+    }();
+    return table;
+}
+
+
+// The running CPU's features the kernels may use
+ft::rf::simd::t_cpu_features get_enabled_features()
+{
+    using ft::rf::simd::t_kernel_path;
+
+    auto features = ft::rf::simd::get_cpu_features();
+    switch (g_path_limit.load(std::memory_order_relaxed))
+    {
+    case t_kernel_path::scalar:
+        features.neon = false;
+        features.sse2 = false;
+        [[fallthrough]];
+    case t_kernel_path::sse2:
+    case t_kernel_path::neon:
+        features.avx2 = false;
+        break;
+    case t_kernel_path::avx2:
+    default:
+        break;
+    }
+    return features;
+}
+
+
+// Clamp a float to [0, 1], NaN becomes 0
+float saturate(const float p_value)
+{
+    return (p_value > 0.f) ? std::min(p_value, 1.f) : 0.f;
+}
+
+
+// Multiply a channel by an alpha, rounded
+std::uint8_t multiply(const unsigned int p_channel, const unsigned int p_alpha)
+{
+    const auto value = p_channel * p_alpha + 128;
+    return static_cast<std::uint8_t>((value + (value >> 8)) >> 8);
+}
+
+
+// Divide a channel by a non-zero alpha, rounded and clamped
+// Single precision, the vector paths divide the same way
+std::uint8_t divide(const unsigned int p_channel, const unsigned int p_alpha)
+{
+    const auto value = static_cast<float>(p_channel * 255) / static_cast<float>(p_alpha) + 0.5f;
+    return static_cast<std::uint8_t>(std::min(static_cast<int>(value), 255));
+}
+
+
+// Write a pixel from its encoding table indices, the vector paths
+//  without gathers compute the indices and look them up lane by lane
+// The alpha index is the encoded alpha
+void encode_pixel(const std::int32_t* p_indices, std::uint8_t* p_target)
+{
+    const auto & table = get_srgb_encode_table();
+    p_target[0] = static_cast<std::uint8_t>(table[p_indices[0]]);
+    p_target[1] = static_cast<std::uint8_t>(table[p_indices[1]]);
+    p_target[2] = static_cast<std::uint8_t>(table[p_indices[2]]);
+    p_target[3] = static_cast<std::uint8_t>(p_indices[3]);
+}
+
+
+// Scalar kernels, they finish the pixels left by the vector paths
+
+void swizzle_scalar(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    for (std::size_t i = 0; i < p_count; ++i)
+    {
+        const auto red = p_source[i * 4 + 0];
+        const auto green = p_source[i * 4 + 1];
+        const auto blue = p_source[i * 4 + 2];
+        const auto alpha = p_source[i * 4 + 3];
+        p_target[i * 4 + 0] = blue;
+        p_target[i * 4 + 1] = green;
+        p_target[i * 4 + 2] = red;
+        p_target[i * 4 + 3] = alpha;
+    }
+}
+
+
+void expand_scalar(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    for (std::size_t i = 0; i < p_count; ++i)
+    {
+        p_target[i * 4 + 0] = p_source[i * 3 + 0];
+        p_target[i * 4 + 1] = p_source[i * 3 + 1];
+        p_target[i * 4 + 2] = p_source[i * 3 + 2];
+        p_target[i * 4 + 3] = 255;
+    }
+}
+
+
+void premultiply_scalar(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    for (std::size_t i = 0; i < p_count; ++i)
+    {
+        const auto alpha = p_source[i * 4 + 3];
+        p_target[i * 4 + 0] = multiply(p_source[i * 4 + 0], alpha);
+        p_target[i * 4 + 1] = multiply(p_source[i * 4 + 1], alpha);
+        p_target[i * 4 + 2] = multiply(p_source[i * 4 + 2], alpha);
+        p_target[i * 4 + 3] = alpha;
+    }
+}
+
+
+void unpremultiply_scalar(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    for (std::size_t i = 0; i < p_count; ++i)
+    {
+        const auto alpha = p_source[i * 4 + 3];
+        if (alpha == 0)
+        {
+            std::memset(p_target + i * 4, 0, 4);
+            continue;
+        }
+        p_target[i * 4 + 0] = divide(p_source[i * 4 + 0], alpha);
+        p_target[i * 4 + 1] = divide(p_source[i * 4 + 1], alpha);
+        p_target[i * 4 + 2] = divide(p_source[i * 4 + 2], alpha);
+        p_target[i * 4 + 3] = alpha;
+    }
+}
+
+
+void srgb_to_linear_scalar(const std::uint8_t* p_source, float* p_target, const std::size_t p_count)
+{
+    const auto & table = get_srgb_decode_table();
+    for (std::size_t i = 0; i < p_count; ++i)
+    {
+        p_target[i * 4 + 0] = table[p_source[i * 4 + 0]];
+        p_target[i * 4 + 1] = table[p_source[i * 4 + 1]];
+        p_target[i * 4 + 2] = table[p_source[i * 4 + 2]];
+        p_target[i * 4 + 3] = table[256 + p_source[i * 4 + 3]];
+    }
+}
+
+
+void linear_to_srgb_scalar(const float* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    // Rounded to nearest even, like the vector conversions
+    for (std::size_t i = 0; i < p_count; ++i)
+    {
+        std::int32_t indices[4] = {};
+        for (std::size_t channel = 0; channel < 3; ++channel)
+        {
+            indices[channel] = static_cast<std::int32_t>(
+                std::lrint(saturate(p_source[i * 4 + channel]) * static_cast<float>(g_srgb_samples - 1)));
+        }
+        indices[3] = static_cast<std::int32_t>(std::lrint(saturate(p_source[i * 4 + 3]) * 255.f));
+        encode_pixel(indices, p_target + i * 4);
+    }
+}
+
+
+void rgba_to_yuv444_scalar(
+    const std::uint8_t* p_source,
+    std::uint8_t* p_y,
+    std::uint8_t* p_u,
+    std::uint8_t* p_v,
+    const std::size_t p_count)
+{
+    // Fixed point with 8 fractional bits
+    for (std::size_t i = 0; i < p_count; ++i)
+    {
+        const int r = p_source[i * 4 + 0];
+        const int g = p_source[i * 4 + 1];
+        const int b = p_source[i * 4 + 2];
+        p_y[i] = static_cast<std::uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        p_u[i] = static_cast<std::uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        p_v[i] = static_cast<std::uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+}
+
+
+// Average pixel pairs of two rows into `p_count` pixels
+void downsample_row_scalar(
+    const std::uint8_t* p_row0,
+    const std::uint8_t* p_row1,
+    std::uint8_t* p_target,
+    const std::size_t p_count)
+{
+    for (std::size_t x = 0; x < p_count; ++x)
+    {
+        for (std::size_t channel = 0; channel < 4; ++channel)
+        {
+            const auto sum =
+                p_row0[x * 8 + channel] + p_row0[x * 8 + 4 + channel] +
+                p_row1[x * 8 + channel] + p_row1[x * 8 + 4 + channel];
+            p_target[x * 4 + channel] = static_cast<std::uint8_t>((sum + 2) / 4);
+        }
+    }
+}
+
+
+#if defined(FT_RF_SIMD_X86)
+
+// Copy a row with non-temporal stores, the caller fences once done
+// The stores need 16 byte aligned targets, the unaligned head and the
+//  tail are copied normally
+void stream_row_sse2(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_size)
+{
+    const auto misalignment = reinterpret_cast<std::uintptr_t>(p_target) % 16;
+    const auto head = std::min<std::size_t>((16 - misalignment) % 16, p_size);
+    std::memcpy(p_target, p_source, head);
+
+    auto i = head;
+    for (; i + 64 <= p_size; i += 64)
+    {
+        const auto* source = reinterpret_cast<const __m128i*>(p_source + i);
+        auto* target = reinterpret_cast<__m128i*>(p_target + i);
+        const auto a = _mm_loadu_si128(source + 0);
+        const auto b = _mm_loadu_si128(source + 1);
+        const auto c = _mm_loadu_si128(source + 2);
+        const auto d = _mm_loadu_si128(source + 3);
+        _mm_stream_si128(target + 0, a);
+        _mm_stream_si128(target + 1, b);
+        _mm_stream_si128(target + 2, c);
+        _mm_stream_si128(target + 3, d);
+    }
+    for (; i + 16 <= p_size; i += 16)
+    {
+        _mm_stream_si128(
+            reinterpret_cast<__m128i*>(p_target + i),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_source + i)));
+    }
+    std::memcpy(p_target + i, p_source + i, p_size - i);
+}
+
+
+// Vector kernels return the number of pixels they handled, a multiple
+//  of their width
+
+std::size_t swizzle_sse2(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    const auto green_alpha = _mm_set1_epi32(static_cast<int>(0xFF00FF00u));
+    std::size_t i = 0;
+    for (; i + 4 <= p_count; i += 4)
+    {
+        const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_source + i * 4));
+        const auto red_blue = _mm_andnot_si128(green_alpha, pixels);
+        const auto swapped = _mm_or_si128(_mm_slli_epi32(red_blue, 16), _mm_srli_epi32(red_blue, 16));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(p_target + i * 4),
+            _mm_or_si128(_mm_and_si128(pixels, green_alpha), swapped));
+    }
+    return i;
+}
+
+
+FT_RF_TARGET_AVX2
+std::size_t swizzle_avx2(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    const auto order = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    std::size_t i = 0;
+    for (; i + 8 <= p_count; i += 8)
+    {
+        const auto pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_source + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p_target + i * 4), _mm256_shuffle_epi8(pixels, order));
+    }
+    return i;
+}
+
+
+// SSE2 has no byte shuffle, RGB expansion needs SSSE3 and runs with AVX2
+FT_RF_TARGET_AVX2
+std::size_t expand_avx2(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    const auto order = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const auto alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+
+    // Each 16 byte load uses 12 bytes, stop before reading past the source
+    std::size_t i = 0;
+    for (; i + 6 <= p_count; i += 4)
+    {
+        const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_source + i * 3));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(p_target + i * 4),
+            _mm_or_si128(_mm_shuffle_epi8(pixels, order), alpha));
+    }
+    return i;
+}
+
+
+// Multiply 2 pixels widened to 16 bits by their alpha
+__m128i multiply_sse2(const __m128i p_pixels)
+{
+    const auto alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(p_pixels, 0xFF), 0xFF);
+    const auto value = _mm_add_epi16(_mm_mullo_epi16(p_pixels, alpha), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(value, _mm_srli_epi16(value, 8)), 8);
+}
+
+
+std::size_t premultiply_sse2(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    const auto zero = _mm_setzero_si128();
+    const auto alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+
+    std::size_t i = 0;
+    for (; i + 4 <= p_count; i += 4)
+    {
+        const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_source + i * 4));
+        const auto result = _mm_packus_epi16(
+            multiply_sse2(_mm_unpacklo_epi8(pixels, zero)),
+            multiply_sse2(_mm_unpackhi_epi8(pixels, zero)));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(p_target + i * 4),
+            _mm_or_si128(_mm_andnot_si128(alpha_mask, result), _mm_and_si128(pixels, alpha_mask)));
+    }
+    return i;
+}
+
+
+// Multiply 4 pixels widened to 16 bits by their alpha
+FT_RF_TARGET_AVX2
+__m256i multiply_avx2(const __m256i p_pixels)
+{
+    const auto alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(p_pixels, 0xFF), 0xFF);
+    const auto value = _mm256_add_epi16(_mm256_mullo_epi16(p_pixels, alpha), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(value, _mm256_srli_epi16(value, 8)), 8);
+}
+
+
+FT_RF_TARGET_AVX2
+std::size_t premultiply_avx2(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    const auto zero = _mm256_setzero_si256();
+    const auto alpha_mask = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+
+    // Unpacking and packing both work within 128 bit lanes, the order is kept
+    std::size_t i = 0;
+    for (; i + 8 <= p_count; i += 8)
+    {
+        const auto pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_source + i * 4));
+        const auto result = _mm256_packus_epi16(
+            multiply_avx2(_mm256_unpacklo_epi8(pixels, zero)),
+            multiply_avx2(_mm256_unpackhi_epi8(pixels, zero)));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(p_target + i * 4),
+            _mm256_or_si256(_mm256_andnot_si256(alpha_mask, result), _mm256_and_si256(pixels, alpha_mask)));
+    }
+    return i;
+}
+
+
+// Divide one pixel widened to 32 bits by its alpha, 0 if there is none
+__m128i divide_sse2(const __m128i p_pixel)
+{
+    const auto channels = _mm_cvtepi32_ps(p_pixel);
+    const auto alpha = _mm_shuffle_ps(channels, channels, 0xFF);
+    const auto value = _mm_add_ps(_mm_div_ps(_mm_mul_ps(channels, _mm_set1_ps(255.f)), alpha), _mm_set1_ps(0.5f));
+    return _mm_cvttps_epi32(_mm_and_ps(value, _mm_cmpneq_ps(alpha, _mm_setzero_ps())));
+}
+
+
+std::size_t unpremultiply_sse2(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    const auto zero = _mm_setzero_si128();
+    const auto alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+
+    std::size_t i = 0;
+    for (; i + 4 <= p_count; i += 4)
+    {
+        const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_source + i * 4));
+        const auto low = _mm_unpacklo_epi8(pixels, zero);
+        const auto high = _mm_unpackhi_epi8(pixels, zero);
+
+        // Values above 255 saturate when packed
+        const auto result = _mm_packus_epi16(
+            _mm_packs_epi32(divide_sse2(_mm_unpacklo_epi16(low, zero)), divide_sse2(_mm_unpackhi_epi16(low, zero))),
+            _mm_packs_epi32(divide_sse2(_mm_unpacklo_epi16(high, zero)), divide_sse2(_mm_unpackhi_epi16(high, zero))));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(p_target + i * 4),
+            _mm_or_si128(_mm_andnot_si128(alpha_mask, result), _mm_and_si128(pixels, alpha_mask)));
+    }
+    return i;
+}
+
+
+// Divide 2 pixels widened to 32 bits, one per lane, by their alpha,
+//  0 if there is none
+FT_RF_TARGET_AVX2
+__m256i divide_avx2(const __m256i p_pixels)
+{
+    const auto channels = _mm256_cvtepi32_ps(p_pixels);
+    const auto alpha = _mm256_permute_ps(channels, 0xFF);
+    const auto value = _mm256_add_ps(_mm256_div_ps(_mm256_mul_ps(channels, _mm256_set1_ps(255.f)), alpha), _mm256_set1_ps(0.5f));
+    return _mm256_cvttps_epi32(_mm256_and_ps(value, _mm256_cmp_ps(alpha, _mm256_setzero_ps(), _CMP_NEQ_OQ)));
+}
+
+
+FT_RF_TARGET_AVX2
+std::size_t unpremultiply_avx2(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    const auto zero = _mm256_setzero_si256();
+    const auto alpha_mask = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+
+    // Every unpack and pack works within 128 bit lanes, the order is kept
+    std::size_t i = 0;
+    for (; i + 8 <= p_count; i += 8)
+    {
+        const auto pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_source + i * 4));
+        const auto low = _mm256_unpacklo_epi8(pixels, zero);
+        const auto high = _mm256_unpackhi_epi8(pixels, zero);
+
+        // Values above 255 saturate when packed
+        const auto result = _mm256_packus_epi16(
+            _mm256_packs_epi32(divide_avx2(_mm256_unpacklo_epi16(low, zero)), divide_avx2(_mm256_unpackhi_epi16(low, zero))),
+            _mm256_packs_epi32(divide_avx2(_mm256_unpacklo_epi16(high, zero)), divide_avx2(_mm256_unpackhi_epi16(high, zero))));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(p_target + i * 4),
+            _mm256_or_si256(_mm256_andnot_si256(alpha_mask, result), _mm256_and_si256(pixels, alpha_mask)));
+    }
+    return i;
+}
+
+
+// SSE2 has no gather, the table is read lane by lane and the 4 pixels
+//  are stored whole
+std::size_t srgb_to_linear_sse2(const std::uint8_t* p_source, float* p_target, const std::size_t p_count)
+{
+    const auto* table = get_srgb_decode_table().data();
+
+    std::size_t i = 0;
+    for (; i + 4 <= p_count; i += 4)
+    {
+        for (std::size_t pixel = 0; pixel < 4; ++pixel)
+        {
+            const auto* source = p_source + (i + pixel) * 4;
+            _mm_storeu_ps(
+                p_target + (i + pixel) * 4,
+                _mm_setr_ps(table[source[0]], table[source[1]], table[source[2]], table[256 + source[3]]));
+        }
+    }
+    return i;
+}
+
+
+FT_RF_TARGET_AVX2
+std::size_t srgb_to_linear_avx2(const std::uint8_t* p_source, float* p_target, const std::size_t p_count)
+{
+    const auto* table = get_srgb_decode_table().data();
+    const auto alpha_offset = _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256);
+
+    std::size_t i = 0;
+    for (; i + 2 <= p_count; i += 2)
+    {
+        const auto pixels = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p_source + i * 4));
+        const auto indices = _mm256_add_epi32(_mm256_cvtepu8_epi32(pixels), alpha_offset);
+        _mm256_storeu_ps(p_target + i * 4, _mm256_i32gather_ps(table, indices, 4));
+    }
+    return i;
+}
+
+
+// Clamping, scaling and rounding are vectorized, the lookups aren't
+std::size_t linear_to_srgb_sse2(const float* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    constexpr auto samples = static_cast<float>(g_srgb_samples - 1);
+    const auto scale = _mm_setr_ps(samples, samples, samples, 255.f);
+    const auto zero = _mm_setzero_ps();
+    const auto one = _mm_set1_ps(1.f);
+
+    std::size_t i = 0;
+    for (; i < p_count; ++i)
+    {
+        // max returns its second operand for NaN
+        const auto values = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(p_source + i * 4), zero), one);
+
+        alignas(16) std::int32_t indices[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvtps_epi32(_mm_mul_ps(values, scale)));
+        encode_pixel(indices, p_target + i * 4);
+    }
+    return i;
+}
+
+
+FT_RF_TARGET_AVX2
+std::size_t linear_to_srgb_avx2(const float* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    const auto* table = get_srgb_encode_table().data();
+    constexpr auto samples = static_cast<float>(g_srgb_samples - 1);
+    const auto scale = _mm256_setr_ps(samples, samples, samples, 255.f, samples, samples, samples, 255.f);
+    const auto alpha_offset = _mm256_setr_epi32(0, 0, 0, g_srgb_samples, 0, 0, 0, g_srgb_samples);
+    const auto zero = _mm256_setzero_ps();
+    const auto one = _mm256_set1_ps(1.f);
+
+    std::size_t i = 0;
+    for (; i + 2 <= p_count; i += 2)
+    {
+        // max returns its second operand for NaN
+        const auto values = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(p_source + i * 4), zero), one);
+        const auto indices = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(values, scale)), alpha_offset);
+        const auto encoded = _mm256_i32gather_epi32(table, indices, 4);
+
+        // Every value is at most 255, packing keeps the low bytes in order
+        const auto words = _mm256_packus_epi32(encoded, encoded);
+        const auto bytes = _mm256_packus_epi16(words, words);
+        const auto low = _mm_cvtsi128_si32(_mm256_castsi256_si128(bytes));
+        const auto high = _mm_cvtsi128_si32(_mm256_extracti128_si256(bytes, 1));
+        std::memcpy(p_target + i * 4, &low, 4);
+        std::memcpy(p_target + i * 4 + 4, &high, 4);
+    }
+    return i;
+}
+
+
+// Weighted sums of 4 pixels widened to 16 bits, 2 per half, to 8 bits
+int weigh_sse2(const __m128i p_low, const __m128i p_high, const __m128i p_weights, const int p_offset)
+{
+    // Each pixel gives two partial sums, added in the even lanes
+    auto low = _mm_madd_epi16(p_low, p_weights);
+    auto high = _mm_madd_epi16(p_high, p_weights);
+    low = _mm_shuffle_epi32(_mm_add_epi32(low, _mm_srli_epi64(low, 32)), _MM_SHUFFLE(3, 1, 2, 0));
+    high = _mm_shuffle_epi32(_mm_add_epi32(high, _mm_srli_epi64(high, 32)), _MM_SHUFFLE(3, 1, 2, 0));
+    auto sums = _mm_unpacklo_epi64(low, high);
+    sums = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(sums, _mm_set1_epi32(128)), 8), _mm_set1_epi32(p_offset));
+    const auto words = _mm_packs_epi32(sums, sums);
+    return _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+}
+
+
+std::size_t rgba_to_yuv444_sse2(
+    const std::uint8_t* p_source,
+    std::uint8_t* p_y,
+    std::uint8_t* p_u,
+    std::uint8_t* p_v,
+    const std::size_t p_count)
+{
+    const auto zero = _mm_setzero_si128();
+    const auto y_weights = _mm_setr_epi16(66, 129, 25, 0, 66, 129, 25, 0);
+    const auto u_weights = _mm_setr_epi16(-38, -74, 112, 0, -38, -74, 112, 0);
+    const auto v_weights = _mm_setr_epi16(112, -94, -18, 0, 112, -94, -18, 0);
+
+    std::size_t i = 0;
+    for (; i + 4 <= p_count; i += 4)
+    {
+        const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_source + i * 4));
+        const auto low = _mm_unpacklo_epi8(pixels, zero);
+        const auto high = _mm_unpackhi_epi8(pixels, zero);
+
+        const auto y = weigh_sse2(low, high, y_weights, 16);
+        const auto u = weigh_sse2(low, high, u_weights, 128);
+        const auto v = weigh_sse2(low, high, v_weights, 128);
+        std::memcpy(p_y + i, &y, 4);
+        std::memcpy(p_u + i, &u, 4);
+        std::memcpy(p_v + i, &v, 4);
+    }
+    return i;
+}
+
+
+// Weighted sums of 8 pixels, the SSE2 path within each 128 bit lane
+FT_RF_TARGET_AVX2
+long long weigh_avx2(const __m256i p_low, const __m256i p_high, const __m256i p_weights, const int p_offset)
+{
+    auto low = _mm256_madd_epi16(p_low, p_weights);
+    auto high = _mm256_madd_epi16(p_high, p_weights);
+    low = _mm256_shuffle_epi32(_mm256_add_epi32(low, _mm256_srli_epi64(low, 32)), _MM_SHUFFLE(3, 1, 2, 0));
+    high = _mm256_shuffle_epi32(_mm256_add_epi32(high, _mm256_srli_epi64(high, 32)), _MM_SHUFFLE(3, 1, 2, 0));
+    auto sums = _mm256_unpacklo_epi64(low, high);
+    sums = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(sums, _mm256_set1_epi32(128)), 8), _mm256_set1_epi32(p_offset));
+
+    // The 4 bytes of each lane are in its first 32 bits
+    const auto words = _mm256_packs_epi32(sums, sums);
+    const auto bytes = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(words, words), _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0));
+    return _mm_cvtsi128_si64(_mm256_castsi256_si128(bytes));
+}
+
+
+FT_RF_TARGET_AVX2
+std::size_t rgba_to_yuv444_avx2(
+    const std::uint8_t* p_source,
+    std::uint8_t* p_y,
+    std::uint8_t* p_u,
+    std::uint8_t* p_v,
+    const std::size_t p_count)
+{
+    const auto zero = _mm256_setzero_si256();
+    const auto y_weights = _mm256_setr_epi16(66, 129, 25, 0, 66, 129, 25, 0, 66, 129, 25, 0, 66, 129, 25, 0);
+    const auto u_weights = _mm256_setr_epi16(-38, -74, 112, 0, -38, -74, 112, 0, -38, -74, 112, 0, -38, -74, 112, 0);
+    const auto v_weights = _mm256_setr_epi16(112, -94, -18, 0, 112, -94, -18, 0, 112, -94, -18, 0, 112, -94, -18, 0);
+
+    std::size_t i = 0;
+    for (; i + 8 <= p_count; i += 8)
+    {
+        const auto pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_source + i * 4));
+        const auto low = _mm256_unpacklo_epi8(pixels, zero);
+        const auto high = _mm256_unpackhi_epi8(pixels, zero);
+
+        const auto y = weigh_avx2(low, high, y_weights, 16);
+        const auto u = weigh_avx2(low, high, u_weights, 128);
+        const auto v = weigh_avx2(low, high, v_weights, 128);
+        std::memcpy(p_y + i, &y, 8);
+        std::memcpy(p_u + i, &u, 8);
+        std::memcpy(p_v + i, &v, 8);
+    }
+    return i;
+}
+
+
+// Sum 2 x 2 pixels widened to 16 bits in the low 64 bits
+__m128i sum_block_sse2(const __m128i p_row0, const __m128i p_row1)
+{
+    const auto sum = _mm_add_epi16(p_row0, p_row1);
+    return _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+}
+
+
+std::size_t downsample_row_sse2(
+    const std::uint8_t* p_row0,
+    const std::uint8_t* p_row1,
+    std::uint8_t* p_target,
+    const std::size_t p_count)
+{
+    const auto zero = _mm_setzero_si128();
+    const auto rounding = _mm_set1_epi16(2);
+
+    std::size_t x = 0;
+    for (; x + 2 <= p_count; x += 2)
+    {
+        const auto row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_row0 + x * 8));
+        const auto row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_row1 + x * 8));
+        const auto low = sum_block_sse2(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+        const auto high = sum_block_sse2(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+        const auto average = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(low, high), rounding), 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p_target + x * 4), _mm_packus_epi16(average, average));
+    }
+    return x;
+}
+
+
+// Sum 2 x 2 pixels widened to 16 bits in the low 64 bits of each lane
+FT_RF_TARGET_AVX2
+__m256i sum_block_avx2(const __m256i p_row0, const __m256i p_row1)
+{
+    const auto sum = _mm256_add_epi16(p_row0, p_row1);
+    return _mm256_add_epi16(sum, _mm256_srli_si256(sum, 8));
+}
+
+
+FT_RF_TARGET_AVX2
+std::size_t downsample_row_avx2(
+    const std::uint8_t* p_row0,
+    const std::uint8_t* p_row1,
+    std::uint8_t* p_target,
+    const std::size_t p_count)
+{
+    const auto zero = _mm256_setzero_si256();
+    const auto rounding = _mm256_set1_epi16(2);
+
+    std::size_t x = 0;
+    for (; x + 4 <= p_count; x += 4)
+    {
+        const auto row0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_row0 + x * 8));
+        const auto row1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_row1 + x * 8));
+
+        // Lanes hold pixels 0 to 3 and 4 to 7, giving outputs 0, 2 and 1, 3
+        const auto low = sum_block_avx2(_mm256_unpacklo_epi8(row0, zero), _mm256_unpacklo_epi8(row1, zero));
+        const auto high = sum_block_avx2(_mm256_unpackhi_epi8(row0, zero), _mm256_unpackhi_epi8(row1, zero));
+        const auto average = _mm256_srli_epi16(_mm256_add_epi16(_mm256_unpacklo_epi64(low, high), rounding), 2);
+        const auto bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(average, average), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p_target + x * 4), _mm256_castsi256_si128(bytes));
+    }
+    return x;
+}
+
+#endif  // FT_RF_SIMD_X86
+
+
+#if defined(FT_RF_SIMD_NEON)
+
+std::size_t swizzle_neon(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= p_count; i += 16)
+    {
+        auto pixels = vld4q_u8(p_source + i * 4);
+        const auto red = pixels.val[0];
+        pixels.val[0] = pixels.val[2];
+        pixels.val[2] = red;
+        vst4q_u8(p_target + i * 4, pixels);
+    }
+    return i;
+}
+
+
+std::size_t expand_neon(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= p_count; i += 16)
+    {
+        const auto pixels = vld3q_u8(p_source + i * 3);
+        auto expanded = uint8x16x4_t{};
+        expanded.val[0] = pixels.val[0];
+        expanded.val[1] = pixels.val[1];
+        expanded.val[2] = pixels.val[2];
+        expanded.val[3] = vdupq_n_u8(255);
+        vst4q_u8(p_target + i * 4, expanded);
+    }
+    return i;
+}
+
+
+// Multiply 8 channels by their alpha
+// (x + ((x + 128) >> 8) + 128) >> 8, the same rounding as the scalar path
+uint8x8_t multiply_neon(const uint8x8_t p_channel, const uint8x8_t p_alpha)
+{
+    const auto value = vmull_u8(p_channel, p_alpha);
+    return vraddhn_u16(value, vrshrq_n_u16(value, 8));
+}
+
+
+std::size_t premultiply_neon(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= p_count; i += 8)
+    {
+        auto pixels = vld4_u8(p_source + i * 4);
+        pixels.val[0] = multiply_neon(pixels.val[0], pixels.val[3]);
+        pixels.val[1] = multiply_neon(pixels.val[1], pixels.val[3]);
+        pixels.val[2] = multiply_neon(pixels.val[2], pixels.val[3]);
+        vst4_u8(p_target + i * 4, pixels);
+    }
+    return i;
+}
+
+
+// No table lookup fits the decoding table, it is read lane by lane
+std::size_t srgb_to_linear_neon(const std::uint8_t* p_source, float* p_target, const std::size_t p_count)
+{
+    const auto* table = get_srgb_decode_table().data();
+
+    std::size_t i = 0;
+    for (; i + 4 <= p_count; i += 4)
+    {
+        for (std::size_t pixel = 0; pixel < 4; ++pixel)
+        {
+            const auto* source = p_source + (i + pixel) * 4;
+            const float values[4] = { table[source[0]], table[source[1]], table[source[2]], table[256 + source[3]] };
+            vst1q_f32(p_target + (i + pixel) * 4, vld1q_f32(values));
+        }
+    }
+    return i;
+}
+
+
+#if defined(FT_RF_SIMD_NEON_A64)
+
+// Divide 4 channels by their alpha, rounded and clamped to 16 bits
+// Alpha 0 gives any value, the caller masks it
+uint16x4_t divide_neon(const uint16x4_t p_channel, const float32x4_t p_alpha)
+{
+    const auto channel = vcvtq_f32_u32(vmovl_u16(p_channel));
+    const auto value = vaddq_f32(vdivq_f32(vmulq_f32(channel, vdupq_n_f32(255.f)), p_alpha), vdupq_n_f32(0.5f));
+    return vqmovn_u32(vcvtq_u32_f32(value));
+}
+
+
+// 32 bit ARM has no vector division, the scalar path runs there
+std::size_t unpremultiply_neon(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= p_count; i += 8)
+    {
+        auto pixels = vld4_u8(p_source + i * 4);
+        const auto alpha = vmovl_u8(pixels.val[3]);
+        const auto alpha_low = vcvtq_f32_u32(vmovl_u16(vget_low_u16(alpha)));
+        const auto alpha_high = vcvtq_f32_u32(vmovl_u16(vget_high_u16(alpha)));
+        const auto has_alpha = vtst_u8(pixels.val[3], pixels.val[3]);
+
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            const auto values = vmovl_u8(pixels.val[channel]);
+            const auto divided = vcombine_u16(
+                divide_neon(vget_low_u16(values), alpha_low),
+                divide_neon(vget_high_u16(values), alpha_high));
+            pixels.val[channel] = vand_u8(vqmovn_u16(divided), has_alpha);
+        }
+        vst4_u8(p_target + i * 4, pixels);
+    }
+    return i;
+}
+
+
+// 32 bit ARM can't convert rounding to nearest even, the scalar path
+//  runs there
+std::size_t linear_to_srgb_neon(const float* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    constexpr auto samples = static_cast<float>(g_srgb_samples - 1);
+    const float scales[4] = { samples, samples, samples, 255.f };
+    const auto scale = vld1q_f32(scales);
+    const auto zero = vdupq_n_f32(0.f);
+    const auto one = vdupq_n_f32(1.f);
+
+    std::size_t i = 0;
+    for (; i < p_count; ++i)
+    {
+        // NaN fails the comparison and becomes 0
+        const auto source = vld1q_f32(p_source + i * 4);
+        const auto values = vbslq_f32(vcgtq_f32(source, zero), vminq_f32(source, one), zero);
+
+        std::int32_t indices[4];
+        vst1q_s32(indices, vcvtnq_s32_f32(vmulq_f32(values, scale)));
+        encode_pixel(indices, p_target + i * 4);
+    }
+    return i;
+}
+
+#endif  // FT_RF_SIMD_NEON_A64
+
+
+// Weighted sums of 8 pixels in 32 bits, to 8 bits
+uint8x8_t weigh_neon(
+    const int16x8_t p_red,
+    const int16x8_t p_green,
+    const int16x8_t p_blue,
+    const std::int16_t p_red_weight,
+    const std::int16_t p_green_weight,
+    const std::int16_t p_blue_weight,
+    const std::int32_t p_offset)
+{
+    auto low = vmull_n_s16(vget_low_s16(p_red), p_red_weight);
+    low = vmlal_n_s16(low, vget_low_s16(p_green), p_green_weight);
+    low = vmlal_n_s16(low, vget_low_s16(p_blue), p_blue_weight);
+    auto high = vmull_n_s16(vget_high_s16(p_red), p_red_weight);
+    high = vmlal_n_s16(high, vget_high_s16(p_green), p_green_weight);
+    high = vmlal_n_s16(high, vget_high_s16(p_blue), p_blue_weight);
+
+    const auto rounding = vdupq_n_s32(128);
+    const auto offset = vdupq_n_s32(p_offset);
+    low = vaddq_s32(vshrq_n_s32(vaddq_s32(low, rounding), 8), offset);
+    high = vaddq_s32(vshrq_n_s32(vaddq_s32(high, rounding), 8), offset);
+    return vqmovun_s16(vcombine_s16(vmovn_s32(low), vmovn_s32(high)));
+}
+
+
+std::size_t rgba_to_yuv444_neon(
+    const std::uint8_t* p_source,
+    std::uint8_t* p_y,
+    std::uint8_t* p_u,
+    std::uint8_t* p_v,
+    const std::size_t p_count)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= p_count; i += 8)
+    {
+        const auto pixels = vld4_u8(p_source + i * 4);
+        const auto red = vreinterpretq_s16_u16(vmovl_u8(pixels.val[0]));
+        const auto green = vreinterpretq_s16_u16(vmovl_u8(pixels.val[1]));
+        const auto blue = vreinterpretq_s16_u16(vmovl_u8(pixels.val[2]));
+        vst1_u8(p_y + i, weigh_neon(red, green, blue, 66, 129, 25, 16));
+        vst1_u8(p_u + i, weigh_neon(red, green, blue, -38, -74, 112, 128));
+        vst1_u8(p_v + i, weigh_neon(red, green, blue, 112, -94, -18, 128));
+    }
+    return i;
+}
+
+
+std::size_t downsample_row_neon(
+    const std::uint8_t* p_row0,
+    const std::uint8_t* p_row1,
+    std::uint8_t* p_target,
+    const std::size_t p_count)
+{
+    std::size_t x = 0;
+    for (; x + 8 <= p_count; x += 8)
+    {
+        const auto row0 = vld4q_u8(p_row0 + x * 8);
+        const auto row1 = vld4q_u8(p_row1 + x * 8);
+
+        // Pairwise sums of each channel, rounded shift by 2 gives (sum + 2) / 4
+        auto result = uint8x8x4_t{};
+        for (int channel = 0; channel < 4; ++channel)
+        {
+            const auto sum = vaddq_u16(vpaddlq_u8(row0.val[channel]), vpaddlq_u8(row1.val[channel]));
+            result.val[channel] = vrshrn_n_u16(sum, 2);
+        }
+        vst4_u8(p_target + x * 4, result);
+    }
+    return x;
+}
+
+#endif  // FT_RF_SIMD_NEON
+
+
+// Copy rows, in reverse order if `p_flip` is set
+void copy_image_rows(
+    const std::uint8_t* p_source,
+    const std::size_t p_source_stride,
+    std::uint8_t* p_target,
+    const std::size_t p_target_stride,
+    const std::size_t p_row_size,
+    const int p_height,
+    const bool p_flip)
+{
+    // Tightly packed images are copied as a single row
+    if (p_flip == false && p_source_stride == p_row_size && p_target_stride == p_row_size && p_height > 1)
+    {
+        copy_image_rows(p_source, 0, p_target, 0, p_row_size * static_cast<std::size_t>(p_height), 1, false);
+        return;
+    }
+
+    const auto target_row = [&](const int p_row) {
+        const auto row = p_flip ? p_height - 1 - p_row : p_row;
+        return p_target + static_cast<std::size_t>(row) * p_target_stride;
+    };
+
+#if defined(FT_RF_SIMD_X86)
+    // SSE2 has the non-temporal stores, wider ones aren't any faster
+    //  since the copy is bound by memory bandwidth
+    const auto total = p_row_size * static_cast<std::size_t>(std::max(p_height, 0));
+    if (get_enabled_features().sse2 && total >= g_stream_threshold)
+    {
+        for (int y = 0; y < p_height; ++y)
+        {
+            stream_row_sse2(p_source + static_cast<std::size_t>(y) * p_source_stride, target_row(y), p_row_size);
+        }
+
+        // Non-temporal stores are weakly ordered, publish them before
+        //  the caller hands the image over
+        _mm_sfence();
+        return;
+    }
+#endif
+
+    // memcpy is already vectorized by the C library, rows are copied whole
+    for (int y = 0; y < p_height; ++y)
+    {
+        std::memcpy(target_row(y), p_source + static_cast<std::size_t>(y) * p_source_stride, p_row_size);
+    }
+}
+
+
+}   // anonymous namespace
+
+
+// Get the instruction set used by the kernels on the running CPU
+ft::rf::simd::t_kernel_path ft::rf::simd::get_kernel_path()
+{
+    const auto features = get_enabled_features();
+    if (features.avx2) {
+        return t_kernel_path::avx2;
+    }
+    if (features.sse2) {
+        return t_kernel_path::sse2;
+    }
+    if (features.neon) {
+        return t_kernel_path::neon;
+    }
+    return t_kernel_path::scalar;
+}
+
+
+// Restrict the kernels to an instruction set
+void ft::rf::simd::set_kernel_path(const t_kernel_path p_path)
+{
+    g_path_limit.store(p_path, std::memory_order_relaxed);
+}
+
+
+// Swap the red and blue channels, RGBA8 to BGRA8 or back
+void ft::rf::simd::swizzle_rgba_bgra(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    std::size_t done = 0;
+    const auto features = get_enabled_features();
+#if defined(FT_RF_SIMD_X86)
+    if (features.avx2) {
+        done = swizzle_avx2(p_source, p_target, p_count);
+    }
+    else if (features.sse2) {
+        done = swizzle_sse2(p_source, p_target, p_count);
+    }
+#elif defined(FT_RF_SIMD_NEON)
+    if (features.neon) {
+        done = swizzle_neon(p_source, p_target, p_count);
+    }
+#endif
+    (void)features;
+    swizzle_scalar(p_source + done * 4, p_target + done * 4, p_count - done);
+}
+
+
+// Expand RGB8 to RGBA8 with opaque alpha
+void ft::rf::simd::expand_rgb_rgba(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    std::size_t done = 0;
+    const auto features = get_enabled_features();
+#if defined(FT_RF_SIMD_X86)
+    if (features.avx2) {
+        done = expand_avx2(p_source, p_target, p_count);
+    }
+#elif defined(FT_RF_SIMD_NEON)
+    if (features.neon) {
+        done = expand_neon(p_source, p_target, p_count);
+    }
+#endif
+    (void)features;
+    expand_scalar(p_source + done * 3, p_target + done * 4, p_count - done);
+}
+
+
+// Multiply the color channels of RGBA8 pixels by their alpha, rounded
+void ft::rf::simd::premultiply_alpha(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    std::size_t done = 0;
+    const auto features = get_enabled_features();
+#if defined(FT_RF_SIMD_X86)
+    if (features.avx2) {
+        done = premultiply_avx2(p_source, p_target, p_count);
+    }
+    else if (features.sse2) {
+        done = premultiply_sse2(p_source, p_target, p_count);
+    }
+#elif defined(FT_RF_SIMD_NEON)
+    if (features.neon) {
+        done = premultiply_neon(p_source, p_target, p_count);
+    }
+#endif
+    (void)features;
+    premultiply_scalar(p_source + done * 4, p_target + done * 4, p_count - done);
+}
+
+
+// Divide the color channels of premultiplied RGBA8 pixels by their alpha,
+//  rounded and clamped, pixels with no alpha become transparent black
+void ft::rf::simd::unpremultiply_alpha(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    std::size_t done = 0;
+    const auto features = get_enabled_features();
+#if defined(FT_RF_SIMD_X86)
+    if (features.avx2) {
+        done = unpremultiply_avx2(p_source, p_target, p_count);
+    }
+    else if (features.sse2) {
+        done = unpremultiply_sse2(p_source, p_target, p_count);
+    }
+#elif defined(FT_RF_SIMD_NEON_A64)
+    if (features.neon) {
+        done = unpremultiply_neon(p_source, p_target, p_count);
+    }
+#endif
+    (void)features;
+    unpremultiply_scalar(p_source + done * 4, p_target + done * 4, p_count - done);
+}
+
+
+// Decode sRGB RGBA8 pixels to linear RGBA floats, alpha is linear already
+void ft::rf::simd::srgb_to_linear(const std::uint8_t* p_source, float* p_target, const std::size_t p_count)
+{
+    std::size_t done = 0;
+    const auto features = get_enabled_features();
+#if defined(FT_RF_SIMD_X86)
+    if (features.avx2) {
+        done = srgb_to_linear_avx2(p_source, p_target, p_count);
+    }
+    else if (features.sse2) {
+        done = srgb_to_linear_sse2(p_source, p_target, p_count);
+    }
+#elif defined(FT_RF_SIMD_NEON)
+    if (features.neon) {
+        done = srgb_to_linear_neon(p_source, p_target, p_count);
+    }
+#endif
+    (void)features;
+    srgb_to_linear_scalar(p_source + done * 4, p_target + done * 4, p_count - done);
+}
+
+
+// Encode linear RGBA floats to sRGB RGBA8 pixels, values are clamped to [0, 1]
+void ft::rf::simd::linear_to_srgb(const float* p_source, std::uint8_t* p_target, const std::size_t p_count)
+{
+    std::size_t done = 0;
+    const auto features = get_enabled_features();
+#if defined(FT_RF_SIMD_X86)
+    if (features.avx2) {
+        done = linear_to_srgb_avx2(p_source, p_target, p_count);
+    }
+    else if (features.sse2) {
+        done = linear_to_srgb_sse2(p_source, p_target, p_count);
+    }
+#elif defined(FT_RF_SIMD_NEON_A64)
+    if (features.neon) {
+        done = linear_to_srgb_neon(p_source, p_target, p_count);
+    }
+#endif
+    (void)features;
+    linear_to_srgb_scalar(p_source + done * 4, p_target + done * 4, p_count - done);
+}
+
+
+// Convert RGBA8 pixels to BT.601 limited range Y, U and V planes
+void ft::rf::simd::rgba_to_yuv444(
+    const std::uint8_t* p_source,
+    std::uint8_t* p_y,
+    std::uint8_t* p_u,
+    std::uint8_t* p_v,
+    const std::size_t p_count)
+{
+    std::size_t done = 0;
+    const auto features = get_enabled_features();
+#if defined(FT_RF_SIMD_X86)
+    if (features.avx2) {
+        done = rgba_to_yuv444_avx2(p_source, p_y, p_u, p_v, p_count);
+    }
+    else if (features.sse2) {
+        done = rgba_to_yuv444_sse2(p_source, p_y, p_u, p_v, p_count);
+    }
+#elif defined(FT_RF_SIMD_NEON)
+    if (features.neon) {
+        done = rgba_to_yuv444_neon(p_source, p_y, p_u, p_v, p_count);
+    }
+#endif
+    (void)features;
+    rgba_to_yuv444_scalar(p_source + done * 4, p_y + done, p_u + done, p_v + done, p_count - done);
+}
+
+
+// Copy `p_height` rows of `p_row_size` bytes
+void ft::rf::simd::copy_rows(
+    const std::uint8_t* p_source,
+    const std::size_t p_source_stride,
+    std::uint8_t* p_target,
+    const std::size_t p_target_stride,
+    const std::size_t p_row_size,
+    const int p_height)
+{
+    copy_image_rows(p_source, p_source_stride, p_target, p_target_stride, p_row_size, p_height, false);
+}
+
+
+// Copy `p_height` rows of `p_row_size` bytes, reversing their order
+void ft::rf::simd::flip_rows(
+    const std::uint8_t* p_source,
+    const std::size_t p_source_stride,
+    std::uint8_t* p_target,
+    const std::size_t p_target_stride,
+    const std::size_t p_row_size,
+    const int p_height)
+{
+    copy_image_rows(p_source, p_source_stride, p_target, p_target_stride, p_row_size, p_height, true);
+}
+
+
+// Halve a `p_width` x `p_height` RGBA8 image, averaging 2 x 2 blocks
+void ft::rf::simd::downsample_2x2(
+    const std::uint8_t* p_source,
+    const int p_width,
+    const int p_height,
+    std::uint8_t* p_target)
+{
+    const auto target_width = static_cast<std::size_t>(std::max(p_width / 2, 1));
+    const auto target_height = std::max(p_height / 2, 1);
+    const auto row_size = static_cast<std::size_t>(p_width) * 4;
+    const auto features = get_enabled_features();
+    (void)features;
+
+    for (int y = 0; y < target_height; ++y)
+    {
+        const auto* row0 = p_source + static_cast<std::size_t>(std::min(y * 2, p_height - 1)) * row_size;
+        const auto* row1 = p_source + static_cast<std::size_t>(std::min(y * 2 + 1, p_height - 1)) * row_size;
+        auto* target = p_target + static_cast<std::size_t>(y) * target_width * 4;
+
+        // A single column is averaged with itself
+        if (p_width == 1)
+        {
+            for (std::size_t channel = 0; channel < 4; ++channel)
+            {
+                target[channel] = static_cast<std::uint8_t>((row0[channel] * 2 + row1[channel] * 2 + 2) / 4);
+            }
+            continue;
+        }
+
+        std::size_t done = 0;
+#if defined(FT_RF_SIMD_X86)
+        if (features.avx2) {
+            done = downsample_row_avx2(row0, row1, target, target_width);
+        }
+        else if (features.sse2) {
+            done = downsample_row_sse2(row0, row1, target, target_width);
+        }
+#elif defined(FT_RF_SIMD_NEON)
+        if (features.neon) {
+            done = downsample_row_neon(row0, row1, target, target_width);
+        }
+#endif
+        downsample_row_scalar(row0 + done * 8, row1 + done * 8, target + done * 4, target_width - done);
+    }
+}
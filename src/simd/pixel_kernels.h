@@ -0,0 +1,99 @@
+#pragma once
+
+// Pixel format conversion and resampling kernels
+//
+// Each kernel picks the widest instruction set the running CPU supports,
+//  AVX2 or SSE2 on x86 and NEON on ARM, and finishes the pixels left
+//  over with a scalar loop giving the same results
+// Pixels are 8 bits per channel and tightly packed unless stated otherwise
+// Source and target may be the same buffer for kernels that keep the
+//  pixel size, but must not otherwise overlap
+
+// standard headers
+#include <cstddef>
+#include <cstdint>
+
+namespace ft {
+namespace rf {
+namespace simd {
+
+// Instruction set used by the kernels
+enum class t_kernel_path {
+    scalar,
+    sse2,
+    avx2,
+    neon
+};
+
+// Get the instruction set used by the kernels on the running CPU
+t_kernel_path get_kernel_path();
+
+// Restrict the kernels to `p_path`, or to the widest set the CPU supports
+//  if it lacks `p_path`, used to compare the paths with each other
+// The default is the widest set, `scalar` disables every vector path
+void set_kernel_path(const t_kernel_path p_path);
+
+
+// Swap the red and blue channels, RGBA8 to BGRA8 or back
+void swizzle_rgba_bgra(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count);
+
+// Expand RGB8 to RGBA8 with opaque alpha
+void expand_rgb_rgba(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count);
+
+// Multiply the color channels of RGBA8 pixels by their alpha, rounded
+void premultiply_alpha(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count);
+
+// Divide the color channels of premultiplied RGBA8 pixels by their alpha,
+//  rounded and clamped, pixels with no alpha become transparent black
+void unpremultiply_alpha(const std::uint8_t* p_source, std::uint8_t* p_target, const std::size_t p_count);
+
+// Decode sRGB RGBA8 pixels to linear RGBA floats, alpha is linear already
+void srgb_to_linear(const std::uint8_t* p_source, float* p_target, const std::size_t p_count);
+
+// Encode linear RGBA floats to sRGB RGBA8 pixels, values are clamped to [0, 1]
+// The transfer function is sampled at 4096 points
+void linear_to_srgb(const float* p_source, std::uint8_t* p_target, const std::size_t p_count);
+
+// Convert RGBA8 pixels to BT.601 limited range Y, U and V planes
+void rgba_to_yuv444(
+    const std::uint8_t* p_source,
+    std::uint8_t* p_y,
+    std::uint8_t* p_u,
+    std::uint8_t* p_v,
+    const std::size_t p_count);
+
+// Copy `p_height` rows of `p_row_size` bytes
+// Strides are the bytes between the start of two rows
+// Large images are written with non-temporal stores on x86, so handing
+//  a frame to another thread or process doesn't evict the caller's caches
+// The source and target must not overlap
+void copy_rows(
+    const std::uint8_t* p_source,
+    const std::size_t p_source_stride,
+    std::uint8_t* p_target,
+    const std::size_t p_target_stride,
+    const std::size_t p_row_size,
+    const int p_height);
+
+// Same as `copy_rows`, reversing the order of the rows
+// Turns bottom-up OpenGL read backs into top-down images and back
+void flip_rows(
+    const std::uint8_t* p_source,
+    const std::size_t p_source_stride,
+    std::uint8_t* p_target,
+    const std::size_t p_target_stride,
+    const std::size_t p_row_size,
+    const int p_height);
+
+// Halve a `p_width` x `p_height` RGBA8 image, averaging 2 x 2 blocks
+// The target is max(p_width / 2, 1) x max(p_height / 2, 1), the last row
+//  or column of an odd size image is reused
+void downsample_2x2(
+    const std::uint8_t* p_source,
+    const int p_width,
+    const int p_height,
+    std::uint8_t* p_target);
+
+}   // namespace simd
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,78 @@
+#include "soft_framebuffer.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+
+// Constructor
+ft::rf::soft::soft_framebuffer::soft_framebuffer(const int p_width, const int p_height) :
+    m_width(p_width),
+    m_height(p_height),
+    m_color(static_cast<std::size_t>(p_width) * p_height),
+    m_depth(static_cast<std::size_t>(p_width) * p_height, 1.f)
+{
+    FT_ASSERT(p_width > 0 && p_height > 0);
+}
+
+
+// Fill the color buffer with `p_color` and the depth buffer with the far plane
+void ft::rf::soft::soft_framebuffer::clear(const gl::color<float> & p_color)
+{
+    std::fill(m_color.begin(), m_color.end(), pack(p_color.red, p_color.green, p_color.blue, 1.f));
+    std::fill(m_depth.begin(), m_depth.end(), 1.f);
+}
+
+
+// Dimensions in pixels
+int ft::rf::soft::soft_framebuffer::get_width() const
+{
+    return m_width;
+}
+
+int ft::rf::soft::soft_framebuffer::get_height() const
+{
+    return m_height;
+}
+
+
+// Pixel rows, bottom row first
+std::uint32_t * ft::rf::soft::soft_framebuffer::get_color()
+{
+    return m_color.data();
+}
+
+const std::uint32_t * ft::rf::soft::soft_framebuffer::get_color() const
+{
+    return m_color.data();
+}
+
+float * ft::rf::soft::soft_framebuffer::get_depth()
+{
+    return m_depth.data();
+}
+
+const float * ft::rf::soft::soft_framebuffer::get_depth() const
+{
+    return m_depth.data();
+}
+
+
+// Pack a color to RGBA8
+std::uint32_t ft::rf::soft::soft_framebuffer::pack(
+    const float p_red,
+    const float p_green,
+    const float p_blue,
+    const float p_alpha)
+{
+    auto channel = [](const float p_value) {
+        const auto clamped = std::clamp(p_value, 0.f, 1.f);
+        return static_cast<std::uint32_t>(clamped * 255.f + 0.5f);
+    };
+
+    return channel(p_red) |
+        (channel(p_green) << 8) |
+        (channel(p_blue) << 16) |
+        (channel(p_alpha) << 24);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+// In-memory color and depth buffers rendered to by the software rasterizer
+// Rows are stored bottom-up like an OpenGL framebuffer
+// Colors are RGBA8, stored as bytes R, G, B, A in memory
+
+// other projects
+#include "basegl/color.h"
+
+// standard headers
+#include <cstdint>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace soft {
+
+class soft_framebuffer
+{
+public:
+    // Constructor
+    soft_framebuffer(const int p_width, const int p_height);
+
+    // Fill the color buffer with `p_color` and the depth buffer with the far plane
+    void clear(const gl::color<float>& p_color);
+
+    // Dimensions in pixels
+    int get_width() const;
+    int get_height() const;
+
+    // Pixel rows, bottom row first
+    std::uint32_t* get_color();
+    const std::uint32_t* get_color() const;
+    float* get_depth();
+    const float* get_depth() const;
+
+    // Pack a color to RGBA8
+    static std::uint32_t pack(const float p_red, const float p_green, const float p_blue, const float p_alpha);
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+
+    std::vector<std::uint32_t> m_color;
+    std::vector<float> m_depth;
+
+};  // class soft_framebuffer
+
+}   // namespace soft
+}   // namespace rf
+}   // namespace ft
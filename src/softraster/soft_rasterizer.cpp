@@ -0,0 +1,710 @@
+#include "soft_rasterizer.h"
+
+// project headers
+#include "simd/cpu_features.h"
+
+// other projects
+#include "error/ft_assert.h"
+
+// standard headers
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined(FT_RF_SIMD_X86)
+    #include <immintrin.h>
+#endif
+
+namespace {
+
+// Unpack an RGBA8 color to floats in [0, 1]
+void unpack(const std::uint32_t p_color, float (&p_out)[4])
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        p_out[i] = static_cast<float>((p_color >> (8 * i)) & 0xFF) / 255.f;
+    }
+}
+
+// Wrap a texel coordinate for repeat addressing
+int wrap(const float p_coordinate, const int p_size)
+{
+    const auto texel = static_cast<int>(std::floor(p_coordinate * static_cast<float>(p_size)));
+    const auto wrapped = texel % p_size;
+    return wrapped < 0 ? wrapped + p_size : wrapped;
+}
+
+}   // anonymous namespace
+
+
+// Constructor
+// Renders with `p_threads` threads including the caller, 0 uses every core
+ft::rf::soft::soft_rasterizer::soft_rasterizer(soft_framebuffer & p_target, unsigned int p_threads) :
+    m_target(&p_target)
+{
+    m_tiles_x = (p_target.get_width() + s_tile_size - 1) / s_tile_size;
+    m_tiles_y = (p_target.get_height() + s_tile_size - 1) / s_tile_size;
+    m_bins.resize(static_cast<std::size_t>(m_tiles_x) * m_tiles_y);
+
+    const auto & features = simd::get_cpu_features();
+    m_use_avx2 = features.avx2;
+    m_use_sse2 = features.sse2;
+
+    if (p_threads == 0)
+    {
+        p_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // The calling thread renders too
+    for (unsigned int i = 1; i < p_threads; ++i)
+    {
+        m_workers.emplace_back([this]() { run_worker(); });
+    }
+}
+
+
+// Destructor
+// Stops the worker threads
+ft::rf::soft::soft_rasterizer::~soft_rasterizer()
+{
+    {
+        std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+        m_stop = true;
+    }
+    m_start_condition.notify_all();
+
+    for (auto & worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+
+// Render state applied to the following draws
+void ft::rf::soft::soft_rasterizer::set_polygon_mode(const t_polygon_mode p_mode)
+{
+    m_polygon_mode = p_mode;
+}
+
+ft::rf::soft::soft_rasterizer::t_polygon_mode
+ft::rf::soft::soft_rasterizer::get_polygon_mode() const
+{
+    return m_polygon_mode;
+}
+
+void ft::rf::soft::soft_rasterizer::set_culling_mode(const t_culling_mode p_mode)
+{
+    m_culling_mode = p_mode;
+}
+
+ft::rf::soft::soft_rasterizer::t_culling_mode
+ft::rf::soft::soft_rasterizer::get_culling_mode() const
+{
+    return m_culling_mode;
+}
+
+void ft::rf::soft::soft_rasterizer::set_depth_test_mode(const t_depth_buffering p_mode)
+{
+    m_depth_buffering = p_mode;
+}
+
+ft::rf::soft::soft_rasterizer::t_depth_buffering
+ft::rf::soft::soft_rasterizer::get_depth_test_mode() const
+{
+    return m_depth_buffering;
+}
+
+void ft::rf::soft::soft_rasterizer::set_blending_mode(const t_blend_mode p_mode)
+{
+    m_blending_mode = p_mode;
+}
+
+ft::rf::soft::soft_rasterizer::t_blend_mode
+ft::rf::soft::soft_rasterizer::get_blending_mode() const
+{
+    return m_blending_mode;
+}
+
+
+// Queue a list of triangles, 3 vertices each
+// The color is multiplied with the texture if one is provided
+void ft::rf::soft::soft_rasterizer::draw(
+    std::span<const t_soft_vertex> p_vertices,
+    const gl::color<float> & p_color,
+    const float p_alpha,
+    const t_soft_texture * p_texture)
+{
+    FT_ASSERT(p_vertices.size() % 3 == 0);
+
+    auto state = t_draw_state{
+        m_polygon_mode,
+        m_depth_buffering,
+        m_blending_mode,
+        { p_color.red, p_color.green, p_color.blue, p_alpha },
+        p_texture != nullptr ? *p_texture : t_soft_texture{}
+    };
+    m_states.push_back(state);
+
+    for (std::size_t i = 0; i + 2 < p_vertices.size(); i += 3)
+    {
+        add_triangle(p_vertices[i], p_vertices[i + 1], p_vertices[i + 2]);
+    }
+}
+
+
+// Render every queued draw
+void ft::rf::soft::soft_rasterizer::flush()
+{
+    if (m_primitives.empty() == false)
+    {
+        bin();
+
+        m_remaining_tiles = m_bins.size();
+        m_next_tile = 0;
+        {
+            std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+            ++m_generation;
+        }
+        m_start_condition.notify_all();
+
+        run_tiles();
+
+        std::unique_lock<decltype(m_mutex)> lock{ m_mutex };
+        m_done_condition.wait(lock, [this]() {
+            return m_remaining_tiles.load() == 0;
+        });
+    }
+
+    m_primitives.clear();
+    m_states.clear();
+}
+
+
+// Number of threads used to render
+unsigned int ft::rf::soft::soft_rasterizer::get_thread_count() const
+{
+    return static_cast<unsigned int>(m_workers.size() + 1);
+}
+
+
+// Queue a triangle, applying face culling
+void ft::rf::soft::soft_rasterizer::add_triangle(
+    const t_soft_vertex & p_a,
+    const t_soft_vertex & p_b,
+    const t_soft_vertex & p_c)
+{
+    // Counter-clockwise triangles face the viewer
+    const auto area = (p_b.x - p_a.x) * (p_c.y - p_a.y) - (p_c.x - p_a.x) * (p_b.y - p_a.y);
+    if (area == 0.f)
+    {
+        return;
+    }
+
+    const auto front = area > 0.f;
+    switch (m_culling_mode)
+    {
+    case t_culling_mode::back_culling:
+        if (front == false) return;
+        break;
+    case t_culling_mode::front_culling:
+        if (front) return;
+        break;
+    case t_culling_mode::full_culling:
+        return;
+    case t_culling_mode::no_culling:
+    default:
+        break;
+    }
+
+    if (m_polygon_mode == t_polygon_mode::line)
+    {
+        add_line(p_a, p_b);
+        add_line(p_b, p_c);
+        add_line(p_c, p_a);
+        return;
+    }
+    if (m_polygon_mode == t_polygon_mode::point)
+    {
+        add_point(p_a);
+        add_point(p_b);
+        add_point(p_c);
+        return;
+    }
+
+    // Make the winding counter-clockwise so the edge functions are positive inside
+    const t_soft_vertex* v[3] = { &p_a, &p_b, &p_c };
+    if (front == false)
+    {
+        std::swap(v[1], v[2]);
+    }
+    const auto abs_area = std::abs(area);
+
+    auto primitive = t_primitive{};
+    primitive.kind = t_kind::triangle;
+    primitive.state = static_cast<std::uint32_t>(m_states.size() - 1);
+
+    // Edge i is opposite of vertex i
+    for (int i = 0; i < 3; ++i)
+    {
+        const auto & a = *v[(i + 1) % 3];
+        const auto & b = *v[(i + 2) % 3];
+        auto & edge = primitive.edges[i];
+        edge.dx = a.y - b.y;
+        edge.dy = b.x - a.x;
+        edge.c = a.x * b.y - a.y * b.x;
+
+        // Pixels exactly on an edge belong to the triangle
+        //  only if it is a top or left edge
+        primitive.top_left[i] = edge.dx > 0.f || (edge.dx == 0.f && edge.dy < 0.f);
+    }
+
+    // Attributes are the barycentric weighted sum of the vertex attributes
+    auto make_plane = [&](auto p_attribute) {
+        auto plane = t_plane{};
+        for (int i = 0; i < 3; ++i)
+        {
+            const auto value = p_attribute(*v[i]) / abs_area;
+            plane.dx += value * primitive.edges[i].dx;
+            plane.dy += value * primitive.edges[i].dy;
+            plane.c += value * primitive.edges[i].c;
+        }
+        return plane;
+    };
+    primitive.z = make_plane([](const t_soft_vertex & p_vertex) { return p_vertex.z; });
+    primitive.u = make_plane([](const t_soft_vertex & p_vertex) { return p_vertex.u; });
+    primitive.v = make_plane([](const t_soft_vertex & p_vertex) { return p_vertex.v; });
+
+    const auto min_x = std::min({ p_a.x, p_b.x, p_c.x });
+    const auto min_y = std::min({ p_a.y, p_b.y, p_c.y });
+    const auto max_x = std::max({ p_a.x, p_b.x, p_c.x });
+    const auto max_y = std::max({ p_a.y, p_b.y, p_c.y });
+    primitive.min_x = std::max(static_cast<int>(std::floor(min_x)), 0);
+    primitive.min_y = std::max(static_cast<int>(std::floor(min_y)), 0);
+    primitive.max_x = std::min(static_cast<int>(std::ceil(max_x)), m_target->get_width() - 1);
+    primitive.max_y = std::min(static_cast<int>(std::ceil(max_y)), m_target->get_height() - 1);
+
+    if (primitive.min_x <= primitive.max_x && primitive.min_y <= primitive.max_y)
+    {
+        m_primitives.push_back(primitive);
+    }
+}
+
+
+// Queue a line
+void ft::rf::soft::soft_rasterizer::add_line(const t_soft_vertex & p_a, const t_soft_vertex & p_b)
+{
+    auto primitive = t_primitive{};
+    primitive.kind = t_kind::line;
+    primitive.state = static_cast<std::uint32_t>(m_states.size() - 1);
+    primitive.ends[0] = p_a;
+    primitive.ends[1] = p_b;
+
+    primitive.min_x = std::max(static_cast<int>(std::floor(std::min(p_a.x, p_b.x))), 0);
+    primitive.min_y = std::max(static_cast<int>(std::floor(std::min(p_a.y, p_b.y))), 0);
+    primitive.max_x = std::min(static_cast<int>(std::floor(std::max(p_a.x, p_b.x))), m_target->get_width() - 1);
+    primitive.max_y = std::min(static_cast<int>(std::floor(std::max(p_a.y, p_b.y))), m_target->get_height() - 1);
+
+    if (primitive.min_x <= primitive.max_x && primitive.min_y <= primitive.max_y)
+    {
+        m_primitives.push_back(primitive);
+    }
+}
+
+
+// Queue a point
+// Rendered as a line of length 0
+void ft::rf::soft::soft_rasterizer::add_point(const t_soft_vertex & p_a)
+{
+    const auto count = m_primitives.size();
+    add_line(p_a, p_a);
+    if (m_primitives.size() != count)
+    {
+        m_primitives.back().kind = t_kind::point;
+    }
+}
+
+
+// Sort the primitives into the tiles they overlap
+void ft::rf::soft::soft_rasterizer::bin()
+{
+    for (auto & bin : m_bins)
+    {
+        bin.clear();
+    }
+
+    for (std::size_t index = 0; index < m_primitives.size(); ++index)
+    {
+        const auto & primitive = m_primitives[index];
+        const auto first_x = primitive.min_x / s_tile_size;
+        const auto first_y = primitive.min_y / s_tile_size;
+        const auto last_x = primitive.max_x / s_tile_size;
+        const auto last_y = primitive.max_y / s_tile_size;
+
+        for (auto tile_y = first_y; tile_y <= last_y; ++tile_y)
+        {
+            for (auto tile_x = first_x; tile_x <= last_x; ++tile_x)
+            {
+                m_bins[static_cast<std::size_t>(tile_y) * m_tiles_x + tile_x].push_back(
+                    static_cast<std::uint32_t>(index));
+            }
+        }
+    }
+}
+
+
+// Render tiles until there are none left
+// Each tile is rendered by a single thread, in submission order
+void ft::rf::soft::soft_rasterizer::run_tiles()
+{
+    while (true)
+    {
+        const auto tile = m_next_tile.fetch_add(1);
+        if (tile >= m_bins.size())
+        {
+            return;
+        }
+
+        render_tile(tile);
+
+        if (m_remaining_tiles.fetch_sub(1) == 1)
+        {
+            std::lock_guard<decltype(m_mutex)> lock{ m_mutex };
+            m_done_condition.notify_all();
+        }
+    }
+}
+
+
+// Render the primitives of a tile
+void ft::rf::soft::soft_rasterizer::render_tile(const std::size_t p_tile)
+{
+    const auto tile_x = static_cast<int>(p_tile % m_tiles_x) * s_tile_size;
+    const auto tile_y = static_cast<int>(p_tile / m_tiles_x) * s_tile_size;
+    const auto tile_end_x = std::min(tile_x + s_tile_size, m_target->get_width());
+    const auto tile_end_y = std::min(tile_y + s_tile_size, m_target->get_height());
+
+    for (const auto index : m_bins[p_tile])
+    {
+        const auto & primitive = m_primitives[index];
+        const auto x0 = std::max(tile_x, primitive.min_x);
+        const auto y0 = std::max(tile_y, primitive.min_y);
+        const auto x1 = std::min(tile_end_x, primitive.max_x + 1);
+        const auto y1 = std::min(tile_end_y, primitive.max_y + 1);
+
+        if (primitive.kind == t_kind::triangle) {
+            render_triangle(primitive, x0, y0, x1, y1);
+        }
+        else {
+            render_line(primitive, x0, y0, x1, y1);
+        }
+    }
+}
+
+
+// Render part of a triangle inside of a rectangle
+void ft::rf::soft::soft_rasterizer::render_triangle(
+    const t_primitive & p_primitive,
+    int p_x0, int p_y0, int p_x1, int p_y1)
+{
+    const auto & state = m_states[p_primitive.state];
+
+    for (auto y = p_y0; y < p_y1; ++y)
+    {
+        auto x = p_x0;
+        if (m_use_avx2) {
+            x = render_row_avx2(p_primitive, state, y, x, p_x1);
+        }
+        else if (m_use_sse2) {
+            x = render_row_sse2(p_primitive, state, y, x, p_x1);
+        }
+
+        // Remaining pixels
+        const auto center_y = static_cast<float>(y) + 0.5f;
+        for (; x < p_x1; ++x)
+        {
+            const auto center_x = static_cast<float>(x) + 0.5f;
+
+            auto inside = true;
+            for (int i = 0; i < 3 && inside; ++i)
+            {
+                const auto value = p_primitive.edges[i].at(center_x, center_y);
+                inside = value > 0.f || (value == 0.f && p_primitive.top_left[i]);
+            }
+
+            if (inside)
+            {
+                process_pixel(p_primitive, state, x, y);
+            }
+        }
+    }
+}
+
+
+// Render part of a line or point inside of a rectangle
+void ft::rf::soft::soft_rasterizer::render_line(
+    const t_primitive & p_primitive,
+    int p_x0, int p_y0, int p_x1, int p_y1)
+{
+    const auto & state = m_states[p_primitive.state];
+    const auto & a = p_primitive.ends[0];
+    const auto & b = p_primitive.ends[1];
+
+    const auto delta_x = b.x - a.x;
+    const auto delta_y = b.y - a.y;
+    const auto steps = p_primitive.kind == t_kind::point ?
+        0 :
+        static_cast<int>(std::ceil(std::max(std::abs(delta_x), std::abs(delta_y))));
+
+    for (int step = 0; step <= steps; ++step)
+    {
+        const auto t = steps > 0 ? static_cast<float>(step) / static_cast<float>(steps) : 0.f;
+        const auto x = static_cast<int>(std::floor(a.x + delta_x * t));
+        const auto y = static_cast<int>(std::floor(a.y + delta_y * t));
+        if (x < p_x0 || x >= p_x1 || y < p_y0 || y >= p_y1)
+        {
+            continue;
+        }
+
+        // Lines are interpolated along their length instead of with planes
+        auto line = p_primitive;
+        line.z = { 0.f, 0.f, a.z + (b.z - a.z) * t };
+        line.u = { 0.f, 0.f, a.u + (b.u - a.u) * t };
+        line.v = { 0.f, 0.f, a.v + (b.v - a.v) * t };
+        process_pixel(line, state, x, y);
+    }
+}
+
+
+// Depth test and shade a single pixel, writing its depth
+void ft::rf::soft::soft_rasterizer::process_pixel(
+    const t_primitive & p_primitive,
+    const t_draw_state & p_state,
+    const int p_x,
+    const int p_y)
+{
+    if (p_state.depth != t_depth_buffering::disabled)
+    {
+        auto & depth = m_target->get_depth()[static_cast<std::size_t>(p_y) * m_target->get_width() + p_x];
+        const auto z = p_primitive.z.at(static_cast<float>(p_x) + 0.5f, static_cast<float>(p_y) + 0.5f);
+        if ((z < depth) == false)
+        {
+            return;
+        }
+        if (p_state.depth == t_depth_buffering::enabled)
+        {
+            depth = z;
+        }
+    }
+
+    shade(p_primitive, p_state, p_x, p_y);
+}
+
+
+// Shade a pixel that passed the depth test
+void ft::rf::soft::soft_rasterizer::shade(
+    const t_primitive & p_primitive,
+    const t_draw_state & p_state,
+    const int p_x,
+    const int p_y)
+{
+    float color[4] = { p_state.color[0], p_state.color[1], p_state.color[2], p_state.color[3] };
+
+    const auto & texture = p_state.texture;
+    if (texture.texels != nullptr)
+    {
+        const auto center_x = static_cast<float>(p_x) + 0.5f;
+        const auto center_y = static_cast<float>(p_y) + 0.5f;
+        const auto s = wrap(p_primitive.u.at(center_x, center_y), texture.width);
+        const auto t = wrap(p_primitive.v.at(center_x, center_y), texture.height);
+
+        float texel[4];
+        unpack(texture.texels[static_cast<std::size_t>(t) * texture.width + s], texel);
+        for (int i = 0; i < 4; ++i)
+        {
+            color[i] *= texel[i];
+        }
+    }
+
+    auto & target = m_target->get_color()[static_cast<std::size_t>(p_y) * m_target->get_width() + p_x];
+    if (p_state.blending == t_blend_mode::default_transparency)
+    {
+        // glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA), alpha included
+        float destination[4];
+        unpack(target, destination);
+        const auto alpha = color[3];
+        for (int i = 0; i < 4; ++i)
+        {
+            color[i] = color[i] * alpha + destination[i] * (1.f - alpha);
+        }
+    }
+
+    target = soft_framebuffer::pack(color[0], color[1], color[2], color[3]);
+}
+
+
+// Rasterize pixels [p_x0, p_x1) of a row, 4 at a time
+// Returns the first pixel left for the scalar path
+int ft::rf::soft::soft_rasterizer::render_row_sse2(
+    const t_primitive & p_primitive,
+    const t_draw_state & p_state,
+    const int p_y,
+    int p_x0,
+    const int p_x1)
+{
+#if defined(FT_RF_SIMD_X86)
+    const auto center_y = static_cast<float>(p_y) + 0.5f;
+    const auto zero = _mm_setzero_ps();
+    const auto ramp = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+    __m128 edge_dx[3], edge_row[3], top_left[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        const auto & edge = p_primitive.edges[i];
+        edge_dx[i] = _mm_set1_ps(edge.dx);
+        edge_row[i] = _mm_set1_ps(edge.dy * center_y + edge.c);
+        top_left[i] = _mm_castsi128_ps(_mm_set1_epi32(p_primitive.top_left[i] ? -1 : 0));
+    }
+
+    const auto depth_test = p_state.depth != t_depth_buffering::disabled;
+    const auto depth_write = p_state.depth == t_depth_buffering::enabled;
+    const auto z_dx = _mm_set1_ps(p_primitive.z.dx);
+    const auto z_row = _mm_set1_ps(p_primitive.z.dy * center_y + p_primitive.z.c);
+    auto * depth_row = m_target->get_depth() + static_cast<std::size_t>(p_y) * m_target->get_width();
+
+    for (; p_x0 + 4 <= p_x1; p_x0 += 4)
+    {
+        const auto x = _mm_add_ps(_mm_set1_ps(static_cast<float>(p_x0)), ramp);
+
+        auto mask = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int i = 0; i < 3; ++i)
+        {
+            const auto value = _mm_add_ps(_mm_mul_ps(edge_dx[i], x), edge_row[i]);
+            const auto inside = _mm_or_ps(
+                _mm_cmpgt_ps(value, zero),
+                _mm_and_ps(_mm_cmpeq_ps(value, zero), top_left[i]));
+            mask = _mm_and_ps(mask, inside);
+        }
+        if (_mm_movemask_ps(mask) == 0) {
+            continue;
+        }
+
+        if (depth_test)
+        {
+            const auto z = _mm_add_ps(_mm_mul_ps(z_dx, x), z_row);
+            const auto depth = _mm_loadu_ps(depth_row + p_x0);
+            mask = _mm_and_ps(mask, _mm_cmplt_ps(z, depth));
+            if (depth_write)
+            {
+                _mm_storeu_ps(depth_row + p_x0, _mm_or_ps(
+                    _mm_and_ps(mask, z),
+                    _mm_andnot_ps(mask, depth)));
+            }
+        }
+
+        auto bits = static_cast<unsigned int>(_mm_movemask_ps(mask));
+        while (bits != 0)
+        {
+            shade(p_primitive, p_state, p_x0 + std::countr_zero(bits), p_y);
+            bits &= bits - 1;
+        }
+    }
+#else
+    (void)p_primitive; (void)p_state; (void)p_y; (void)p_x1;
+#endif
+    return p_x0;
+}
+
+
+// Rasterize pixels [p_x0, p_x1) of a row, 8 at a time
+// Returns the first pixel left for the scalar path
+FT_RF_TARGET_AVX2
+int ft::rf::soft::soft_rasterizer::render_row_avx2(
+    const t_primitive & p_primitive,
+    const t_draw_state & p_state,
+    const int p_y,
+    int p_x0,
+    const int p_x1)
+{
+#if defined(FT_RF_SIMD_X86)
+    const auto center_y = static_cast<float>(p_y) + 0.5f;
+    const auto zero = _mm256_setzero_ps();
+    const auto ramp = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+
+    __m256 edge_dx[3], edge_row[3], top_left[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        const auto & edge = p_primitive.edges[i];
+        edge_dx[i] = _mm256_set1_ps(edge.dx);
+        edge_row[i] = _mm256_set1_ps(edge.dy * center_y + edge.c);
+        top_left[i] = _mm256_castsi256_ps(_mm256_set1_epi32(p_primitive.top_left[i] ? -1 : 0));
+    }
+
+    const auto depth_test = p_state.depth != t_depth_buffering::disabled;
+    const auto depth_write = p_state.depth == t_depth_buffering::enabled;
+    const auto z_dx = _mm256_set1_ps(p_primitive.z.dx);
+    const auto z_row = _mm256_set1_ps(p_primitive.z.dy * center_y + p_primitive.z.c);
+    auto * depth_row = m_target->get_depth() + static_cast<std::size_t>(p_y) * m_target->get_width();
+
+    for (; p_x0 + 8 <= p_x1; p_x0 += 8)
+    {
+        const auto x = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(p_x0)), ramp);
+
+        auto mask = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int i = 0; i < 3; ++i)
+        {
+            const auto value = _mm256_fmadd_ps(edge_dx[i], x, edge_row[i]);
+            const auto inside = _mm256_or_ps(
+                _mm256_cmp_ps(value, zero, _CMP_GT_OQ),
+                _mm256_and_ps(_mm256_cmp_ps(value, zero, _CMP_EQ_OQ), top_left[i]));
+            mask = _mm256_and_ps(mask, inside);
+        }
+        if (_mm256_movemask_ps(mask) == 0) {
+            continue;
+        }
+
+        if (depth_test)
+        {
+            const auto z = _mm256_fmadd_ps(z_dx, x, z_row);
+            const auto depth = _mm256_loadu_ps(depth_row + p_x0);
+            mask = _mm256_and_ps(mask, _mm256_cmp_ps(z, depth, _CMP_LT_OQ));
+            if (depth_write)
+            {
+                _mm256_storeu_ps(depth_row + p_x0, _mm256_blendv_ps(depth, z, mask));
+            }
+        }
+
+        auto bits = static_cast<unsigned int>(_mm256_movemask_ps(mask));
+        while (bits != 0)
+        {
+            shade(p_primitive, p_state, p_x0 + std::countr_zero(bits), p_y);
+            bits &= bits - 1;
+        }
+    }
+#else
+    (void)p_primitive; (void)p_state; (void)p_y; (void)p_x1;
+#endif
+    return p_x0;
+}
+
+
+// Worker thread entry point
+void ft::rf::soft::soft_rasterizer::run_worker()
+{
+    std::uint64_t generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<decltype(m_mutex)> lock{ m_mutex };
+            m_start_condition.wait(lock, [&]() {
+                return m_stop || m_generation != generation;
+            });
+
+            if (m_stop) {
+                return;
+            }
+            generation = m_generation;
+        }
+
+        run_tiles();
+    }
+}
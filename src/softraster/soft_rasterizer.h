@@ -0,0 +1,232 @@
+#pragma once
+
+// Tile-based, multithreaded triangle rasterizer rendering to a soft_framebuffer
+//
+// Supported features :
+//  - Triangles in window coordinates (pixels, origin at the bottom left),
+//    with a depth in [0, 1] and affinely interpolated texture coordinates
+//  - A constant color per draw, optionally modulated by an RGBA8 texture
+//    sampled with nearest filtering and repeat wrapping
+//  - opengl_context's polygon, face culling, depth testing and blending modes,
+//    with counter-clockwise front faces and a "less" depth test
+//
+// Draws are queued by `draw` and rendered by `flush`
+// Coverage and depth testing use AVX2 or SSE2 when the CPU supports them
+
+// project headers
+#include "soft_framebuffer.h"
+#include "opengl_context/opengl_context.h"
+
+// other projects
+#include "basegl/color.h"
+
+// standard headers
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace ft {
+namespace rf {
+namespace soft {
+
+// A vertex in window coordinates
+struct t_soft_vertex
+{
+    float x = 0.f;
+    float y = 0.f;
+    float z = 0.f;
+    float u = 0.f;
+    float v = 0.f;
+
+};  // struct t_soft_vertex
+
+
+// An RGBA8 texture, rows stored bottom-up
+// The texels must outlive the next `flush`
+struct t_soft_texture
+{
+    int width = 0;
+    int height = 0;
+    const std::uint32_t* texels = nullptr;
+
+};  // struct t_soft_texture
+
+
+class soft_rasterizer
+{
+public:
+    using t_polygon_mode = context::opengl_context::t_polygon_mode;
+    using t_culling_mode = context::opengl_context::t_culling_mode;
+    using t_depth_buffering = context::opengl_context::t_depth_buffering;
+    using t_blend_mode = context::opengl_context::t_blend_mode;
+
+    // Width and height of a tile in pixels
+    static constexpr int s_tile_size = 64;
+
+public:
+    // Constructor
+    // Renders with `p_threads` threads including the caller, 0 uses every core
+    explicit soft_rasterizer(soft_framebuffer& p_target, unsigned int p_threads = 0);
+
+    // Destructor
+    // Stops the worker threads
+    ~soft_rasterizer();
+
+    // Prevent copy
+    soft_rasterizer(const soft_rasterizer&) = delete;
+    soft_rasterizer& operator=(const soft_rasterizer&) = delete;
+
+    // Render state applied to the following draws
+    void set_polygon_mode(const t_polygon_mode p_mode);
+    t_polygon_mode get_polygon_mode() const;
+    void set_culling_mode(const t_culling_mode p_mode);
+    t_culling_mode get_culling_mode() const;
+    void set_depth_test_mode(const t_depth_buffering p_mode);
+    t_depth_buffering get_depth_test_mode() const;
+    void set_blending_mode(const t_blend_mode p_mode);
+    t_blend_mode get_blending_mode() const;
+
+    // Queue a list of triangles, 3 vertices each
+    // The color is multiplied with the texture if one is provided
+    void draw(
+        std::span<const t_soft_vertex> p_vertices,
+        const gl::color<float>& p_color,
+        const float p_alpha = 1.f,
+        const t_soft_texture* p_texture = nullptr);
+
+    // Render every queued draw
+    void flush();
+
+    // Number of threads used to render
+    unsigned int get_thread_count() const;
+
+private:
+    // Per-draw state
+    struct t_draw_state {
+        t_polygon_mode polygon;
+        t_depth_buffering depth;
+        t_blend_mode blending;
+        float color[4];
+        t_soft_texture texture;
+    };
+
+    // A plane equation f(x, y) = dx * x + dy * y + c
+    struct t_plane {
+        float dx = 0.f;
+        float dy = 0.f;
+        float c = 0.f;
+
+        float at(const float p_x, const float p_y) const {
+            return dx * p_x + dy * p_y + c;
+        }
+    };
+
+    enum class t_kind : std::uint8_t {
+        triangle,
+        line,
+        point
+    };
+
+    // A primitive ready to be rasterized
+    struct t_primitive {
+        t_kind kind;
+        std::uint32_t state;
+
+        // Triangles : edge functions, positive inside, and their fill rule
+        t_plane edges[3];
+        bool top_left[3];
+
+        // Lines and points : end points
+        t_soft_vertex ends[2];
+
+        // Interpolated attributes
+        t_plane z;
+        t_plane u;
+        t_plane v;
+
+        // Pixel bounds, inclusive
+        int min_x;
+        int min_y;
+        int max_x;
+        int max_y;
+    };
+
+    // Queue a triangle, applying face culling
+    void add_triangle(const t_soft_vertex& p_a, const t_soft_vertex& p_b, const t_soft_vertex& p_c);
+
+    // Queue a line or a point
+    void add_line(const t_soft_vertex& p_a, const t_soft_vertex& p_b);
+    void add_point(const t_soft_vertex& p_a);
+
+    // Sort the primitives into the tiles they overlap
+    void bin();
+
+    // Render tiles until there are none left
+    void run_tiles();
+
+    // Render the primitives of a tile
+    void render_tile(const std::size_t p_tile);
+
+    // Render part of a primitive inside of a rectangle
+    void render_triangle(const t_primitive& p_primitive, int p_x0, int p_y0, int p_x1, int p_y1);
+    void render_line(const t_primitive& p_primitive, int p_x0, int p_y0, int p_x1, int p_y1);
+
+    // Shade a pixel that passed the depth test
+    void shade(const t_primitive& p_primitive, const t_draw_state& p_state, const int p_x, const int p_y);
+
+    // Depth test and shade a single pixel, writing its depth
+    void process_pixel(const t_primitive& p_primitive, const t_draw_state& p_state, const int p_x, const int p_y);
+
+    // Rasterize pixels [p_x0, p_x1) of a row using vector instructions
+    // Returns the first pixel left for the scalar path
+    int render_row_sse2(const t_primitive& p_primitive, const t_draw_state& p_state, const int p_y, int p_x0, const int p_x1);
+    int render_row_avx2(const t_primitive& p_primitive, const t_draw_state& p_state, const int p_y, int p_x0, const int p_x1);
+
+    // Worker thread entry point
+    void run_worker();
+
+private:
+    // Target framebuffer
+    soft_framebuffer* m_target = nullptr;
+
+    // Current render state
+    t_polygon_mode m_polygon_mode = t_polygon_mode::fill;
+    t_culling_mode m_culling_mode = t_culling_mode::no_culling;
+    t_depth_buffering m_depth_buffering = t_depth_buffering::disabled;
+    t_blend_mode m_blending_mode = t_blend_mode::disabled;
+
+    // Queued work
+    std::vector<t_draw_state> m_states;
+    std::vector<t_primitive> m_primitives;
+
+    // Primitive indices per tile, in submission order
+    int m_tiles_x = 0;
+    int m_tiles_y = 0;
+    std::vector<std::vector<std::uint32_t>> m_bins;
+
+    // Vector path to use
+    bool m_use_avx2 = false;
+    bool m_use_sse2 = false;
+
+    // Tile distribution
+    std::atomic<std::size_t> m_next_tile{ 0 };
+    std::atomic<std::size_t> m_remaining_tiles{ 0 };
+
+    // Worker threads
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_start_condition;
+    std::condition_variable m_done_condition;
+    std::uint64_t m_generation = 0;
+    bool m_stop = false;
+
+};  // class soft_rasterizer
+
+}   // namespace soft
+}   // namespace rf
+}   // namespace ft
@@ -0,0 +1,71 @@
+#include "soft_render_frame.h"
+
+// standard headers
+#include <utility>
+
+
+// Constructor
+// Renders with `p_threads` threads, 0 uses every core
+ft::rf::soft::soft_render_frame::soft_render_frame(t_render_frame_params p_params, unsigned int p_threads) :
+    m_params{ std::move(p_params) },
+    m_back{ m_params.size.x(), m_params.size.y() },
+    m_front{ m_params.size.x(), m_params.size.y() },
+    m_rasterizer{ m_back, p_threads }
+{
+    m_front.clear(m_params.background);
+}
+
+
+// Get the frame's initial parameters
+const ft::rf::t_render_frame_params &
+ft::rf::soft::soft_render_frame::get_params() const
+{
+    return m_params;
+}
+
+
+// Get the rasterizer drawing to the current frame
+ft::rf::soft::soft_rasterizer &
+ft::rf::soft::soft_render_frame::get_rasterizer()
+{
+    return m_rasterizer;
+}
+
+
+// Clear the current frame and prepare to start drawing to it
+void ft::rf::soft::soft_render_frame::start_frame()
+{
+    // Draws queued outside of a frame are discarded by the clear
+    m_rasterizer.flush();
+    m_back.clear(m_params.background);
+}
+
+
+// Finish rendering the current frame and present it
+void ft::rf::soft::soft_render_frame::end_frame()
+{
+    m_rasterizer.flush();
+
+    // Swaps the buffers' storage, the rasterizer keeps drawing to `m_back`
+    std::swap(m_front, m_back);
+
+    if (m_present_callback)
+    {
+        m_present_callback(m_front);
+    }
+}
+
+
+// Get the last presented frame
+const ft::rf::soft::soft_framebuffer &
+ft::rf::soft::soft_render_frame::get_presented_frame() const
+{
+    return m_front;
+}
+
+
+// Set the function called when a frame is presented
+void ft::rf::soft::soft_render_frame::set_present_callback(t_present_callback p_callback)
+{
+    m_present_callback = std::move(p_callback);
+}
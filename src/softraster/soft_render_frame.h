@@ -0,0 +1,68 @@
+#pragma once
+
+// CPU-only counterpart of render_frame for machines without an OpenGL driver
+// Follows the same `start_frame` / `end_frame` contract, but renders to
+//  in-memory framebuffers with a soft_rasterizer instead of a window
+// `t_render_frame_params::size` sets the framebuffer size, the window
+//  and pixel format parameters are ignored
+
+// project headers
+#include "soft_framebuffer.h"
+#include "soft_rasterizer.h"
+#include "renderframe/renderframeparams.h"
+
+// standard headers
+#include <functional>
+
+namespace ft {
+namespace rf {
+namespace soft {
+
+class soft_render_frame
+{
+public:
+    // Called by `end_frame` with the frame that was just completed
+    using t_present_callback = std::function<void(const soft_framebuffer&)>;
+
+public:
+    // Constructor
+    // Renders with `p_threads` threads, 0 uses every core
+    explicit soft_render_frame(t_render_frame_params p_params, unsigned int p_threads = 0);
+
+    // Get the frame's initial parameters
+    const t_render_frame_params& get_params() const;
+
+    // Get the rasterizer drawing to the current frame
+    soft_rasterizer& get_rasterizer();
+
+    // Clear the current frame and prepare to start drawing to it
+    void start_frame();
+
+    // Finish rendering the current frame and present it
+    void end_frame();
+
+    // Get the last presented frame
+    const soft_framebuffer& get_presented_frame() const;
+
+    // Set the function called when a frame is presented
+    void set_present_callback(t_present_callback p_callback);
+
+private:
+    // The frame's parameters
+    t_render_frame_params m_params;
+
+    // Frame being drawn and last presented frame
+    soft_framebuffer m_back;
+    soft_framebuffer m_front;
+
+    // Rasterizer drawing to `m_back`
+    soft_rasterizer m_rasterizer;
+
+    // Called on present
+    t_present_callback m_present_callback;
+
+};  // class soft_render_frame
+
+}   // namespace soft
+}   // namespace rf
+}   // namespace ft